@@ -16,12 +16,9 @@ const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
 };
 
 bool process_record_user(uint16_t keycode, keyrecord_t *record) {
-    if (record->event.pressed) {
-        uint8_t packet[2] = { keycode & 0xFF, 1 }; // [key, pressed]
-        wireless_send(packet, sizeof(packet));
-    } else {
-        uint8_t packet[2] = { keycode & 0xFF, 0 }; // [key, released]
-        wireless_send(packet, sizeof(packet));
+    // Queued for the radio; coalesced and sent by DMA from wireless_task()
+    if (IS_KEYEVENT(record->event)) {
+        wireless_send_key(record->event.key, record->event.pressed);
     }
     return true;
 }
@@ -6,13 +6,18 @@ void keyboard_pre_init_kb(void) {
 }
 
 void matrix_scan_kb(void) {
-    uint8_t rx[4];
-    wireless_receive(rx, sizeof(rx));
-
-    // Example: check for “message start” or simple command
-    if (rx[0] == 0xAA) {
-        // Handle whatever data you expect from the nRF
+    // Messages the nRF has sent; the SPI reads already happened in the
+    // background when it raised data ready
+    wireless_msg_t msg;
+    while (wireless_receive(&msg)) {
+        // Handle whatever data you expect from the nRF (msg.type, msg.data)
     }
 
     matrix_scan_user(); // keep default behavior
+}
+
+void housekeeping_task_kb(void) {
+    // Batch queued key events into radio packets and start the DMA
+    wireless_task();
+    housekeeping_task_user();
 }
\ No newline at end of file
@@ -0,0 +1,294 @@
+// Host benchmark for wireless_link with the nRF side replaced by a loopback:
+// a packet "sent" by the transport completes after the time SPI would take
+// to clock it out and is fed straight into wireless_link_parse(). Virtual
+// time advances in 1 us steps, with wireless_link_task() called once per
+// scan period, so latencies are deterministic.
+//
+// For each workload it reports events/s delivered, events per packet, the
+// queue-to-delivery latency (average and worst), any drops or losses, and
+// whether the receiver's key state ends up equal to the keyboard's. A last
+// run measures the host CPU cost of packing and parsing.
+//
+// The receive side is measured too: the old blocking 4-byte SPI poll per
+// matrix scan against the interrupt-filled receive ring, where a scan with
+// nothing waiting only compares two indices.
+//
+// Build and run from sm65_test:
+//   cc -O2 -I. tools/wireless_link_bench.c wireless_link.c -o wireless_link_bench
+//   ./wireless_link_bench
+
+#include "wireless_link.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define SPI_HZ          4000000
+#define CS_OVERHEAD_US  4
+#define XFER_US(len)    ((len) * 8 * 1000000 / SPI_HZ + CS_OVERHEAD_US)
+#define SCAN_US         250     // wireless_link_task() period (QMK scan)
+#define SIM_US          2000000 // Virtual time per workload
+
+// ---- Loopback transport ----
+
+static uint32_t now_us;
+static bool in_flight;
+static uint32_t done_at;
+static uint8_t wire[WIRELESS_LINK_PACKET_SIZE];
+static uint8_t wire_len;
+
+bool wireless_transport_start(const uint8_t *packet, uint8_t len) {
+    memcpy(wire, packet, len);
+    wire_len = len;
+    in_flight = true;
+    done_at = now_us + XFER_US(len);
+    return true;
+}
+
+// ---- Receiver: checks every change arrives and the states agree ----
+
+static uint8_t truth[WIRELESS_LINK_STATE_SIZE];
+static uint32_t sent_changes;
+static uint32_t recv_changes;
+static wireless_link_rx_t rx;
+
+static void on_key(void *ctx, uint8_t index, bool pressed) {
+    (void) ctx;
+    (void) index;
+    (void) pressed;
+    recv_changes++;
+}
+
+static void queue(uint8_t index, bool pressed) {
+    if (wireless_link_queue_key(index, pressed, now_us)) {
+        uint8_t bit = (uint8_t)(1u << (index & 7));
+        if (((truth[index >> 3] & bit) != 0) != pressed) {
+            truth[index >> 3] ^= bit;
+            sent_changes++;
+        }
+    }
+}
+
+static void reset(void) {
+    wireless_link_init();
+    wireless_link_rx_init(&rx);
+    in_flight = false;
+    memset(truth, 0, sizeof(truth));
+    sent_changes = recv_changes = 0;
+}
+
+// ---- Workloads: called every 1 us, queue the events due at now_us ----
+
+static uint32_t rng = 12345;
+
+static uint32_t rnd(uint32_t n) {
+    rng = rng * 1664525u + 1013904223u;
+    return (rng >> 8) % n;
+}
+
+// ~7 keystrokes/s: 60-120 ms holds, 20-80 ms between keys
+static void typing(uint32_t t) {
+    static uint32_t next_press, release_at;
+    static uint8_t key;
+    if (t == 0) {
+        next_press = 0;
+        release_at = UINT32_MAX;
+    }
+    if (t == next_press) {
+        key = (uint8_t)(4 + rnd(26));
+        queue(key, true);
+        release_at = t + 60000 + rnd(60000);
+    }
+    if (t == release_at) {
+        queue(key, false);
+        next_press = t + 20000 + rnd(60000);
+    }
+}
+
+// Six-key chord every 200 ms, released together 100 ms later
+static void chords(uint32_t t) {
+    uint32_t phase = t % 200000;
+    if (phase == 0 || phase == 100000) {
+        for (uint8_t k = 0; k < 6; k++) {
+            queue((uint8_t)(4 + k), phase == 0);
+        }
+    }
+}
+
+// Rapid trigger: one key toggling every 100 us for 5 ms, every 50 ms
+static void rapid_trigger(uint32_t t) {
+    uint32_t phase = t % 50000;
+    if (phase < 5000 && phase % 100 == 0) {
+        queue(30, (phase / 100) % 2 == 0);
+    }
+}
+
+// As fast as the queue accepts, 64 keys going down then up: the link's
+// ceiling
+static void saturate(uint32_t t) {
+    if (t % 10 == 0) {
+        uint32_t n = t / 10;
+        queue((uint8_t)(n % 64), (n / 64) % 2 == 0);
+    }
+}
+
+typedef struct {
+    const char *name;
+    void (*step)(uint32_t t);
+} workload_t;
+
+static const workload_t workloads[] = {
+    {"typing",        typing},
+    {"6-key chords",  chords},
+    {"rapid trigger", rapid_trigger},
+    {"saturate",      saturate},
+};
+
+static void run(const workload_t *w) {
+    reset();
+
+    // Workload for SIM_US, then drain what is still queued
+    for (now_us = 0; now_us < SIM_US || wireless_link_busy(); now_us++) {
+        if (now_us < SIM_US) {
+            w->step(now_us);
+        }
+        if (in_flight && now_us >= done_at) {
+            in_flight = false;
+            wireless_link_parse(&rx, wire, wire_len, on_key, NULL);
+            wireless_link_tx_done(now_us);
+        }
+        if (now_us % SCAN_US == 0) {
+            wireless_link_task(now_us);
+        }
+    }
+
+    wireless_link_stats_t s;
+    wireless_link_get_stats(&s);
+    bool state_ok = memcmp(truth, rx.state, sizeof(truth)) == 0 && recv_changes == sent_changes;
+    printf("%-14s %8lu %8lu %9.2f %10.0f %8.1f %8lu %7lu %5lu %5s\n", w->name,
+           (unsigned long) s.events_sent, (unsigned long) s.packets_sent,
+           s.packets_sent ? (double) s.events_sent / s.packets_sent : 0.0,
+           s.events_sent * 1e6 / SIM_US,
+           s.events_sent ? (double) s.latency_us_sum / s.events_sent : 0.0,
+           (unsigned long) s.latency_us_max, (unsigned long) s.events_dropped,
+           (unsigned long) (rx.lost + rx.crc_errors), state_ok ? "ok" : "BAD");
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Host CPU cost per event of queueing, packing (with CRC) and parsing:
+// eight keys go down in one packet and come up in the next
+static void cpu_cost(void) {
+    const uint32_t events = 4000000;
+    const uint32_t per_packet = 8;
+    reset();
+    wireless_link_set_timing(0, 0);
+
+    double start = now_ns();
+    for (uint32_t i = 0; i < events; i += per_packet) {
+        for (uint32_t k = 0; k < per_packet; k++) {
+            queue((uint8_t)((i / 16 + k) % WIRELESS_LINK_NUM_KEYS), (i / per_packet) % 2 == 0);
+        }
+        wireless_link_task(i);
+        wireless_link_parse(&rx, wire, wire_len, on_key, NULL);
+        in_flight = false;
+        wireless_link_tx_done(i);
+    }
+    double elapsed = now_ns() - start;
+    printf("\nHost CPU: %.1f ns/event queue+pack+CRC+parse (%.1f M events/s), %lu of %lu changes delivered\n",
+           elapsed / events, events * 1e3 / elapsed, (unsigned long) recv_changes, (unsigned long) sent_changes);
+    wireless_link_set_timing(WIRELESS_LINK_COALESCE_US, WIRELESS_LINK_KEYFRAME_US);
+}
+
+// ---- Receive: nRF packets through the ring, and what a scan pays ----
+
+#define POLL_BYTES      4   // What matrix_scan_kb() used to read every scan
+
+static void build_packet(uint8_t *p, uint8_t seq, uint8_t fill) {
+    memset(p, 0, WIRELESS_LINK_PACKET_SIZE);
+    p[0] = WIRELESS_LINK_SYNC;
+    p[1] = WIRELESS_MSG_DELTA;
+    p[2] = seq;
+    p[3] = 1;
+    p[WIRELESS_LINK_HEADER_SIZE] = fill & 0x7F;
+    uint16_t crc = wireless_link_crc16(&p[1], WIRELESS_LINK_HEADER_SIZE);
+    p[WIRELESS_LINK_HEADER_SIZE + 1] = (uint8_t) crc;
+    p[WIRELESS_LINK_HEADER_SIZE + 2] = (uint8_t)(crc >> 8);
+}
+
+static void receive_cost(void) {
+    const uint32_t scans = 20000000;
+    const uint32_t packets = 1000000;
+    wireless_link_init();
+
+    // Scans with nothing waiting: the common case
+    wireless_msg_t msg;
+    uint32_t got = 0;
+    double start = now_ns();
+    for (uint32_t i = 0; i < scans; i++) {
+        got += wireless_link_receive(&msg);
+    }
+    double idle_ns = (now_ns() - start) / scans;
+
+    // Packets arriving by "DMA" in bursts of up to the ring size, drained
+    // by the scan loop; one in 16 corrupted, one seq in 64 skipped
+    uint8_t seq = 0;
+    uint32_t sent = 0, dropped_seq = 0, corrupted = 0, full = 0;
+    got = 0;
+    start = now_ns();
+    while (sent < packets) {
+        for (uint32_t b = 0; b < WIRELESS_LINK_RX_QUEUE + 1 && sent < packets; b++) {
+            uint8_t *slot = wireless_link_rx_slot();
+            if (!slot) {
+                full++;     // nRF holds the packet until a slot frees
+                break;
+            }
+            if (sent % 64 == 63) {
+                seq++;
+                dropped_seq++;
+            }
+            build_packet(slot, seq++, (uint8_t) sent);
+            if (sent % 16 == 15) {
+                slot[4] ^= 0x40;
+                corrupted++;
+            }
+            wireless_link_rx_commit();
+            sent++;
+        }
+        while (wireless_link_receive(&msg)) {
+            got++;
+        }
+    }
+    double msg_ns = (now_ns() - start) / packets;
+
+    wireless_link_rx_t rx_stats;
+    wireless_link_get_rx_stats(&rx_stats);
+    uint32_t poll_us = POLL_BYTES * 8 * 1000000 / SPI_HZ + CS_OVERHEAD_US;
+    printf("\nReceive: old blocking poll %lu us of SPI every scan; ring check %.2f ns/scan idle (host), "
+           "%.1f ns/packet received\n", (unsigned long) poll_us, idle_ns, msg_ns);
+    printf("         %lu packets: %lu delivered, %lu CRC rejects (%lu corrupted), %lu seq gaps (%lu skipped + the rejects), "
+           "%lu ring-full waits\n", (unsigned long) sent, (unsigned long) got,
+           (unsigned long) rx_stats.crc_errors, (unsigned long) corrupted,
+           (unsigned long) rx_stats.lost, (unsigned long) dropped_seq, (unsigned long) full);
+    for (uint32_t scan_us = 100; scan_us <= 1000; scan_us *= 10) {
+        printf("         at a %4lu us scan the poll cost %4.1f%% of the loop\n",
+               (unsigned long) scan_us, 100.0 * poll_us / scan_us);
+    }
+}
+
+int main(void) {
+    printf("SPI %d Hz, packets up to %d bytes (%d us), task every %d us, coalesce %d us, keyframe every %d us\n\n",
+           SPI_HZ, WIRELESS_LINK_PACKET_SIZE, XFER_US(WIRELESS_LINK_PACKET_SIZE), SCAN_US,
+           WIRELESS_LINK_COALESCE_US, WIRELESS_LINK_KEYFRAME_US);
+    printf("%-14s %8s %8s %9s %10s %8s %8s %7s %5s %5s\n", "workload", "events", "packets",
+           "ev/pkt", "events/s", "avg us", "max us", "dropped", "lost", "state");
+    for (size_t i = 0; i < sizeof(workloads) / sizeof(workloads[0]); i++) {
+        run(&workloads[i]);
+    }
+    cpu_cost();
+    receive_cost();
+    return 0;
+}
@@ -0,0 +1,455 @@
+// Host simulator that replays key traces through the radio link and
+// compares three ways of getting them to the nRF:
+//
+//   per-event   one blocking 32-byte SPI packet per process_record_user()
+//               event, as wireless.c first did (model)
+//   batched     3-byte events, up to 8 per fixed 32-byte packet, packed
+//               when the bus is free (model of the previous link layer)
+//   delta       the current wireless_link.c: shadow bitmap, varint deltas,
+//               coalescing window and periodic keyframes, run for real
+//
+// Events land on QMK scan ticks and wireless_link_task() runs right after
+// each scan, as housekeeping_task_kb() does. Every transfer takes the time
+// SPI needs to clock its bytes out; "air" bytes add the ESB framing
+// (preamble, address, control field, CRC) each packet costs on the radio.
+// Latency is from the scan that saw the change to the end of the transfer
+// carrying it.
+//
+// A last section drops packets at random and measures how long the
+// receiver's key state stays wrong, with and without keyframes.
+//
+// Build and run from sm65_test:
+//   cc -O2 -I. tools/wireless_trace_sim.c wireless_link.c -o wireless_trace_sim
+//   ./wireless_trace_sim [trace.txt]
+//
+// A trace file has one event per line, "time_us key pressed" (key is the
+// link index, row * MATRIX_COLS + col), sorted by time; it replaces the
+// built-in traces.
+
+#include "wireless_link.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SPI_HZ          4000000
+#define CS_OVERHEAD_US  4
+#define XFER_US(len)    ((len) * 8 * 1000000 / SPI_HZ + CS_OVERHEAD_US)
+#define SCAN_US         250
+#define ESB_OVERHEAD    10      // Preamble 1 + address 5 + PCF 2 + CRC 2
+#define TRACE_US        20000000
+#define MAX_EVENTS      65536
+
+typedef struct {
+    uint32_t t_us;
+    uint8_t  key;
+    bool     pressed;
+} trace_event_t;
+
+typedef struct {
+    const char *name;
+    trace_event_t events[MAX_EVENTS];
+    uint32_t count;
+} trace_t;
+
+typedef struct {
+    uint32_t keystrokes;
+    uint32_t packets;
+    uint32_t bytes;
+    uint64_t latency_sum;
+    uint32_t latency_max;
+    uint32_t events;
+} result_t;
+
+// ---- Trace generation ----
+
+static uint32_t rng;
+
+static uint32_t rnd(uint32_t n) {
+    rng = rng * 1664525u + 1013904223u;
+    return (rng >> 8) % n;
+}
+
+static uint32_t rnd_range(uint32_t lo, uint32_t hi) {
+    return lo + rnd(hi - lo + 1);
+}
+
+static void add(trace_t *tr, uint32_t t, uint8_t key, bool pressed) {
+    if (tr->count < MAX_EVENTS && t < TRACE_US) {
+        tr->events[tr->count++] = (trace_event_t){t, key, pressed};
+    }
+}
+
+static int by_time(const void *a, const void *b) {
+    const trace_event_t *x = a, *y = b;
+    return x->t_us < y->t_us ? -1 : x->t_us > y->t_us;
+}
+
+#define KEY_SHIFT   42
+#define KEY_SPACE   58
+
+// Typing: keystrokes every gap_lo..gap_hi us held hold_lo..hold_hi us, so
+// fast typing overlaps (rollover); one in eight under shift
+static void gen_typing(trace_t *tr, uint32_t gap_lo, uint32_t gap_hi, uint32_t hold_lo, uint32_t hold_hi) {
+    for (uint32_t t = 0; t < TRACE_US; t += rnd_range(gap_lo, gap_hi)) {
+        uint8_t key = rnd(6) == 0 ? KEY_SPACE : (uint8_t) rnd_range(16, 40);
+        uint32_t hold = rnd_range(hold_lo, hold_hi);
+        if (rnd(8) == 0) {
+            add(tr, t, KEY_SHIFT, true);
+            add(tr, t + 30000 + hold, KEY_SHIFT, false);
+            t += 30000;
+        }
+        add(tr, t, key, true);
+        add(tr, t + hold, key, false);
+    }
+}
+
+static void gen_prose(trace_t *tr) {
+    gen_typing(tr, 120000, 280000, 70000, 110000);    // ~60 wpm
+}
+
+static void gen_fast(trace_t *tr) {
+    gen_typing(tr, 50000, 110000, 80000, 150000);     // ~140 wpm with rollover
+}
+
+// WASD held for long stretches with taps of space and number keys on top
+static void gen_gaming(trace_t *tr) {
+    static const uint8_t moves[] = {17, 30, 31, 32};
+    for (uint32_t t = 0; t < TRACE_US; t += rnd_range(100000, 400000)) {
+        uint8_t key = moves[rnd(4)];
+        uint32_t hold = rnd_range(150000, 900000);
+        add(tr, t, key, true);
+        add(tr, t + hold, key, false);
+        if (rnd(3) == 0) {
+            uint32_t tap = t + rnd(hold);
+            uint8_t other = rnd(2) ? KEY_SPACE : (uint8_t) rnd_range(2, 6);
+            add(tr, tap, other, true);
+            add(tr, tap + rnd_range(40000, 90000), other, false);
+        }
+    }
+}
+
+// Steno-style chords: 3-6 keys down within 10 ms, up within 10 ms
+static void gen_chords(trace_t *tr) {
+    for (uint32_t t = 0; t < TRACE_US; t += rnd_range(200000, 400000)) {
+        uint32_t n = rnd_range(3, 6);
+        uint32_t up = t + rnd_range(80000, 150000);
+        for (uint32_t k = 0; k < n; k++) {
+            uint8_t key = (uint8_t)(16 + k * 3 + rnd(3));
+            add(tr, t + rnd(10000), key, true);
+            add(tr, up + rnd(10000), key, false);
+        }
+    }
+}
+
+// Rapid trigger on an analog board: a key re-actuating every 2-4 ms for
+// 40 ms, every 150 ms
+static void gen_rapid(trace_t *tr) {
+    for (uint32_t t = 0; t < TRACE_US; t += 150000) {
+        uint8_t key = (uint8_t) rnd_range(16, 40);
+        uint32_t s = t;
+        for (bool down = true; s < t + 40000; down = !down) {
+            add(tr, s, key, down);
+            s += rnd_range(2000, 4000);
+        }
+        add(tr, s, key, false);
+    }
+}
+
+static void finish_trace(trace_t *tr) {
+    qsort(tr->events, tr->count, sizeof(tr->events[0]), by_time);
+    // Drop events that repeat the key's state (overlapping generated holds)
+    uint8_t down[256] = {0};
+    uint32_t out = 0;
+    for (uint32_t i = 0; i < tr->count; i++) {
+        trace_event_t e = tr->events[i];
+        e.t_us = (e.t_us + SCAN_US - 1) / SCAN_US * SCAN_US;   // Seen by the next scan
+        if (e.key < WIRELESS_LINK_NUM_KEYS && down[e.key] != e.pressed) {
+            down[e.key] = e.pressed;
+            tr->events[out++] = e;
+        }
+    }
+    tr->count = out;
+}
+
+static bool load_trace(trace_t *tr, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        return false;
+    }
+    unsigned long t;
+    unsigned key, pressed;
+    tr->name = path;
+    tr->count = 0;
+    while (tr->count < MAX_EVENTS && fscanf(f, "%lu %u %u", &t, &key, &pressed) == 3) {
+        tr->events[tr->count++] = (trace_event_t){(uint32_t) t, (uint8_t) key, pressed != 0};
+    }
+    fclose(f);
+    finish_trace(tr);
+    return true;
+}
+
+static uint32_t count_presses(const trace_t *tr) {
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < tr->count; i++) {
+        n += tr->events[i].pressed;
+    }
+    return n;
+}
+
+static uint32_t trace_end(const trace_t *tr) {
+    return tr->count ? tr->events[tr->count - 1].t_us + 1000000 : 0;
+}
+
+// ---- Models of the earlier schemes ----
+
+static void note_latency(result_t *r, uint32_t latency) {
+    r->latency_sum += latency;
+    if (latency > r->latency_max) {
+        r->latency_max = latency;
+    }
+    r->events++;
+}
+
+// One 32-byte transfer per event, back to back
+static void run_per_event(const trace_t *tr, result_t *r) {
+    uint32_t bus_free = 0;
+    for (uint32_t i = 0; i < tr->count; i++) {
+        uint32_t start = tr->events[i].t_us > bus_free ? tr->events[i].t_us : bus_free;
+        bus_free = start + XFER_US(WIRELESS_LINK_PACKET_SIZE);
+        note_latency(r, bus_free - tr->events[i].t_us);
+        r->packets++;
+        r->bytes += WIRELESS_LINK_PACKET_SIZE;
+    }
+}
+
+// Up to 8 events per 32-byte packet: a packet starts at a scan when the bus
+// is free, and a full one chains straight on from the previous transfer
+static void run_batched(const trace_t *tr, result_t *r) {
+    const uint32_t per_packet = 8;
+    uint32_t next = 0, queued = 0, busy_until = 0;
+    for (uint32_t t = 0; next < tr->count || queued < next; t += SCAN_US) {
+        while (next < tr->count && tr->events[next].t_us <= t) {
+            next++;
+        }
+        uint32_t start = t;
+        while (queued < next && busy_until <= t) {
+            uint32_t n = next - queued < per_packet ? next - queued : per_packet;
+            start = busy_until > start ? busy_until : start;
+            uint32_t done = start + XFER_US(WIRELESS_LINK_PACKET_SIZE);
+            for (uint32_t k = 0; k < n; k++) {
+                note_latency(r, done - tr->events[queued + k].t_us);
+            }
+            queued += n;
+            r->packets++;
+            r->bytes += WIRELESS_LINK_PACKET_SIZE;
+            busy_until = done;
+            if (next - queued < per_packet) {
+                break;
+            }
+            start = done;
+        }
+    }
+}
+
+// ---- The real link, with a lossy loopback transport ----
+
+static bool in_flight;
+static uint32_t done_at;
+static uint8_t wire[WIRELESS_LINK_PACKET_SIZE];
+static uint8_t wire_len;
+
+bool wireless_transport_start(const uint8_t *packet, uint8_t len) {
+    memcpy(wire, packet, len);
+    wire_len = len;
+    in_flight = true;
+    done_at += XFER_US(len);
+    return true;
+}
+
+static void on_key(void *ctx, uint8_t index, bool pressed) {
+    (void) ctx;
+    (void) index;
+    (void) pressed;
+}
+
+typedef struct {
+    uint32_t loss_per_mille;
+    uint32_t dropped;
+    uint32_t wrong_us;      // Time the lossy receiver's state was wrong
+    uint32_t worst_wrong_us;
+    bool     state_ok;      // Lossless receiver matches the trace at the end
+} loss_t;
+
+static void run_delta(const trace_t *tr, uint32_t coalesce_us, uint32_t keyframe_us, result_t *r, loss_t *loss) {
+    wireless_link_rx_t rx, lossy;
+    uint8_t truth[WIRELESS_LINK_STATE_SIZE] = {0};
+    wireless_link_init();
+    wireless_link_set_timing(coalesce_us, keyframe_us);
+    wireless_link_rx_init(&rx);
+    wireless_link_rx_init(&lossy);
+    in_flight = false;
+
+    uint32_t next = 0, wrong_since = 0;
+    bool wrong = false;
+    uint32_t end = trace_end(tr);
+    for (uint32_t t = 0; t < end || wireless_link_busy(); t += SCAN_US) {
+        // Transfers that finished since the last scan, chaining as they go
+        while (in_flight && done_at <= t) {
+            in_flight = false;
+            wireless_link_parse(&rx, wire, wire_len, on_key, NULL);
+            if (loss && rnd(1000) < loss->loss_per_mille) {
+                loss->dropped++;
+            } else {
+                wireless_link_parse(&lossy, wire, wire_len, on_key, NULL);
+            }
+            wireless_link_tx_done(done_at);
+        }
+        if (loss) {
+            bool now_wrong = memcmp(rx.state, lossy.state, sizeof(rx.state)) != 0;
+            if (now_wrong && !wrong) {
+                wrong_since = t;
+            } else if (!now_wrong && wrong && t - wrong_since > loss->worst_wrong_us) {
+                loss->worst_wrong_us = t - wrong_since;
+            }
+            loss->wrong_us += now_wrong ? SCAN_US : 0;
+            wrong = now_wrong;
+        }
+
+        while (next < tr->count && tr->events[next].t_us <= t) {
+            const trace_event_t *e = &tr->events[next++];
+            wireless_link_queue_key(e->key, e->pressed, t);
+            truth[e->key >> 3] ^= (uint8_t)(1u << (e->key & 7));
+        }
+        if (!in_flight) {
+            done_at = t;
+        }
+        wireless_link_task(t);
+    }
+
+    wireless_link_stats_t s;
+    wireless_link_get_stats(&s);
+    r->packets = s.packets_sent;
+    r->bytes = s.bytes_sent;
+    r->events = s.events_sent;
+    r->latency_sum = s.latency_us_sum;
+    r->latency_max = s.latency_us_max;
+    if (loss) {
+        loss->state_ok = memcmp(truth, rx.state, sizeof(truth)) == 0;
+        if (wrong) {
+            loss->worst_wrong_us = UINT32_MAX;     // Never recovered
+        }
+    }
+}
+
+// ---- Report ----
+
+static void print_result(const char *scheme, const result_t *r) {
+    double ks = r->keystrokes ? r->keystrokes : 1;
+    printf("  %-26s %8.2f %9.1f %9.1f %9.1f %9lu\n", scheme, r->packets / ks, r->bytes / ks,
+           (r->bytes + (double) r->packets * ESB_OVERHEAD) / ks,
+           r->events ? (double) r->latency_sum / r->events : 0.0, (unsigned long) r->latency_max);
+}
+
+static void compare(const trace_t *tr) {
+    result_t r;
+    uint32_t keystrokes = count_presses(tr);
+    printf("%s: %lu events, %lu keystrokes\n", tr->name, (unsigned long) tr->count, (unsigned long) keystrokes);
+    printf("  %-26s %8s %9s %9s %9s %9s\n", "scheme", "pkt/ks", "SPI B/ks", "air B/ks", "avg us", "max us");
+
+    memset(&r, 0, sizeof(r));
+    r.keystrokes = keystrokes;
+    run_per_event(tr, &r);
+    print_result("per-event (first)", &r);
+
+    memset(&r, 0, sizeof(r));
+    r.keystrokes = keystrokes;
+    run_batched(tr, &r);
+    print_result("batched (previous)", &r);
+
+    static const struct {
+        const char *name;
+        uint32_t coalesce_us;
+        uint32_t keyframe_us;
+    } configs[] = {
+        {"delta",                        0, WIRELESS_LINK_KEYFRAME_US},
+        {"delta, coalesce 1 ms",      1000, WIRELESS_LINK_KEYFRAME_US},
+        {"delta, coalesce 4 ms",      4000, WIRELESS_LINK_KEYFRAME_US},
+        {"delta, no keyframes",          0, 0},
+    };
+    for (size_t i = 0; i < sizeof(configs) / sizeof(configs[0]); i++) {
+        memset(&r, 0, sizeof(r));
+        r.keystrokes = keystrokes;
+        loss_t check = {0};
+        run_delta(tr, configs[i].coalesce_us, configs[i].keyframe_us, &r, &check);
+        print_result(configs[i].name, &r);
+        if (!check.state_ok) {
+            printf("  ^ receiver state does not match the trace\n");
+        }
+    }
+    printf("\n");
+}
+
+static void loss_recovery(const trace_t *tr) {
+    static const uint32_t keyframes[] = {100000, WIRELESS_LINK_KEYFRAME_US, 0};
+    printf("%s with 2%% of packets lost:\n", tr->name);
+    printf("  %-26s %8s %13s %15s\n", "keyframe period", "dropped", "state wrong", "worst stretch");
+    for (size_t i = 0; i < sizeof(keyframes) / sizeof(keyframes[0]); i++) {
+        result_t r = {0};
+        loss_t loss = {.loss_per_mille = 20};
+        rng = 99;
+        run_delta(tr, 0, keyframes[i], &r, &loss);
+        char label[32];
+        snprintf(label, sizeof(label), keyframes[i] ? "%lu ms" : "off", (unsigned long)(keyframes[i] / 1000));
+        if (loss.worst_wrong_us == UINT32_MAX) {
+            printf("  %-26s %8lu %10.1f ms %15s\n", label, (unsigned long) loss.dropped, loss.wrong_us / 1000.0,
+                   "never recovers");
+        } else {
+            printf("  %-26s %8lu %10.1f ms %12.1f ms\n", label, (unsigned long) loss.dropped,
+                   loss.wrong_us / 1000.0, loss.worst_wrong_us / 1000.0);
+        }
+    }
+}
+
+static trace_t trace;
+
+int main(int argc, char **argv) {
+    printf("SPI %d Hz, scan every %d us, %d-key bitmap, ESB framing %d bytes/packet, keystroke = one press\n\n",
+           SPI_HZ, SCAN_US, WIRELESS_LINK_NUM_KEYS, ESB_OVERHEAD);
+
+    if (argc > 1) {
+        if (!load_trace(&trace, argv[1])) {
+            fprintf(stderr, "Cannot read %s\n", argv[1]);
+            return 1;
+        }
+        compare(&trace);
+        loss_recovery(&trace);
+        return 0;
+    }
+
+    static const struct {
+        const char *name;
+        void (*gen)(trace_t *tr);
+    } traces[] = {
+        {"prose, ~60 wpm",          gen_prose},
+        {"fast typing, ~140 wpm",   gen_fast},
+        {"gaming",                  gen_gaming},
+        {"chords",                  gen_chords},
+        {"rapid trigger",           gen_rapid},
+    };
+    for (size_t i = 0; i < sizeof(traces) / sizeof(traces[0]); i++) {
+        rng = 12345 + (uint32_t) i;
+        trace.name = traces[i].name;
+        trace.count = 0;
+        traces[i].gen(&trace);
+        finish_trace(&trace);
+        compare(&trace);
+    }
+
+    rng = 12345 + 1;
+    trace.name = "fast typing, ~140 wpm";
+    trace.count = 0;
+    gen_fast(&trace);
+    finish_trace(&trace);
+    loss_recovery(&trace);
+    return 0;
+}
@@ -2,12 +2,15 @@
 #include "sm65_test.h"
 
 /* The wireless implementation uses the Raspberry Pi Pico SDK (hardware/spi.h,
- * pico/stdlib.h). Those headers are only available when the Pico SDK is
- * enabled for the build. Guard the includes and implementation with
- * PICO_SDK so builds for other MCUs won't fail.
+ * hardware/dma.h, pico/stdlib.h). Those headers are only available when the
+ * Pico SDK is enabled for the build. Guard the includes and implementation
+ * with PICO_SDK so builds for other MCUs won't fail.
  */
 #ifdef PICO_SDK
 #include "hardware/spi.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
 #include "pico/stdlib.h"
 #endif
 
@@ -15,8 +18,98 @@
 #define PIN_CS   17
 #define PIN_SCK  18
 #define PIN_MOSI 19
+#define PIN_DRDY 21     // nRF data ready, active low
+
+#ifdef PICO_SDK
+/* Every transfer runs on two DMA channels paced by the SPI DREQs. Sending a
+ * packet, TX feeds it and RX drains the bytes clocked back; reading one,
+ * TX repeats a 0xFF filler and RX writes straight into a receive ring slot.
+ * RX finishing means the last byte has left the shifter, so its interrupt
+ * raises CS and starts whatever is due next. A pending read goes first: the
+ * nRF's data-ready line stays low until its packet has been read. */
+typedef enum {
+    BUS_IDLE,
+    BUS_TX,
+    BUS_RX,
+} bus_state_t;
+
+static int dma_tx = -1;
+static int dma_rx = -1;
+static uint8_t rx_discard;
+static const uint8_t tx_filler = 0xFF;
+
+static volatile bus_state_t bus_state = BUS_IDLE;
+static const uint8_t *volatile tx_pending = NULL;
+static uint8_t tx_pending_len;
+
+static void bus_start(const uint8_t *tx, bool tx_increment, uint8_t *rx, bool rx_increment, uint8_t len) {
+    gpio_put(PIN_CS, 0);
+
+    dma_channel_config c = dma_get_channel_config(dma_tx);
+    channel_config_set_read_increment(&c, tx_increment);
+    dma_channel_set_config(dma_tx, &c, false);
+    dma_channel_set_read_addr(dma_tx, tx, false);
+    dma_channel_set_trans_count(dma_tx, len, false);
+
+    c = dma_get_channel_config(dma_rx);
+    channel_config_set_write_increment(&c, rx_increment);
+    dma_channel_set_config(dma_rx, &c, false);
+    dma_channel_set_write_addr(dma_rx, rx, false);
+    dma_channel_set_trans_count(dma_rx, len, false);
+
+    dma_start_channel_mask((1u << dma_tx) | (1u << dma_rx));
+}
+
+// Start the next transfer if the bus is free; interrupts must be off or
+// this must run in one of the wireless interrupts
+static void bus_kick(void) {
+    if (bus_state != BUS_IDLE) {
+        return;
+    }
+    if (!gpio_get(PIN_DRDY)) {
+        uint8_t *slot = wireless_link_rx_slot();
+        if (slot) {
+            bus_state = BUS_RX;
+            bus_start(&tx_filler, false, slot, true, WIRELESS_LINK_PACKET_SIZE);
+            return;
+        }
+        // Ring full: the read is retried once wireless_receive() frees a slot
+    }
+    if (tx_pending) {
+        const uint8_t *packet = tx_pending;
+        tx_pending = NULL;
+        bus_state = BUS_TX;
+        bus_start(packet, true, &rx_discard, false, tx_pending_len);
+    }
+}
+
+static void wireless_dma_irq(void) {
+    if (!(dma_hw->ints1 & (1u << dma_rx))) {
+        return;     // Another channel on the shared line
+    }
+    dma_hw->ints1 = 1u << dma_rx;
+    gpio_put(PIN_CS, 1);
+
+    bus_state_t done = bus_state;
+    bus_state = BUS_IDLE;
+    if (done == BUS_RX) {
+        wireless_link_rx_commit();
+    } else if (done == BUS_TX) {
+        // May hand over the next packet through wireless_transport_start()
+        wireless_link_tx_done(time_us_32());
+    }
+    bus_kick();
+}
+
+static void wireless_drdy_irq(uint gpio, uint32_t events) {
+    (void)gpio;
+    (void)events;
+    bus_kick();
+}
+#endif
 
 void wireless_init(void) {
+    wireless_link_init();
 #ifdef PICO_SDK
     spi_init(spi0, 4000 * 1000); // 4 MHz
     gpio_set_function(PIN_MISO, GPIO_FUNC_SPI);
@@ -25,6 +118,39 @@ void wireless_init(void) {
     gpio_init(PIN_CS);
     gpio_set_dir(PIN_CS, GPIO_OUT);
     gpio_put(PIN_CS, 1);
+
+    dma_tx = dma_claim_unused_channel(true);
+    dma_rx = dma_claim_unused_channel(true);
+
+    dma_channel_config c = dma_channel_get_default_config(dma_tx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_dreq(&c, spi_get_dreq(spi0, true));
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    dma_channel_configure(dma_tx, &c, &spi_get_hw(spi0)->dr, NULL, 0, false);
+
+    c = dma_channel_get_default_config(dma_rx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_dreq(&c, spi_get_dreq(spi0, false));
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, false);
+    dma_channel_configure(dma_rx, &c, &rx_discard, &spi_get_hw(spi0)->dr, 0, false);
+
+    dma_channel_set_irq1_enabled(dma_rx, true);
+    irq_add_shared_handler(DMA_IRQ_1, wireless_dma_irq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    // A packet waiting in the nRF pulls the line low
+    gpio_init(PIN_DRDY);
+    gpio_set_dir(PIN_DRDY, GPIO_IN);
+    gpio_pull_up(PIN_DRDY);
+    gpio_set_irq_enabled_with_callback(PIN_DRDY, GPIO_IRQ_EDGE_FALL, true, wireless_drdy_irq);
+
+    // The line may have gone low before the edge interrupt was armed (a
+    // packet waiting since boot); no edge comes for that one, so look now
+    uint32_t irq_state = save_and_disable_interrupts();
+    bus_kick();
+    restore_interrupts(irq_state);
 #else
     // Pico SDK not available; provide a no-op implementation so non-Pico
     // builds still link. If you intend to use wireless on another MCU,
@@ -32,38 +158,54 @@ void wireless_init(void) {
 #endif
 }
 
-/* Send any packet of bytes to the nRF */
-void wireless_send(uint8_t *data, size_t len) {
+/* Hand one packet to the bus; it goes out as soon as the bus is free
+ * (completes in wireless_dma_irq) */
+bool wireless_transport_start(const uint8_t *packet, uint8_t len) {
 #ifdef PICO_SDK
-    gpio_put(PIN_CS, 0);
-    spi_write_blocking(spi0, data, len);
-    gpio_put(PIN_CS, 1);
+    uint32_t irq_state = save_and_disable_interrupts();
+    tx_pending_len = len;
+    tx_pending = packet;
+    bus_kick();
+    restore_interrupts(irq_state);
+    return true;
 #else
-    // No-op for non-Pico builds
-    (void)data;
+    // No radio on non-Pico builds: packets stay queued
+    (void)packet;
     (void)len;
+    return false;
 #endif
 }
 
-/* Receive bytes from the nRF.
- * Returns number of bytes read (up to max_len).
- * Call this periodically or from matrix_scan_kb() if you want to poll.
- */
-size_t wireless_receive(uint8_t *buffer, size_t max_len) {
+static uint32_t wireless_now_us(void) {
 #ifdef PICO_SDK
-    if (!buffer || max_len == 0) return 0;
+    return time_us_32();
+#else
+    return timer_read32() * 1000;
+#endif
+}
 
-    gpio_put(PIN_CS, 0);
+void wireless_send_key(keypos_t key, bool pressed) {
+    wireless_link_queue_key((uint8_t)(key.row * MATRIX_COLS + key.col), pressed, wireless_now_us());
+}
 
-    // Send dummy bytes (0xFF) to read back nRF data
-    spi_read_blocking(spi0, 0xFF, buffer, max_len);
+void wireless_task(void) {
+    wireless_link_task(wireless_now_us());
+}
 
-    gpio_put(PIN_CS, 1);
-    return max_len;
-#else
-    // Not supported on non-Pico builds
-    (void)buffer;
-    (void)max_len;
-    return 0;
+/* Take the next checked message read from the nRF. Only looks at the
+ * receive ring: the SPI reads happen in the background when the nRF
+ * signals data ready.
+ */
+bool wireless_receive(wireless_msg_t *msg) {
+    if (!wireless_link_rx_pending()) {
+        return false;
+    }
+    bool got = wireless_link_receive(msg);
+#ifdef PICO_SDK
+    // A read may have been waiting for the slot just freed
+    uint32_t irq_state = save_and_disable_interrupts();
+    bus_kick();
+    restore_interrupts(irq_state);
 #endif
+    return got;
 }
@@ -1,6 +1,16 @@
 #pragma once
 #include "quantum.h"
+#include "wireless_link.h"
 
 void wireless_init(void);
-void wireless_send(uint8_t *data, size_t len);
-size_t wireless_receive(uint8_t *buffer, size_t max_len);
+
+// Queue a change of the key at this matrix position for the radio; never
+// blocks (see wireless_link.h)
+void wireless_send_key(keypos_t key, bool pressed);
+
+// Pack queued events and keep the DMA transport fed; call every scan
+void wireless_task(void);
+
+// Next message read from the nRF (data-ready interrupt + DMA); false if
+// none is waiting. Costs one index compare when idle.
+bool wireless_receive(wireless_msg_t *msg);
@@ -0,0 +1,365 @@
+#include "wireless_link.h"
+#include <string.h>
+
+typedef struct {
+    uint8_t  index;
+    bool     pressed;
+    uint32_t queued_us;
+} link_event_t;
+
+typedef struct {
+    uint8_t  bytes[WIRELESS_LINK_PACKET_SIZE];
+    uint8_t  len;           // Bytes on the wire
+    uint8_t  num_events;
+    uint32_t first_us;      // Queue time of the oldest event
+    uint32_t stamp_sum;     // Sum of the events' queue times (wraps)
+} link_packet_t;
+
+// Events: produced and consumed in the main loop
+static link_event_t events[WIRELESS_LINK_EVENT_QUEUE];
+static uint32_t event_head;
+static uint32_t event_tail;
+
+// Packets: produced in the main loop, consumed by the transport completion
+// interrupt; the packet at packet_tail is on the wire while transmitting
+static link_packet_t packets[WIRELESS_LINK_PACKET_QUEUE];
+static volatile uint32_t packet_head;
+static volatile uint32_t packet_tail;
+static volatile bool transmitting;
+
+static uint8_t tx_seq;
+static wireless_link_stats_t stats;
+
+// Key state as of the last packed packet, i.e. what the receiver will hold
+static uint8_t tx_state[WIRELESS_LINK_STATE_SIZE];
+static bool state_changed;          // Since the last keyframe
+static uint32_t last_keyframe_us;
+static uint32_t coalesce_us = WIRELESS_LINK_COALESCE_US;
+static uint32_t keyframe_us = WIRELESS_LINK_KEYFRAME_US;
+
+// Received packets: filled by the transport interrupt, drained by the scan
+// loop
+static uint8_t rx_slots[WIRELESS_LINK_RX_QUEUE][WIRELESS_LINK_PACKET_SIZE];
+static volatile uint32_t rx_head;
+static volatile uint32_t rx_tail;
+static wireless_link_rx_t link_rx;
+
+// CRC-16/CCITT-FALSE, a nibble at a time
+static const uint16_t crc16_nibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+uint16_t wireless_link_crc16(const uint8_t *data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc = (uint16_t)(crc << 4) ^ crc16_nibble[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (uint16_t)(crc << 4) ^ crc16_nibble[(crc >> 12) ^ (data[i] & 0x0F)];
+    }
+    return crc;
+}
+
+void wireless_link_init(void) {
+    event_head = event_tail = 0;
+    packet_head = packet_tail = 0;
+    transmitting = false;
+    tx_seq = 0;
+    memset(&stats, 0, sizeof(stats));
+    memset(tx_state, 0, sizeof(tx_state));
+    state_changed = false;
+    last_keyframe_us = 0;
+    rx_head = rx_tail = 0;
+    wireless_link_rx_init(&link_rx);
+}
+
+void wireless_link_set_timing(uint32_t coalesce, uint32_t keyframe) {
+    coalesce_us = coalesce;
+    keyframe_us = keyframe;
+}
+
+bool wireless_link_queue_key(uint8_t index, bool pressed, uint32_t now_us) {
+    if (event_head - event_tail >= WIRELESS_LINK_EVENT_QUEUE || index >= WIRELESS_LINK_NUM_KEYS) {
+        stats.events_dropped++;
+        return false;
+    }
+    link_event_t *event = &events[event_head % WIRELESS_LINK_EVENT_QUEUE];
+    event->index = index;
+    event->pressed = pressed;
+    event->queued_us = now_us;
+    event_head++;
+    stats.events_queued++;
+    return true;
+}
+
+static uint8_t put_varint(uint8_t *p, uint32_t value) {
+    uint8_t n = 0;
+    while (value >= 0x80) {
+        p[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    p[n++] = (uint8_t) value;
+    return n;
+}
+
+static void finish_packet(link_packet_t *packet, uint8_t type, uint8_t len) {
+    uint8_t *p = packet->bytes;
+    p[0] = WIRELESS_LINK_SYNC;
+    p[1] = type;
+    p[2] = tx_seq++;
+    p[3] = len;
+    uint16_t crc = wireless_link_crc16(&p[1], WIRELESS_LINK_HEADER_SIZE - 1 + len);
+    p[WIRELESS_LINK_HEADER_SIZE + len] = (uint8_t) crc;
+    p[WIRELESS_LINK_HEADER_SIZE + len + 1] = (uint8_t)(crc >> 8);
+    packet->len = (uint8_t)(WIRELESS_LINK_HEADER_SIZE + len + WIRELESS_LINK_CRC_SIZE);
+    packet_head++;
+}
+
+static void pack_keyframe(link_packet_t *packet, uint32_t now_us) {
+    memcpy(&packet->bytes[WIRELESS_LINK_HEADER_SIZE], tx_state, sizeof(tx_state));
+    state_changed = false;
+    last_keyframe_us = now_us;
+    stats.keyframes_sent++;
+    finish_packet(packet, WIRELESS_MSG_KEYFRAME, sizeof(tx_state));
+}
+
+// Fold queued events into the next packet slot: a delta, or a keyframe
+// once that is smaller. A keyframe only shows the final state, so it is
+// not used once a key has changed twice, and a keyframe packet ends before
+// a key would change twice.
+static void pack_events(uint32_t now_us) {
+    link_packet_t *packet = &packets[packet_head % WIRELESS_LINK_PACKET_QUEUE];
+    uint8_t *payload = &packet->bytes[WIRELESS_LINK_HEADER_SIZE];
+    uint8_t in_packet[WIRELESS_LINK_STATE_SIZE] = {0};
+    uint8_t len = 0;
+    bool as_keyframe = false;
+    bool repeated = false;
+
+    packet->num_events = 0;
+    packet->first_us = events[event_tail % WIRELESS_LINK_EVENT_QUEUE].queued_us;
+    packet->stamp_sum = 0;
+    while (event_tail != event_head) {
+        const link_event_t *event = &events[event_tail % WIRELESS_LINK_EVENT_QUEUE];
+        uint8_t byte = event->index >> 3;
+        uint8_t bit = (uint8_t)(1u << (event->index & 7));
+        if (((tx_state[byte] & bit) != 0) != event->pressed) {
+            bool again = (in_packet[byte] & bit) != 0;
+            if (again && as_keyframe) {
+                break;
+            }
+            if (!as_keyframe) {
+                uint8_t varint[2];
+                uint8_t n = put_varint(varint, (uint32_t)(event->index << 1) | event->pressed);
+                if (len + n > WIRELESS_LINK_STATE_SIZE && !repeated && !again) {
+                    as_keyframe = true;
+                } else if (len + n > WIRELESS_LINK_MAX_PAYLOAD) {
+                    break;
+                } else {
+                    memcpy(&payload[len], varint, n);
+                    len += n;
+                    repeated |= again;
+                }
+            }
+            in_packet[byte] |= bit;
+            tx_state[byte] ^= bit;
+        }
+        packet->stamp_sum += event->queued_us;
+        packet->num_events++;
+        event_tail++;
+    }
+
+    if (as_keyframe) {
+        pack_keyframe(packet, now_us);
+    } else if (len > 0) {
+        if (!state_changed) {
+            // Keyframe period starts at the first change after a keyframe
+            state_changed = true;
+            last_keyframe_us = now_us;
+        }
+        finish_packet(packet, WIRELESS_MSG_DELTA, len);
+    } else {
+        // Only repeats of the current state: nothing to send
+        stats.events_sent += packet->num_events;
+    }
+}
+
+static bool any_key_down(void) {
+    for (uint8_t i = 0; i < WIRELESS_LINK_STATE_SIZE; i++) {
+        if (tx_state[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void wireless_link_task(uint32_t now_us) {
+    // A batch with enough events to fill a keyframe goes straight into the
+    // queue; a smaller one waits until the transport is idle (events keep
+    // coalescing while it is busy) and until its oldest event has waited
+    // the coalescing window
+    while (event_head != event_tail && packet_head - packet_tail < WIRELESS_LINK_PACKET_QUEUE) {
+        uint32_t pending = event_head - event_tail;
+        if (pending < WIRELESS_LINK_STATE_SIZE) {
+            if (packet_head != packet_tail) {
+                break;
+            }
+            uint32_t waited = now_us - events[event_tail % WIRELESS_LINK_EVENT_QUEUE].queued_us;
+            if (waited < coalesce_us) {
+                break;
+            }
+        }
+        pack_events(now_us);
+    }
+
+    // Periodic keyframe once everything else is out
+    if (keyframe_us && event_head == event_tail && packet_head == packet_tail && !transmitting &&
+        now_us - last_keyframe_us >= keyframe_us && (state_changed || any_key_down())) {
+        link_packet_t *packet = &packets[packet_head % WIRELESS_LINK_PACKET_QUEUE];
+        packet->num_events = 0;
+        packet->first_us = now_us;
+        packet->stamp_sum = 0;
+        pack_keyframe(packet, now_us);
+    }
+
+    if (!transmitting && packet_head != packet_tail) {
+        const link_packet_t *packet = &packets[packet_tail % WIRELESS_LINK_PACKET_QUEUE];
+        transmitting = true;
+        if (!wireless_transport_start(packet->bytes, packet->len)) {
+            transmitting = false;
+        }
+    }
+}
+
+void wireless_link_tx_done(uint32_t now_us) {
+    const link_packet_t *packet = &packets[packet_tail % WIRELESS_LINK_PACKET_QUEUE];
+    if (packet->num_events) {
+        uint32_t latency_max = now_us - packet->first_us;
+        stats.latency_us_sum += packet->num_events * now_us - packet->stamp_sum;
+        if (latency_max > stats.latency_us_max) {
+            stats.latency_us_max = latency_max;
+        }
+    }
+    stats.events_sent += packet->num_events;
+    stats.packets_sent++;
+    stats.bytes_sent += packet->len;
+    packet_tail++;
+
+    // Chain the next packet straight from the interrupt
+    if (packet_head != packet_tail) {
+        const link_packet_t *next = &packets[packet_tail % WIRELESS_LINK_PACKET_QUEUE];
+        if (wireless_transport_start(next->bytes, next->len)) {
+            return;
+        }
+    }
+    transmitting = false;
+}
+
+bool wireless_link_busy(void) {
+    return transmitting || packet_head != packet_tail || event_head != event_tail;
+}
+
+void wireless_link_get_stats(wireless_link_stats_t *out) {
+    *out = stats;
+}
+
+void wireless_link_rx_init(wireless_link_rx_t *rx) {
+    memset(rx, 0, sizeof(*rx));
+}
+
+bool wireless_link_check(wireless_link_rx_t *rx, const uint8_t *packet, uint8_t len) {
+    if (len < WIRELESS_LINK_HEADER_SIZE + WIRELESS_LINK_CRC_SIZE || packet[0] != WIRELESS_LINK_SYNC ||
+        packet[3] > WIRELESS_LINK_MAX_PAYLOAD ||
+        WIRELESS_LINK_HEADER_SIZE + packet[3] + WIRELESS_LINK_CRC_SIZE > len) {
+        rx->crc_errors++;
+        return false;
+    }
+    const uint8_t *crc_at = &packet[WIRELESS_LINK_HEADER_SIZE + packet[3]];
+    uint16_t crc = (uint16_t)(crc_at[0] | (crc_at[1] << 8));
+    if (wireless_link_crc16(&packet[1], WIRELESS_LINK_HEADER_SIZE - 1 + packet[3]) != crc) {
+        rx->crc_errors++;
+        return false;
+    }
+
+    uint8_t seq = packet[2];
+    if (rx->synced) {
+        rx->lost += (uint8_t)(seq - rx->next_seq);
+    }
+    rx->next_seq = (uint8_t)(seq + 1);
+    rx->synced = true;
+    rx->packets++;
+    return true;
+}
+
+static void apply_key(wireless_link_rx_t *rx, uint32_t index, bool pressed,
+                      wireless_link_key_cb_t cb, void *ctx) {
+    if (index >= WIRELESS_LINK_NUM_KEYS) {
+        return;
+    }
+    uint8_t bit = (uint8_t)(1u << (index & 7));
+    if (((rx->state[index >> 3] & bit) != 0) != pressed) {
+        rx->state[index >> 3] ^= bit;
+        cb(ctx, (uint8_t) index, pressed);
+    }
+}
+
+bool wireless_link_parse(wireless_link_rx_t *rx, const uint8_t *packet, uint8_t len,
+                         wireless_link_key_cb_t cb, void *ctx) {
+    if (!wireless_link_check(rx, packet, len)) {
+        return false;
+    }
+    const uint8_t *payload = &packet[WIRELESS_LINK_HEADER_SIZE];
+    uint8_t payload_len = packet[3];
+    if (packet[1] == WIRELESS_MSG_DELTA) {
+        uint32_t value = 0;
+        uint8_t shift = 0;
+        for (uint8_t i = 0; i < payload_len && shift < 28; i++) {
+            value |= (uint32_t)(payload[i] & 0x7F) << shift;
+            shift += 7;
+            if (!(payload[i] & 0x80)) {
+                apply_key(rx, value >> 1, value & 1, cb, ctx);
+                value = 0;
+                shift = 0;
+            }
+        }
+    } else if (packet[1] == WIRELESS_MSG_KEYFRAME && payload_len == WIRELESS_LINK_STATE_SIZE) {
+        for (uint32_t index = 0; index < WIRELESS_LINK_NUM_KEYS; index++) {
+            apply_key(rx, index, (payload[index >> 3] >> (index & 7)) & 1, cb, ctx);
+        }
+    }
+    return true;
+}
+
+uint8_t *wireless_link_rx_slot(void) {
+    if (rx_head - rx_tail >= WIRELESS_LINK_RX_QUEUE) {
+        return NULL;
+    }
+    return rx_slots[rx_head % WIRELESS_LINK_RX_QUEUE];
+}
+
+void wireless_link_rx_commit(void) {
+    rx_head++;
+}
+
+bool wireless_link_rx_pending(void) {
+    return rx_head != rx_tail;
+}
+
+bool wireless_link_receive(wireless_msg_t *msg) {
+    while (rx_head != rx_tail) {
+        const uint8_t *packet = rx_slots[rx_tail % WIRELESS_LINK_RX_QUEUE];
+        bool ok = wireless_link_check(&link_rx, packet, WIRELESS_LINK_PACKET_SIZE);
+        if (ok) {
+            msg->type = packet[1];
+            msg->len = packet[3];
+            memcpy(msg->data, &packet[WIRELESS_LINK_HEADER_SIZE], packet[3]);
+        }
+        rx_tail++;
+        if (ok) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void wireless_link_get_rx_stats(wireless_link_rx_t *rx) {
+    *rx = link_rx;
+}
@@ -0,0 +1,178 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Link layer between the keyboard and the nRF radio module.
+ *
+ * Key events are queued in O(1) from process_record_user() and never touch
+ * SPI there. wireless_link_task() coalesces queued events into packets, and
+ * the transport (wireless.c) clocks the packets out by DMA one after the
+ * other, calling wireless_link_tx_done() from its completion interrupt.
+ *
+ * Packets from the nRF travel the other way: when the nRF raises its
+ * data-ready line the transport reads one packet by DMA straight into a
+ * slot of the receive ring (wireless_link_rx_slot() / _rx_commit()), and
+ * the scan loop only dequeues checked messages with wireless_link_receive().
+ *
+ * Packets are 6 to WIRELESS_LINK_PACKET_SIZE bytes (one ESB payload, sent
+ * with dynamic payload length):
+ *
+ *   [0]      sync        WIRELESS_LINK_SYNC
+ *   [1]      type        WIRELESS_MSG_*
+ *   [2]      seq         +1 per packet, so the receiver sees losses
+ *   [3]      len         payload bytes
+ *   [4..]    payload
+ *   [4+len]  crc         CRC-16/CCITT-FALSE of bytes 1..3+len, LE
+ *
+ * Keys are numbered 0..WIRELESS_LINK_NUM_KEYS-1 (matrix row * MATRIX_COLS
+ * + col). Both ends keep a bitmap of which keys are down and only changes
+ * travel:
+ *
+ *   WIRELESS_MSG_DELTA     one varint per changed key, (index << 1) |
+ *                          pressed, 7 bits per byte low first, top bit set
+ *                          on all but the last byte. Applied in order, and a
+ *                          key may appear more than once, so a tap inside
+ *                          the coalescing window still arrives as a press
+ *                          and a release.
+ *   WIRELESS_MSG_KEYFRAME  the whole bitmap, WIRELESS_LINK_STATE_SIZE
+ *                          bytes, bit i of byte i / 8 = key i down. Sent in
+ *                          place of a delta that would be larger (unless a
+ *                          key changes twice in it), and every keyframe
+ *                          period while keys are down or the state has
+ *                          changed since the last one, so the receiver
+ *                          recovers from a lost packet within that period.
+ *
+ * No hardware dependencies: builds on the host (tools/wireless_link_bench.c
+ * runs it against a loopback transport, tools/wireless_trace_sim.c replays
+ * typing traces through it).
+ */
+
+#define WIRELESS_LINK_PACKET_SIZE   32
+#define WIRELESS_LINK_HEADER_SIZE   4
+#define WIRELESS_LINK_CRC_SIZE      2
+#define WIRELESS_LINK_MAX_PAYLOAD   (WIRELESS_LINK_PACKET_SIZE - WIRELESS_LINK_HEADER_SIZE - WIRELESS_LINK_CRC_SIZE)
+#define WIRELESS_LINK_SYNC          0xA5
+
+#define WIRELESS_MSG_DELTA          0x02
+#define WIRELESS_MSG_KEYFRAME       0x03
+
+// Key positions covered by the state bitmap (multiple of 8); a keyframe
+// has to fit in one packet
+#ifndef WIRELESS_LINK_NUM_KEYS
+#define WIRELESS_LINK_NUM_KEYS      128
+#endif
+#define WIRELESS_LINK_STATE_SIZE    (WIRELESS_LINK_NUM_KEYS / 8)
+
+#if WIRELESS_LINK_STATE_SIZE > WIRELESS_LINK_MAX_PAYLOAD
+#error "WIRELESS_LINK_NUM_KEYS does not fit in a keyframe"
+#endif
+
+// Key events waiting to be packed (power of two)
+#ifndef WIRELESS_LINK_EVENT_QUEUE
+#define WIRELESS_LINK_EVENT_QUEUE   64
+#endif
+
+// Packed packets waiting for the transport (power of two)
+#ifndef WIRELESS_LINK_PACKET_QUEUE
+#define WIRELESS_LINK_PACKET_QUEUE  8
+#endif
+
+// Packets read from the nRF waiting for the scan loop (power of two)
+#ifndef WIRELESS_LINK_RX_QUEUE
+#define WIRELESS_LINK_RX_QUEUE      8
+#endif
+
+// How long a lone change may wait for others to share its packet; 0
+// sends as soon as the transport is free (changes still coalesce while it
+// is busy). Changeable at run time with wireless_link_set_timing().
+#ifndef WIRELESS_LINK_COALESCE_US
+#define WIRELESS_LINK_COALESCE_US   0
+#endif
+
+// Keyframe period for loss recovery, counted from the first change after
+// the last keyframe; 0 sends keyframes only in place of large deltas
+#ifndef WIRELESS_LINK_KEYFRAME_US
+#define WIRELESS_LINK_KEYFRAME_US   500000
+#endif
+
+typedef struct {
+    uint32_t events_queued;
+    uint32_t events_dropped;    // Event queue full or key out of range
+    uint32_t events_sent;       // Including repeats of the current state
+    uint32_t packets_sent;
+    uint32_t keyframes_sent;
+    uint32_t bytes_sent;
+    uint32_t latency_us_sum;    // Queue to end of transfer, per event (wraps)
+    uint32_t latency_us_max;
+} wireless_link_stats_t;
+
+/* Transport, provided by wireless.c (or a host stub): start sending one
+ * packet without blocking. Returns false if nothing could be started; the
+ * link then retries from wireless_link_task(). */
+bool wireless_transport_start(const uint8_t *packet, uint8_t len);
+
+void wireless_link_init(void);
+
+// Coalescing window and keyframe period, defaults above
+void wireless_link_set_timing(uint32_t coalesce_us, uint32_t keyframe_us);
+
+// Queue one key event; false (and counted) if the queue is full
+bool wireless_link_queue_key(uint8_t index, bool pressed, uint32_t now_us);
+
+// Pack queued events (and keyframes when due) and start the transport if
+// it is idle
+void wireless_link_task(uint32_t now_us);
+
+// Called by the transport when a packet has been clocked out (may run in
+// interrupt context); starts the next queued packet
+void wireless_link_tx_done(uint32_t now_us);
+
+// True while packets are queued or on the wire
+bool wireless_link_busy(void);
+
+void wireless_link_get_stats(wireless_link_stats_t *stats);
+
+/* ---- Receive side (nRF firmware, host tools) ---- */
+
+typedef struct {
+    uint8_t  next_seq;
+    bool     synced;
+    uint32_t packets;
+    uint32_t crc_errors;        // Bad sync, length or CRC
+    uint32_t lost;              // Packets missing from the seq
+    uint8_t  state[WIRELESS_LINK_STATE_SIZE];   // Keys down as received
+} wireless_link_rx_t;
+
+typedef void (*wireless_link_key_cb_t)(void *ctx, uint8_t index, bool pressed);
+
+void wireless_link_rx_init(wireless_link_rx_t *rx);
+
+// Check one packet, apply it to rx->state and report each key that
+// changed; false if rejected
+bool wireless_link_parse(wireless_link_rx_t *rx, const uint8_t *packet, uint8_t len,
+                         wireless_link_key_cb_t cb, void *ctx);
+
+typedef struct {
+    uint8_t type;               // WIRELESS_MSG_*
+    uint8_t len;
+    uint8_t data[WIRELESS_LINK_MAX_PAYLOAD];
+} wireless_msg_t;
+
+// Check framing, CRC and seq of one packet; false if rejected
+bool wireless_link_check(wireless_link_rx_t *rx, const uint8_t *packet, uint8_t len);
+
+/* Receive ring. The transport takes a slot for each packet it reads from
+ * the nRF and commits it once the DMA has filled it (interrupt context);
+ * the scan loop drains it. While the ring is full the nRF keeps its data
+ * ready line up and the read waits for a free slot. */
+uint8_t *wireless_link_rx_slot(void);   // NULL if full
+void wireless_link_rx_commit(void);
+bool wireless_link_rx_pending(void);
+
+// Next valid message from the nRF; false once the ring is empty
+bool wireless_link_receive(wireless_msg_t *msg);
+
+void wireless_link_get_rx_stats(wireless_link_rx_t *rx);
+
+uint16_t wireless_link_crc16(const uint8_t *data, size_t len);
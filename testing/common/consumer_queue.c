@@ -0,0 +1,75 @@
+#include "consumer_queue.h"
+#include <string.h>
+
+void consumer_queue_init(consumer_queue_t *queue) {
+    memset(queue, 0, sizeof(*queue));
+}
+
+bool consumer_queue_tap(consumer_queue_t *queue, uint16_t usage) {
+    if (usage == 0) {
+        return true;
+    }
+
+    // Coalesce with the newest entry, even while it is being sent
+    if (queue->used) {
+        uint8_t tail = (uint8_t)((queue->head + queue->used - 1) % CONSUMER_QUEUE_DEPTH);
+        if (queue->usage[tail] == usage && queue->count[tail] < UINT16_MAX) {
+            queue->count[tail]++;
+            return true;
+        }
+    }
+
+    if (queue->used == CONSUMER_QUEUE_DEPTH) {
+        queue->dropped++;
+        return false;
+    }
+    uint8_t slot = (uint8_t)((queue->head + queue->used) % CONSUMER_QUEUE_DEPTH);
+    queue->usage[slot] = usage;
+    queue->count[slot] = 1;
+    queue->used++;
+    return true;
+}
+
+bool consumer_queue_next(const consumer_queue_t *queue, uint16_t *report) {
+    if (queue->in_flight) {
+        return false;
+    }
+    if (queue->pressed) {
+        *report = 0;
+        return true;
+    }
+    if (queue->used) {
+        *report = queue->usage[queue->head];
+        return true;
+    }
+    return false;
+}
+
+void consumer_queue_sent(consumer_queue_t *queue, bool accepted) {
+    queue->in_flight = accepted;
+}
+
+void consumer_queue_complete(consumer_queue_t *queue) {
+    if (!queue->in_flight) {
+        return;
+    }
+    queue->in_flight = false;
+
+    if (!queue->pressed) {
+        queue->pressed = true;
+        return;
+    }
+
+    // Release delivered: one tap done
+    queue->pressed = false;
+    if (--queue->count[queue->head] == 0) {
+        queue->head = (uint8_t)((queue->head + 1) % CONSUMER_QUEUE_DEPTH);
+        queue->used--;
+    }
+}
+
+void consumer_queue_clear(consumer_queue_t *queue) {
+    uint32_t dropped = queue->dropped;
+    consumer_queue_init(queue);
+    queue->dropped = dropped;
+}
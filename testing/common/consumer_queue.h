@@ -0,0 +1,79 @@
+#ifndef CONSUMER_QUEUE_H
+#define CONSUMER_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Consumer-control (media key) taps without blocking.
+//
+// Each tap is a press report followed by a release report (usage 0). The
+// USB side asks for the next report with consumer_queue_next() whenever the
+// endpoint is free and reports completion from tud_hid_report_complete_cb,
+// so taps go out back to back at the polling rate and the caller never
+// waits. Repeated taps of the same usage (encoder detents) coalesce into one
+// entry with a count, so a fast burst needs one slot, not one per detent.
+// No hardware dependencies: builds on the host.
+
+#ifndef CONSUMER_QUEUE_DEPTH
+#define CONSUMER_QUEUE_DEPTH 8
+#endif
+
+typedef struct {
+    uint16_t usage[CONSUMER_QUEUE_DEPTH];
+    uint16_t count[CONSUMER_QUEUE_DEPTH];  // Taps left for this usage
+    uint8_t  head;                  // Entry being sent
+    uint8_t  used;                  // Entries queued
+    bool     pressed;               // Press sent, release due next
+    bool     in_flight;             // A report is waiting for completion
+    uint32_t dropped;               // Taps lost to a full queue
+} consumer_queue_t;
+
+/**
+ * @brief Start empty with nothing in flight
+ */
+void consumer_queue_init(consumer_queue_t *queue);
+
+/**
+ * @brief Queue one tap of a consumer usage (e.g. 0x00E9 Volume Up)
+ *
+ * @return false if the queue was full and the tap was dropped
+ */
+bool consumer_queue_tap(consumer_queue_t *queue, uint16_t usage);
+
+/**
+ * @brief Get the next report to send, if any is due
+ *
+ * Returns false while a report is in flight. After true, send *report and
+ * call consumer_queue_sent() with whether the stack accepted it.
+ *
+ * @param queue Queue
+ * @param report Usage to report (0 = release)
+ */
+bool consumer_queue_next(const consumer_queue_t *queue, uint16_t *report);
+
+/**
+ * @brief Record the result of sending the report from consumer_queue_next()
+ *
+ * @param queue Queue
+ * @param accepted false to offer the same report again later
+ */
+void consumer_queue_sent(consumer_queue_t *queue, bool accepted);
+
+/**
+ * @brief The host collected the report in flight: advance to the next one
+ */
+void consumer_queue_complete(consumer_queue_t *queue);
+
+/**
+ * @brief Drop everything, e.g. when the host switches to boot protocol
+ */
+void consumer_queue_clear(consumer_queue_t *queue);
+
+/**
+ * @brief Check whether taps are queued or a report is in flight
+ */
+static inline bool consumer_queue_busy(const consumer_queue_t *queue) {
+    return queue->used != 0 || queue->in_flight;
+}
+
+#endif // CONSUMER_QUEUE_H
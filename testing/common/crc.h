@@ -0,0 +1,27 @@
+#ifndef CRC_H
+#define CRC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// CRCs for records and packets. A 16-entry (nibble) table keeps the code and
+// table tiny while costing two lookups per byte, fast enough for telemetry
+// packets at the scan rate.
+
+#define CRC32_INIT 0xFFFFFFFFu
+
+/**
+ * @brief Update a CRC-32 (IEEE 802.3, reflected, poly 0xEDB88320)
+ *
+ * Start with CRC32_INIT and invert the final value (crc32() does both).
+ */
+uint32_t crc32_update(uint32_t crc, const void *data, size_t len);
+
+/**
+ * @brief CRC-32 of a buffer (same as zlib's crc32())
+ */
+static inline uint32_t crc32(const void *data, size_t len) {
+    return crc32_update(CRC32_INIT, data, len) ^ 0xFFFFFFFFu;
+}
+
+#endif // CRC_H
@@ -0,0 +1,149 @@
+#include "flash_store.h"
+#include "crc.h"
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "hardware/flash.h"
+#include <stddef.h>
+#include <string.h>
+
+#define FLASH_STORE_SECTORS 2
+#define FLASH_STORE_SLOTS_PER_SECTOR (FLASH_SECTOR_SIZE / FLASH_STORE_SLOT_SIZE)
+#define FLASH_STORE_SLOTS (FLASH_STORE_SECTORS * FLASH_STORE_SLOTS_PER_SECTOR)
+
+#ifndef FLASH_STORE_OFFSET
+#define FLASH_STORE_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_STORE_SECTORS * FLASH_SECTOR_SIZE)
+#endif
+
+_Static_assert(FLASH_STORE_SLOT_SIZE % FLASH_PAGE_SIZE == 0, "slots must be whole pages");
+_Static_assert(FLASH_SECTOR_SIZE % FLASH_STORE_SLOT_SIZE == 0, "slots must tile a sector");
+
+// Slot layout: [0]magic [4]seq [8]len [10]reserved [12]crc32(header[0..11] + payload)
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint16_t len;
+    uint16_t reserved;
+    uint32_t crc;
+} flash_store_header_t;
+
+_Static_assert(sizeof(flash_store_header_t) == FLASH_STORE_HEADER_SIZE, "header layout");
+
+static const uint8_t *slot_ptr(uint32_t slot) {
+    return (const uint8_t *)(XIP_BASE + FLASH_STORE_OFFSET + slot * FLASH_STORE_SLOT_SIZE);
+}
+
+static uint32_t record_crc(const flash_store_header_t *header, const void *data) {
+    uint32_t crc = crc32_update(CRC32_INIT, header, offsetof(flash_store_header_t, crc));
+    return crc32_update(crc, data, header->len) ^ 0xFFFFFFFFu;
+}
+
+// Still erased: nothing has been programmed into the slot since the last erase
+static bool slot_blank(uint32_t slot) {
+    const uint32_t *words = (const uint32_t *) slot_ptr(slot);
+    for (uint32_t i = 0; i < FLASH_STORE_SLOT_SIZE / sizeof(uint32_t); i++) {
+        if (words[i] != 0xFFFFFFFFu) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool slot_valid(uint32_t slot, flash_store_header_t *header) {
+    memcpy(header, slot_ptr(slot), sizeof(*header));
+    if (header->magic == 0xFFFFFFFFu || header->len > FLASH_STORE_MAX_PAYLOAD) {
+        return false;
+    }
+    return record_crc(header, slot_ptr(slot) + FLASH_STORE_HEADER_SIZE) == header->crc;
+}
+
+// Newest valid slot of any magic (for sequencing), -1 if the store is empty
+static int newest_slot(uint32_t magic_filter, bool filter, uint32_t *seq_out) {
+    int newest = -1;
+    uint32_t newest_seq = 0;
+    for (uint32_t slot = 0; slot < FLASH_STORE_SLOTS; slot++) {
+        flash_store_header_t header;
+        if (!slot_valid(slot, &header)) continue;
+        if (filter && header.magic != magic_filter) continue;
+        if (newest < 0 || (int32_t)(header.seq - newest_seq) > 0) {
+            newest = (int) slot;
+            newest_seq = header.seq;
+        }
+    }
+    if (seq_out) *seq_out = newest_seq;
+    return newest;
+}
+
+bool flash_store_load(uint32_t magic, void *data, uint16_t len) {
+    int slot = newest_slot(magic, true, NULL);
+    if (slot < 0) {
+        return false;
+    }
+
+    flash_store_header_t header;
+    memcpy(&header, slot_ptr((uint32_t) slot), sizeof(header));
+    if (header.len != len) {
+        return false;
+    }
+    memcpy(data, slot_ptr((uint32_t) slot) + FLASH_STORE_HEADER_SIZE, len);
+    return true;
+}
+
+typedef struct {
+    uint32_t offset;
+    bool erase;
+    const uint8_t *image;
+} flash_store_write_t;
+
+// Runs with interrupts off and the other core locked out
+static void flash_store_write(void *param) {
+    const flash_store_write_t *w = (const flash_store_write_t *) param;
+    if (w->erase) {
+        flash_range_erase(w->offset & ~(FLASH_SECTOR_SIZE - 1u), FLASH_SECTOR_SIZE);
+    }
+    flash_range_program(w->offset, w->image, FLASH_STORE_SLOT_SIZE);
+}
+
+bool flash_store_save(uint32_t magic, const void *data, uint16_t len) {
+    static uint8_t image[FLASH_STORE_SLOT_SIZE];
+
+    if (len > FLASH_STORE_MAX_PAYLOAD) {
+        return false;
+    }
+
+    uint32_t seq;
+    int newest = newest_slot(0, false, &seq);
+    uint32_t slot = newest < 0 ? 0 : ((uint32_t) newest + 1) % FLASH_STORE_SLOTS;
+
+    // Write into an erased slot. Entering a sector erases it; leftovers in
+    // the sector that holds the newest record (e.g. a torn write) are
+    // skipped, never erased, so that record survives until the next sector
+    // has a newer one.
+    while (slot % FLASH_STORE_SLOTS_PER_SECTOR != 0 && !slot_blank(slot)) {
+        slot = (slot + 1) % FLASH_STORE_SLOTS;
+    }
+    bool erase = slot % FLASH_STORE_SLOTS_PER_SECTOR == 0;
+
+    flash_store_header_t header = {
+        .magic = magic,
+        .seq = newest < 0 ? 1 : seq + 1,
+        .len = len,
+        .reserved = 0xFFFF,
+    };
+    header.crc = record_crc(&header, data);
+
+    memset(image, 0xFF, sizeof(image));
+    memcpy(image, &header, sizeof(header));
+    memcpy(image + FLASH_STORE_HEADER_SIZE, data, len);
+
+    flash_store_write_t w = {
+        .offset = FLASH_STORE_OFFSET + slot * FLASH_STORE_SLOT_SIZE,
+        .erase = erase,
+        .image = image,
+    };
+    if (flash_safe_execute(flash_store_write, &w, UINT32_MAX) != PICO_OK) {
+        return false;
+    }
+
+    flash_store_header_t check;
+    return slot_valid(slot, &check) && check.seq == header.seq;
+}
@@ -0,0 +1,49 @@
+#ifndef FLASH_STORE_H
+#define FLASH_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Wear-leveled record storage in the last two sectors of flash.
+//
+// Records are appended to fixed-size slots with an increasing sequence
+// number and a CRC; loading returns the newest valid record. A sector is
+// erased only when writing moves into it, and the newest record is always
+// in the other sector at that point, so a power loss mid-write loses at
+// most the record being written; a slot left dirty by such a write is
+// skipped. With 512-byte slots each sector takes 8 saves per erase.
+//
+// Requires the Pico SDK (hardware_flash, pico_flash). When the other core is
+// running it must have called flash_safe_execute_core_init().
+
+#ifndef FLASH_STORE_SLOT_SIZE
+#define FLASH_STORE_SLOT_SIZE 512       // Multiple of FLASH_PAGE_SIZE
+#endif
+
+#define FLASH_STORE_HEADER_SIZE 16
+#define FLASH_STORE_MAX_PAYLOAD (FLASH_STORE_SLOT_SIZE - FLASH_STORE_HEADER_SIZE)
+
+/**
+ * @brief Load the newest valid record with a given magic
+ *
+ * @param magic Record type tag chosen by the caller
+ * @param data Receives the payload
+ * @param len Expected payload length
+ * @return false if no valid record of that magic and length exists
+ */
+bool flash_store_load(uint32_t magic, void *data, uint16_t len);
+
+/**
+ * @brief Append a record (erases the next sector first when needed)
+ *
+ * Blocks for a page program, plus a sector erase every few saves; the other
+ * core is paused for that time.
+ *
+ * @param magic Record type tag
+ * @param data Payload
+ * @param len Payload length (at most FLASH_STORE_MAX_PAYLOAD)
+ * @return false if the payload is too large or the flash write failed
+ */
+bool flash_store_save(uint32_t magic, const void *data, uint16_t len);
+
+#endif // FLASH_STORE_H
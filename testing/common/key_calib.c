@@ -0,0 +1,175 @@
+#include "key_calib.h"
+#include <string.h>
+
+static void set_range(key_calib_t *calib, uint16_t key, int16_t range) {
+    calib->range[key] = range;
+    uint32_t span = range ? (uint32_t)(range < 0 ? -range : range) : KEY_CALIB_DEFAULT_RANGE;
+    calib->scale[key] = ((uint32_t) KEY_CALIB_TRAVEL_MAX << 16) / span;
+}
+
+static void set_rest(key_calib_t *calib, uint16_t key, uint16_t rest) {
+    calib->rest[key] = rest;
+    calib->rest_acc[key] = (uint32_t) rest << KEY_CALIB_REST_SHIFT;
+}
+
+// A key read this far into its pressed direction is held, not resting
+static bool reseat_held(const key_calib_t *calib, uint16_t key, uint16_t raw) {
+    int32_t delta = (int32_t) raw - calib->rest[key];
+    int32_t range = calib->range[key];
+    if (range != 0 && (delta < 0) != (range < 0)) {
+        return false;
+    }
+    return (delta < 0 ? -delta : delta) >= KEY_CALIB_RESEAT_HELD;
+}
+
+// Re-take the rest of imported keys that read the same as last frame and
+// are not held down
+static void reseat(key_calib_t *calib, const uint16_t *raw) {
+    for (uint16_t key = 0; key < calib->num_keys; key++) {
+        if (!calib->reseat[key]) {
+            continue;
+        }
+        int32_t step = (int32_t) raw[key] - calib->reseat_last[key];
+        calib->reseat_last[key] = raw[key];
+        if (!calib->reseat_seen || step < -KEY_CALIB_REST_BAND || step > KEY_CALIB_REST_BAND ||
+            reseat_held(calib, key, raw[key])) {
+            continue;
+        }
+        set_rest(calib, key, raw[key]);
+        calib->reseat[key] = false;
+        calib->reseat_left--;
+    }
+    calib->reseat_seen = true;
+}
+
+bool key_calib_init(key_calib_t *calib, uint16_t num_keys, uint16_t floating_below) {
+    if (num_keys > KEY_CALIB_MAX_KEYS) {
+        return false;
+    }
+
+    memset(calib, 0, sizeof(*calib));
+    calib->num_keys = num_keys;
+    calib->floating_below = floating_below;
+    for (uint16_t key = 0; key < num_keys; key++) {
+        set_range(calib, key, 0);
+    }
+    return true;
+}
+
+void key_calib_process(key_calib_t *calib, const uint16_t *raw, uint16_t *travel) {
+    if (!calib->have_rest) {
+        for (uint16_t key = 0; key < calib->num_keys; key++) {
+            set_rest(calib, key, raw[key]);
+            if (calib->capture) {
+                set_range(calib, key, 0);
+            }
+            travel[key] = 0;
+        }
+        calib->have_rest = true;
+        calib->reseat_left = 0;
+        memset(calib->reseat, 0, sizeof(calib->reseat));
+        return;
+    }
+
+    if (calib->reseat_left > 0) {
+        reseat(calib, raw);
+    }
+
+    for (uint16_t key = 0; key < calib->num_keys; key++) {
+        uint16_t rest = calib->rest[key];
+        if (rest < calib->floating_below || raw[key] < calib->floating_below) {
+            travel[key] = 0;
+            continue;
+        }
+
+        int32_t delta = (int32_t) raw[key] - rest;
+        int32_t range = calib->range[key];
+        int32_t magnitude = delta < 0 ? -delta : delta;
+
+        if (magnitude <= KEY_CALIB_REST_BAND) {
+            // Drift tracking: exponential average of readings near rest
+            uint32_t acc = calib->rest_acc[key];
+            acc = acc - (acc >> KEY_CALIB_REST_SHIFT) + raw[key];
+            calib->rest_acc[key] = acc;
+            calib->rest[key] = (uint16_t)(acc >> KEY_CALIB_REST_SHIFT);
+        } else if (magnitude >= KEY_CALIB_MIN_RANGE && magnitude <= INT16_MAX) {
+            // Auto-range: extend the range in its learned direction; an
+            // unknown range takes the direction of the first real press
+            bool same_direction = range == 0 || (delta < 0) == (range < 0);
+            if (same_direction && magnitude > (range < 0 ? -range : range)) {
+                set_range(calib, key, (int16_t) delta);
+                range = delta;
+                calib->dirty = true;
+            }
+        }
+
+        // Travel along the pressed direction only
+        uint32_t distance;
+        if (range == 0) {
+            distance = (uint32_t) magnitude;
+        } else {
+            distance = (delta < 0) == (range < 0) ? (uint32_t) magnitude : 0;
+        }
+
+        uint32_t fraction = (distance * calib->scale[key]) >> 16;
+        if (fraction > KEY_CALIB_TRAVEL_MAX) {
+            fraction = KEY_CALIB_TRAVEL_MAX;
+        }
+        travel[key] = calib->shape ? calib->shape[fraction] : (uint16_t) fraction;
+    }
+}
+
+void key_calib_begin_capture(key_calib_t *calib) {
+    calib->capture = true;
+    calib->have_rest = false;
+}
+
+void key_calib_end_capture(key_calib_t *calib) {
+    calib->capture = false;
+    calib->dirty = true;
+}
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+size_t key_calib_export(key_calib_t *calib, uint8_t *buf, size_t size) {
+    uint16_t n = calib->num_keys;
+    size_t len = KEY_CALIB_RECORD_SIZE(n);
+    if (size < len || !calib->have_rest) {
+        return 0;
+    }
+
+    put_u16(buf, n);
+    put_u16(buf + 2, 0);
+    for (uint16_t key = 0; key < n; key++) {
+        put_u16(buf + 4 + 2 * key, calib->rest[key]);
+        put_u16(buf + 4 + 2 * n + 2 * key, (uint16_t) calib->range[key]);
+    }
+    calib->dirty = false;
+    return len;
+}
+
+bool key_calib_import(key_calib_t *calib, const uint8_t *buf, size_t len) {
+    uint16_t n = calib->num_keys;
+    if (len != KEY_CALIB_RECORD_SIZE(n) || get_u16(buf) != n) {
+        return false;
+    }
+
+    for (uint16_t key = 0; key < n; key++) {
+        set_rest(calib, key, get_u16(buf + 4 + 2 * key));
+        set_range(calib, key, (int16_t) get_u16(buf + 4 + 2 * n + 2 * key));
+        calib->reseat[key] = true;
+    }
+    calib->reseat_left = n;
+    calib->reseat_seen = false;
+    calib->have_rest = true;
+    calib->capture = false;
+    calib->dirty = false;
+    return true;
+}
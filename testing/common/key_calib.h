@@ -0,0 +1,153 @@
+#ifndef KEY_CALIB_H
+#define KEY_CALIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Per-key travel calibration for hall-effect keys.
+//
+// Each key has a rest value and a signed range (bottom-out minus rest, in
+// raw counts; hall sensors are mounted both ways round, so the sign says
+// which way the reading moves when pressed). Raw counts map to a travel of
+// 0 (rest) to KEY_CALIB_TRAVEL_MAX (bottom-out): the linear fraction of the
+// range goes through an optional 256-entry shape LUT that linearizes the
+// sensor's response to distance.
+//
+//   - Rest drifts slowly toward readings near it (temperature, ageing).
+//   - After key_calib_import() the stored ranges are kept but rest is
+//     re-taken, key by key, from the first frame in which the key reads the
+//     same as the frame before and is not held down, so drift of any size
+//     since the table was saved (temperature, a reseated magnet) is dropped.
+//   - Auto-range: a key's range grows whenever it is pressed further than
+//     seen before, so bottom-out is learned in normal use.
+//   - Capture mode: the explicit calibration pass. Rest is re-taken from the
+//     first frame and ranges restart from zero; press every key fully, then
+//     end the capture and persist the table (see key_calib_export()).
+//
+// Keys whose range is still unknown use KEY_CALIB_DEFAULT_RANGE in either
+// direction. Integer-only; no hardware dependencies, builds on the host.
+
+#ifndef KEY_CALIB_MAX_KEYS
+#define KEY_CALIB_MAX_KEYS 128
+#endif
+
+#define KEY_CALIB_TRAVEL_MAX 255
+
+// Range assumed before a key's bottom-out has been seen (raw counts)
+#ifndef KEY_CALIB_DEFAULT_RANGE
+#define KEY_CALIB_DEFAULT_RANGE 800
+#endif
+
+// Excursions smaller than this never define a range, so noise and shallow
+// presses on a fresh key keep the default range until it is pressed deeper
+#ifndef KEY_CALIB_MIN_RANGE
+#define KEY_CALIB_MIN_RANGE (KEY_CALIB_DEFAULT_RANGE / 2)
+#endif
+
+// Readings within this many counts of rest pull rest toward them
+#ifndef KEY_CALIB_REST_BAND
+#define KEY_CALIB_REST_BAND 8
+#endif
+
+// Rest tracking rate: rest moves 1/2^KEY_CALIB_REST_SHIFT of the way per frame
+#define KEY_CALIB_REST_SHIFT 8
+
+// After an import, a key read this far or further from its stored rest in
+// the pressed direction counts as held and keeps the stored rest until it
+// is let go
+#ifndef KEY_CALIB_RESEAT_HELD
+#define KEY_CALIB_RESEAT_HELD (KEY_CALIB_MIN_RANGE / 2)
+#endif
+
+typedef struct {
+    uint16_t num_keys;
+    uint16_t floating_below;                // Keys resting below this are unpopulated
+    bool     have_rest;
+    bool     capture;                       // Explicit calibration in progress
+    bool     dirty;                         // Table changed since last export
+    bool     reseat_seen;                   // reseat_last holds the previous frame
+    uint16_t reseat_left;                   // Keys whose imported rest is still to be re-taken
+    const uint8_t *shape;                   // Travel LUT, NULL = linear
+    uint32_t rest_acc[KEY_CALIB_MAX_KEYS];  // Rest << KEY_CALIB_REST_SHIFT
+    uint16_t rest[KEY_CALIB_MAX_KEYS];
+    int16_t  range[KEY_CALIB_MAX_KEYS];     // Bottom-out - rest, 0 = unknown
+    uint32_t scale[KEY_CALIB_MAX_KEYS];     // (TRAVEL_MAX << 16) / |range|
+    bool     reseat[KEY_CALIB_MAX_KEYS];    // Rest still to be re-taken after an import
+    uint16_t reseat_last[KEY_CALIB_MAX_KEYS];
+} key_calib_t;
+
+/**
+ * @brief Initialize with no rest values and unknown ranges
+ *
+ * @param calib Calibration state
+ * @param num_keys Number of keys (at most KEY_CALIB_MAX_KEYS)
+ * @param floating_below Keys resting below this raw value always read 0
+ *                       travel and never learn (0 to disable)
+ * @return false if num_keys is out of range
+ */
+bool key_calib_init(key_calib_t *calib, uint16_t num_keys, uint16_t floating_below);
+
+/**
+ * @brief Set the travel shape LUT (256 entries, fraction of range -> travel)
+ *
+ * @param shape LUT that must outlive the calibration, or NULL for linear
+ */
+static inline void key_calib_set_shape(key_calib_t *calib, const uint8_t *shape) {
+    calib->shape = shape;
+}
+
+/**
+ * @brief Map one frame of raw readings to travel, learning as it goes
+ *
+ * The first frame after init (without an imported table) or after
+ * key_calib_begin_capture() is taken as rest and reads 0 travel. After an
+ * import, each key's rest is re-taken once it is steady and not held.
+ *
+ * @param calib Calibration state
+ * @param raw num_keys raw readings
+ * @param travel Receives num_keys travel values (0-KEY_CALIB_TRAVEL_MAX)
+ */
+void key_calib_process(key_calib_t *calib, const uint16_t *raw, uint16_t *travel);
+
+/**
+ * @brief Start an explicit calibration pass (keys must be at rest now)
+ */
+void key_calib_begin_capture(key_calib_t *calib);
+
+/**
+ * @brief Finish the explicit calibration pass and mark the table dirty
+ */
+void key_calib_end_capture(key_calib_t *calib);
+
+/**
+ * @brief Convert travel to hundredths of a millimetre
+ *
+ * @param travel Travel from key_calib_process()
+ * @param total_cmm Full key travel in hundredths of a millimetre (e.g. 400)
+ */
+static inline uint16_t key_calib_travel_cmm(uint16_t travel, uint16_t total_cmm) {
+    return (uint16_t)(((uint32_t) travel * total_cmm + KEY_CALIB_TRAVEL_MAX / 2) / KEY_CALIB_TRAVEL_MAX);
+}
+
+// Serialized table: uint16 num_keys, uint16 reserved, uint16 rest[n], int16 range[n]
+#define KEY_CALIB_RECORD_SIZE(num_keys) (4 + 4 * (size_t)(num_keys))
+
+/**
+ * @brief Serialize rest and range of every key (little-endian) and clear dirty
+ *
+ * @return Bytes written, 0 if the buffer is too small or rest is unknown
+ */
+size_t key_calib_export(key_calib_t *calib, uint8_t *buf, size_t size);
+
+/**
+ * @brief Load a table produced by key_calib_export()
+ *
+ * The ranges are used as stored; rest is used until key_calib_process()
+ * re-takes it from the current readings.
+ *
+ * @return false if the record does not match num_keys; calib is unchanged
+ */
+bool key_calib_import(key_calib_t *calib, const uint8_t *buf, size_t len);
+
+#endif // KEY_CALIB_H
@@ -0,0 +1,92 @@
+#include "key_engine.h"
+#include <string.h>
+
+static bool config_valid(const key_engine_config_t *config) {
+    return config->actuation > 0 && config->release <= config->actuation &&
+           (config->rt_down == 0 || config->rt_up > 0);
+}
+
+bool key_engine_init(key_engine_t *engine, uint16_t num_keys, const key_engine_config_t *config) {
+    if (num_keys > KEY_ENGINE_MAX_KEYS || !config_valid(config)) {
+        return false;
+    }
+
+    memset(engine, 0, sizeof(*engine));
+    engine->num_keys = num_keys;
+    for (uint16_t key = 0; key < num_keys; key++) {
+        key_engine_set_config(engine, key, config);
+    }
+    return true;
+}
+
+bool key_engine_set_config(key_engine_t *engine, uint16_t key, const key_engine_config_t *config) {
+    if (key >= engine->num_keys || !config_valid(config)) {
+        return false;
+    }
+
+    engine->actuation[key] = config->actuation;
+    engine->release[key] = config->release;
+    engine->rt_down[key] = config->rt_down;
+    engine->rt_up[key] = config->rt_up;
+    engine->extreme[key] = 0;
+    engine->flags[key] = 0;
+    return true;
+}
+
+void key_engine_get_config(const key_engine_t *engine, uint16_t key, key_engine_config_t *config) {
+    config->actuation = engine->actuation[key];
+    config->release = engine->release[key];
+    config->rt_down = engine->rt_down[key];
+    config->rt_up = engine->rt_up[key];
+}
+
+uint16_t key_engine_process(key_engine_t *engine, const uint16_t *travel, uint8_t *changed) {
+    uint16_t num_changed = 0;
+
+    for (uint16_t key = 0; key < engine->num_keys; key++) {
+        uint16_t t = travel[key];
+        uint8_t flags = engine->flags[key];
+
+        // Fast path: released, outside the rapid trigger zone, above actuation
+        if (flags == 0 && t < engine->actuation[key]) {
+            continue;
+        }
+
+        uint16_t extreme = engine->extreme[key];
+        uint8_t next = flags;
+
+        if (t < engine->release[key]) {
+            // Below the release point everything resets
+            next = 0;
+        } else if (flags & KEY_ENGINE_FLAG_PRESSED) {
+            if (t > extreme) {
+                extreme = t;
+            } else if (engine->rt_down[key] && (uint32_t)t + engine->rt_up[key] <= extreme) {
+                next = KEY_ENGINE_FLAG_RT;
+                extreme = t;
+            }
+        } else if (flags & KEY_ENGINE_FLAG_RT) {
+            if (t < extreme) {
+                extreme = t;
+            } else if (t >= (uint32_t)extreme + engine->rt_down[key]) {
+                next = KEY_ENGINE_FLAG_PRESSED | KEY_ENGINE_FLAG_RT;
+                extreme = t;
+            }
+        } else if (t >= engine->actuation[key]) {
+            next = KEY_ENGINE_FLAG_PRESSED | (engine->rt_down[key] ? KEY_ENGINE_FLAG_RT : 0);
+            extreme = t;
+        }
+
+        engine->extreme[key] = extreme;
+        engine->flags[key] = next;
+
+        if ((next ^ flags) & KEY_ENGINE_FLAG_PRESSED) {
+            if (changed) {
+                changed[key >> 3] |= (uint8_t)(1u << (key & 7));
+            }
+            num_changed++;
+        }
+    }
+
+    return num_changed;
+}
@@ -0,0 +1,90 @@
+#ifndef KEY_ENGINE_H
+#define KEY_ENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Analog key engine: per-key actuation/release points and rapid trigger.
+//
+// Input is key travel in integer units (raw ADC counts away from rest, or a
+// calibrated scale), larger = pressed further. Each key:
+//   - presses when travel reaches its actuation point
+//   - always releases when travel falls below its release point
+//     (release < actuation gives static hysteresis)
+//   - with rapid trigger, while travel stays above the release point, releases
+//     after rt_up units of upward travel from the deepest point and presses
+//     again after rt_down units of downward travel from the shallowest point
+//   - with rapid trigger and a release point of 0 (continuous rapid
+//     trigger), the rapid trigger zone lasts all the way back to rest
+//
+// Configuration and state are struct-of-arrays so the per-frame loop streams
+// through a few dense arrays; idle keys below actuation take a single
+// compare. No floats, no hardware dependencies: builds on the host.
+
+#ifndef KEY_ENGINE_MAX_KEYS
+#define KEY_ENGINE_MAX_KEYS 128
+#endif
+
+#define KEY_ENGINE_BITMAP_BYTES ((KEY_ENGINE_MAX_KEYS + 7) / 8)
+
+typedef struct {
+    uint16_t actuation;     // Travel at which the key presses
+    uint16_t release;       // Travel below which the key always releases
+    uint16_t rt_down;       // Rapid trigger re-press distance (0 = rapid trigger off)
+    uint16_t rt_up;         // Rapid trigger release distance
+} key_engine_config_t;
+
+typedef struct {
+    uint16_t num_keys;
+    uint16_t actuation[KEY_ENGINE_MAX_KEYS];
+    uint16_t release[KEY_ENGINE_MAX_KEYS];
+    uint16_t rt_down[KEY_ENGINE_MAX_KEYS];
+    uint16_t rt_up[KEY_ENGINE_MAX_KEYS];
+    uint16_t extreme[KEY_ENGINE_MAX_KEYS];  // Deepest travel while pressed, shallowest while RT-released
+    uint8_t  flags[KEY_ENGINE_MAX_KEYS];
+} key_engine_t;
+
+/**
+ * @brief Initialize all keys released with the same configuration
+ *
+ * @param engine Engine state
+ * @param num_keys Number of keys (at most KEY_ENGINE_MAX_KEYS)
+ * @param config Configuration applied to every key
+ * @return false if num_keys or the configuration is out of range
+ */
+bool key_engine_init(key_engine_t *engine, uint16_t num_keys, const key_engine_config_t *config);
+
+/**
+ * @brief Change one key's configuration (its state is reset to released)
+ *
+ * @return false if the key or the configuration is out of range
+ */
+bool key_engine_set_config(key_engine_t *engine, uint16_t key, const key_engine_config_t *config);
+
+/**
+ * @brief Read back one key's configuration
+ */
+void key_engine_get_config(const key_engine_t *engine, uint16_t key, key_engine_config_t *config);
+
+/**
+ * @brief Run every key's state machine on one frame of travel
+ *
+ * @param engine Engine state
+ * @param travel num_keys travel values
+ * @param changed Optional bitmap ((num_keys + 7) / 8 bytes) of keys that
+ *                changed state; only set bits are written, clear it first
+ * @return Number of keys that changed state
+ */
+uint16_t key_engine_process(key_engine_t *engine, const uint16_t *travel, uint8_t *changed);
+
+#define KEY_ENGINE_FLAG_PRESSED 0x01
+#define KEY_ENGINE_FLAG_RT      0x02    // Inside the rapid trigger zone
+
+/**
+ * @brief Check whether a key is pressed
+ */
+static inline bool key_engine_is_pressed(const key_engine_t *engine, uint16_t key) {
+    return key < engine->num_keys && (engine->flags[key] & KEY_ENGINE_FLAG_PRESSED);
+}
+
+#endif // KEY_ENGINE_H
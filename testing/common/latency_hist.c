@@ -0,0 +1,76 @@
+#include "latency_hist.h"
+#include <stdio.h>
+#include <string.h>
+
+void latency_hist_reset(latency_hist_t *hist) {
+    memset(hist, 0, sizeof(*hist));
+    hist->min_us = UINT32_MAX;
+}
+
+void latency_hist_add(latency_hist_t *hist, uint32_t latency_us) {
+    uint32_t bucket = latency_us / LATENCY_HIST_BUCKET_US;
+    if (bucket >= LATENCY_HIST_BUCKETS) {
+        bucket = LATENCY_HIST_BUCKETS - 1;
+    }
+    hist->buckets[bucket]++;
+    hist->count++;
+    hist->sum_us += latency_us;
+    if (latency_us < hist->min_us) {
+        hist->min_us = latency_us;
+    }
+    if (latency_us > hist->max_us) {
+        hist->max_us = latency_us;
+    }
+}
+
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint16_t permille) {
+    if (hist->count == 0) {
+        return 0;
+    }
+
+    // Rank of the sample, rounded up so p100 is the last one
+    uint32_t rank = (uint32_t)(((uint64_t)hist->count * permille + 999) / 1000);
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint32_t seen = 0;
+    for (uint32_t bucket = 0; bucket < LATENCY_HIST_BUCKETS - 1; bucket++) {
+        seen += hist->buckets[bucket];
+        if (seen >= rank) {
+            uint32_t edge = (bucket + 1) * LATENCY_HIST_BUCKET_US;
+            return edge < hist->max_us ? edge : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
+
+void latency_hist_print(const latency_hist_t *hist, latency_hist_line_cb_t line_cb, void *ctx) {
+    char line[128];
+
+    line_cb(ctx, "===LATENCY_START===");
+    if (hist->count) {
+        snprintf(line, sizeof(line), "REPORTS %lu: min %lu us, avg %lu us, p50 %lu us, p99 %lu us, max %lu us",
+                 (unsigned long)hist->count, (unsigned long)hist->min_us,
+                 (unsigned long)(hist->sum_us / hist->count),
+                 (unsigned long)latency_hist_percentile(hist, 500),
+                 (unsigned long)latency_hist_percentile(hist, 990), (unsigned long)hist->max_us);
+        line_cb(ctx, line);
+        for (int b = 0; b < LATENCY_HIST_BUCKETS; b++) {
+            if (hist->buckets[b] == 0) {
+                continue;
+            }
+            if (b == LATENCY_HIST_BUCKETS - 1) {
+                snprintf(line, sizeof(line), "BUCKET %d+ us: %lu", b * LATENCY_HIST_BUCKET_US,
+                         (unsigned long)hist->buckets[b]);
+            } else {
+                snprintf(line, sizeof(line), "BUCKET %d-%d us: %lu", b * LATENCY_HIST_BUCKET_US,
+                         (b + 1) * LATENCY_HIST_BUCKET_US, (unsigned long)hist->buckets[b]);
+            }
+            line_cb(ctx, line);
+        }
+    } else {
+        line_cb(ctx, "REPORTS 0");
+    }
+    line_cb(ctx, "===LATENCY_END===");
+}
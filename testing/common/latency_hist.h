@@ -0,0 +1,64 @@
+#ifndef LATENCY_HIST_H
+#define LATENCY_HIST_H
+
+#include <stdint.h>
+
+// Fixed-bucket latency histogram for on-device instrumentation, e.g. the
+// time from the scan that detected a key change to the USB transfer that
+// carried it. Buckets are LATENCY_HIST_BUCKET_US wide; the last one also
+// counts everything beyond the range. No hardware dependencies.
+
+#ifndef LATENCY_HIST_BUCKETS
+#define LATENCY_HIST_BUCKETS 40
+#endif
+
+#ifndef LATENCY_HIST_BUCKET_US
+#define LATENCY_HIST_BUCKET_US 125
+#endif
+
+typedef struct {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t buckets[LATENCY_HIST_BUCKETS];
+} latency_hist_t;
+
+/**
+ * @brief Clear all samples
+ */
+void latency_hist_reset(latency_hist_t *hist);
+
+/**
+ * @brief Add one sample
+ */
+void latency_hist_add(latency_hist_t *hist, uint32_t latency_us);
+
+/**
+ * @brief Latency below which the given fraction of samples fall
+ *
+ * @param hist Histogram
+ * @param permille Fraction in 1/1000 (500 = median, 990 = p99)
+ * @return Upper edge of the bucket holding that sample (max_us for the
+ *         last bucket), 0 if there are no samples
+ */
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint16_t permille);
+
+/**
+ * @brief Receives one line of latency_hist_print() output
+ *
+ * @param ctx Context passed to latency_hist_print()
+ * @param line Text without a line ending
+ */
+typedef void (*latency_hist_line_cb_t)(void *ctx, const char *line);
+
+/**
+ * @brief Format the histogram as the ===LATENCY_START=== ... block
+ *
+ * One summary line (count, min, avg, p50, p99, max) and one line per
+ * non-empty bucket, handed to the callback line by line so each firmware
+ * can write them with its own output and line ending.
+ */
+void latency_hist_print(const latency_hist_t *hist, latency_hist_line_cb_t line_cb, void *ctx);
+
+#endif // LATENCY_HIST_H
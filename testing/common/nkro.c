@@ -0,0 +1,79 @@
+#include "nkro.h"
+#include <string.h>
+
+void nkro_init(nkro_t *nkro) {
+    memset(nkro, 0, sizeof(*nkro));
+}
+
+void nkro_set(nkro_t *nkro, uint8_t usage, bool pressed) {
+    if (usage >= NKRO_MODIFIER_FIRST) {
+        if (usage > NKRO_MODIFIER_LAST) {
+            return;
+        }
+        uint8_t mask = (uint8_t)(1u << (usage - NKRO_MODIFIER_FIRST));
+        uint8_t next = pressed ? (nkro->modifiers | mask) : (nkro->modifiers & ~mask);
+        if (next != nkro->modifiers) {
+            nkro->modifiers = next;
+            nkro->pending = true;
+        }
+        return;
+    }
+    if (usage == 0) {
+        return;
+    }
+
+    uint8_t *byte = &nkro->bits[usage >> 3];
+    uint8_t mask = (uint8_t)(1u << (usage & 7));
+    if (((*byte & mask) != 0) == pressed) {
+        return;
+    }
+    *byte ^= mask;
+    nkro->num_keys = pressed ? nkro->num_keys + 1 : nkro->num_keys - 1;
+    nkro->pending = true;
+}
+
+bool nkro_is_set(const nkro_t *nkro, uint8_t usage) {
+    if (usage >= NKRO_MODIFIER_FIRST) {
+        return usage <= NKRO_MODIFIER_LAST &&
+               (nkro->modifiers & (1u << (usage - NKRO_MODIFIER_FIRST))) != 0;
+    }
+    return (nkro->bits[usage >> 3] & (1u << (usage & 7))) != 0;
+}
+
+void nkro_clear(nkro_t *nkro) {
+    if (nkro->modifiers == 0 && nkro->num_keys == 0) {
+        return;
+    }
+    nkro->modifiers = 0;
+    nkro->num_keys = 0;
+    memset(nkro->bits, 0, sizeof(nkro->bits));
+    nkro->pending = true;
+}
+
+uint8_t nkro_build_report(const nkro_t *nkro, bool boot, uint8_t *out) {
+    if (!boot) {
+        out[0] = nkro->modifiers;
+        memcpy(&out[1], nkro->bits, NKRO_BITMAP_BYTES);
+        return NKRO_REPORT_SIZE;
+    }
+
+    memset(out, 0, NKRO_BOOT_REPORT_SIZE);
+    out[0] = nkro->modifiers;
+    uint8_t *keys = &out[2];
+    if (nkro->num_keys > NKRO_BOOT_KEYS) {
+        memset(keys, NKRO_ERROR_ROLLOVER, NKRO_BOOT_KEYS);
+        return NKRO_BOOT_REPORT_SIZE;
+    }
+
+    // At most six bits are set; skip empty bytes
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < NKRO_BITMAP_BYTES && count < nkro->num_keys; i++) {
+        uint8_t byte = nkro->bits[i];
+        while (byte) {
+            uint8_t bit = (uint8_t)__builtin_ctz(byte);
+            keys[count++] = (uint8_t)(i * 8 + bit);
+            byte &= (uint8_t)(byte - 1);
+        }
+    }
+    return NKRO_BOOT_REPORT_SIZE;
+}
@@ -0,0 +1,128 @@
+#ifndef NKRO_H
+#define NKRO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// N-key rollover keyboard state as a bitmap over the keyboard usage page.
+//
+// Report protocol sends NKRO_REPORT_SIZE bytes: one modifier byte (usages
+// 0xE0-0xE7) followed by one bit for every usage 0x00-0xDF, so any number
+// of keys can be down at once. When the host selects the boot protocol
+// (BIOS, boot loaders) the same state is sent as the standard 8-byte boot
+// report instead; more than six keys then report ErrorRollOver as the HID
+// spec requires.
+//
+// Set/clear is O(1). Only changes to the state mark a report as pending, so
+// the USB side sends a report when something changed and never otherwise.
+// No hardware dependencies: builds on the host.
+
+#define NKRO_MODIFIER_FIRST 0xE0        // Left Control
+#define NKRO_MODIFIER_LAST 0xE7         // Right GUI
+#define NKRO_BITMAP_USAGES 0xE0         // Usages 0x00-0xDF are in the bitmap
+#define NKRO_BITMAP_BYTES (NKRO_BITMAP_USAGES / 8)
+#define NKRO_REPORT_SIZE (1 + NKRO_BITMAP_BYTES)
+#define NKRO_BOOT_REPORT_SIZE 8
+#define NKRO_BOOT_KEYS 6
+#define NKRO_ERROR_ROLLOVER 0x01
+
+// Report descriptor for the NKRO report (report protocol). Pass
+// NKRO_REPORT_ID(id) when the interface carries other reports too. The LED
+// output report matches the boot keyboard so hosts can drive the lock LEDs
+// in either protocol.
+#define NKRO_REPORT_ID(id) 0x85, (id),
+#define NKRO_REPORT_DESC(...) \
+    0x05, 0x01,         /* Usage Page (Generic Desktop) */          \
+    0x09, 0x06,         /* Usage (Keyboard) */                      \
+    0xA1, 0x01,         /* Collection (Application) */              \
+    __VA_ARGS__                                                     \
+    0x05, 0x07,         /*   Usage Page (Keyboard/Keypad) */        \
+    0x19, 0xE0,         /*   Usage Minimum (Left Control) */        \
+    0x29, 0xE7,         /*   Usage Maximum (Right GUI) */           \
+    0x15, 0x00,         /*   Logical Minimum (0) */                 \
+    0x25, 0x01,         /*   Logical Maximum (1) */                 \
+    0x75, 0x01,         /*   Report Size (1) */                     \
+    0x95, 0x08,         /*   Report Count (8) */                    \
+    0x81, 0x02,         /*   Input (Data, Variable, Absolute) */    \
+    0x05, 0x08,         /*   Usage Page (LEDs) */                   \
+    0x19, 0x01,         /*   Usage Minimum (Num Lock) */            \
+    0x29, 0x05,         /*   Usage Maximum (Kana) */                \
+    0x95, 0x05,         /*   Report Count (5) */                    \
+    0x91, 0x02,         /*   Output (Data, Variable, Absolute) */   \
+    0x95, 0x03,         /*   Report Count (3) */                    \
+    0x91, 0x01,         /*   Output (Constant) */                   \
+    0x05, 0x07,         /*   Usage Page (Keyboard/Keypad) */        \
+    0x19, 0x00,         /*   Usage Minimum (0) */                   \
+    0x29, NKRO_BITMAP_USAGES - 1, /* Usage Maximum (0xDF) */        \
+    0x95, NKRO_BITMAP_USAGES,     /* Report Count (224) */          \
+    0x81, 0x02,         /*   Input (Data, Variable, Absolute) */    \
+    0xC0                /* End Collection */
+
+typedef struct {
+    uint8_t modifiers;
+    uint8_t bits[NKRO_BITMAP_BYTES];
+    uint8_t num_keys;                   // Bits set in bits[]
+    bool    pending;                    // Changed since the last nkro_mark_sent()
+} nkro_t;
+
+/**
+ * @brief Start with no keys down and nothing pending
+ */
+void nkro_init(nkro_t *nkro);
+
+/**
+ * @brief Press or release one usage (modifiers included)
+ *
+ * Usage 0 and usages above NKRO_MODIFIER_LAST are ignored.
+ */
+void nkro_set(nkro_t *nkro, uint8_t usage, bool pressed);
+
+/**
+ * @brief Check whether a usage is down
+ */
+bool nkro_is_set(const nkro_t *nkro, uint8_t usage);
+
+/**
+ * @brief Release everything (pending if anything was down)
+ */
+void nkro_clear(nkro_t *nkro);
+
+/**
+ * @brief Force the next report, e.g. after the host switches protocol
+ */
+static inline void nkro_invalidate(nkro_t *nkro) {
+    nkro->pending = true;
+}
+
+/**
+ * @brief Check whether the state changed since the last report was sent
+ */
+static inline bool nkro_pending(const nkro_t *nkro) {
+    return nkro->pending;
+}
+
+/**
+ * @brief Report length for the protocol in use
+ */
+static inline uint8_t nkro_report_size(bool boot) {
+    return boot ? NKRO_BOOT_REPORT_SIZE : NKRO_REPORT_SIZE;
+}
+
+/**
+ * @brief Build the report for the current state
+ *
+ * @param nkro State
+ * @param boot true for the 8-byte boot protocol report
+ * @param out NKRO_REPORT_SIZE bytes (NKRO_BOOT_REPORT_SIZE for boot)
+ * @return Report length in bytes
+ */
+uint8_t nkro_build_report(const nkro_t *nkro, bool boot, uint8_t *out);
+
+/**
+ * @brief Record that the current state reached the host
+ */
+static inline void nkro_mark_sent(nkro_t *nkro) {
+    nkro->pending = false;
+}
+
+#endif // NKRO_H
@@ -0,0 +1,114 @@
+#include "power_mode.h"
+#include <string.h>
+
+static void set_tier(power_mode_t *pm, power_tier_t tier) {
+    if (tier == pm->tier) {
+        return;
+    }
+    pm->tier = tier;
+    pm->changed = true;
+    pm->slice = 0;
+    // The new tier's settings read differently: re-reference every channel
+    memset(pm->armed, 0, sizeof(pm->armed));
+    pm->stats.entered[tier]++;
+}
+
+bool power_mode_init(power_mode_t *pm, uint16_t num_channels, uint16_t num_groups,
+                     const power_config_t *config, uint32_t now_us) {
+    if (num_channels == 0 || num_channels > POWER_MODE_MAX_CHANNELS ||
+        num_groups == 0 || num_groups > num_channels) {
+        return false;
+    }
+    for (int tier = 0; tier < POWER_TIER_COUNT; tier++) {
+        if (config->tier[tier].slices == 0 || config->tier[tier].slices > num_groups) {
+            return false;
+        }
+    }
+
+    memset(pm, 0, sizeof(*pm));
+    pm->config = *config;
+    pm->num_channels = num_channels;
+    pm->num_groups = num_groups;
+    pm->tier = POWER_TIER_ACTIVE;
+    pm->last_activity_us = now_us;
+    pm->stats.entered[POWER_TIER_ACTIVE] = 1;
+    latency_hist_reset(&pm->stats.wake_latency);
+    return true;
+}
+
+power_tier_t power_mode_update(power_mode_t *pm, uint32_t now_us, uint8_t slice,
+                               const uint8_t *travel, bool any_pressed) {
+    power_tier_t tier = pm->tier;
+    uint8_t slices = pm->config.tier[tier].slices;
+    pm->stats.scans[tier]++;
+
+    // First full-rate scan since the wake
+    if (pm->wake_pending && tier == POWER_TIER_ACTIVE) {
+        latency_hist_add(&pm->stats.wake_latency, now_us - pm->wake_from_us);
+        pm->wake_pending = false;
+    }
+
+    bool activity = any_pressed;
+    uint32_t quiet_age_us = 0;  // Longest a moved channel had gone unscanned
+    for (uint16_t ch = 0; ch < pm->num_channels; ch++) {
+        if (slices > 1 && (ch % pm->num_groups) % slices != slice) {
+            continue;
+        }
+        uint8_t bit = (uint8_t)(1u << (ch & 7));
+        if (!(pm->armed[ch >> 3] & bit)) {
+            pm->ref[ch] = travel[ch];
+            pm->armed[ch >> 3] |= bit;
+        } else {
+            int delta = (int) travel[ch] - (int) pm->ref[ch];
+            if (delta >= pm->config.wake_travel || -delta >= pm->config.wake_travel) {
+                activity = true;
+                uint32_t age = now_us - pm->sampled_us[ch];
+                if (age > quiet_age_us) {
+                    quiet_age_us = age;
+                }
+            }
+        }
+        pm->sampled_us[ch] = now_us;
+    }
+
+    if (activity) {
+        pm->last_activity_us = now_us;
+        if (tier != POWER_TIER_ACTIVE) {
+            pm->stats.wakes++;
+            pm->wake_pending = true;
+            // A key already down with no reference to compare against: it
+            // could have moved any time since its channel was last covered
+            if (quiet_age_us == 0) {
+                quiet_age_us = pm->config.tier[tier].interval_us * slices;
+            }
+            pm->wake_from_us = now_us - quiet_age_us;
+            set_tier(pm, POWER_TIER_ACTIVE);
+        } else {
+            // References follow the keys while they move
+            memcpy(pm->ref, travel, pm->num_channels);
+        }
+        return pm->tier;
+    }
+
+    uint32_t idle_ms = (now_us - pm->last_activity_us) / 1000;
+    if (idle_ms >= pm->config.sleep_after_ms) {
+        set_tier(pm, POWER_TIER_SLEEP);
+    } else if (idle_ms >= pm->config.idle_after_ms && tier == POWER_TIER_ACTIVE) {
+        set_tier(pm, POWER_TIER_IDLE);
+    }
+    if (pm->tier == tier && slices > 1) {
+        pm->slice = (uint8_t)((slice + 1) % slices);
+    }
+    return pm->tier;
+}
+
+void power_mode_poke(power_mode_t *pm, uint32_t now_us) {
+    pm->last_activity_us = now_us;
+    set_tier(pm, POWER_TIER_ACTIVE);
+}
+
+bool power_mode_take_change(power_mode_t *pm) {
+    bool changed = pm->changed;
+    pm->changed = false;
+    return changed;
+}
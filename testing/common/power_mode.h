@@ -0,0 +1,137 @@
+#ifndef POWER_MODE_H
+#define POWER_MODE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "latency_hist.h"
+
+// Tiered scan power policy. The scan loop reports every scan and the policy
+// tells it how to run the next one:
+//
+//   ACTIVE  full-rate scan of every channel, LEDs at full brightness
+//   IDLE    after idle_after_ms without activity: lower scan rate, fewer
+//           oversampling passes and a shorter settle, LEDs dimmed
+//   SLEEP   after sleep_after_ms: the channels are split into slices and
+//           each (slow) scan covers one slice in turn, LEDs off
+//
+// Activity is any pressed key, a channel's travel moving wake_travel or
+// more from its reference, or power_mode_poke() (USB, encoder, commands).
+// In IDLE and SLEEP the first such change switches straight back to ACTIVE.
+// References are taken at the last activity and again from each channel's
+// first scan in a new tier, so the coarser low-power readings never count
+// as a change on their own.
+//
+// Wake latency is measured from the last scan in which the waking channel
+// was still quiet to the first full-rate scan after the wake: how long a
+// travel change could have waited for the scan to catch up. A press can
+// start up to the time the key takes to move wake_travel before that.
+//
+// Channels belong to num_groups groups (channel % num_groups), the unit a
+// scan engine can skip: a select step of a shared mux, or a single ADC
+// input. In a tier with N slices, scan k covers the groups g with
+// g % N == k % N. No hardware dependencies: builds on the host.
+
+#ifndef POWER_MODE_MAX_CHANNELS
+#define POWER_MODE_MAX_CHANNELS 128
+#endif
+
+typedef enum {
+    POWER_TIER_ACTIVE,
+    POWER_TIER_IDLE,
+    POWER_TIER_SLEEP,
+    POWER_TIER_COUNT,
+} power_tier_t;
+
+typedef struct {
+    uint32_t interval_us;       // Scan period, 0 = as fast as the engine runs
+    uint8_t  slices;            // Scans to cover every group once (1 = all each scan)
+    uint8_t  oversample;        // Passes per sample, 0 = engine default
+    uint16_t settle_us;         // Settle cap per step, 0 = engine default
+    uint8_t  led_brightness;    // LED scale, 255 = as set
+} power_tier_config_t;
+
+typedef struct {
+    power_tier_config_t tier[POWER_TIER_COUNT];
+    uint32_t idle_after_ms;     // No activity for this long: ACTIVE -> IDLE
+    uint32_t sleep_after_ms;    // No activity for this long: -> SLEEP
+    uint8_t  wake_travel;       // Travel change (0-255) that counts as activity
+} power_config_t;
+
+typedef struct {
+    uint32_t wakes;                             // Low-power tier -> ACTIVE on travel
+    uint32_t entered[POWER_TIER_COUNT];         // Times each tier was entered
+    uint32_t scans[POWER_TIER_COUNT];           // Scans reported in each tier
+    latency_hist_t wake_latency;
+} power_mode_stats_t;
+
+typedef struct {
+    power_config_t config;
+    uint16_t num_channels;
+    uint16_t num_groups;
+    power_tier_t tier;
+    bool     changed;                           // Tier changed since power_mode_take_change()
+    uint8_t  slice;                             // Slice of the next scan
+    uint32_t last_activity_us;
+    bool     wake_pending;                      // Waiting for the first full-rate scan
+    uint32_t wake_from_us;
+    uint8_t  ref[POWER_MODE_MAX_CHANNELS];      // Travel to compare against
+    uint8_t  armed[(POWER_MODE_MAX_CHANNELS + 7) / 8];  // ref is valid
+    uint32_t sampled_us[POWER_MODE_MAX_CHANNELS];       // Last scan that covered the channel
+    power_mode_stats_t stats;
+} power_mode_t;
+
+/**
+ * @brief Start in ACTIVE with every channel's reference taken from the next scan
+ *
+ * @param pm Policy state
+ * @param num_channels Number of channels (at most POWER_MODE_MAX_CHANNELS)
+ * @param num_groups Groups a scan engine can skip (channel % num_groups)
+ * @param config Tier settings and timeouts
+ * @param now_us Current time
+ * @return false if an argument is out of range
+ */
+bool power_mode_init(power_mode_t *pm, uint16_t num_channels, uint16_t num_groups,
+                     const power_config_t *config, uint32_t now_us);
+
+/**
+ * @brief Settings for the current tier
+ */
+static inline const power_tier_config_t *power_mode_tier_config(const power_mode_t *pm) {
+    return &pm->config.tier[pm->tier];
+}
+
+/**
+ * @brief Check whether the next scan covers a group
+ */
+static inline bool power_mode_scan_group(const power_mode_t *pm, uint16_t group) {
+    uint8_t slices = power_mode_tier_config(pm)->slices;
+    return slices <= 1 || group % slices == pm->slice;
+}
+
+/**
+ * @brief Report a completed scan
+ *
+ * @param pm Policy state
+ * @param now_us Time of the scan
+ * @param slice Slice the scan covered (power_mode_t.slice when it started)
+ * @param travel Travel of every channel, 0 = rest to 255 = bottom-out;
+ *               only the channels in the slice are looked at
+ * @param any_pressed true if the key engine has a key down
+ * @return Tier for the next scan
+ */
+power_tier_t power_mode_update(power_mode_t *pm, uint32_t now_us, uint8_t slice,
+                               const uint8_t *travel, bool any_pressed);
+
+/**
+ * @brief Count activity that did not come from the keys
+ *
+ * Switches to ACTIVE without counting a wake.
+ */
+void power_mode_poke(power_mode_t *pm, uint32_t now_us);
+
+/**
+ * @brief Check and clear whether the tier changed since the last call
+ */
+bool power_mode_take_change(power_mode_t *pm);
+
+#endif // POWER_MODE_H
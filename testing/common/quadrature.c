@@ -0,0 +1,67 @@
+#include "quadrature.h"
+
+// Indexed by previous state << 2 | new state. Gray code order of a forward
+// turn is 00 -> 01 -> 11 -> 10 -> 00; 2 marks a skipped state.
+static const int8_t transition[16] = {
+     0, +1, -1,  2,     // from 00
+    -1,  0,  2, +1,     // from 01
+    +1,  2,  0, -1,     // from 10
+     2, -1, +1,  0,     // from 11
+};
+
+void quad_decoder_init(quad_decoder_t *decoder, uint8_t state) {
+    decoder->state = state & 3;
+    decoder->steps = 0;
+    decoder->detents = 0;
+    decoder->errors = 0;
+}
+
+int8_t quad_decoder_update(quad_decoder_t *decoder, uint8_t state) {
+    state &= 3;
+    int8_t step = transition[(decoder->state << 2) | state];
+    decoder->state = state;
+
+    if (step == 2) {
+        // Direction unknown; the steps counted so far still stand
+        decoder->errors++;
+        return 0;
+    }
+
+    decoder->steps += step;
+    if (decoder->steps >= QUAD_STEPS_PER_DETENT) {
+        decoder->steps -= QUAD_STEPS_PER_DETENT;
+        decoder->detents++;
+        return 1;
+    }
+    if (decoder->steps <= -QUAD_STEPS_PER_DETENT) {
+        decoder->steps += QUAD_STEPS_PER_DETENT;
+        decoder->detents--;
+        return -1;
+    }
+    return 0;
+}
+
+void quad_accel_init(quad_accel_t *accel) {
+    accel->last_us = 0;
+    accel->have_last = false;
+}
+
+int32_t quad_accel_steps(quad_accel_t *accel, int32_t detents, uint32_t now_us) {
+    if (detents == 0) {
+        return 0;
+    }
+
+    int32_t mult = 1;
+    if (accel->have_last) {
+        uint32_t count = (uint32_t)(detents < 0 ? -detents : detents);
+        uint32_t per_detent = (now_us - accel->last_us) / count;
+        if (per_detent < QUAD_ACCEL_FAST_US) {
+            mult = QUAD_ACCEL_FAST_MULT;
+        } else if (per_detent < QUAD_ACCEL_MEDIUM_US) {
+            mult = QUAD_ACCEL_MEDIUM_MULT;
+        }
+    }
+    accel->last_us = now_us;
+    accel->have_last = true;
+    return detents * mult;
+}
@@ -0,0 +1,78 @@
+#ifndef QUADRATURE_H
+#define QUADRATURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Quadrature (rotary encoder) decoding with a full 4-state transition table.
+//
+// Feed every change of the two encoder lines (from a GPIO edge interrupt)
+// to quad_decoder_update() as a 2-bit state (A << 1 | B). Each valid
+// transition moves the position one step in its direction; a change of
+// both lines at once (a missed edge) is counted as an error and ignored.
+// Contact bounce is a back-and-forth between two adjacent states, so it
+// cancels out. A detent is reported every QUAD_STEPS_PER_DETENT steps.
+//
+// quad_accel_steps() turns detents into volume-style steps, multiplying them
+// when detents arrive quickly. No hardware dependencies: builds on the host.
+
+#ifndef QUAD_STEPS_PER_DETENT
+#define QUAD_STEPS_PER_DETENT 4         // Full quadrature cycle per click (EC11)
+#endif
+
+// Acceleration: detents closer together than these get the multipliers
+#ifndef QUAD_ACCEL_FAST_US
+#define QUAD_ACCEL_FAST_US 15000
+#endif
+#ifndef QUAD_ACCEL_MEDIUM_US
+#define QUAD_ACCEL_MEDIUM_US 40000
+#endif
+#define QUAD_ACCEL_FAST_MULT 4
+#define QUAD_ACCEL_MEDIUM_MULT 2
+
+typedef struct {
+    uint8_t  state;                 // Last 2-bit line state
+    int8_t   steps;                 // Steps since the last detent
+    int32_t  detents;               // Signed detent count, + = A leads B
+    uint32_t errors;                // Transitions with both lines changed
+} quad_decoder_t;
+
+typedef struct {
+    uint32_t last_us;               // Time of the last detent
+    bool     have_last;
+} quad_accel_t;
+
+/**
+ * @brief Start from the current line state
+ *
+ * @param decoder Decoder state
+ * @param state Current lines, A << 1 | B
+ */
+void quad_decoder_init(quad_decoder_t *decoder, uint8_t state);
+
+/**
+ * @brief Apply a new line state
+ *
+ * @param decoder Decoder state
+ * @param state Lines after the edge, A << 1 | B
+ * @return Detents completed by this edge: -1, 0 or +1
+ */
+int8_t quad_decoder_update(quad_decoder_t *decoder, uint8_t state);
+
+/**
+ * @brief Reset acceleration (the next detent counts as slow)
+ */
+void quad_accel_init(quad_accel_t *accel);
+
+/**
+ * @brief Scale detents by how fast they arrive
+ *
+ * @param accel Acceleration state
+ * @param detents Detents since the last call (signed)
+ * @param now_us Current time
+ * @return Signed steps: detents times 1, QUAD_ACCEL_MEDIUM_MULT or
+ *         QUAD_ACCEL_FAST_MULT depending on the time per detent
+ */
+int32_t quad_accel_steps(quad_accel_t *accel, int32_t detents, uint32_t now_us);
+
+#endif // QUADRATURE_H
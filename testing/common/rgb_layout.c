@@ -0,0 +1,73 @@
+// Generated by tools/kle_layout.py from seung65_kle_layout.json; do not edit.
+#include "rgb_layout.h"
+
+_Static_assert(RGB_LAYOUT_LED_COUNT == 66, "layout size");
+
+const rgb_layout_point_t rgb_layout[RGB_LAYOUT_LED_COUNT] = {
+    {  7,  6},   //  0 Esc
+    { 21,  6},   //  1 1
+    { 35,  6},   //  2 2
+    { 49,  6},   //  3 3
+    { 63,  6},   //  4 4
+    { 77,  6},   //  5 5
+    { 91,  6},   //  6 6
+    {105,  6},   //  7 7
+    {119,  6},   //  8 8
+    {133,  6},   //  9 9
+    {147,  6},   // 10 0
+    {161,  6},   // 11 -
+    {175,  6},   // 12 =
+    {196,  6},   // 13 Backspace
+    { 10, 19},   // 14 Tab
+    { 28, 19},   // 15 Q
+    { 42, 19},   // 16 W
+    { 56, 19},   // 17 E
+    { 70, 19},   // 18 R
+    { 84, 19},   // 19 T
+    { 98, 19},   // 20 Y
+    {112, 19},   // 21 U
+    {126, 19},   // 22 I
+    {140, 19},   // 23 O
+    {154, 19},   // 24 P
+    {168, 19},   // 25 [
+    {182, 19},   // 26 ]
+    {200, 19},   // 27 Backslash
+    {217, 19},   // 28 Delete
+    { 12, 32},   // 29 Caps Lock
+    { 32, 32},   // 30 A
+    { 46, 32},   // 31 S
+    { 60, 32},   // 32 D
+    { 74, 32},   // 33 F
+    { 88, 32},   // 34 G
+    {102, 32},   // 35 H
+    {116, 32},   // 36 J
+    {130, 32},   // 37 K
+    {144, 32},   // 38 L
+    {158, 32},   // 39 ;
+    {172, 32},   // 40 '
+    {194, 32},   // 41 Enter
+    {217, 32},   // 42 PgUp
+    { 16, 45},   // 43 Shift
+    { 38, 45},   // 44 Z
+    { 52, 45},   // 45 X
+    { 66, 45},   // 46 C
+    { 80, 45},   // 47 V
+    { 94, 45},   // 48 B
+    {108, 45},   // 49 N
+    {122, 45},   // 50 M
+    {136, 45},   // 51 ,
+    {150, 45},   // 52 .
+    {164, 45},   // 53 /
+    {184, 45},   // 54 Shift
+    {203, 45},   // 55 Up
+    {217, 45},   // 56 PgDn
+    {  9, 58},   // 57 Ctrl
+    { 26, 58},   // 58 Win
+    { 44, 58},   // 59 LAlt
+    { 96, 58},   // 60 Space
+    {149, 58},   // 61 RAlt
+    {166, 58},   // 62 Fn
+    {189, 58},   // 63 Left
+    {203, 58},   // 64 Down
+    {217, 58},   // 65 Right
+};
@@ -0,0 +1,20 @@
+#ifndef RGB_LAYOUT_H
+#define RGB_LAYOUT_H
+
+#include <stdint.h>
+
+// Key centres of the Seung65 layout (seung65_kle_layout.json) for RGB
+// effects, one LED per key in KLE order (the same order as the c_hid
+// keymap). x runs 0-224 left to right, y 0-64 top to bottom. The table is
+// generated by tools/kle_layout.py; regenerate it when the layout changes.
+
+#define RGB_LAYOUT_LED_COUNT 66
+
+typedef struct {
+    uint8_t x;
+    uint8_t y;
+} rgb_layout_point_t;
+
+extern const rgb_layout_point_t rgb_layout[RGB_LAYOUT_LED_COUNT];
+
+#endif // RGB_LAYOUT_H
@@ -0,0 +1,241 @@
+#include "rgb_matrix.h"
+#include <string.h>
+
+// Gamma 2.2: perceived brightness steps to PWM duty
+static const uint8_t gamma8[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+      3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+      6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+     12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+     20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+     30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+     42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+     56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+     73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+     91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+    113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+    137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+    163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+    192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255,
+};
+
+// First quarter of a sine wave, 0-255
+static const uint8_t quarter_sine[65] = {
+      0,   6,  13,  19,  25,  31,  37,  44,  50,  56,  62,  68,  74,  80,  86,  92,
+     98, 103, 109, 115, 120, 126, 131, 136, 142, 147, 152, 157, 162, 167, 171, 176,
+    180, 185, 189, 193, 197, 201, 205, 208, 212, 215, 219, 222, 225, 228, 231, 233,
+    236, 238, 240, 242, 244, 246, 247, 249, 250, 251, 252, 253, 254, 254, 255, 255,
+    255,
+};
+
+#define BREATHING_MIN 16                // Lowest value of the breathing effect
+#define RIPPLE_BASE 48                  // Value of keys no ring touches
+#define RIPPLE_RANGE 256                // Radius at which a ring has faded out
+#define TRAVEL_MIN 32                   // Value of keys at rest
+
+// Sine over a 256-step period, 1-255 centred on 128
+static inline uint8_t sin8(uint8_t phase) {
+    uint8_t idx = phase & 63;
+    uint8_t s = quarter_sine[(phase & 64) ? 64 - idx : idx] >> 1;
+    return (phase & 128) ? (uint8_t)(128 - s) : (uint8_t)(128 + s);
+}
+
+static rgb_matrix_rgb_t hsv_to_rgb(uint8_t h, uint8_t s, uint8_t v) {
+    rgb_matrix_rgb_t c;
+    if (s == 0) {
+        c.r = c.g = c.b = v;
+        return c;
+    }
+
+    uint8_t region = h / 43;
+    uint16_t rem = (uint16_t)(h - region * 43) * 6;
+    uint8_t p = (uint8_t)((v * (255 - s)) >> 8);
+    uint8_t q = (uint8_t)((v * (255 - ((s * rem) >> 8))) >> 8);
+    uint8_t t = (uint8_t)((v * (255 - ((s * (255 - rem)) >> 8))) >> 8);
+
+    switch (region) {
+        case 0:  c.r = v; c.g = t; c.b = p; break;
+        case 1:  c.r = q; c.g = v; c.b = p; break;
+        case 2:  c.r = p; c.g = v; c.b = t; break;
+        case 3:  c.r = p; c.g = q; c.b = v; break;
+        case 4:  c.r = t; c.g = p; c.b = v; break;
+        default: c.r = v; c.g = p; c.b = q; break;
+    }
+    return c;
+}
+
+static inline bool held_get(const rgb_matrix_t *matrix, uint8_t led) {
+    return (matrix->held[led >> 3] >> (led & 7)) & 1;
+}
+
+static inline void held_put(rgb_matrix_t *matrix, uint8_t led, bool held) {
+    if (held) {
+        matrix->held[led >> 3] |= (uint8_t)(1u << (led & 7));
+    } else {
+        matrix->held[led >> 3] &= (uint8_t)~(1u << (led & 7));
+    }
+}
+
+static inline uint32_t ripple_radius(const rgb_matrix_t *matrix, uint8_t slot) {
+    uint32_t age_ms = matrix->frame_ms - matrix->ripple_start_ms[slot];
+    return (age_ms * (matrix->speed + 32u)) >> 9;
+}
+
+// Start, grow and retire rings from the travel input; once per frame
+static void update_ripples(rgb_matrix_t *matrix) {
+    const uint8_t *travel = matrix->travel;
+
+    if (travel) {
+        for (uint8_t led = 0; led < matrix->num_leds; led++) {
+            uint8_t t = travel[led];
+            if (!held_get(matrix, led)) {
+                if (t >= RGB_RIPPLE_TRIGGER) {
+                    uint8_t slot = matrix->ripple_next;
+                    matrix->ripple_next = (uint8_t)((slot + 1) % RGB_RIPPLE_MAX);
+                    matrix->ripple_led[slot] = led;
+                    matrix->ripple_peak[slot] = t;
+                    matrix->ripple_start_ms[slot] = matrix->frame_ms;
+                    held_put(matrix, led, true);
+                }
+            } else if (t < RGB_RIPPLE_RELEASE) {
+                held_put(matrix, led, false);
+            }
+        }
+    }
+
+    for (uint8_t slot = 0; slot < RGB_RIPPLE_MAX; slot++) {
+        if (matrix->ripple_peak[slot] == 0) {
+            continue;
+        }
+        if (ripple_radius(matrix, slot) >= RIPPLE_RANGE) {
+            matrix->ripple_peak[slot] = 0;
+            continue;
+        }
+        // A ring is as bright as its key's deepest travel while held
+        uint8_t led = matrix->ripple_led[slot];
+        if (travel && held_get(matrix, led) && travel[led] > matrix->ripple_peak[slot]) {
+            matrix->ripple_peak[slot] = travel[led];
+        }
+    }
+}
+
+static uint8_t ripple_value(const rgb_matrix_t *matrix, uint8_t led) {
+    uint32_t v = RIPPLE_BASE;
+    if (matrix->travel) {
+        v += matrix->travel[led];
+    }
+
+    uint8_t x = rgb_layout[led].x;
+    uint8_t y = rgb_layout[led].y;
+    for (uint8_t slot = 0; slot < RGB_RIPPLE_MAX && v < 255; slot++) {
+        uint8_t peak = matrix->ripple_peak[slot];
+        if (peak == 0) {
+            continue;
+        }
+        // Octagonal distance: max + 3/8 min, within 7% of Euclidean
+        const rgb_layout_point_t *o = &rgb_layout[matrix->ripple_led[slot]];
+        uint32_t dx = x > o->x ? x - o->x : o->x - x;
+        uint32_t dy = y > o->y ? y - o->y : o->y - y;
+        uint32_t dist = dx > dy ? dx + ((dy * 3) >> 3) : dy + ((dx * 3) >> 3);
+
+        uint32_t radius = ripple_radius(matrix, slot);
+        uint32_t band = dist > radius ? dist - radius : radius - dist;
+        if (band >= RGB_RIPPLE_WIDTH || radius >= RIPPLE_RANGE) {
+            continue;
+        }
+        uint32_t amp = (peak * (RIPPLE_RANGE - radius)) / RIPPLE_RANGE;
+        v += (amp * (RGB_RIPPLE_WIDTH - band)) / RGB_RIPPLE_WIDTH;
+    }
+    return v > 255 ? 255 : (uint8_t)v;
+}
+
+void rgb_matrix_init(rgb_matrix_t *matrix, uint8_t num_leds) {
+    memset(matrix, 0, sizeof(*matrix));
+    matrix->num_leds = num_leds < RGB_LAYOUT_LED_COUNT ? num_leds : RGB_LAYOUT_LED_COUNT;
+    matrix->effect = RGB_EFFECT_SOLID;
+    matrix->sat = 255;
+    matrix->speed = 128;
+    rgb_matrix_set_brightness(matrix, 255);
+}
+
+void rgb_matrix_set_effect(rgb_matrix_t *matrix, uint8_t effect) {
+    if (effect < RGB_EFFECT_COUNT) {
+        matrix->effect = effect;
+    }
+}
+
+void rgb_matrix_set_color(rgb_matrix_t *matrix, uint8_t hue, uint8_t sat) {
+    matrix->hue = hue;
+    matrix->sat = sat;
+}
+
+void rgb_matrix_set_speed(rgb_matrix_t *matrix, uint8_t speed) {
+    matrix->speed = speed;
+}
+
+void rgb_matrix_set_brightness(rgb_matrix_t *matrix, uint8_t brightness) {
+    matrix->brightness = brightness;
+    for (uint16_t i = 0; i < 256; i++) {
+        matrix->out_lut[i] = gamma8[(i * brightness + 127) / 255];
+    }
+}
+
+void rgb_matrix_set_travel(rgb_matrix_t *matrix, const uint8_t *travel) {
+    matrix->travel = travel;
+}
+
+bool rgb_matrix_task(rgb_matrix_t *matrix, uint32_t now_ms) {
+    if (matrix->next_led == 0) {
+        matrix->frame_ms = now_ms;
+        update_ripples(matrix);
+    }
+
+    // Time-based phase for the animated effects, 256 steps per cycle
+    // (about 4 s at speed 128)
+    uint8_t phase = (uint8_t)(((uint64_t)matrix->frame_ms * matrix->speed) >> 11);
+
+    uint8_t end = matrix->next_led + RGB_MATRIX_LEDS_PER_TICK;
+    if (end > matrix->num_leds) {
+        end = matrix->num_leds;
+    }
+
+    for (uint8_t led = matrix->next_led; led < end; led++) {
+        uint8_t hue = matrix->hue;
+        uint8_t value = 255;
+
+        switch (matrix->effect) {
+            case RGB_EFFECT_BREATHING:
+                value = (uint8_t)(BREATHING_MIN + ((sin8(phase) * (255 - BREATHING_MIN)) >> 8));
+                break;
+            case RGB_EFFECT_GRADIENT:
+                hue = (uint8_t)(hue + rgb_layout[led].x + phase);
+                break;
+            case RGB_EFFECT_RIPPLE:
+                value = ripple_value(matrix, led);
+                hue = (uint8_t)(hue + (value >> 2));    // Brighter = shifted hue
+                break;
+            case RGB_EFFECT_TRAVEL: {
+                uint32_t t = matrix->travel ? matrix->travel[led] : 0;
+                value = (uint8_t)(TRAVEL_MIN + ((t * (256 - TRAVEL_MIN)) >> 8));
+                hue = (uint8_t)(hue + ((t * RGB_TRAVEL_HUE_SHIFT) >> 8));
+                break;
+            }
+            default:
+                break;
+        }
+
+        rgb_matrix_rgb_t c = hsv_to_rgb(hue, matrix->sat, value);
+        matrix->rgb[led].r = matrix->out_lut[c.r];
+        matrix->rgb[led].g = matrix->out_lut[c.g];
+        matrix->rgb[led].b = matrix->out_lut[c.b];
+    }
+
+    if (end >= matrix->num_leds) {
+        matrix->next_led = 0;
+        return true;
+    }
+    matrix->next_led = end;
+    return false;
+}
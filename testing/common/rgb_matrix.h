@@ -0,0 +1,125 @@
+#ifndef RGB_MATRIX_H
+#define RGB_MATRIX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "rgb_layout.h"
+
+// RGB matrix effects over the key positions in rgb_layout.
+//
+// Effects are computed with integer math only: hue/saturation/value per LED,
+// then each channel goes through one 256-entry table that applies the
+// brightness and gamma 2.2 together. A frame is rendered a fixed number of
+// LEDs per rgb_matrix_task() call (RGB_MATRIX_LEDS_PER_TICK), so one call
+// costs a bounded amount of time however many LEDs the board has; the time
+// is latched at the first call of a frame so every LED sees the same
+// instant.
+//
+// The ripple effect is driven by analog key travel: a key passing
+// RGB_RIPPLE_TRIGGER starts a ring spreading from it, as bright as the
+// deepest travel reached while the key is held, and held keys glow with
+// their travel. The travel effect maps each key's travel straight to its
+// LED: deeper is brighter and shifts the hue by up to RGB_TRAVEL_HUE_SHIFT.
+// The travel array is read in place (rgb_matrix_set_travel()), never
+// copied. No hardware dependencies: builds on the host.
+
+#ifndef RGB_MATRIX_LEDS_PER_TICK
+#define RGB_MATRIX_LEDS_PER_TICK 16
+#endif
+
+#ifndef RGB_RIPPLE_MAX
+#define RGB_RIPPLE_MAX 8                // Rings alive at once; the oldest is replaced
+#endif
+
+#define RGB_RIPPLE_TRIGGER 96           // Travel (0-255) that starts a ring
+#define RGB_RIPPLE_RELEASE 64           // Travel below which the key may ring again
+#define RGB_RIPPLE_WIDTH 16             // Ring thickness, layout units
+
+#define RGB_TRAVEL_HUE_SHIFT 85         // Hue change at bottom-out (green -> blue)
+
+#define RGB_MATRIX_BITMAP_BYTES ((RGB_LAYOUT_LED_COUNT + 7) / 8)
+
+typedef enum {
+    RGB_EFFECT_SOLID = 0,               // One color
+    RGB_EFFECT_BREATHING,               // One color, value follows a sine
+    RGB_EFFECT_GRADIENT,                // Hue across the board, scrolling
+    RGB_EFFECT_RIPPLE,                  // Rings from pressed keys
+    RGB_EFFECT_TRAVEL,                  // Each key lit by its own travel
+    RGB_EFFECT_COUNT
+} rgb_effect_t;
+
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} rgb_matrix_rgb_t;
+
+typedef struct {
+    uint8_t num_leds;
+    uint8_t effect;
+    uint8_t hue;
+    uint8_t sat;
+    uint8_t speed;                  // 0-255, 128 = default pace
+    uint8_t brightness;
+    uint8_t out_lut[256];           // Brightness then gamma, per channel
+
+    const uint8_t *travel;          // Per-LED travel 0-255, read in place
+    uint8_t held[RGB_MATRIX_BITMAP_BYTES]; // Above trigger, not yet released
+
+    // Rings, struct-of-arrays; peak 0 = slot free
+    uint8_t ripple_led[RGB_RIPPLE_MAX];
+    uint8_t ripple_peak[RGB_RIPPLE_MAX];
+    uint32_t ripple_start_ms[RGB_RIPPLE_MAX];
+    uint8_t ripple_next;            // Slot for the next ring
+
+    uint8_t next_led;               // Next LED to render, 0 = start of frame
+    uint32_t frame_ms;              // Time of the frame being rendered
+    rgb_matrix_rgb_t rgb[RGB_LAYOUT_LED_COUNT]; // Output, valid when a frame completes
+} rgb_matrix_t;
+
+/**
+ * @brief Start with the solid effect at full brightness, no travel input
+ *
+ * @param matrix Effect state
+ * @param num_leds LEDs driven; they take the first num_leds layout positions
+ */
+void rgb_matrix_init(rgb_matrix_t *matrix, uint8_t num_leds);
+
+/**
+ * @brief Select the effect (out-of-range values are ignored)
+ */
+void rgb_matrix_set_effect(rgb_matrix_t *matrix, uint8_t effect);
+
+/**
+ * @brief Set the base color used by the effects
+ */
+void rgb_matrix_set_color(rgb_matrix_t *matrix, uint8_t hue, uint8_t sat);
+
+/**
+ * @brief Set the animation speed (128 = default)
+ */
+void rgb_matrix_set_speed(rgb_matrix_t *matrix, uint8_t speed);
+
+/**
+ * @brief Set the brightness and rebuild the output table
+ */
+void rgb_matrix_set_brightness(rgb_matrix_t *matrix, uint8_t brightness);
+
+/**
+ * @brief Point the reactive effects at a per-LED travel array
+ *
+ * The array is read during rendering, not copied, so it must stay valid
+ * (NULL = no key input).
+ */
+void rgb_matrix_set_travel(rgb_matrix_t *matrix, const uint8_t *travel);
+
+/**
+ * @brief Render up to RGB_MATRIX_LEDS_PER_TICK LEDs of the current frame
+ *
+ * @param matrix Effect state
+ * @param now_ms Current time; only used by the first call of a frame
+ * @return true when the frame is complete and matrix->rgb can be sent
+ */
+bool rgb_matrix_task(rgb_matrix_t *matrix, uint32_t now_ms);
+
+#endif // RGB_MATRIX_H
@@ -0,0 +1,118 @@
+#include "sample_filter.h"
+#include <string.h>
+
+static bool config_valid(const sample_filter_config_t *config) {
+    return config->weight >= 1 && config->weight <= SAMPLE_FILTER_WEIGHT_ONE;
+}
+
+bool sample_filter_init(sample_filter_t *filter, uint16_t num_channels, uint8_t median_len,
+                        const sample_filter_config_t *config) {
+    if (num_channels > SAMPLE_FILTER_MAX_CHANNELS || !config_valid(config) ||
+        (median_len != 1 && median_len != 3 && median_len != 5)) {
+        return false;
+    }
+
+    memset(filter, 0, sizeof(*filter));
+    filter->num_channels = num_channels;
+    filter->median_len = median_len;
+    for (uint16_t ch = 0; ch < num_channels; ch++) {
+        sample_filter_set_config(filter, ch, config);
+    }
+    return true;
+}
+
+bool sample_filter_set_config(sample_filter_t *filter, uint16_t channel, const sample_filter_config_t *config) {
+    if (channel >= filter->num_channels || !config_valid(config)) {
+        return false;
+    }
+
+    filter->weight[channel] = config->weight;
+    filter->deadband[channel] = config->deadband;
+    filter->slope[channel] = config->full_speed
+        ? (uint16_t)(((uint32_t)(SAMPLE_FILTER_WEIGHT_ONE - config->weight) << 8) / config->full_speed)
+        : 0;
+    return true;
+}
+
+void sample_filter_reset(sample_filter_t *filter) {
+    filter->primed = false;
+    filter->hist_pos = 0;
+}
+
+static inline uint16_t min_u16(uint16_t a, uint16_t b) { return a < b ? a : b; }
+static inline uint16_t max_u16(uint16_t a, uint16_t b) { return a > b ? a : b; }
+
+static inline uint16_t median3(uint16_t a, uint16_t b, uint16_t c) {
+    return max_u16(min_u16(a, b), min_u16(max_u16(a, b), c));
+}
+
+static inline uint16_t median5(uint16_t a, uint16_t b, uint16_t c, uint16_t d, uint16_t e) {
+    // Drop the smaller of the two pair minimums and the larger of the two
+    // pair maximums; neither can be the median, which is then the median
+    // of the three values left
+    uint16_t lo = max_u16(min_u16(a, b), min_u16(c, d));
+    uint16_t hi = min_u16(max_u16(a, b), max_u16(c, d));
+    return median3(e, lo, hi);
+}
+
+// Adaptive EMA step for one channel; returns the rounded output
+static inline uint16_t smooth(sample_filter_t *filter, uint16_t ch, uint16_t sample) {
+    int32_t estimate = filter->estimate[ch];
+    int32_t dev = ((int32_t)sample << SAMPLE_FILTER_FRAC_BITS) - estimate;
+    uint32_t dist = (uint32_t)(dev < 0 ? -dev : dev) >> SAMPLE_FILTER_FRAC_BITS;
+
+    uint32_t weight = filter->weight[ch];
+    if (dist > filter->deadband[ch]) {
+        weight += ((uint32_t)filter->slope[ch] * (dist - filter->deadband[ch])) >> 8;
+        if (weight > SAMPLE_FILTER_WEIGHT_ONE) {
+            weight = SAMPLE_FILTER_WEIGHT_ONE;
+        }
+    }
+
+    // dev * weight stays below 2^31: |dev| < 2^20, weight <= 2^8
+    estimate += (dev * (int32_t)weight) / SAMPLE_FILTER_WEIGHT_ONE;
+    filter->estimate[ch] = estimate;
+    return (uint16_t)((estimate + (1 << (SAMPLE_FILTER_FRAC_BITS - 1))) >> SAMPLE_FILTER_FRAC_BITS);
+}
+
+void sample_filter_process(sample_filter_t *filter, const uint16_t *in, uint16_t *out) {
+    uint16_t n = filter->num_channels;
+    uint8_t len = filter->median_len;
+
+    if (!filter->primed) {
+        // Seed the history and the estimate with the first frame
+        for (uint8_t row = 0; row < len; row++) {
+            memcpy(filter->hist[row], in, n * sizeof(uint16_t));
+        }
+        for (uint16_t ch = 0; ch < n; ch++) {
+            filter->estimate[ch] = (int32_t)in[ch] << SAMPLE_FILTER_FRAC_BITS;
+        }
+        filter->hist_pos = 0;
+        filter->primed = true;
+    }
+
+    if (len > 1) {
+        memcpy(filter->hist[filter->hist_pos], in, n * sizeof(uint16_t));
+        filter->hist_pos = (uint8_t)((filter->hist_pos + 1) % len);
+    }
+
+    // One loop per window length so the inner loop has no branches on it
+    const uint16_t (*h)[SAMPLE_FILTER_MAX_CHANNELS] = (const uint16_t (*)[SAMPLE_FILTER_MAX_CHANNELS]) filter->hist;
+    switch (len) {
+    case 5:
+        for (uint16_t ch = 0; ch < n; ch++) {
+            out[ch] = smooth(filter, ch, median5(h[0][ch], h[1][ch], h[2][ch], h[3][ch], h[4][ch]));
+        }
+        break;
+    case 3:
+        for (uint16_t ch = 0; ch < n; ch++) {
+            out[ch] = smooth(filter, ch, median3(h[0][ch], h[1][ch], h[2][ch]));
+        }
+        break;
+    default:
+        for (uint16_t ch = 0; ch < n; ch++) {
+            out[ch] = smooth(filter, ch, in[ch]);
+        }
+        break;
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef SAMPLE_FILTER_H
+#define SAMPLE_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Per-channel filter pipeline for hall sensor samples, run once per frame:
+//
+//   1. median-of-N (N = 1 (off), 3 or 5) over the last N frames, which
+//      removes single-frame spikes (e.g. WS2812 edges) at the cost of
+//      (N - 1) / 2 frames of delay on a step
+//   2. an adaptive exponential moving average. Each frame the estimate moves
+//      weight/256 of the way to the new sample; weight starts at the
+//      channel's minimum and grows with how far the sample is from the
+//      estimate beyond a noise deadband, reaching 256 (no smoothing) at
+//      full_speed counts. This is the 1-euro idea (cutoff rises with speed)
+//      using the deviation as the speed estimate, so a fast press passes
+//      almost unfiltered while a resting key gets the full smoothing.
+//      full_speed = 0 gives a plain EMA; weight = 256 disables the stage.
+//
+// State is struct-of-arrays Q8 fixed point with no floats or divisions in
+// the per-frame loop, and no hardware dependencies: builds on the host.
+
+#ifndef SAMPLE_FILTER_MAX_CHANNELS
+#define SAMPLE_FILTER_MAX_CHANNELS 128
+#endif
+
+#define SAMPLE_FILTER_MEDIAN_MAX 5
+#define SAMPLE_FILTER_FRAC_BITS 8
+#define SAMPLE_FILTER_WEIGHT_ONE 256
+
+typedef struct {
+    uint16_t weight;        // Minimum EMA weight, 1-256 (256 = smoothing off)
+    uint16_t deadband;      // Deviation in counts still treated as noise
+    uint16_t full_speed;    // Deviation beyond the deadband at which weight reaches 256, 0 = plain EMA
+} sample_filter_config_t;
+
+typedef struct {
+    uint16_t num_channels;
+    uint8_t  median_len;
+    uint8_t  hist_pos;      // Next history row to overwrite
+    bool     primed;        // First frame seeds every stage
+    uint16_t weight[SAMPLE_FILTER_MAX_CHANNELS];
+    uint16_t deadband[SAMPLE_FILTER_MAX_CHANNELS];
+    uint16_t slope[SAMPLE_FILTER_MAX_CHANNELS];     // Q8 extra weight per count beyond the deadband
+    int32_t  estimate[SAMPLE_FILTER_MAX_CHANNELS];  // Q8 filter output
+    uint16_t hist[SAMPLE_FILTER_MEDIAN_MAX][SAMPLE_FILTER_MAX_CHANNELS];
+} sample_filter_t;
+
+/**
+ * @brief Initialize every channel with the same smoothing
+ *
+ * @param filter Filter state
+ * @param num_channels Number of channels (at most SAMPLE_FILTER_MAX_CHANNELS)
+ * @param median_len Median window in frames: 1 (off), 3 or 5
+ * @param config Smoothing applied to every channel
+ * @return false if an argument is out of range
+ */
+bool sample_filter_init(sample_filter_t *filter, uint16_t num_channels, uint8_t median_len,
+                        const sample_filter_config_t *config);
+
+/**
+ * @brief Change one channel's smoothing
+ *
+ * @return false if the channel or the configuration is out of range
+ */
+bool sample_filter_set_config(sample_filter_t *filter, uint16_t channel, const sample_filter_config_t *config);
+
+/**
+ * @brief Forget history; the next frame seeds the filter again
+ */
+void sample_filter_reset(sample_filter_t *filter);
+
+/**
+ * @brief Filter one frame
+ *
+ * @param filter Filter state
+ * @param in num_channels samples
+ * @param out num_channels filtered samples (may be the same buffer as in)
+ */
+void sample_filter_process(sample_filter_t *filter, const uint16_t *in, uint16_t *out);
+
+#endif // SAMPLE_FILTER_H
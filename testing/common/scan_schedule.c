@@ -0,0 +1,73 @@
+#include "scan_schedule.h"
+#include "settle.h"
+#include <string.h>
+
+bool scan_schedule_init(scan_schedule_t *sched, const uint8_t *adc_inputs, uint8_t num_muxes, uint16_t wait_us) {
+    if (num_muxes == 0 || num_muxes > SCAN_SCHEDULE_MAX_MUXES) {
+        return false;
+    }
+
+    memset(sched, 0, sizeof(*sched));
+    sched->num_muxes = num_muxes;
+
+    for (uint8_t mux = 0; mux < num_muxes; mux++) {
+        for (uint8_t other = 0; other < mux; other++) {
+            if (adc_inputs[other] == adc_inputs[mux]) {
+                return false;
+            }
+        }
+        sched->adc_input[mux] = adc_inputs[mux];
+    }
+
+    // Insertion sort of the muxes by ADC input
+    for (uint8_t i = 0; i < num_muxes; i++) {
+        uint8_t j = i;
+        while (j > 0 && sched->adc_input[sched->input_order[j - 1]] > adc_inputs[i]) {
+            sched->input_order[j] = sched->input_order[j - 1];
+            j--;
+        }
+        sched->input_order[j] = i;
+    }
+
+    for (uint8_t step = 0; step < SCAN_SCHEDULE_SELECTS; step++) {
+        sched->steps[step].select = step;
+        sched->steps[step].wait_us = wait_us;
+        memcpy(sched->steps[step].slot_mux, sched->input_order, num_muxes);
+    }
+
+    return true;
+}
+
+void scan_schedule_plan_rotation(scan_schedule_t *sched, const uint16_t (*settle_us)[SCAN_SCHEDULE_SELECTS], uint16_t conv_us) {
+    uint16_t slot_settle[SCAN_SCHEDULE_MAX_MUXES];
+    uint8_t n = sched->num_muxes;
+
+    for (uint8_t step = 0; step < SCAN_SCHEDULE_SELECTS; step++) {
+        scan_step_t *s = &sched->steps[step];
+        for (uint8_t slot = 0; slot < n; slot++) {
+            slot_settle[slot] = settle_us[sched->input_order[slot]][s->select];
+        }
+
+        uint8_t rotation;
+        s->wait_us = settle_plan_rotation(slot_settle, n, conv_us, &rotation);
+        for (uint8_t slot = 0; slot < n; slot++) {
+            s->slot_mux[slot] = sched->input_order[(rotation + slot) % n];
+        }
+    }
+}
+
+void scan_schedule_plan_order(scan_schedule_t *sched, const uint16_t (*settle_us)[SCAN_SCHEDULE_SELECTS], uint16_t conv_us) {
+    uint16_t mux_settle[SCAN_SCHEDULE_MAX_MUXES];
+    uint8_t order[SCAN_SCHEDULE_MAX_MUXES];
+    uint8_t n = sched->num_muxes;
+
+    for (uint8_t step = 0; step < SCAN_SCHEDULE_SELECTS; step++) {
+        scan_step_t *s = &sched->steps[step];
+        for (uint8_t mux = 0; mux < n; mux++) {
+            mux_settle[mux] = settle_us[mux][s->select];
+        }
+
+        s->wait_us = settle_plan_order(mux_settle, n, conv_us, order);
+        memcpy(s->slot_mux, order, n);
+    }
+}
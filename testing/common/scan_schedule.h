@@ -0,0 +1,86 @@
+#ifndef SCAN_SCHEDULE_H
+#define SCAN_SCHEDULE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Table-driven scan schedule for HC4067 muxes sharing S0-S3.
+//
+// One select value exposes one channel on every mux at once, so a frame is
+// 16 steps: drive the select lines once, wait for them to settle, then
+// convert every mux in the step's slot order. Each mux is wired to one ADC
+// input (internal ADC or an external converter channel); the schedule only
+// deals in those input numbers, so any wiring can reuse it.
+//
+// Channel numbering is mux-major: channel = mux * SCAN_SCHEDULE_SELECTS + select.
+
+#define SCAN_SCHEDULE_MAX_MUXES 8
+#define SCAN_SCHEDULE_SELECTS 16
+
+typedef struct {
+    uint8_t  select;                            // Value driven onto S0-S3
+    uint16_t wait_us;                           // Settle wait after driving it
+    uint8_t  slot_mux[SCAN_SCHEDULE_MAX_MUXES]; // Mux converted in each slot
+} scan_step_t;
+
+typedef struct {
+    uint8_t     num_muxes;
+    uint8_t     adc_input[SCAN_SCHEDULE_MAX_MUXES];   // ADC input wired to each mux
+    uint8_t     input_order[SCAN_SCHEDULE_MAX_MUXES]; // Muxes in ascending input order
+    scan_step_t steps[SCAN_SCHEDULE_SELECTS];
+} scan_schedule_t;
+
+/**
+ * @brief Build a schedule for a wiring
+ *
+ * Steps run select 0-15 in order with a uniform wait; each step converts
+ * the muxes in ascending ADC input order.
+ *
+ * @param sched Schedule to fill
+ * @param adc_inputs ADC input wired to each mux
+ * @param num_muxes Number of muxes (1 to SCAN_SCHEDULE_MAX_MUXES)
+ * @param wait_us Settle wait for every step
+ * @return false if num_muxes is out of range or an input is used twice
+ */
+bool scan_schedule_init(scan_schedule_t *sched, const uint8_t *adc_inputs, uint8_t num_muxes, uint16_t wait_us);
+
+/**
+ * @brief Plan waits for a converter that walks inputs in a fixed cycle
+ *
+ * For round-robin ADCs that convert the inputs in ascending order starting
+ * from a chosen input: each step becomes the rotation of that order that
+ * needs the shortest settle wait.
+ *
+ * @param sched Schedule to update
+ * @param settle_us Settle time per mux and select
+ * @param conv_us Time per conversion
+ */
+void scan_schedule_plan_rotation(scan_schedule_t *sched, const uint16_t (*settle_us)[SCAN_SCHEDULE_SELECTS], uint16_t conv_us);
+
+/**
+ * @brief Plan waits for a converter that can take inputs in any order
+ *
+ * Each step converts its muxes in ascending settle time order.
+ *
+ * @param sched Schedule to update
+ * @param settle_us Settle time per mux and select
+ * @param conv_us Time per conversion
+ */
+void scan_schedule_plan_order(scan_schedule_t *sched, const uint16_t (*settle_us)[SCAN_SCHEDULE_SELECTS], uint16_t conv_us);
+
+/**
+ * @brief ADC input converted in a slot of a step
+ */
+static inline uint8_t scan_schedule_slot_input(const scan_schedule_t *sched, uint8_t step, uint8_t slot) {
+    return sched->adc_input[sched->steps[step].slot_mux[slot]];
+}
+
+/**
+ * @brief Mux-major channel number converted in a slot of a step
+ */
+static inline uint8_t scan_schedule_slot_channel(const scan_schedule_t *sched, uint8_t step, uint8_t slot) {
+    const scan_step_t *s = &sched->steps[step];
+    return (uint8_t)(s->slot_mux[slot] * SCAN_SCHEDULE_SELECTS + s->select);
+}
+
+#endif // SCAN_SCHEDULE_H
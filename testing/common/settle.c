@@ -0,0 +1,80 @@
+#include "settle.h"
+
+uint16_t settle_time_from_trace(const uint16_t *samples, uint16_t count, uint16_t interval_us, uint16_t tolerance_lsb) {
+    if (count == 0) {
+        return 0;
+    }
+
+    uint16_t tail = count < SETTLE_FINAL_SAMPLES ? count : SETTLE_FINAL_SAMPLES;
+    uint32_t sum = 0;
+    for (uint16_t i = count - tail; i < count; i++) {
+        sum += samples[i];
+    }
+    uint16_t final_value = (uint16_t)((sum + tail / 2) / tail);
+
+    // Walk back from the end to the last sample outside the band
+    uint16_t settled = count;
+    while (settled > 0) {
+        uint16_t v = samples[settled - 1];
+        uint16_t delta = v > final_value ? v - final_value : final_value - v;
+        if (delta > tolerance_lsb) {
+            break;
+        }
+        settled--;
+    }
+
+    return (uint16_t)(settled * interval_us);
+}
+
+static uint16_t plan_wait(const uint16_t *settle_us, const uint8_t *order, uint8_t num_slots, uint16_t conv_us) {
+    int32_t wait = 0;
+    for (uint8_t k = 0; k < num_slots; k++) {
+        int32_t need = (int32_t)settle_us[order[k]] - (int32_t)k * conv_us;
+        if (need > wait) {
+            wait = need;
+        }
+    }
+    return (uint16_t)wait;
+}
+
+uint16_t settle_plan_rotation(const uint16_t *settle_us, uint8_t num_slots, uint16_t conv_us, uint8_t *rotation) {
+    uint8_t order[16];
+    uint16_t best_wait = UINT16_MAX;
+    *rotation = 0;
+
+    if (num_slots > sizeof(order)) {
+        num_slots = sizeof(order);
+    }
+
+    for (uint8_t r = 0; r < num_slots; r++) {
+        for (uint8_t k = 0; k < num_slots; k++) {
+            order[k] = (uint8_t)((r + k) % num_slots);
+        }
+        uint16_t wait = plan_wait(settle_us, order, num_slots, conv_us);
+        if (wait < best_wait) {
+            best_wait = wait;
+            *rotation = r;
+        }
+    }
+
+    return num_slots ? best_wait : 0;
+}
+
+uint16_t settle_plan_order(const uint16_t *settle_us, uint8_t num_slots, uint16_t conv_us, uint8_t *order) {
+    for (uint8_t k = 0; k < num_slots; k++) {
+        order[k] = k;
+    }
+
+    // Insertion sort by settle time; num_slots is tiny
+    for (uint8_t i = 1; i < num_slots; i++) {
+        uint8_t slot = order[i];
+        uint8_t j = i;
+        while (j > 0 && settle_us[order[j - 1]] > settle_us[slot]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = slot;
+    }
+
+    return plan_wait(settle_us, order, num_slots, conv_us);
+}
@@ -0,0 +1,66 @@
+#ifndef SETTLE_H
+#define SETTLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Mux settle-time characterization and scheduling helpers.
+//
+// After the HC4067 select lines change, each analog line needs a different
+// time to converge depending on the sensor, trace and previous channel.
+// Characterization records a trace of samples right after a select change
+// and finds how long the line takes to stay within a tolerance of its final
+// value. When several muxes share the select lines their settling runs in
+// parallel, so the order in which they are converted can hide the slow ones
+// behind the conversions of the fast ones.
+//
+// Nothing here touches hardware; traces come from the caller.
+
+// Samples at the end of a trace averaged to estimate the final value
+#ifndef SETTLE_FINAL_SAMPLES
+#define SETTLE_FINAL_SAMPLES 8
+#endif
+
+/**
+ * @brief Time for a trace to settle within a tolerance of its final value
+ *
+ * @param samples Samples taken at a fixed interval, starting at the select change
+ * @param count Number of samples (should be well past the settle time)
+ * @param interval_us Time between samples
+ * @param tolerance_lsb Allowed deviation from the final value
+ * @return Microseconds until the trace stays within tolerance; if it never
+ *         does, the full trace length
+ */
+uint16_t settle_time_from_trace(const uint16_t *samples, uint16_t count, uint16_t interval_us, uint16_t tolerance_lsb);
+
+/**
+ * @brief Choose the conversion order and wait for one shared select step
+ *
+ * The slots are converted in a fixed cyclic order (e.g. ADC round-robin)
+ * starting at a chosen rotation; slot k of the burst is sampled
+ * wait + k * conv_us after the select change. Finds the rotation that
+ * minimizes the wait while every slot still meets its settle time.
+ *
+ * @param settle_us Settle time of each slot in cyclic order
+ * @param num_slots Number of slots
+ * @param conv_us Time per conversion
+ * @param rotation Receives the index of the slot to convert first
+ * @return Wait in microseconds between select change and first conversion
+ */
+uint16_t settle_plan_rotation(const uint16_t *settle_us, uint8_t num_slots, uint16_t conv_us, uint8_t *rotation);
+
+/**
+ * @brief Choose a free conversion order and wait for one shared select step
+ *
+ * For converters that can sample the slots in any order (e.g. an external
+ * SPI ADC). Converting in ascending settle time order is optimal.
+ *
+ * @param settle_us Settle time of each slot
+ * @param num_slots Number of slots
+ * @param conv_us Time per conversion
+ * @param order Receives slot indices in conversion order
+ * @return Wait in microseconds between select change and first conversion
+ */
+uint16_t settle_plan_order(const uint16_t *settle_us, uint8_t num_slots, uint16_t conv_us, uint8_t *order);
+
+#endif // SETTLE_H
@@ -0,0 +1,120 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdatomic.h>
+
+// Lock-free single-producer / single-consumer ring of fixed-size elements.
+//
+// Intended for handing data between the two RP2350 cores (e.g. core1 scan
+// loop -> core0 USB loop) without locks or the inter-core FIFO. head and
+// tail are free-running sequence counters: the producer only writes head,
+// the consumer only writes tail, and each publishes with release ordering
+// after touching the slot. The header only depends on C11 atomics, so the
+// same code runs on the host with two threads.
+//
+// Elements can be copied in and out (push/pop) or produced/consumed in
+// place (write_slot/commit and read_slot/release) to avoid copying large
+// elements such as scan frames.
+//
+// depth must be a power of two; storage must hold depth * elem_size bytes.
+
+typedef struct {
+    _Atomic uint32_t head;      // Next sequence number to write (producer)
+    _Atomic uint32_t tail;      // Next sequence number to read (consumer)
+    uint32_t mask;
+    uint32_t elem_size;
+    uint8_t *storage;
+} spsc_ring_t;
+
+static inline bool spsc_ring_init(spsc_ring_t *ring, void *storage, uint32_t elem_size, uint32_t depth) {
+    if (depth == 0 || (depth & (depth - 1)) != 0) {
+        return false;
+    }
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    ring->mask = depth - 1;
+    ring->elem_size = elem_size;
+    ring->storage = (uint8_t *) storage;
+    return true;
+}
+
+// Number of elements waiting; exact from either side, a snapshot otherwise
+static inline uint32_t spsc_ring_count(spsc_ring_t *ring) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return head - tail;
+}
+
+// ---- Producer side ----
+
+// Slot for the next element, or NULL if the ring is full
+static inline void *spsc_ring_write_slot(spsc_ring_t *ring) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail > ring->mask) {
+        return NULL;
+    }
+    return ring->storage + (size_t)(head & ring->mask) * ring->elem_size;
+}
+
+// Publish the slot returned by spsc_ring_write_slot()
+static inline void spsc_ring_commit(spsc_ring_t *ring) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+static inline bool spsc_ring_push(spsc_ring_t *ring, const void *elem) {
+    void *slot = spsc_ring_write_slot(ring);
+    if (slot == NULL) {
+        return false;
+    }
+    memcpy(slot, elem, ring->elem_size);
+    spsc_ring_commit(ring);
+    return true;
+}
+
+// ---- Consumer side ----
+
+// Oldest unread element, or NULL if the ring is empty. The slot stays valid
+// until spsc_ring_release().
+static inline const void *spsc_ring_read_slot(spsc_ring_t *ring) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (head == tail) {
+        return NULL;
+    }
+    return ring->storage + (size_t)(tail & ring->mask) * ring->elem_size;
+}
+
+// Element index places after the oldest unread one (0 = oldest), or NULL if
+// fewer are waiting. Stays valid until released.
+static inline const void *spsc_ring_peek(spsc_ring_t *ring, uint32_t index) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (head - tail <= index) {
+        return NULL;
+    }
+    return ring->storage + (size_t)((tail + index) & ring->mask) * ring->elem_size;
+}
+
+// Hand the slot returned by spsc_ring_read_slot() back to the producer
+static inline void spsc_ring_release(spsc_ring_t *ring) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
+
+static inline bool spsc_ring_pop(spsc_ring_t *ring, void *elem) {
+    const void *slot = spsc_ring_read_slot(ring);
+    if (slot == NULL) {
+        return false;
+    }
+    memcpy(elem, slot, ring->elem_size);
+    spsc_ring_release(ring);
+    return true;
+}
+
+#endif // SPSC_RING_H
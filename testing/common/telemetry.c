@@ -0,0 +1,191 @@
+#include "telemetry.h"
+#include "crc.h"
+#include <string.h>
+
+// ---- Device side ----
+
+// COBS encoder writing straight into the ring: the code byte of each block
+// is reserved first and filled in when the block ends
+typedef struct {
+    telemetry_tx_t *tx;
+    uint32_t pos;
+    uint32_t code_pos;
+    uint8_t code;
+} cobs_writer_t;
+
+static inline void cobs_begin(cobs_writer_t *w, telemetry_tx_t *tx) {
+    w->tx = tx;
+    w->code_pos = tx->head;
+    w->pos = tx->head + 1;
+    w->code = 1;
+}
+
+static inline void cobs_end_block(cobs_writer_t *w) {
+    w->tx->buf[w->code_pos & w->tx->mask] = w->code;
+    w->code_pos = w->pos++;
+    w->code = 1;
+}
+
+static inline void cobs_put(cobs_writer_t *w, uint8_t byte) {
+    if (byte == 0) {
+        cobs_end_block(w);
+        return;
+    }
+    w->tx->buf[w->pos++ & w->tx->mask] = byte;
+    if (++w->code == 0xFF) {
+        cobs_end_block(w);
+    }
+}
+
+static void cobs_write(cobs_writer_t *w, const void *data, uint32_t len) {
+    const uint8_t *p = (const uint8_t *) data;
+    for (uint32_t i = 0; i < len; i++) {
+        cobs_put(w, p[i]);
+    }
+}
+
+static inline void cobs_finish(cobs_writer_t *w) {
+    w->tx->buf[w->code_pos & w->tx->mask] = w->code;
+    w->tx->buf[w->pos++ & w->tx->mask] = 0;
+    w->tx->head = w->pos;
+}
+
+bool telemetry_tx_init(telemetry_tx_t *tx, uint8_t *storage, uint32_t size) {
+    if (size == 0 || (size & (size - 1)) != 0) {
+        return false;
+    }
+    memset(tx, 0, sizeof(*tx));
+    tx->buf = storage;
+    tx->mask = size - 1;
+    return true;
+}
+
+bool telemetry_send(telemetry_tx_t *tx, uint8_t type, const void *head, uint16_t head_len,
+                    const void *data, uint16_t data_len) {
+    uint32_t len = (uint32_t)head_len + data_len;
+    if (len > TELEMETRY_MAX_PAYLOAD ||
+        TELEMETRY_MAX_PACKET(len) > tx->mask + 1 - telemetry_tx_used(tx)) {
+        tx->records_dropped++;
+        return false;
+    }
+
+    uint32_t crc = crc32_update(CRC32_INIT, &type, 1);
+    crc = crc32_update(crc, head, head_len);
+    crc = crc32_update(crc, data, data_len);
+    crc ^= 0xFFFFFFFFu;
+    const uint8_t crc_le[4] = {
+        (uint8_t) crc, (uint8_t)(crc >> 8), (uint8_t)(crc >> 16), (uint8_t)(crc >> 24)
+    };
+
+    cobs_writer_t w;
+    cobs_begin(&w, tx);
+    cobs_put(&w, type);
+    cobs_write(&w, head, head_len);
+    cobs_write(&w, data, data_len);
+    cobs_write(&w, crc_le, sizeof(crc_le));
+    cobs_finish(&w);
+    tx->records_sent++;
+    return true;
+}
+
+bool telemetry_tx_write_raw(telemetry_tx_t *tx, const void *data, uint32_t len) {
+    if (len > tx->mask + 1 - telemetry_tx_used(tx)) {
+        return false;
+    }
+    const uint8_t *p = (const uint8_t *) data;
+    for (uint32_t i = 0; i < len; i++) {
+        tx->buf[tx->head++ & tx->mask] = p[i];
+    }
+    return true;
+}
+
+uint32_t telemetry_tx_peek(const telemetry_tx_t *tx, const uint8_t **data) {
+    uint32_t used = telemetry_tx_used(tx);
+    uint32_t offset = tx->tail & tx->mask;
+    uint32_t to_end = tx->mask + 1 - offset;
+    *data = tx->buf + offset;
+    return used < to_end ? used : to_end;
+}
+
+void telemetry_tx_consume(telemetry_tx_t *tx, uint32_t len) {
+    tx->tail += len;
+}
+
+bool telemetry_tx_drain(telemetry_tx_t *tx, telemetry_write_t write) {
+    bool wrote = false;
+    const uint8_t *data;
+    uint32_t len;
+    while ((len = telemetry_tx_peek(tx, &data)) != 0) {
+        uint32_t written = write(data, len);
+        telemetry_tx_consume(tx, written);
+        wrote |= written != 0;
+        if (written < len) {
+            break;      // Sink full; the rest goes next pass
+        }
+    }
+    return wrote;
+}
+
+// ---- Host side ----
+
+void telemetry_rx_init(telemetry_rx_t *rx) {
+    memset(rx, 0, sizeof(*rx));
+}
+
+// Decode one COBS packet in place; returns the decoded length or -1
+static int cobs_decode(uint8_t *buf, uint32_t len) {
+    uint32_t in = 0, out = 0;
+    while (in < len) {
+        uint8_t code = buf[in++];
+        if (code == 0 || in + code - 1 > len) {
+            return -1;
+        }
+        for (uint8_t i = 1; i < code; i++) {
+            buf[out++] = buf[in++];
+        }
+        if (code < 0xFF && in < len) {
+            buf[out++] = 0;
+        }
+    }
+    return (int) out;
+}
+
+static void finish_packet(telemetry_rx_t *rx, telemetry_record_cb_t cb, void *ctx) {
+    if (rx->overflow) {
+        rx->framing_errors++;
+        return;
+    }
+    if (rx->len == 0) {
+        return;     // Back-to-back delimiters
+    }
+
+    int len = cobs_decode(rx->buf, rx->len);
+    if (len < 5) {
+        rx->framing_errors++;
+        return;
+    }
+    uint32_t crc = (uint32_t) rx->buf[len - 4] | ((uint32_t) rx->buf[len - 3] << 8) |
+                   ((uint32_t) rx->buf[len - 2] << 16) | ((uint32_t) rx->buf[len - 1] << 24);
+    if (crc32(rx->buf, (size_t) len - 4) != crc) {
+        rx->crc_errors++;
+        return;
+    }
+    rx->packets++;
+    cb(ctx, rx->buf[0], rx->buf + 1, (uint16_t)(len - 5));
+}
+
+void telemetry_rx_feed(telemetry_rx_t *rx, const uint8_t *data, uint32_t len,
+                       telemetry_record_cb_t cb, void *ctx) {
+    for (uint32_t i = 0; i < len; i++) {
+        uint8_t byte = data[i];
+        if (byte == 0) {
+            finish_packet(rx, cb, ctx);
+            rx->len = 0;
+            rx->overflow = false;
+        } else if (rx->len < sizeof(rx->buf)) {
+            rx->buf[rx->len++] = byte;
+        } else {
+            rx->overflow = true;
+        }
+    }
+}
@@ -0,0 +1,171 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Binary telemetry over a byte stream (USB CDC).
+//
+// Each record is one packet: [type][payload][CRC-32 of type + payload, LE],
+// COBS-encoded and terminated by a 0x00 byte. COBS removes every zero from
+// the packet, so a reader that starts mid-stream or loses bytes resyncs at
+// the next 0x00, and the CRC rejects damaged packets. All fields are
+// little-endian.
+//
+// Device side: records are encoded straight into a byte ring (telemetry_tx_t)
+// that the USB loop drains with telemetry_tx_drain() as the CDC FIFO frees
+// up, flushing once per pass instead of per record. A record that does not
+// fit is dropped whole and counted.
+//
+// Host side: telemetry_rx_feed() reassembles and checks packets from any
+// chunking of the stream. No hardware dependencies: builds on the host and
+// links into C or C++ tools (tools/telemetry.py parses the same format).
+
+#define TELEMETRY_MAX_PAYLOAD 512
+// Longest encoded packet: type + payload + CRC, one COBS code byte per 254
+// data bytes plus one, and the delimiter
+#define TELEMETRY_MAX_PACKET(payload) \
+    ((1 + (payload) + 4) + (1 + (payload) + 4) / 254 + 1 + 1)
+
+// Record types
+#define TELEMETRY_TEXT   0x01   // Log text (UTF-8), any chunking
+#define TELEMETRY_FRAME  0x02   // telemetry_frame_header_t + uint16_t value[count]
+#define TELEMETRY_KEY    0x03   // telemetry_key_t
+#define TELEMETRY_STATS  0x04   // telemetry_stats_t
+
+typedef struct __attribute__((packed)) {
+    uint32_t seq;               // Scan frame sequence number
+    uint32_t timestamp_us;
+    uint16_t count;             // Values that follow
+} telemetry_frame_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp_us;
+    uint16_t key;               // Channel / key index
+    uint8_t  pressed;
+    uint8_t  reserved;
+} telemetry_key_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t uptime_ms;
+    uint32_t records_sent;      // Records queued since boot
+    uint32_t records_dropped;   // Records lost to a full ring
+    uint32_t scans;             // Scan frames published
+    uint32_t scans_dropped;     // Scan frames lost before telemetry saw them
+} telemetry_stats_t;
+
+// ---- Device side ----
+
+typedef struct {
+    uint8_t *buf;
+    uint32_t mask;              // Size - 1, size a power of two
+    uint32_t head;              // Free-running write position
+    uint32_t tail;              // Free-running read position
+    uint32_t records_sent;
+    uint32_t records_dropped;
+} telemetry_tx_t;
+
+/**
+ * @brief Initialize an empty ring
+ *
+ * @param tx Ring state
+ * @param storage Byte storage, size must be a power of two
+ * @param size Bytes of storage
+ * @return false if size is not a power of two
+ */
+bool telemetry_tx_init(telemetry_tx_t *tx, uint8_t *storage, uint32_t size);
+
+/**
+ * @brief Queue one record
+ *
+ * The payload is gathered from two parts (header and data, either may be
+ * empty) so frames go straight from their buffers into the ring.
+ *
+ * @return false if the ring had no room and the record was dropped
+ */
+bool telemetry_send(telemetry_tx_t *tx, uint8_t type, const void *head, uint16_t head_len,
+                    const void *data, uint16_t data_len);
+
+/**
+ * @brief Queue raw bytes (text mode), all or nothing
+ *
+ * @return false if the ring had no room
+ */
+bool telemetry_tx_write_raw(telemetry_tx_t *tx, const void *data, uint32_t len);
+
+/**
+ * @brief Get the oldest queued bytes that are contiguous in the ring
+ *
+ * @param tx Ring state
+ * @param data Receives a pointer to the bytes
+ * @return Number of bytes available at *data (0 if empty)
+ */
+uint32_t telemetry_tx_peek(const telemetry_tx_t *tx, const uint8_t **data);
+
+/**
+ * @brief Remove bytes returned by telemetry_tx_peek() once written
+ */
+void telemetry_tx_consume(telemetry_tx_t *tx, uint32_t len);
+
+/**
+ * @brief Byte sink for telemetry_tx_drain(), e.g. the CDC write
+ *
+ * @return Bytes taken, fewer than len when the sink is full
+ */
+typedef uint32_t (*telemetry_write_t)(const void *data, uint32_t len);
+
+/**
+ * @brief Write queued bytes to the sink until it is full or the ring empty
+ *
+ * @param tx Ring state
+ * @param write Sink
+ * @return true if anything was written: flush the sink once
+ */
+bool telemetry_tx_drain(telemetry_tx_t *tx, telemetry_write_t write);
+
+/**
+ * @brief Number of bytes queued
+ */
+static inline uint32_t telemetry_tx_used(const telemetry_tx_t *tx) {
+    return tx->head - tx->tail;
+}
+
+// ---- Host side ----
+
+typedef void (*telemetry_record_cb_t)(void *ctx, uint8_t type, const uint8_t *payload, uint16_t len);
+
+typedef struct {
+    uint8_t buf[TELEMETRY_MAX_PACKET(TELEMETRY_MAX_PAYLOAD)];
+    uint16_t len;
+    bool overflow;              // Current packet too long; skip to delimiter
+    uint32_t packets;           // Valid records delivered
+    uint32_t crc_errors;
+    uint32_t framing_errors;    // Bad COBS, too long or too short
+} telemetry_rx_t;
+
+/**
+ * @brief Start with an empty packet buffer and zero counters
+ */
+void telemetry_rx_init(telemetry_rx_t *rx);
+
+/**
+ * @brief Feed received bytes; calls cb for every valid record
+ *
+ * @param rx Decoder state
+ * @param data Received bytes, any chunking
+ * @param len Number of bytes
+ * @param cb Called with the record type and payload (valid during the call)
+ * @param ctx Passed to cb
+ */
+void telemetry_rx_feed(telemetry_rx_t *rx, const uint8_t *data, uint32_t len,
+                       telemetry_record_cb_t cb, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_H
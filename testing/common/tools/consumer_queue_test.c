@@ -0,0 +1,285 @@
+// Host test of the consumer-control tap queue (consumer_queue.c) driven the
+// way usb.c drives it: a stand-in USB stack takes one report at a time
+// (sometimes refusing it), the host collects it some polls later, and the
+// encoder queues volume steps in bursts while reports are in flight. The
+// host side turns the report stream back into taps (a press of a usage
+// followed by a release) and checks that
+//   - every accepted tap arrives exactly once, in the order queued, with
+//     no report of usage 0 as a press and no press without its release,
+//   - a burst of one usage coalesces into one entry however long it is,
+//     including past the UINT16_MAX count of a single entry,
+//   - alternating usages fill the queue, after which only repeats of the
+//     newest entry's usage are accepted and the taps refused are the ones
+//     counted as dropped,
+//   - consumer_queue_clear() (protocol switch, unmount) leaves nothing in
+//     flight and the queue usable.
+//
+// Build and run from testing/common:
+//   cc -O2 -I. tools/consumer_queue_test.c consumer_queue.c -o consumer_queue_test
+//   ./consumer_queue_test
+
+#include "consumer_queue.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#define VOLUME_UP   0x00E9
+#define VOLUME_DOWN 0x00EA
+#define MUTE        0x00E2
+#define MAX_TAPS    200000
+
+static uint32_t failures;
+static uint32_t rng = 1;
+
+static uint32_t rnd(uint32_t n) {
+    rng = rng * 1664525u + 1013904223u;
+    return (rng >> 8) % n;
+}
+
+static void fail(const char *fmt, ...) {
+    if (failures++ < 20) {
+        va_list args;
+        va_start(args, fmt);
+        printf("    FAIL: ");
+        vprintf(fmt, args);
+        printf("\n");
+        va_end(args);
+    }
+}
+
+// Taps accepted by the queue, and taps the host decoded from the reports
+typedef struct {
+    consumer_queue_t queue;
+    uint16_t queued[MAX_TAPS];
+    uint32_t num_queued;
+    uint16_t received[MAX_TAPS];
+    uint32_t num_received;
+    uint16_t held;                      // Usage the host sees pressed, 0 if none
+    uint32_t wait;                      // Polls until the host collects the report in flight
+    uint32_t refuse_per_mille;          // Chance the stack refuses a report
+    uint32_t max_wait;
+    uint32_t reports;
+} bus_t;
+
+static void bus_init(bus_t *bus, uint32_t refuse_per_mille, uint32_t max_wait) {
+    memset(bus, 0, sizeof(*bus));
+    consumer_queue_init(&bus->queue);
+    bus->refuse_per_mille = refuse_per_mille;
+    bus->max_wait = max_wait;
+}
+
+static bool tap(bus_t *bus, uint16_t usage) {
+    bool accepted = consumer_queue_tap(&bus->queue, usage);
+    if (accepted && usage != 0 && bus->num_queued < MAX_TAPS) {
+        bus->queued[bus->num_queued++] = usage;
+    }
+    return accepted;
+}
+
+// The host receives one report
+static void host_receive(bus_t *bus, uint16_t report) {
+    bus->reports++;
+    if (report != 0) {
+        if (bus->held != 0) {
+            fail("press of 0x%04x while 0x%04x is still held", report, bus->held);
+        }
+        bus->held = report;
+        return;
+    }
+    if (bus->held == 0) {
+        fail("release with nothing pressed (report %u)", bus->reports);
+        return;
+    }
+    if (bus->num_received < MAX_TAPS) {
+        bus->received[bus->num_received++] = bus->held;
+    }
+    bus->held = 0;
+}
+
+// One USB poll: complete the report in flight once the host has it, then
+// send the next one as the firmware's flush does
+static void poll(bus_t *bus) {
+    if (bus->queue.in_flight) {
+        if (bus->wait > 0) {
+            bus->wait--;
+            return;
+        }
+        consumer_queue_complete(&bus->queue);
+    }
+    uint16_t report;
+    if (!consumer_queue_next(&bus->queue, &report)) {
+        return;
+    }
+    bool accepted = rnd(1000) >= bus->refuse_per_mille;
+    consumer_queue_sent(&bus->queue, accepted);
+    if (accepted) {
+        host_receive(bus, report);
+        bus->wait = bus->max_wait ? rnd(bus->max_wait + 1) : 0;
+    }
+}
+
+static void drain(bus_t *bus) {
+    for (uint32_t i = 0; i < 4 * MAX_TAPS * (bus->max_wait + 2) && consumer_queue_busy(&bus->queue); i++) {
+        poll(bus);
+    }
+    if (consumer_queue_busy(&bus->queue)) {
+        fail("queue still busy after draining");
+    }
+}
+
+static void check_delivery(const bus_t *bus, const char *name) {
+    if (bus->held != 0) {
+        fail("%s: 0x%04x left pressed", name, bus->held);
+    }
+    if (bus->num_received != bus->num_queued) {
+        fail("%s: %u taps queued, %u received", name, bus->num_queued, bus->num_received);
+    }
+    uint32_t n = bus->num_received < bus->num_queued ? bus->num_received : bus->num_queued;
+    for (uint32_t i = 0; i < n; i++) {
+        if (bus->received[i] != bus->queued[i]) {
+            fail("%s: tap %u is 0x%04x, queued 0x%04x", name, i, bus->received[i], bus->queued[i]);
+            break;
+        }
+    }
+}
+
+static bus_t bus;
+
+// Volume steps from one fast encoder spin land while the first is in flight
+static void test_burst(void) {
+    uint32_t before = failures;
+    bus_init(&bus, 0, 3);
+
+    tap(&bus, VOLUME_UP);
+    poll(&bus);
+    if (!bus.queue.in_flight) {
+        fail("burst: first press not in flight");
+    }
+    for (int i = 0; i < 1000; i++) {
+        if (!tap(&bus, VOLUME_UP)) {
+            fail("burst: step %d refused", i);
+            break;
+        }
+    }
+    if (bus.queue.used != 1 || bus.queue.count[bus.queue.head] != 1001) {
+        fail("burst: %u entries, count %u (expected one entry of 1001)", bus.queue.used,
+             bus.queue.count[bus.queue.head]);
+    }
+    drain(&bus);
+    check_delivery(&bus, "burst");
+    if (bus.reports != 2 * 1001 || bus.queue.dropped != 0) {
+        fail("burst: %u reports, %u dropped", bus.reports, bus.queue.dropped);
+    }
+    printf("  %-34s %s\n", "1001 steps, one in flight", failures == before ? "ok" : "FAILED");
+}
+
+// More than one entry's count of the same usage
+static void test_saturation(void) {
+    uint32_t before = failures;
+    bus_init(&bus, 0, 0);
+
+    tap(&bus, VOLUME_DOWN);
+    poll(&bus);
+    for (uint32_t i = 0; i < UINT16_MAX + 1000u; i++) {
+        tap(&bus, VOLUME_DOWN);
+    }
+    if (bus.queue.used != 2 || bus.queue.dropped != 0) {
+        fail("saturation: %u entries, %u dropped (expected 2, 0)", bus.queue.used, bus.queue.dropped);
+    }
+    drain(&bus);
+    check_delivery(&bus, "saturation");
+    printf("  %-34s %s\n", "past UINT16_MAX of one usage", failures == before ? "ok" : "FAILED");
+}
+
+// Alternating usages need one entry each: the queue fills and refuses
+static void test_full(void) {
+    uint32_t before = failures;
+    bus_init(&bus, 0, 0);
+    uint32_t refused = 0;
+
+    tap(&bus, MUTE);
+    poll(&bus);
+    uint16_t newest = ((CONSUMER_QUEUE_DEPTH - 2) & 1) ? VOLUME_UP : VOLUME_DOWN;
+    for (int i = 0; i < 3 * CONSUMER_QUEUE_DEPTH; i++) {
+        uint16_t usage = (i & 1) ? VOLUME_UP : VOLUME_DOWN;
+        bool accepted = tap(&bus, usage);
+        // MUTE holds one entry and the rest fit until the queue is full;
+        // after that only the newest entry's usage still coalesces
+        bool should = i < CONSUMER_QUEUE_DEPTH - 1 || usage == newest;
+        if (accepted != should) {
+            fail("full: tap %d %s", i, accepted ? "accepted into a full queue" : "refused");
+        }
+        refused += !accepted;
+    }
+    if (bus.queue.dropped != refused) {
+        fail("full: dropped %u, refused %u", bus.queue.dropped, refused);
+    }
+    drain(&bus);
+    check_delivery(&bus, "full");
+    printf("  %-34s %s\n", "alternating usages, queue full", failures == before ? "ok" : "FAILED");
+}
+
+// Random bursts while reports are in flight, refused by the stack and
+// collected after random delays
+static void test_random(void) {
+    uint32_t before = failures;
+    static const uint16_t usages[] = {VOLUME_UP, VOLUME_DOWN, MUTE};
+    bus_init(&bus, 100, 4);
+
+    for (int step = 0; step < 200000 && bus.num_queued < MAX_TAPS - 64; step++) {
+        if (rnd(40) == 0) {
+            uint16_t usage = usages[rnd(3)];
+            for (uint32_t k = 1 + rnd(rnd(4) ? 3 : 40); k > 0; k--) {
+                tap(&bus, rnd(20) ? usage : usages[rnd(3)]);
+            }
+        }
+        if (rnd(50) == 0) {
+            tap(&bus, 0);           // Ignored
+        }
+        poll(&bus);
+    }
+    drain(&bus);
+    check_delivery(&bus, "random");
+    printf("  %-34s %s (%u taps, %u dropped)\n", "random bursts, refused reports", failures == before ? "ok" : "FAILED",
+           bus.num_received, bus.queue.dropped);
+}
+
+// Clearing mid-tap (protocol switch or unmount) leaves the queue usable
+static void test_clear(void) {
+    uint32_t before = failures;
+    uint16_t report;
+    bus_init(&bus, 0, 0);
+
+    tap(&bus, VOLUME_UP);
+    tap(&bus, MUTE);
+    poll(&bus);
+    consumer_queue_clear(&bus.queue);
+    if (consumer_queue_busy(&bus.queue) || consumer_queue_next(&bus.queue, &report)) {
+        fail("clear: still busy");
+    }
+    // The completion of the lost report must not advance anything
+    consumer_queue_complete(&bus.queue);
+    if (consumer_queue_busy(&bus.queue)) {
+        fail("clear: late completion made the queue busy");
+    }
+
+    bus_init(&bus, 0, 1);
+    for (int i = 0; i < 5; i++) {
+        tap(&bus, VOLUME_DOWN);
+    }
+    drain(&bus);
+    check_delivery(&bus, "after clear");
+    printf("  %-34s %s\n", "clear while in flight", failures == before ? "ok" : "FAILED");
+}
+
+int main(void) {
+    printf("consumer_queue, depth %d:\n", CONSUMER_QUEUE_DEPTH);
+    test_burst();
+    test_saturation();
+    test_full();
+    test_random();
+    test_clear();
+
+    printf("\n%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
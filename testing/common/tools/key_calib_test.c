@@ -0,0 +1,210 @@
+// Host test of the per-key calibration (key_calib.c) across a reboot: a
+// table is learned and exported, the rest readings then move (temperature,
+// a reseated magnet) by more than the drift-tracking band, and the table
+// is imported into a fresh calibration as the firmware does at boot. Checks
+// that
+//   - a resting key whose rest moved either way, by any amount short of a
+//     press, reads 0 travel once it has read the same for two frames, and
+//     reaches full travel at its new rest plus the imported range,
+//   - a key whose range is unknown gets its rest back the same way,
+//   - a key held down through boot keeps the stored rest, so it reads
+//     pressed, until it is let go, and then takes rest where it settles,
+//   - a key still moving at boot waits until it is steady,
+//   - the imported ranges are never touched and the table stays clean,
+//   - a calibration started without a table takes rest from the first frame.
+//
+// Build and run from testing/common:
+//   cc -O2 -I. tools/key_calib_test.c key_calib.c -o key_calib_test
+//   ./key_calib_test
+
+#include "key_calib.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NUM_KEYS 8
+#define REST     2000
+
+static uint32_t failures;
+
+static void fail(const char *fmt, ...) {
+    if (failures++ < 20) {
+        va_list args;
+        va_start(args, fmt);
+        printf("    FAIL: ");
+        vprintf(fmt, args);
+        printf("\n");
+        va_end(args);
+    }
+}
+
+// Ranges learned before the reboot: both mounting directions, one unknown
+static const int16_t ranges[NUM_KEYS] = {900, -900, 700, -700, 1000, 0, 900, 900};
+
+static key_calib_t calib;
+static uint8_t record[KEY_CALIB_RECORD_SIZE(NUM_KEYS)];
+
+static void learn_table(void) {
+    uint16_t raw[NUM_KEYS], travel[NUM_KEYS];
+
+    key_calib_init(&calib, NUM_KEYS, 0);
+    for (int key = 0; key < NUM_KEYS; key++) {
+        raw[key] = REST;
+    }
+    key_calib_process(&calib, raw, travel);
+    // Bottom out every key with a known range once
+    for (int key = 0; key < NUM_KEYS; key++) {
+        if (ranges[key] == 0) {
+            continue;
+        }
+        raw[key] = (uint16_t)(REST + ranges[key]);
+        key_calib_process(&calib, raw, travel);
+        raw[key] = REST;
+        key_calib_process(&calib, raw, travel);
+    }
+    if (key_calib_export(&calib, record, sizeof(record)) != sizeof(record)) {
+        fail("export failed");
+    }
+}
+
+static void boot(void) {
+    key_calib_init(&calib, NUM_KEYS, 0);
+    if (!key_calib_import(&calib, record, sizeof(record))) {
+        fail("import failed");
+    }
+}
+
+static void check_ranges(const char *name) {
+    for (int key = 0; key < NUM_KEYS; key++) {
+        if (calib.range[key] != ranges[key]) {
+            fail("%s: key %d range %d, imported %d", name, key, calib.range[key], ranges[key]);
+        }
+    }
+    if (calib.dirty) {
+        fail("%s: table dirty", name);
+    }
+}
+
+// Every key's rest moved by offset raw counts since the save, or with away
+// set, by offset counts away from the way the key is pressed
+static void test_drift(const char *name, int32_t offset, int32_t unknown_offset, bool away) {
+    uint32_t before = failures;
+    uint16_t raw[NUM_KEYS], travel[NUM_KEYS];
+
+    boot();
+    for (int key = 0; key < NUM_KEYS; key++) {
+        int32_t moved = ranges[key] == 0 ? unknown_offset : away && ranges[key] > 0 ? -offset : offset;
+        raw[key] = (uint16_t)(REST + moved);
+    }
+    for (int frame = 0; frame < 3; frame++) {
+        key_calib_process(&calib, raw, travel);
+    }
+    for (int key = 0; key < NUM_KEYS; key++) {
+        if (travel[key] != 0) {
+            fail("%s: key %d reads travel %u at its new rest", name, key, travel[key]);
+        }
+        if (calib.rest[key] != raw[key]) {
+            fail("%s: key %d rest %u, reading %u", name, key, calib.rest[key], raw[key]);
+        }
+    }
+    // Full travel is the imported range from the new rest
+    for (int key = 0; key < NUM_KEYS; key++) {
+        if (ranges[key] == 0) {
+            continue;
+        }
+        uint16_t rest = raw[key];
+        raw[key] = (uint16_t)(rest + ranges[key]);
+        key_calib_process(&calib, raw, travel);
+        // The fixed-point scale rounds down by up to a count
+        if (travel[key] < KEY_CALIB_TRAVEL_MAX - 1) {
+            fail("%s: key %d bottomed out reads %u", name, key, travel[key]);
+        }
+        raw[key] = rest;
+        key_calib_process(&calib, raw, travel);
+    }
+    check_ranges(name);
+    printf("  %-34s %s\n", name, failures == before ? "ok" : "FAILED");
+}
+
+// Key 0 is held halfway down through boot, key 6 is still moving
+static void test_held(void) {
+    uint32_t before = failures;
+    uint16_t raw[NUM_KEYS], travel[NUM_KEYS];
+    const uint16_t drift = 60;
+
+    boot();
+    for (int key = 0; key < NUM_KEYS; key++) {
+        raw[key] = REST + drift;
+    }
+    raw[0] = REST + drift + ranges[0] / 2;
+    for (int frame = 0; frame < 20; frame++) {
+        raw[6] = (uint16_t)(REST + drift + (frame & 1) * 3 * KEY_CALIB_REST_BAND);
+        key_calib_process(&calib, raw, travel);
+        if (calib.rest[0] != REST) {
+            fail("held: rest taken while held (frame %d)", frame);
+            break;
+        }
+        if (frame > 0 && travel[0] < KEY_CALIB_TRAVEL_MAX / 3) {
+            fail("held: reads travel %u while held halfway", travel[0]);
+            break;
+        }
+        if (calib.rest[6] != REST) {
+            fail("held: rest of a moving key taken (frame %d)", frame);
+            break;
+        }
+    }
+
+    // Let both go: each takes rest once it has read the same twice
+    raw[0] = raw[6] = REST + drift;
+    key_calib_process(&calib, raw, travel);
+    if (calib.rest[0] != REST) {
+        fail("held: rest taken on the release frame");
+    }
+    key_calib_process(&calib, raw, travel);
+    if (calib.rest[0] != REST + drift || calib.rest[6] != REST + drift || travel[0] != 0 || travel[6] != 0) {
+        fail("held: after release rest %u/%u, travel %u/%u", calib.rest[0], calib.rest[6], travel[0], travel[6]);
+    }
+    if (calib.reseat_left != 0) {
+        fail("held: %u keys still waiting", calib.reseat_left);
+    }
+    check_ranges("held");
+    printf("  %-34s %s\n", "held and moving through boot", failures == before ? "ok" : "FAILED");
+}
+
+// Without a table rest comes from the very first frame
+static void test_first_boot(void) {
+    uint32_t before = failures;
+    uint16_t raw[NUM_KEYS], travel[NUM_KEYS];
+
+    key_calib_init(&calib, NUM_KEYS, 0);
+    for (int key = 0; key < NUM_KEYS; key++) {
+        raw[key] = (uint16_t)(REST + 37 * key);
+    }
+    key_calib_process(&calib, raw, travel);
+    for (int key = 0; key < NUM_KEYS; key++) {
+        if (calib.rest[key] != raw[key] || travel[key] != 0) {
+            fail("first boot: key %d rest %u, reading %u", key, calib.rest[key], raw[key]);
+        }
+    }
+    if (calib.reseat_left != 0) {
+        fail("first boot: %u keys waiting to re-take rest", calib.reseat_left);
+    }
+    printf("  %-34s %s\n", "first boot, no table", failures == before ? "ok" : "FAILED");
+}
+
+int main(void) {
+    printf("key_calib rest after a reboot (band %d, held from %d counts):\n", KEY_CALIB_REST_BAND,
+           KEY_CALIB_RESEAT_HELD);
+    learn_table();
+    test_drift("no drift", 0, 0, false);
+    test_drift("drift of 60 counts up", 60, 60, false);
+    test_drift("drift of 60 counts down", -60, -60, false);
+    // Away from the pressed direction any amount is rest; an unknown range
+    // has no such side
+    test_drift("drift of 600 counts, not pressing", 600, 1 - KEY_CALIB_RESEAT_HELD, true);
+    test_held();
+    test_first_boot();
+
+    printf("\n%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
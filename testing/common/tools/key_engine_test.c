@@ -0,0 +1,339 @@
+// Host test of the rapid-trigger key engine (key_engine.c) replaying travel
+// curves: one travel value per scan frame, as keys.c feeds it, for a plain
+// tap, a press held with jitter, rapid up/down wiggles, a slow press
+// dithering around the actuation point and a key fluttered near the top of
+// its travel. Each curve is replayed under three configurations
+// and the frames at which the key presses and releases must match the
+// events worked out by hand in the comments:
+//   static  actuation 100, release 80, no rapid trigger (hysteresis only)
+//   rt      actuation 100, release 80, rapid trigger 20 down / 20 up
+//   cont    actuation 100, release 0, rapid trigger 20 / 20: continuous
+//           rapid trigger, the zone lasts all the way back to rest
+// All curves are then replayed at once on neighbouring keys (the changed
+// bitmap and count must match), and long random curves with random
+// configurations are checked against a separate reference model of the
+// rules in key_engine.h.
+//
+// Build and run from testing/common:
+//   cc -O2 -I. tools/key_engine_test.c key_engine.c -o key_engine_test
+//   ./key_engine_test
+
+#include "key_engine.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_EVENTS 16
+#define RANDOM_KEYS 64
+#define RANDOM_FRAMES 200000
+
+enum { STATIC, RT, CONT, CONFIGS };
+
+static const key_engine_config_t configs[CONFIGS] = {
+    [STATIC] = {.actuation = 100, .release = 80, .rt_down = 0, .rt_up = 0},
+    [RT] = {.actuation = 100, .release = 80, .rt_down = 20, .rt_up = 20},
+    [CONT] = {.actuation = 100, .release = 0, .rt_down = 20, .rt_up = 20},
+};
+
+static const char *config_names[CONFIGS] = {"static", "rt", "cont"};
+
+// Event: +frame = pressed at that frame, -frame = released
+typedef struct {
+    const char *name;
+    const uint16_t *travel;
+    uint16_t frames;
+    int16_t events[CONFIGS][MAX_EVENTS];    // Terminated by 0 (frame 0 never changes)
+} curve_t;
+
+// Press to bottom-out, straight back up. rt: 235 is still within 20 of the
+// 240 peak, 200 is not (release at 13). static: first value below 80 (18).
+static const uint16_t tap[] = {0, 10, 30, 60, 90, 99, 100, 130, 180, 220, 240, 240, 235, 200, 150, 100,
+                               81, 80, 79, 50, 10, 0};
+
+// Held around 150 with jitter under the rapid trigger distance (peak 160,
+// lowest 141): no chatter in any mode, released by the drop to 0.
+static const uint16_t hold_jitter[] = {0, 50, 100, 150, 160, 145, 158, 142, 155, 141, 150, 160, 141, 150, 0};
+
+// Wiggles above the release point. rt: up 20 from 210 (6), down 20 from
+// 185 (10), up 20 from 206 (13), down 20 from 170 (17), up from 190 (18),
+// 79 leaves the zone, then a fresh press at the actuation point (25).
+// static: holds from 2 until 79 (21). cont: 79 does not end the zone, so
+// 85 is 20 down from the 60 low point (23).
+static const uint16_t rapid[] = {0, 60, 120, 200, 210, 195, 190, 185, 195, 204, 205, 206, 190, 186, 170, 175,
+                                 189, 190, 150, 120, 90, 79, 60, 85, 99, 100, 0};
+
+// Dithering 94-103 around the actuation point: one press, no chatter, and
+// the release at 60 in every mode (below 80, or 20 up from the 103 peak).
+static const uint16_t noisy_actuation[] = {0, 90, 97, 101, 96, 99, 103, 95, 98, 102, 97, 100, 94, 60, 0};
+
+// Press, then flutter near the top. rt: released at 150, zone ends at 30.
+// static: released at 30. cont: 20 down from 30 (5), 20 up from 50 (6),
+// 20 down from 5 (8), 20 up from 40 (11), 20 down from 20 (13), 0 (14).
+static const uint16_t flutter[] = {0, 100, 200, 150, 30, 50, 10, 5, 25, 40, 21, 20, 39, 40, 0};
+
+#define CURVE(c) c, sizeof(c) / sizeof(c[0])
+
+static const curve_t curves[] = {
+    {"tap", CURVE(tap), {
+        [STATIC] = {6, -18},
+        [RT] = {6, -13},
+        [CONT] = {6, -13},
+    }},
+    {"hold with jitter", CURVE(hold_jitter), {
+        [STATIC] = {2, -14},
+        [RT] = {2, -14},
+        [CONT] = {2, -14},
+    }},
+    {"rapid wiggles", CURVE(rapid), {
+        [STATIC] = {2, -21, 25, -26},
+        [RT] = {2, -6, 10, -13, 17, -18, 25, -26},
+        [CONT] = {2, -6, 10, -13, 17, -18, 23, -26},
+    }},
+    {"noisy actuation", CURVE(noisy_actuation), {
+        [STATIC] = {3, -13},
+        [RT] = {3, -13},
+        [CONT] = {3, -13},
+    }},
+    {"flutter near the top", CURVE(flutter), {
+        [STATIC] = {1, -4},
+        [RT] = {1, -3},
+        [CONT] = {1, -3, 5, -6, 8, -11, 13, -14},
+    }},
+};
+
+#define NUM_CURVES (sizeof(curves) / sizeof(curves[0]))
+
+static uint32_t failures;
+static uint32_t rng = 1;
+
+static uint32_t rnd(uint32_t n) {
+    rng = rng * 1664525u + 1013904223u;
+    return (rng >> 8) % n;
+}
+
+static void fail(const char *fmt, ...) {
+    if (failures++ < 20) {
+        va_list args;
+        va_start(args, fmt);
+        printf("    FAIL: ");
+        vprintf(fmt, args);
+        printf("\n");
+        va_end(args);
+    }
+}
+
+static void format_events(const int16_t *events, int count, char *out, size_t size) {
+    size_t n = 0;
+    out[0] = 0;
+    for (int i = 0; i < count && n < size; i++) {
+        n += (size_t) snprintf(out + n, size - n, "%s%+d", i ? " " : "", events[i]);
+    }
+}
+
+static void test_curves(void) {
+    for (size_t c = 0; c < NUM_CURVES; c++) {
+        const curve_t *curve = &curves[c];
+        uint32_t before = failures;
+        for (int cfg = 0; cfg < CONFIGS; cfg++) {
+            key_engine_t engine;
+            key_engine_init(&engine, 1, &configs[cfg]);
+            int16_t got[MAX_EVENTS];
+            int count = 0;
+            for (uint16_t f = 0; f < curve->frames; f++) {
+                uint8_t changed[1] = {0};
+                if (key_engine_process(&engine, &curve->travel[f], changed) && count < MAX_EVENTS) {
+                    got[count++] = (int16_t)(key_engine_is_pressed(&engine, 0) ? f : -f);
+                }
+            }
+            int want = 0;
+            while (want < MAX_EVENTS && curve->events[cfg][want]) {
+                want++;
+            }
+            if (count != want || memcmp(got, curve->events[cfg], (size_t) count * sizeof(got[0])) != 0) {
+                char a[128], b[128];
+                format_events(got, count, a, sizeof(a));
+                format_events(curve->events[cfg], want, b, sizeof(b));
+                fail("%s, %s: events [%s], expected [%s]", curve->name, config_names[cfg], a, b);
+            }
+        }
+        printf("  %-24s %s\n", curve->name, failures == before ? "ok" : "FAILED");
+    }
+}
+
+// Every curve on its own key, all keys in one engine
+static void test_curves_together(void) {
+    uint32_t before = failures;
+    for (int cfg = 0; cfg < CONFIGS; cfg++) {
+        key_engine_t engine;
+        key_engine_init(&engine, NUM_CURVES, &configs[cfg]);
+        uint16_t longest = 0;
+        for (size_t c = 0; c < NUM_CURVES; c++) {
+            longest = curves[c].frames > longest ? curves[c].frames : longest;
+        }
+        for (uint16_t f = 0; f < longest; f++) {
+            uint16_t travel[NUM_CURVES];
+            uint8_t changed[(NUM_CURVES + 7) / 8] = {0}, want_changed[(NUM_CURVES + 7) / 8] = {0};
+            uint16_t want_count = 0;
+            for (size_t c = 0; c < NUM_CURVES; c++) {
+                travel[c] = f < curves[c].frames ? curves[c].travel[f] : 0;
+                for (int e = 0; e < MAX_EVENTS && curves[c].events[cfg][e]; e++) {
+                    int16_t ev = curves[c].events[cfg][e];
+                    if (ev == f || ev == -f) {
+                        want_changed[c >> 3] |= (uint8_t)(1u << (c & 7));
+                        want_count++;
+                    }
+                }
+            }
+            uint16_t count = key_engine_process(&engine, travel, changed);
+            if (count != want_count || memcmp(changed, want_changed, sizeof(changed)) != 0) {
+                fail("%s, frame %u: %u changed (bitmap %02x), expected %u (%02x)", config_names[cfg], f, count,
+                     changed[0], want_count, want_changed[0]);
+            }
+        }
+    }
+    printf("  %-24s %s\n", "all curves at once", failures == before ? "ok" : "FAILED");
+}
+
+// ---------------------------------------------------------------------------
+// Reference model, written from the rules in key_engine.h
+
+typedef enum { REF_UP, REF_DOWN, REF_RT_UP } ref_state_t;
+
+typedef struct {
+    key_engine_config_t config;
+    ref_state_t state;
+    uint16_t peak;      // Deepest since pressed
+    uint16_t trough;    // Shallowest since released by rapid trigger
+} ref_key_t;
+
+// Returns true if the key's pressed state changed
+static bool ref_step(ref_key_t *k, uint16_t t) {
+    const key_engine_config_t *c = &k->config;
+    bool was_down = k->state == REF_DOWN;
+    if (t < c->release) {
+        k->state = REF_UP;
+    } else if (k->state == REF_UP) {
+        if (t >= c->actuation) {
+            k->state = REF_DOWN;
+            k->peak = t;
+        }
+    } else if (k->state == REF_DOWN) {
+        if (t > k->peak) {
+            k->peak = t;
+        } else if (c->rt_down && k->peak - t >= c->rt_up) {
+            k->state = REF_RT_UP;
+            k->trough = t;
+        }
+    } else {
+        if (t < k->trough) {
+            k->trough = t;
+        } else if (t - k->trough >= c->rt_down) {
+            k->state = REF_DOWN;
+            k->peak = t;
+        }
+    }
+    return was_down != (k->state == REF_DOWN);
+}
+
+static void random_config(key_engine_config_t *c) {
+    c->actuation = (uint16_t)(1 + rnd(250));
+    switch (rnd(3)) {
+        case 0:
+            c->release = 0;     // Continuous
+            break;
+        case 1:
+            c->release = c->actuation;
+            break;
+        default:
+            c->release = (uint16_t) rnd(c->actuation + 1u);
+            break;
+    }
+    c->rt_down = (uint16_t)(rnd(3) ? 1 + rnd(40) : 0);
+    c->rt_up = (uint16_t)(c->rt_down ? 1 + rnd(40) : 0);
+}
+
+static void test_random(void) {
+    uint32_t before = failures;
+    static ref_key_t ref[RANDOM_KEYS];
+    key_engine_t engine;
+    key_engine_init(&engine, RANDOM_KEYS, &configs[RT]);
+    for (uint16_t key = 0; key < RANDOM_KEYS; key++) {
+        random_config(&ref[key].config);
+        ref[key].state = REF_UP;
+        if (!key_engine_set_config(&engine, key, &ref[key].config)) {
+            fail("key %u: valid config rejected", key);
+        }
+    }
+
+    // Random walks with occasional jumps, clamped to 0-255
+    uint16_t travel[RANDOM_KEYS] = {0};
+    uint32_t changes = 0;
+    for (uint32_t f = 0; f < RANDOM_FRAMES; f++) {
+        uint8_t changed[KEY_ENGINE_BITMAP_BYTES] = {0};
+        for (uint16_t key = 0; key < RANDOM_KEYS; key++) {
+            int t = travel[key] + (int) rnd(31) - 15;
+            if (rnd(200) == 0) {
+                t = (int) rnd(256);
+            }
+            travel[key] = (uint16_t)(t < 0 ? 0 : t > 255 ? 255 : t);
+        }
+        uint16_t count = key_engine_process(&engine, travel, changed);
+        uint16_t want = 0;
+        for (uint16_t key = 0; key < RANDOM_KEYS; key++) {
+            bool ref_changed = ref_step(&ref[key], travel[key]);
+            bool got_changed = changed[key >> 3] & (1u << (key & 7));
+            want += ref_changed;
+            if (got_changed != ref_changed || key_engine_is_pressed(&engine, key) != (ref[key].state == REF_DOWN)) {
+                fail("frame %lu key %u (act %u rel %u rt %u/%u) travel %u: engine %s, reference %s",
+                     (unsigned long) f, key, ref[key].config.actuation, ref[key].config.release,
+                     ref[key].config.rt_down, ref[key].config.rt_up, travel[key],
+                     key_engine_is_pressed(&engine, key) ? "down" : "up", ref[key].state == REF_DOWN ? "down" : "up");
+                ref[key].state = key_engine_is_pressed(&engine, key) ? REF_DOWN : REF_UP;
+            }
+        }
+        if (count != want) {
+            fail("frame %lu: %u changes counted, %u flagged", (unsigned long) f, count, want);
+        }
+        changes += count;
+    }
+    printf("  %-24s %s (%d keys x %d frames, %lu changes)\n", "random vs reference",
+           failures == before ? "ok" : "FAILED", RANDOM_KEYS, RANDOM_FRAMES, (unsigned long) changes);
+}
+
+static void test_config_checks(void) {
+    uint32_t before = failures;
+    key_engine_t engine;
+    key_engine_config_t bad_act = {.actuation = 0}, bad_rel = {.actuation = 50, .release = 51},
+                        bad_rt = {.actuation = 50, .release = 40, .rt_down = 10, .rt_up = 0}, back;
+    if (key_engine_init(&engine, KEY_ENGINE_MAX_KEYS + 1, &configs[RT]) || key_engine_init(&engine, 4, &bad_act) ||
+        key_engine_init(&engine, 4, &bad_rel) || key_engine_init(&engine, 4, &bad_rt)) {
+        fail("bad key count or configuration accepted");
+    }
+    key_engine_init(&engine, 4, &configs[RT]);
+    if (key_engine_set_config(&engine, 4, &configs[CONT]) || !key_engine_set_config(&engine, 3, &configs[CONT])) {
+        fail("set_config key range");
+    }
+    key_engine_get_config(&engine, 3, &back);
+    if (memcmp(&back, &configs[CONT], sizeof(back)) != 0) {
+        fail("get_config does not return what was set");
+    }
+    // Reconfiguring a pressed key releases it without reporting a change
+    uint16_t deep[4] = {200, 200, 200, 200};
+    key_engine_process(&engine, deep, NULL);
+    key_engine_set_config(&engine, 0, &configs[STATIC]);
+    if (key_engine_is_pressed(&engine, 0) || !key_engine_is_pressed(&engine, 1)) {
+        fail("set_config did not reset only its key");
+    }
+    printf("  %-24s %s\n", "configuration checks", failures == before ? "ok" : "FAILED");
+}
+
+int main(void) {
+    printf("key_engine on recorded travel curves (static / rt / cont):\n");
+    test_curves();
+    test_curves_together();
+    test_random();
+    test_config_checks();
+
+    printf("\n%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,63 @@
+"""
+KLE layout to LED coordinate table
+
+Reads a keyboard-layout-editor JSON export (seung65_kle_layout.json at the
+repo root) and writes rgb_layout.c: the centre of every key, in KLE order,
+scaled to x 0-224 and y 0-64 (the RGB matrix convention), so effects never
+parse or scale positions at run time.
+
+Usage (from testing/common):
+    python tools/kle_layout.py ../../seung65_kle_layout.json > rgb_layout.c
+"""
+
+import json
+import sys
+
+X_MAX = 224
+Y_MAX = 64
+
+
+def key_centres(kle):
+    """Yield (label, x, y, w, h) key centres and sizes in key units, in KLE order."""
+    y = 0.0
+    for row in kle:
+        if not isinstance(row, list):
+            continue                        # Keyboard metadata
+        x = 0.0
+        w = h = 1.0
+        for item in row:
+            if isinstance(item, dict):
+                x += item.get("x", 0.0)
+                y += item.get("y", 0.0)
+                w = item.get("w", w)
+                h = item.get("h", h)
+                continue
+            yield item.split("\n")[-1], x + w / 2, y + h / 2, w, h
+            x += w
+            w = h = 1.0
+        y += 1.0
+
+
+def main():
+    with open(sys.argv[1], encoding="utf-8") as f:
+        keys = list(key_centres(json.load(f)))
+
+    width = max(x + w / 2 for _, x, _, w, _ in keys)
+    height = max(y + h / 2 for _, _, y, _, h in keys)
+
+    print("// Generated by tools/kle_layout.py from seung65_kle_layout.json; do not edit.")
+    print('#include "rgb_layout.h"')
+    print()
+    print("_Static_assert(RGB_LAYOUT_LED_COUNT == %d, \"layout size\");" % len(keys))
+    print()
+    print("const rgb_layout_point_t rgb_layout[RGB_LAYOUT_LED_COUNT] = {")
+    for i, (label, x, y, _, _) in enumerate(keys):
+        px = round(x * X_MAX / width)
+        py = round(y * Y_MAX / height)
+        # A trailing backslash would continue the comment onto the next line
+        print("    {%3d, %2d},   // %2d %s" % (px, py, i, label.replace("\\", "Backslash")))
+    print("};")
+
+
+if __name__ == "__main__":
+    main()
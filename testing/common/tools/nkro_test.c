@@ -0,0 +1,342 @@
+// Host test of the NKRO keyboard state and its report (nkro.c, nkro.h).
+//   - NKRO_REPORT_DESC, with and without a report ID, is walked item by item
+//     like a host parser would: one input report of NKRO_REPORT_SIZE bytes,
+//     one 1-byte LED output report, balanced collections, and every usage
+//     0x00-0xE7 mapped to exactly one input bit,
+//   - each usage pressed alone sets exactly the bit the descriptor gives it,
+//   - random sets of 20-60 keys (and modifiers) pressed and released in
+//     random order: the report read back through the descriptor's bit map
+//     matches a reference set after every change, and the boot report
+//     lists the keys for up to six and ErrorRollOver beyond that,
+//   - every usage down at once, ignored usages and the pending flag.
+//
+// Build and run from testing/common:
+//   cc -O2 -I. tools/nkro_test.c nkro.c -o nkro_test
+//   ./nkro_test
+
+#include "nkro.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#define USAGES (NKRO_MODIFIER_LAST + 1)
+#define TEST_REPORT_ID 3
+#define TRIALS 2000
+
+static uint32_t failures;
+static uint32_t rng = 1;
+
+static uint32_t rnd(uint32_t n) {
+    rng = rng * 1664525u + 1013904223u;
+    return (rng >> 8) % n;
+}
+
+static void fail(const char *fmt, ...) {
+    if (failures++ < 20) {
+        va_list args;
+        va_start(args, fmt);
+        printf("    FAIL: ");
+        vprintf(fmt, args);
+        printf("\n");
+        va_end(args);
+    }
+}
+
+static const uint8_t desc_plain[] = {NKRO_REPORT_DESC()};
+static const uint8_t desc_with_id[] = {NKRO_REPORT_DESC(NKRO_REPORT_ID(TEST_REPORT_ID))};
+
+// What the descriptor says about the keyboard page inputs and the outputs
+typedef struct {
+    uint32_t input_bits;
+    uint32_t output_bits;
+    uint8_t report_id;
+    int16_t bit_of_usage[USAGES];       // Input bit offset per usage, -1 if none
+    bool ok;
+} layout_t;
+
+static void parse(const uint8_t *desc, size_t len, layout_t *out) {
+    uint32_t usage_page = 0, report_size = 0, report_count = 0;
+    uint32_t usage_min = 0, usage_max = 0;
+    bool have_range = false;
+    int depth = 0;
+
+    memset(out, 0, sizeof(*out));
+    memset(out->bit_of_usage, 0xFF, sizeof(out->bit_of_usage));
+    out->ok = true;
+
+    for (size_t i = 0; i < len;) {
+        uint8_t prefix = desc[i];
+        uint8_t size = (prefix & 3) == 3 ? 4 : (prefix & 3);
+        if (prefix == 0xFE || i + 1 + size > len) {
+            fail("descriptor: bad item 0x%02x at %zu", prefix, i);
+            out->ok = false;
+            return;
+        }
+        uint32_t value = 0;
+        for (uint8_t b = 0; b < size; b++) {
+            value |= (uint32_t) desc[i + 1 + b] << (8 * b);
+        }
+        i += 1u + size;
+
+        switch (prefix & 0xFC) {
+        case 0x04: usage_page = value; break;
+        case 0x74: report_size = value; break;
+        case 0x94: report_count = value; break;
+        case 0x84: out->report_id = (uint8_t) value; break;
+        case 0x18: usage_min = value; have_range = true; break;
+        case 0x28: usage_max = value; have_range = true; break;
+        case 0xA0: depth++; break;
+        case 0xC0: depth--; break;
+        case 0x90: out->output_bits += report_size * report_count; break;
+        case 0x80:
+            // Variable items on the keyboard page map one usage per field
+            if (usage_page == 0x07 && (value & 0x02) && have_range) {
+                if (report_size != 1 || usage_max - usage_min + 1 != report_count || usage_max >= USAGES) {
+                    fail("descriptor: input range 0x%02x-0x%02x, %u x %u bits", usage_min, usage_max,
+                         report_count, report_size);
+                    out->ok = false;
+                } else {
+                    for (uint32_t u = usage_min; u <= usage_max; u++) {
+                        if (out->bit_of_usage[u] >= 0) {
+                            fail("descriptor: usage 0x%02x mapped twice", u);
+                            out->ok = false;
+                        }
+                        out->bit_of_usage[u] = (int16_t)(out->input_bits + (u - usage_min));
+                    }
+                }
+            }
+            out->input_bits += report_size * report_count;
+            break;
+        default:
+            break;
+        }
+        // Local items apply to the next main item only
+        if ((prefix & 0x0C) == 0x00) {
+            have_range = false;
+        }
+        if (depth < 0) {
+            fail("descriptor: End Collection without Collection");
+            out->ok = false;
+        }
+    }
+    if (depth != 0) {
+        fail("descriptor: %d collections left open", depth);
+        out->ok = false;
+    }
+}
+
+static void test_descriptor(const char *name, const uint8_t *desc, size_t len, uint8_t report_id,
+                            layout_t *layout) {
+    uint32_t before = failures;
+    parse(desc, len, layout);
+    if (layout->input_bits != NKRO_REPORT_SIZE * 8) {
+        fail("%s: %u input bits, expected %u", name, layout->input_bits, NKRO_REPORT_SIZE * 8);
+    }
+    if (layout->output_bits != 8) {
+        fail("%s: %u output bits, expected 8", name, layout->output_bits);
+    }
+    if (layout->report_id != report_id) {
+        fail("%s: report ID %u, expected %u", name, layout->report_id, report_id);
+    }
+    for (uint32_t u = 1; u < USAGES; u++) {
+        if (layout->bit_of_usage[u] < 0) {
+            fail("%s: usage 0x%02x has no input bit", name, u);
+        }
+    }
+    printf("  %-30s %s (%zu bytes)\n", name, failures == before ? "ok" : "FAILED", len);
+}
+
+static bool report_bit(const uint8_t *report, int16_t bit) {
+    return (report[bit / 8] >> (bit % 8)) & 1;
+}
+
+// Compare the report, read through the descriptor, with the reference set
+static void check_report(const layout_t *layout, const nkro_t *nkro, const bool *down, const char *what) {
+    uint8_t report[NKRO_REPORT_SIZE];
+    if (nkro_build_report(nkro, false, report) != NKRO_REPORT_SIZE) {
+        fail("%s: report length", what);
+        return;
+    }
+    for (uint32_t u = 1; u < USAGES; u++) {
+        if (report_bit(report, layout->bit_of_usage[u]) != down[u] || nkro_is_set(nkro, (uint8_t) u) != down[u]) {
+            fail("%s: usage 0x%02x %s", what, u, down[u] ? "missing" : "reported but up");
+            return;
+        }
+    }
+}
+
+static void check_boot_report(const nkro_t *nkro, const bool *down, const char *what) {
+    uint8_t report[NKRO_BOOT_REPORT_SIZE + 1];
+    report[NKRO_BOOT_REPORT_SIZE] = 0xA5;
+    if (nkro_build_report(nkro, true, report) != NKRO_BOOT_REPORT_SIZE || report[NKRO_BOOT_REPORT_SIZE] != 0xA5) {
+        fail("%s: boot report length", what);
+        return;
+    }
+
+    uint8_t modifiers = 0, keys[NKRO_BOOT_KEYS] = {0}, count = 0, total = 0;
+    for (uint32_t u = 1; u < USAGES; u++) {
+        if (!down[u]) {
+            continue;
+        }
+        if (u >= NKRO_MODIFIER_FIRST) {
+            modifiers |= (uint8_t)(1u << (u - NKRO_MODIFIER_FIRST));
+        } else if (++total <= NKRO_BOOT_KEYS) {
+            keys[count++] = (uint8_t) u;
+        }
+    }
+    if (total > NKRO_BOOT_KEYS) {
+        memset(keys, NKRO_ERROR_ROLLOVER, sizeof(keys));
+    }
+    if (report[0] != modifiers || report[1] != 0 || memcmp(&report[2], keys, sizeof(keys)) != 0) {
+        fail("%s: boot report with %u keys wrong", what, total);
+    }
+}
+
+static void test_single_keys(const layout_t *layout) {
+    uint32_t before = failures;
+    nkro_t nkro;
+    bool down[USAGES];
+
+    for (uint32_t u = 1; u < USAGES; u++) {
+        nkro_init(&nkro);
+        memset(down, 0, sizeof(down));
+        nkro_set(&nkro, (uint8_t) u, true);
+        down[u] = true;
+        check_report(layout, &nkro, down, "single key");
+        check_boot_report(&nkro, down, "single key");
+        if (nkro.num_keys != (u < NKRO_MODIFIER_FIRST)) {
+            fail("usage 0x%02x: num_keys %u", u, nkro.num_keys);
+        }
+    }
+    printf("  %-30s %s\n", "each usage alone", failures == before ? "ok" : "FAILED");
+}
+
+static void test_many_keys(const layout_t *layout) {
+    uint32_t before = failures;
+    nkro_t nkro;
+    bool down[USAGES];
+    uint8_t pressed[64];
+    uint32_t most = 0;
+
+    for (int trial = 0; trial < TRIALS; trial++) {
+        nkro_init(&nkro);
+        memset(down, 0, sizeof(down));
+
+        // Press 20-60 distinct usages (modifiers included) one at a time
+        uint32_t n = 20 + rnd(41), keys = 0;
+        for (uint32_t k = 0; k < n; k++) {
+            uint8_t u;
+            do {
+                u = (uint8_t)(1 + rnd(USAGES - 1));
+            } while (down[u]);
+            pressed[k] = u;
+            down[u] = true;
+            keys += u < NKRO_MODIFIER_FIRST;
+            nkro_set(&nkro, u, true);
+            if (!nkro_pending(&nkro)) {
+                fail("press of 0x%02x not pending", u);
+            }
+            nkro_mark_sent(&nkro);
+            check_report(layout, &nkro, down, "pressing");
+            check_boot_report(&nkro, down, "pressing");
+        }
+        if (nkro.num_keys != keys) {
+            fail("%u keys down, num_keys %u", keys, nkro.num_keys);
+        }
+        most = keys > most ? keys : most;
+
+        // Pressing a held key again changes nothing
+        nkro_set(&nkro, pressed[rnd(n)], true);
+        if (nkro_pending(&nkro)) {
+            fail("repeat press marked pending");
+        }
+
+        // Release in a random order
+        for (uint32_t k = n; k > 0; k--) {
+            uint32_t pick = rnd(k);
+            uint8_t u = pressed[pick];
+            pressed[pick] = pressed[k - 1];
+            down[u] = false;
+            nkro_set(&nkro, u, false);
+            if (!nkro_pending(&nkro)) {
+                fail("release of 0x%02x not pending", u);
+            }
+            nkro_mark_sent(&nkro);
+            check_report(layout, &nkro, down, "releasing");
+            check_boot_report(&nkro, down, "releasing");
+        }
+        if (nkro.num_keys != 0 || nkro.modifiers != 0) {
+            fail("keys left after releasing all");
+        }
+    }
+    printf("  %-30s %s (up to %u keys plus modifiers)\n", "20-60 keys at once", failures == before ? "ok" : "FAILED",
+           most);
+}
+
+static void test_all_and_ignored(const layout_t *layout) {
+    uint32_t before = failures;
+    nkro_t nkro;
+    bool down[USAGES];
+
+    nkro_init(&nkro);
+    memset(down, 0, sizeof(down));
+    for (uint32_t u = 1; u < USAGES; u++) {
+        nkro_set(&nkro, (uint8_t) u, true);
+        down[u] = true;
+    }
+    check_report(layout, &nkro, down, "all keys");
+    check_boot_report(&nkro, down, "all keys");
+    if (nkro.num_keys != NKRO_BITMAP_USAGES - 1) {
+        fail("all keys: num_keys %u", nkro.num_keys);
+    }
+
+    // Usage 0 and anything above Right GUI are ignored
+    nkro_mark_sent(&nkro);
+    nkro_set(&nkro, 0, true);
+    nkro_set(&nkro, NKRO_MODIFIER_LAST + 1, true);
+    nkro_set(&nkro, 0xFF, false);
+    if (nkro_pending(&nkro) || nkro_is_set(&nkro, 0) || nkro_is_set(&nkro, 0xFF)) {
+        fail("ignored usages changed the state");
+    }
+
+    nkro_clear(&nkro);
+    memset(down, 0, sizeof(down));
+    if (!nkro_pending(&nkro)) {
+        fail("clear with keys down not pending");
+    }
+    check_report(layout, &nkro, down, "cleared");
+    nkro_mark_sent(&nkro);
+    nkro_clear(&nkro);
+    if (nkro_pending(&nkro)) {
+        fail("clear with nothing down marked pending");
+    }
+    nkro_invalidate(&nkro);
+    if (!nkro_pending(&nkro)) {
+        fail("invalidate not pending");
+    }
+    if (nkro_report_size(true) != NKRO_BOOT_REPORT_SIZE || nkro_report_size(false) != NKRO_REPORT_SIZE) {
+        fail("nkro_report_size");
+    }
+    printf("  %-30s %s\n", "all keys, ignored, pending", failures == before ? "ok" : "FAILED");
+}
+
+int main(void) {
+    layout_t plain, with_id;
+
+    printf("NKRO report descriptor:\n");
+    test_descriptor("without report ID", desc_plain, sizeof(desc_plain), 0, &plain);
+    test_descriptor("with report ID", desc_with_id, sizeof(desc_with_id), TEST_REPORT_ID, &with_id);
+    if (memcmp(plain.bit_of_usage, with_id.bit_of_usage, sizeof(plain.bit_of_usage)) != 0) {
+        fail("report ID changes the bit layout");
+    }
+
+    if (plain.ok) {
+        printf("\nNKRO reports (read through the descriptor) and boot reports:\n");
+        test_single_keys(&plain);
+        test_many_keys(&plain);
+        test_all_and_ignored(&plain);
+    }
+
+    printf("\n%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,201 @@
+// Host simulation of the power_mode policy on an 80-channel board laid out
+// like rp2350_c_hid (16 select groups of 5 muxes). Each scan reads every
+// channel in the tier's slice with a little noise, plus a fixed offset in
+// the low-power tiers for the shorter settle; keys press by ramping to
+// bottom-out over PRESS_RAMP_US.
+//
+// It checks the tier timeline, that noise and the low-power offset never
+// wake the board, and then presses a random key at a random moment in IDLE
+// and in SLEEP many times, reporting the true wake latency (press start to
+// first full-rate scan) next to the one the policy measures, and the ADC
+// conversions per second each tier costs.
+//
+// Build and run from testing/common:
+//   cc -O2 -I. tools/power_mode_sim.c power_mode.c latency_hist.c -o power_mode_sim
+//   ./power_mode_sim
+
+#include "power_mode.h"
+#include <stdio.h>
+#include <string.h>
+
+#define CHANNELS        80
+#define GROUPS          16
+#define ACTIVE_FRAME_US 420         // Free-running c_hid frame: 16 x (16 us settle + 5 x 2 us)
+#define NOISE           2           // +/- travel units
+#define LOW_POWER_SHIFT 3           // Reading offset with the short settle
+#define PRESS_RAMP_US   15000       // Rest to bottom-out
+#define HOLD_US         80000
+#define TRIALS          200
+
+static const power_config_t config = {
+    .tier = {
+        [POWER_TIER_ACTIVE] = {.interval_us = 0,     .slices = 1, .oversample = 0, .settle_us = 0, .led_brightness = 255},
+        [POWER_TIER_IDLE]   = {.interval_us = 5000,  .slices = 1, .oversample = 1, .settle_us = 8, .led_brightness = 64},
+        [POWER_TIER_SLEEP]  = {.interval_us = 10000, .slices = 4, .oversample = 1, .settle_us = 8, .led_brightness = 0},
+    },
+    .idle_after_ms = 5000,
+    .sleep_after_ms = 60000,
+    .wake_travel = 8,
+};
+
+static power_mode_t pm;
+static uint32_t now_us;
+static uint32_t rng = 12345;
+
+static uint32_t rnd(uint32_t n) {
+    rng = rng * 1664525u + 1013904223u;
+    return (rng >> 8) % n;
+}
+
+// One key press in flight
+static int press_key = -1;
+static uint32_t press_at;
+
+static uint8_t key_travel(int ch) {
+    if (ch != press_key || (int32_t)(now_us - press_at) < 0) {
+        return 0;
+    }
+    uint32_t t = now_us - press_at;
+    if (t < PRESS_RAMP_US) {
+        return (uint8_t)(255 * t / PRESS_RAMP_US);
+    }
+    if (t < PRESS_RAMP_US + HOLD_US) {
+        return 255;
+    }
+    return 0;
+}
+
+static uint64_t conversions[POWER_TIER_COUNT];
+static uint64_t tier_time_us[POWER_TIER_COUNT];
+
+// Run one scan in the current tier and advance time to the next
+static void scan(void) {
+    const power_tier_config_t *cfg = power_mode_tier_config(&pm);
+    power_tier_t tier = pm.tier;
+    uint8_t slice = pm.slice;
+    static uint8_t travel[CHANNELS];    // Channels outside the slice keep their last reading
+    bool any_pressed = false;
+    uint32_t sampled = 0;
+
+    for (int ch = 0; ch < CHANNELS; ch++) {
+        if (power_mode_scan_group(&pm, (uint16_t)(ch % GROUPS))) {
+            int t = key_travel(ch) + (int) rnd(2 * NOISE + 1) - NOISE;
+            if (tier != POWER_TIER_ACTIVE) {
+                t += LOW_POWER_SHIFT;
+            }
+            travel[ch] = (uint8_t)(t < 0 ? 0 : t > 255 ? 255 : t);
+            sampled++;
+        }
+        any_pressed |= travel[ch] >= 96;
+    }
+    conversions[tier] += sampled * (cfg->oversample ? cfg->oversample : 1);
+
+    // Time to the next scan: a wake starts it straight away
+    power_mode_update(&pm, now_us, slice, travel, any_pressed);
+    uint32_t interval = power_mode_tier_config(&pm)->interval_us;
+    uint32_t step = interval > ACTIVE_FRAME_US ? interval : ACTIVE_FRAME_US;
+    tier_time_us[tier] += step;
+    now_us += step;
+}
+
+static void run_until(uint32_t end_us) {
+    while ((int32_t)(now_us - end_us) < 0) {
+        scan();
+    }
+}
+
+static void print_timeline(void) {
+    static const char *names[] = {"ACTIVE", "IDLE", "SLEEP"};
+    power_tier_t last = pm.tier;
+    printf("Timeline (no keys from t = 0):\n  %8.3f s  %s\n", now_us / 1e6, names[last]);
+    uint32_t end = now_us + 70000000;
+    while ((int32_t)(now_us - end) < 0) {
+        scan();
+        if (pm.tier != last) {
+            last = pm.tier;
+            printf("  %8.3f s  %s\n", now_us / 1e6, names[last]);
+        }
+    }
+}
+
+typedef struct {
+    uint32_t min, max;
+    uint64_t sum;
+    uint32_t count;
+} span_t;
+
+static void span_add(span_t *s, uint32_t v) {
+    if (s->count == 0 || v < s->min) s->min = v;
+    if (v > s->max) s->max = v;
+    s->sum += v;
+    s->count++;
+}
+
+// Press a random key at a random time while in the given tier
+static void wake_trials(power_tier_t tier, const char *name) {
+    span_t truth = {0};
+    latency_hist_reset(&pm.stats.wake_latency);
+    uint32_t wakes_before = pm.stats.wakes;
+
+    for (int i = 0; i < TRIALS; i++) {
+        // Quiet until the tier is reached and every channel has its
+        // reference, then a random while longer
+        while (pm.tier != tier) {
+            scan();
+        }
+        run_until(now_us + 50000 + rnd(50000));
+
+        press_key = (int) rnd(CHANNELS);
+        press_at = now_us + rnd(config.tier[tier].interval_us);
+        while (pm.tier != POWER_TIER_ACTIVE || (int32_t)(now_us - press_at) < 0) {
+            scan();
+        }
+        span_add(&truth, now_us - press_at);   // First full-rate scan
+        scan();
+        run_until(press_at + PRESS_RAMP_US + HOLD_US + 1000);
+        press_key = -1;
+    }
+
+    const latency_hist_t *h = &pm.stats.wake_latency;
+    printf("  %-6s %4lu wakes  true %5.1f / %5.1f / %5.1f ms   measured %5.1f / %5.1f / %5.1f ms\n",
+           name, (unsigned long)(pm.stats.wakes - wakes_before), truth.min / 1000.0,
+           truth.sum / (double) truth.count / 1000, truth.max / 1000.0, h->min_us / 1000.0,
+           h->count ? h->sum_us / (double) h->count / 1000 : 0.0, h->max_us / 1000.0);
+}
+
+int main(void) {
+    if (!power_mode_init(&pm, CHANNELS, GROUPS, &config, 0)) {
+        printf("bad config\n");
+        return 1;
+    }
+
+    print_timeline();
+
+    // An hour asleep with noise: nothing may wake it
+    uint32_t wakes = pm.stats.wakes;
+    for (int minute = 0; minute < 60; minute++) {
+        run_until(now_us + 60000000);
+    }
+    printf("\nFalse wakes in 1 h of noise (+/-%d travel, %+d in low power): %lu\n",
+           NOISE, LOW_POWER_SHIFT, (unsigned long)(pm.stats.wakes - wakes));
+
+    // Non-key activity brings it back without counting a wake
+    power_mode_poke(&pm, now_us);
+    printf("Poke: tier %s, wakes %lu\n", pm.tier == POWER_TIER_ACTIVE ? "ACTIVE" : "not ACTIVE",
+           (unsigned long) pm.stats.wakes);
+
+    printf("\nWake latency min / avg / max, %d random presses per tier (ramp %d ms):\n",
+           TRIALS, PRESS_RAMP_US / 1000);
+    wake_trials(POWER_TIER_IDLE, "IDLE");
+    wake_trials(POWER_TIER_SLEEP, "SLEEP");
+
+    printf("\nScan cost per tier:\n");
+    static const char *names[] = {"ACTIVE", "IDLE", "SLEEP"};
+    for (int t = 0; t < POWER_TIER_COUNT; t++) {
+        double seconds = tier_time_us[t] / 1e6;
+        printf("  %-6s %9.0f conversions/s  %7.0f scans/s  LEDs %3d/255\n", names[t],
+               seconds ? conversions[t] / seconds : 0.0, seconds ? pm.stats.scans[t] / seconds : 0.0,
+               config.tier[t].led_brightness);
+    }
+    return 0;
+}
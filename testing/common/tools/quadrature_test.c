@@ -0,0 +1,267 @@
+// Host test of the quadrature decoder (quadrature.c) replaying recorded A/B
+// edge sequences, as the GPIO edge interrupt in encoder.c feeds them. Each
+// sequence lists the line state (A B) after every edge; the expected string
+// below it marks, edge by edge, where quad_decoder_update() must report a
+// detent ('+' / '-') and where nothing ('.'), worked out by hand from the
+// forward Gray order 00 -> 01 -> 11 -> 10 -> 00 with four steps per detent:
+// clean turns both ways, contact bounce on ordinary and detent edges,
+// direction reversals mid-detent and right after one, and missed states
+// (both lines changed at once) that must count as errors without moving.
+//
+// Long random walks with bounce then check that the detents and leftover
+// steps always add up to the net position, and that missed states never
+// leave more than a detent's worth of steps pending. quad_accel_steps() is
+// checked at the two speed thresholds.
+//
+// Build and run from testing/common:
+//   cc -O2 -I. tools/quadrature_test.c quadrature.c -o quadrature_test
+//   ./quadrature_test
+
+#include "quadrature.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t failures;
+static uint32_t rng = 1;
+
+static uint32_t rnd(uint32_t n) {
+    rng = rng * 1664525u + 1013904223u;
+    return (rng >> 8) % n;
+}
+
+static void fail(const char *fmt, ...) {
+    if (failures++ < 20) {
+        va_list args;
+        va_start(args, fmt);
+        printf("    FAIL: ");
+        vprintf(fmt, args);
+        printf("\n");
+        va_end(args);
+    }
+}
+
+typedef struct {
+    const char *name;
+    const char *edges;                  // Start state, then the state after each edge
+    const char *expect;                 // One mark per edge
+    int32_t detents;
+    uint32_t errors;
+} replay_t;
+
+static const replay_t replays[] = {
+    {"clockwise, 3 detents",
+     "00  01 11 10 00  01 11 10 00  01 11 10 00",
+     "    .  .  .  +   .  .  .  +   .  .  .  +", 3, 0},
+    {"counter-clockwise, 2 detents",
+     "00  10 11 01 00  10 11 01 00",
+     "    .  .  .  -   .  .  .  -", -2, 0},
+    // EC11s rest at 11 as often as at 00: the detent is wherever it started
+    {"clockwise from 11",
+     "11  10 00 01 11  10 00 01 11",
+     "    .  .  .  +   .  .  .  +", 2, 0},
+    // Every edge chatters once before it holds
+    {"bounce on every edge",
+     "00  01 00 01 11 01 11 10 11 10 00 10 00",
+     "    .  .  .  .  .  .  .  .  .  +  .  .", 1, 0},
+    // The closing edge chatters: one detent, not two
+    {"bounce on the detent edge",
+     "00  01 11 10 00 10 00 10 00  01 11 10 00",
+     "    .  .  .  +  .  .  .  .   .  .  .  +", 2, 0},
+    // Half a detent forward, then back past the start
+    {"reversal mid-detent",
+     "00  01 11 01 00  10 11 01 00",
+     "    .  .  .  .   .  .  .  -", -1, 0},
+    // A full detent forward, then straight back
+    {"reversal after a detent",
+     "00  01 11 10 00  10 11 01 00",
+     "    .  .  .  +   .  .  .  -", 0, 0},
+    // Back one step, bounce, and on: the detent needs all four steps again
+    {"reversal with bounce",
+     "00  01 11 01 11 01 11 10 00",
+     "    .  .  .  .  .  .  .  +", 1, 0},
+    // 00 -> 11 skips 01: an error and no step, while the steps around it
+    // still count, so the detent lands two edges late
+    {"missed state",
+     "00  11 10 00  01 11 10 00",
+     "    .  .  .   .  +  .  .", 1, 1},
+    // Two skips lose a detent's worth of steps; going back still takes four
+    {"missed states, then reversal",
+     "00  01 10 00 11 10 00  10 11 01 00",
+     "    .  .  .  .  .  +   .  .  .  -", 0, 2},
+    // Noise on both lines at once, then a clean turn from wherever it is
+    {"missed states only",
+     "00  11 00 11 00  01 11 10 00",
+     "    .  .  .  .   .  .  .  +", 1, 4},
+};
+
+static uint8_t parse_state(const char *s) {
+    return (uint8_t)((s[0] - '0') << 1 | (s[1] - '0'));
+}
+
+static void test_replay(const replay_t *r) {
+    uint32_t before = failures;
+    quad_decoder_t dec;
+    const char *e = r->edges;
+    const char *x = r->expect;
+
+    quad_decoder_init(&dec, parse_state(e));
+    e += 2;
+    int edge = 0;
+    for (;;) {
+        while (*e == ' ') {
+            e++;
+        }
+        while (*x == ' ') {
+            x++;
+        }
+        if (*e == 0 || *x == 0) {
+            break;
+        }
+        int8_t got = quad_decoder_update(&dec, parse_state(e));
+        int8_t want = *x == '+' ? 1 : *x == '-' ? -1 : 0;
+        if (got != want) {
+            fail("%s: edge %d (-> %.2s) reported %d, expected %d", r->name, edge, e, got, want);
+        }
+        e += 2;
+        x++;
+        edge++;
+    }
+    if (*e != 0 || *x != 0) {
+        fail("%s: edges and expectations differ in length", r->name);
+    }
+    if (dec.detents != r->detents || dec.errors != r->errors) {
+        fail("%s: %d detents, %u errors, expected %d, %u", r->name, dec.detents, dec.errors, r->detents,
+             r->errors);
+    }
+    printf("  %-30s %s\n", r->name, failures == before ? "ok" : "FAILED");
+}
+
+// Forward Gray order; position p is in state gray[p & 3]
+static const uint8_t gray[4] = {0, 1, 3, 2};
+
+static void test_random_walk(void) {
+    uint32_t before = failures;
+    uint32_t edges = 0, bounces = 0;
+
+    for (int trial = 0; trial < 1000; trial++) {
+        int32_t start = (int32_t) rnd(4), pos = start, reported = 0;
+        quad_decoder_t dec;
+        quad_decoder_init(&dec, gray[start & 3]);
+
+        for (int i = 0; i < 2000; i++) {
+            // Keep turning one way for a while, sometimes reverse
+            int32_t dir = (i / (1 + (trial % 16))) & 1 ? -1 : 1;
+            if (rnd(10) == 0) {
+                dir = -dir;
+            }
+            int32_t next = pos + dir;
+            // Chatter: to the next state and back a few times first
+            for (uint32_t b = rnd(4) == 0 ? 1 + rnd(3) : 0; b > 0; b--) {
+                reported += quad_decoder_update(&dec, gray[next & 3]);
+                reported += quad_decoder_update(&dec, gray[pos & 3]);
+                edges += 2;
+                bounces++;
+            }
+            reported += quad_decoder_update(&dec, gray[next & 3]);
+            edges++;
+            pos = next;
+
+            if (dec.detents * QUAD_STEPS_PER_DETENT + dec.steps != pos - start) {
+                fail("walk %d edge %d: %d detents + %d steps, moved %d", trial, i, dec.detents, dec.steps,
+                     pos - start);
+                break;
+            }
+        }
+        if (reported != dec.detents || dec.errors != 0) {
+            fail("walk %d: reported %d, counted %d, %u errors", trial, reported, dec.detents, dec.errors);
+        }
+    }
+    printf("  %-30s %s (%u edges, %u bounces)\n", "random walks with bounce", failures == before ? "ok" : "FAILED",
+           edges, bounces);
+}
+
+static void test_random_missed(void) {
+    uint32_t before = failures;
+    uint32_t missed = 0;
+
+    for (int trial = 0; trial < 1000; trial++) {
+        int32_t pos = 0, reported = 0;
+        quad_decoder_t dec;
+        quad_decoder_init(&dec, gray[0]);
+
+        for (int i = 0; i < 2000; i++) {
+            int32_t step = rnd(8) == 0 ? 2 : 1;         // 2: an edge too fast to catch
+            int32_t dir = rnd(5) == 0 ? -1 : 1;
+            pos += dir * step;
+            missed += step == 2;
+            reported += quad_decoder_update(&dec, gray[pos & 3]);
+            if (dec.steps <= -QUAD_STEPS_PER_DETENT || dec.steps >= QUAD_STEPS_PER_DETENT) {
+                fail("missed %d edge %d: %d steps pending", trial, i, dec.steps);
+                break;
+            }
+        }
+        if (reported != dec.detents) {
+            fail("missed %d: reported %d, counted %d", trial, reported, dec.detents);
+        }
+        // Only missed states lose steps, never more than they skipped
+        int32_t lost = pos - (dec.detents * QUAD_STEPS_PER_DETENT + dec.steps);
+        if ((uint32_t) abs(lost) > 2 * dec.errors) {
+            fail("missed %d: %d steps lost to %u errors", trial, lost, dec.errors);
+        }
+    }
+    printf("  %-30s %s (%u missed states)\n", "random walks, missed states", failures == before ? "ok" : "FAILED",
+           missed);
+}
+
+static void test_accel(void) {
+    uint32_t before = failures;
+    quad_accel_t accel;
+
+    quad_accel_init(&accel);
+    if (quad_accel_steps(&accel, 1, 1000) != 1) {
+        fail("accel: first detent not slow");
+    }
+    if (quad_accel_steps(&accel, 0, 1500) != 0) {
+        fail("accel: no detents gave steps");
+    }
+    // Per-detent gaps just under and at each threshold
+    uint32_t now = 1000;
+    struct { int32_t detents; uint32_t gap_us; int32_t steps; } cases[] = {
+        {1, QUAD_ACCEL_FAST_US - 1, QUAD_ACCEL_FAST_MULT},
+        {-1, QUAD_ACCEL_FAST_US, -QUAD_ACCEL_MEDIUM_MULT},
+        {1, QUAD_ACCEL_MEDIUM_US - 1, QUAD_ACCEL_MEDIUM_MULT},
+        {1, QUAD_ACCEL_MEDIUM_US, 1},
+        {3, 3 * (QUAD_ACCEL_FAST_US - 1), 3 * QUAD_ACCEL_FAST_MULT},
+        {-2, 2 * QUAD_ACCEL_MEDIUM_US, -2},
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        now += cases[i].gap_us;
+        int32_t got = quad_accel_steps(&accel, cases[i].detents, now);
+        if (got != cases[i].steps) {
+            fail("accel: %d detents after %u us gave %d, expected %d", cases[i].detents, cases[i].gap_us, got,
+                 cases[i].steps);
+        }
+    }
+    // Across the 32-bit wrap of the microsecond timer
+    quad_accel_init(&accel);
+    quad_accel_steps(&accel, 1, UINT32_MAX - 1000);
+    if (quad_accel_steps(&accel, 1, 1000) != QUAD_ACCEL_FAST_MULT) {
+        fail("accel: fast detent across the timer wrap");
+    }
+    printf("  %-30s %s\n", "acceleration thresholds", failures == before ? "ok" : "FAILED");
+}
+
+int main(void) {
+    printf("quadrature edge replay (%d steps per detent):\n", QUAD_STEPS_PER_DETENT);
+    for (size_t i = 0; i < sizeof(replays) / sizeof(replays[0]); i++) {
+        test_replay(&replays[i]);
+    }
+    test_random_walk();
+    test_random_missed();
+    test_accel();
+
+    printf("\n%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
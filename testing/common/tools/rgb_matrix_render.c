@@ -0,0 +1,170 @@
+// Host renderer for rgb_matrix: runs an effect over the full Seung65 layout
+// with scripted analog key presses and writes every frame as a PPM image
+// and/or one CSV table, then prints the render cost per frame and per
+// rgb_matrix_task() call (the per-tick budget on the device).
+//
+// Build and run from testing/common:
+//   cc -O2 -I. tools/rgb_matrix_render.c rgb_matrix.c rgb_layout.c -o rgb_matrix_render
+//   ./rgb_matrix_render ripple 200 out        # out/frame_0000.ppm ... + out.csv
+//   ./rgb_matrix_render gradient 1000 -       # timing only
+//
+// Effects: solid, breathing, gradient, ripple, travel. Frames are 10 ms apart
+// (the firmware's 100 fps cap). Turn PPMs into a clip with e.g.
+//   ffmpeg -framerate 100 -i out/frame_%04d.ppm out.gif
+
+#include "rgb_matrix.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#define FRAME_MS 10
+#define SCALE 4                 // Image pixels per layout unit
+#define KEY_SIZE 12             // Drawn key square, layout units
+#define IMG_W ((224 + KEY_SIZE) * SCALE)
+#define IMG_H ((64 + KEY_SIZE) * SCALE)
+
+#define PRESS_EVERY_MS 250      // A new key press this often
+#define PRESS_MS 120            // Down-and-up stroke time
+
+static const char *const effect_names[RGB_EFFECT_COUNT] = {
+    "solid", "breathing", "gradient", "ripple", "travel",
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// Key strokes: a triangle from rest to a depth that varies per press
+static void script_travel(uint8_t *travel, uint32_t now_ms) {
+    memset(travel, 0, RGB_LAYOUT_LED_COUNT);
+    uint32_t press = now_ms / PRESS_EVERY_MS;
+    uint32_t t = now_ms % PRESS_EVERY_MS;
+    if (t >= PRESS_MS) {
+        return;
+    }
+    uint8_t led = (uint8_t)((press * 37 + 11) % RGB_LAYOUT_LED_COUNT);
+    uint32_t depth = 128 + (press * 53) % 128;
+    uint32_t half = PRESS_MS / 2;
+    travel[led] = (uint8_t)(depth * (t < half ? t : PRESS_MS - t) / half);
+}
+
+static void write_ppm(const char *dir, uint32_t frame, const rgb_matrix_t *m) {
+    static uint8_t img[IMG_H][IMG_W][3];
+    memset(img, 0, sizeof(img));
+    for (uint8_t led = 0; led < m->num_leds; led++) {
+        int x0 = rgb_layout[led].x * SCALE;
+        int y0 = rgb_layout[led].y * SCALE;
+        for (int y = y0; y < y0 + KEY_SIZE * SCALE - SCALE; y++) {
+            for (int x = x0; x < x0 + KEY_SIZE * SCALE - SCALE; x++) {
+                img[y][x][0] = m->rgb[led].r;
+                img[y][x][1] = m->rgb[led].g;
+                img[y][x][2] = m->rgb[led].b;
+            }
+        }
+    }
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/frame_%04u.ppm", dir, (unsigned)frame);
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    fprintf(f, "P6\n%d %d\n255\n", IMG_W, IMG_H);
+    fwrite(img, 1, sizeof(img), f);
+    fclose(f);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        fprintf(stderr, "usage: %s <effect> <frames> <outdir|->\n", argv[0]);
+        return 1;
+    }
+
+    int effect = -1;
+    for (int i = 0; i < RGB_EFFECT_COUNT; i++) {
+        if (strcmp(argv[1], effect_names[i]) == 0) {
+            effect = i;
+        }
+    }
+    if (effect < 0) {
+        fprintf(stderr, "unknown effect '%s'\n", argv[1]);
+        return 1;
+    }
+    uint32_t frames = (uint32_t)strtoul(argv[2], NULL, 10);
+    const char *dir = strcmp(argv[3], "-") == 0 ? NULL : argv[3];
+
+    FILE *csv = NULL;
+    if (dir) {
+        if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+            perror(dir);
+            return 1;
+        }
+        char path[512];
+        snprintf(path, sizeof(path), "%s.csv", dir);
+        csv = fopen(path, "w");
+        if (!csv) {
+            perror(path);
+            return 1;
+        }
+        fprintf(csv, "frame,time_ms,led,x,y,r,g,b\n");
+    }
+
+    static rgb_matrix_t m;
+    uint8_t travel[RGB_LAYOUT_LED_COUNT];
+    rgb_matrix_init(&m, RGB_LAYOUT_LED_COUNT);
+    rgb_matrix_set_effect(&m, (uint8_t)effect);
+    rgb_matrix_set_color(&m, 170, 255);
+    rgb_matrix_set_travel(&m, travel);
+
+    uint64_t frame_ns_sum = 0, frame_ns_max = 0, tick_ns_max = 0;
+    uint32_t ticks = 0;
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        uint32_t now_ms = frame * FRAME_MS;
+        script_travel(travel, now_ms);
+
+        uint64_t frame_ns = 0;
+        bool done = false;
+        while (!done) {
+            uint64_t start = now_ns();
+            done = rgb_matrix_task(&m, now_ms);
+            uint64_t ns = now_ns() - start;
+            frame_ns += ns;
+            if (ns > tick_ns_max) {
+                tick_ns_max = ns;
+            }
+            ticks++;
+        }
+        frame_ns_sum += frame_ns;
+        if (frame_ns > frame_ns_max) {
+            frame_ns_max = frame_ns;
+        }
+
+        if (dir) {
+            write_ppm(dir, frame, &m);
+            for (uint8_t led = 0; led < m.num_leds; led++) {
+                fprintf(csv, "%u,%u,%u,%u,%u,%u,%u,%u\n", (unsigned)frame, (unsigned)now_ms,
+                        (unsigned)led, (unsigned)rgb_layout[led].x, (unsigned)rgb_layout[led].y,
+                        (unsigned)m.rgb[led].r, (unsigned)m.rgb[led].g, (unsigned)m.rgb[led].b);
+            }
+        }
+    }
+    if (csv) {
+        fclose(csv);
+    }
+
+    if (frames) {
+        printf("%s: %u frames, %u LEDs, %u ticks/frame (%d LEDs/tick)\n", effect_names[effect],
+               (unsigned)frames, (unsigned)m.num_leds, (unsigned)(ticks / frames),
+               RGB_MATRIX_LEDS_PER_TICK);
+        printf("render: avg %.0f ns/frame, max %llu ns/frame, max %llu ns/tick\n",
+               (double)frame_ns_sum / frames, (unsigned long long)frame_ns_max,
+               (unsigned long long)tick_ns_max);
+    }
+    return 0;
+}
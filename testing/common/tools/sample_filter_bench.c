@@ -0,0 +1,130 @@
+// Host benchmark for sample_filter: per-frame cost, residual noise at rest
+// and step-response latency of each filter preset on synthetic hall sensor
+// frames (mid-scale rest, periodic ripple, random noise and single-frame
+// spikes, then a full press).
+//
+// Build and run from testing/common:
+//   cc -O2 -I. tools/sample_filter_bench.c sample_filter.c -lm -o sample_filter_bench
+//   ./sample_filter_bench
+//
+// Cycle counts are host TSC cycles (x86 only); use ns/frame to compare
+// against the device loop budget.
+
+#include "sample_filter.h"
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define CHANNELS 80
+#define REST 2000
+#define PRESS 1200              // Counts from rest to bottom-out
+#define RIPPLE 6                // Periodic noise amplitude (counts)
+#define RIPPLE_PERIOD 7         // Frames
+#define NOISE 3                 // Uniform random noise +/- counts
+#define SPIKE 60                // Single-frame spike height
+#define SPIKE_EVERY 37          // Frames between spikes on a channel
+#define STEP_FRAME 256
+#define TRACE_FRAMES 512
+#define BENCH_FRAMES 200000
+
+typedef struct {
+    const char *name;
+    uint8_t median_len;
+    sample_filter_config_t config;
+} preset_t;
+
+static const preset_t presets[] = {
+    {"none",            1, {256, 0, 0}},
+    {"ema 1/4",         1, {64, 0, 0}},
+    {"ema 1/16",        1, {16, 0, 0}},
+    {"median3",         3, {256, 0, 0}},
+    {"median5",         5, {256, 0, 0}},
+    {"1-euro",          1, {16, 12, 64}},
+    {"median3+1-euro",  3, {16, 12, 64}},
+};
+
+static uint32_t rng = 12345;
+
+static int noise(void) {
+    rng = rng * 1664525u + 1013904223u;
+    return (int)((rng >> 16) % (2 * NOISE + 1)) - NOISE;
+}
+
+static uint16_t sample(int frame, int ch) {
+    double v = REST + RIPPLE * sin(2.0 * M_PI * (frame + ch) / RIPPLE_PERIOD) + noise();
+    if ((frame + 3 * ch) % SPIKE_EVERY == 0) {
+        v += SPIKE;
+    }
+    if (frame >= STEP_FRAME) {
+        v += PRESS;
+    }
+    return (uint16_t)v;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(void) {
+    static uint16_t trace[TRACE_FRAMES][CHANNELS];
+    static uint16_t out[CHANNELS];
+    static sample_filter_t filter;
+
+    for (int f = 0; f < TRACE_FRAMES; f++) {
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            trace[f][ch] = sample(f, ch);
+        }
+    }
+
+    printf("%-16s %10s %10s %10s %8s %8s\n", "filter", "ns/frame", "cyc/frame", "rest rms", "t50", "t90");
+    for (size_t p = 0; p < sizeof(presets) / sizeof(presets[0]); p++) {
+        const preset_t *preset = &presets[p];
+        sample_filter_init(&filter, CHANNELS, preset->median_len, &preset->config);
+
+        // Residual noise before the step and frames to 50% / 90% after it
+        double sq = 0;
+        int count = 0, t50 = -1, t90 = -1;
+        for (int f = 0; f < TRACE_FRAMES; f++) {
+            sample_filter_process(&filter, trace[f], out);
+            for (int ch = 0; ch < CHANNELS; ch++) {
+                if (f >= STEP_FRAME / 2 && f < STEP_FRAME) {
+                    double d = (double)out[ch] - REST;
+                    sq += d * d;
+                    count++;
+                }
+            }
+            if (f >= STEP_FRAME) {
+                int lowest = out[0];
+                for (int ch = 1; ch < CHANNELS; ch++) {
+                    if (out[ch] < lowest) lowest = out[ch];
+                }
+                if (t50 < 0 && lowest >= REST + PRESS / 2) t50 = f - STEP_FRAME;
+                if (t90 < 0 && lowest >= REST + PRESS * 9 / 10) t90 = f - STEP_FRAME;
+            }
+        }
+
+        double start = now_ns();
+#ifdef HAVE_TSC
+        uint64_t c0 = __rdtsc();
+#endif
+        for (int f = 0; f < BENCH_FRAMES; f++) {
+            sample_filter_process(&filter, trace[f % TRACE_FRAMES], out);
+        }
+#ifdef HAVE_TSC
+        double cycles = (double)(__rdtsc() - c0) / BENCH_FRAMES;
+#else
+        double cycles = 0;
+#endif
+        double ns = (now_ns() - start) / BENCH_FRAMES;
+
+        printf("%-16s %10.1f %10.0f %10.2f %8d %8d\n", preset->name, ns, cycles,
+               sqrt(sq / count), t50, t90);
+    }
+    return 0;
+}
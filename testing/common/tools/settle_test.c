@@ -0,0 +1,225 @@
+// Host test of the settle helpers (settle.c) against an RC model.
+//
+// settle_time_from_trace() gets traces of a mux line switching between two
+// channel levels: an exponential approach with a known time constant,
+// sampled every conversion like scan_characterize() does, plus Gaussian
+// noise. The time the model needs to get within the tolerance is
+// tau * ln(step / tolerance). The reported settle time may be early only by
+// what the noise can pull a sample into the band (band widened by 3 sigma,
+// less a sample), and late only until the model is inside the band
+// narrowed by 3 sigma (plus a sample), for rising and falling steps of any
+// size. Edge cases: steps below the tolerance, traces too short to settle
+// and a late glitch.
+//
+// Any single sample outside the band counts as unsettled, so the noise
+// cases keep the tolerance above 5 sigma, as in tools/sim; at 2 LSB noise
+// against an 8 LSB tolerance a few traces in a thousand report a settle
+// time near the end of the trace.
+//
+// settle_plan_rotation() and settle_plan_order() are checked against a
+// brute force over every order: the wait returned is the smallest that lets
+// every slot meet its settle time.
+//
+// Build and run from testing/common:
+//   cc -O2 -I. tools/settle_test.c settle.c -lm -o settle_test
+//   ./settle_test
+
+#include "settle.h"
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+#define TRACE_LEN 128
+#define INTERVAL_US 2
+#define TOLERANCE 8
+#define TRIALS 2000
+
+static uint32_t failures;
+static uint32_t rng = 1;
+
+static uint32_t rnd(uint32_t n) {
+    rng = rng * 1664525u + 1013904223u;
+    return (rng >> 8) % n;
+}
+
+static double rnd_uniform(void) {
+    return (rnd(1u << 24) + 0.5) / (1 << 24);
+}
+
+static double rnd_gauss(void) {
+    return sqrt(-2.0 * log(rnd_uniform())) * cos(6.283185307 * rnd_uniform());
+}
+
+static void fail(const char *fmt, ...) {
+    if (failures++ < 20) {
+        va_list args;
+        va_start(args, fmt);
+        printf("    FAIL: ");
+        vprintf(fmt, args);
+        printf("\n");
+        va_end(args);
+    }
+}
+
+// Sample i converts at (i + 0.5) * INTERVAL_US after the switch
+static void rc_trace(uint16_t *trace, uint16_t len, double from, double to, double tau_us, double noise) {
+    for (uint16_t i = 0; i < len; i++) {
+        double t = (i + 0.5) * INTERVAL_US;
+        double v = to + (from - to) * exp(-t / tau_us) + noise * rnd_gauss();
+        trace[i] = (uint16_t)(v < 0 ? 0 : v > 4095 ? 4095 : lround(v));
+    }
+}
+
+// Time the noise-free model needs to get within band of its final value
+static double model_settle_us(double step, double tau_us, double band) {
+    step = fabs(step);
+    return step <= band ? 0 : tau_us * log(step / band) - 0.5 * INTERVAL_US;
+}
+
+static void test_trace(const char *name, double tau_lo, double tau_hi, double noise) {
+    uint32_t before = failures;
+    uint16_t trace[TRACE_LEN];
+    double worst_early = 0, worst_late = 0;
+
+    for (int i = 0; i < TRIALS; i++) {
+        double tau = tau_lo + (tau_hi - tau_lo) * rnd_uniform();
+        double from = 100 + rnd(3800), to = 100 + rnd(3800);
+        rc_trace(trace, TRACE_LEN, from, to, tau, noise);
+        double got = settle_time_from_trace(trace, TRACE_LEN, INTERVAL_US, TOLERANCE);
+
+        double earliest = model_settle_us(to - from, tau, TOLERANCE + 3 * noise) - INTERVAL_US;
+        double latest = model_settle_us(to - from, tau, TOLERANCE - 3 * noise) + INTERVAL_US;
+        if (got < earliest || got > latest) {
+            fail("%s: tau %.2f us, %4.0f -> %4.0f: %.0f us, expected %.1f-%.1f", name, tau, from, to, got,
+                 earliest, latest);
+        }
+        worst_early = fmin(worst_early, got - model_settle_us(to - from, tau, TOLERANCE));
+        worst_late = fmax(worst_late, got - model_settle_us(to - from, tau, TOLERANCE));
+    }
+    printf("  %-32s %s  (reported - model: %+.1f to %+.1f us)\n", name, failures == before ? "ok" : "FAILED",
+           worst_early, worst_late);
+}
+
+static void test_trace_edges(void) {
+    uint32_t before = failures;
+    uint16_t trace[TRACE_LEN];
+
+    // Already settled, or a step smaller than the tolerance
+    rc_trace(trace, TRACE_LEN, 2000, 2000, 3, 0);
+    if (settle_time_from_trace(trace, TRACE_LEN, INTERVAL_US, TOLERANCE) != 0) {
+        fail("flat trace not settled at 0");
+    }
+    rc_trace(trace, TRACE_LEN, 2000, 2000 + TOLERANCE - 2, 20, 0);
+    if (settle_time_from_trace(trace, TRACE_LEN, INTERVAL_US, TOLERANCE) != 0) {
+        fail("step inside the tolerance not settled at 0");
+    }
+    // Still moving at the end: the final-value estimate trails it, so the
+    // result must be most of the trace
+    rc_trace(trace, TRACE_LEN, 0, 4000, 200, 0);
+    uint16_t got = settle_time_from_trace(trace, TRACE_LEN, INTERVAL_US, TOLERANCE);
+    if (got < TRACE_LEN * INTERVAL_US * 3 / 4) {
+        fail("unsettled trace reported settled at %u us", got);
+    }
+    // One late glitch outside the band holds the result back to it
+    rc_trace(trace, TRACE_LEN, 1000, 3000, 2, 0);
+    trace[100] += 3 * TOLERANCE;
+    if (settle_time_from_trace(trace, TRACE_LEN, INTERVAL_US, TOLERANCE) != 101 * INTERVAL_US) {
+        fail("glitch at sample 100 not reflected");
+    }
+    if (settle_time_from_trace(trace, 0, INTERVAL_US, TOLERANCE) != 0) {
+        fail("empty trace");
+    }
+    printf("  %-32s %s\n", "flat, tiny, unsettled, glitch", failures == before ? "ok" : "FAILED");
+}
+
+// Smallest wait for a fixed conversion order
+static uint16_t wait_for(const uint16_t *settle_us, const uint8_t *order, uint8_t n, uint16_t conv_us) {
+    int wait = 0;
+    for (uint8_t k = 0; k < n; k++) {
+        int need = settle_us[order[k]] - k * conv_us;
+        wait = need > wait ? need : wait;
+    }
+    return (uint16_t) wait;
+}
+
+static uint16_t best_any_order(const uint16_t *settle_us, uint8_t *order, uint8_t k, uint8_t n, uint16_t conv_us) {
+    if (k == n) {
+        return wait_for(settle_us, order, n, conv_us);
+    }
+    uint16_t best = UINT16_MAX;
+    for (uint8_t i = k; i < n; i++) {
+        uint8_t t = order[k];
+        order[k] = order[i];
+        order[i] = t;
+        uint16_t w = best_any_order(settle_us, order, (uint8_t)(k + 1), n, conv_us);
+        best = w < best ? w : best;
+        order[i] = order[k];
+        order[k] = t;
+    }
+    return best;
+}
+
+static void test_plans(void) {
+    uint32_t before = failures;
+    uint16_t settle_us[6];
+    uint8_t order[6], rotation;
+
+    for (int i = 0; i < TRIALS; i++) {
+        uint8_t n = (uint8_t)(1 + rnd(6));
+        uint16_t conv = (uint16_t)(1 + rnd(4));
+        for (uint8_t k = 0; k < n; k++) {
+            settle_us[k] = (uint16_t) rnd(rnd(4) ? 12 : 60);
+        }
+
+        // Rotation: brute force over the n rotations
+        uint16_t best_rot = UINT16_MAX;
+        for (uint8_t r = 0; r < n; r++) {
+            for (uint8_t k = 0; k < n; k++) {
+                order[k] = (uint8_t)((r + k) % n);
+            }
+            uint16_t w = wait_for(settle_us, order, n, conv);
+            best_rot = w < best_rot ? w : best_rot;
+        }
+        uint16_t got = settle_plan_rotation(settle_us, n, conv, &rotation);
+        for (uint8_t k = 0; k < n; k++) {
+            order[k] = (uint8_t)((rotation + k) % n);
+        }
+        if (got != best_rot || wait_for(settle_us, order, n, conv) != got) {
+            fail("rotation: wait %u (rotation %u gives %u), best %u", got, rotation,
+                 wait_for(settle_us, order, n, conv), best_rot);
+        }
+
+        // Free order: brute force over every permutation
+        for (uint8_t k = 0; k < n; k++) {
+            order[k] = k;
+        }
+        uint16_t best_any = best_any_order(settle_us, order, 0, n, conv);
+        got = settle_plan_order(settle_us, n, conv, order);
+        bool used[6] = {false};
+        for (uint8_t k = 0; k < n; k++) {
+            if (order[k] >= n || used[order[k]]) {
+                fail("order: not a permutation");
+                break;
+            }
+            used[order[k]] = true;
+        }
+        if (got != best_any || wait_for(settle_us, order, n, conv) != got) {
+            fail("order: wait %u (order gives %u), best %u", got, wait_for(settle_us, order, n, conv), best_any);
+        }
+    }
+    printf("  %-32s %s\n", "rotation and order plans", failures == before ? "ok" : "FAILED");
+}
+
+int main(void) {
+    printf("settle_time_from_trace on RC steps (tolerance %d LSB, %d us samples):\n", TOLERANCE, INTERVAL_US);
+    test_trace("tau 1-4 us, no noise", 1, 4, 0);
+    test_trace("tau 1-4 us, noise 1 LSB", 1, 4, 1);
+    test_trace("tau 2-12 us, noise 1.5 LSB", 2, 12, 1.5);
+    test_trace("tau 5-25 us, noise 1 LSB", 5, 25, 1);
+    test_trace_edges();
+    printf("\nsettle plans against brute force:\n");
+    test_plans();
+
+    printf("\n%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
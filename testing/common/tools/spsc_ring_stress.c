@@ -0,0 +1,165 @@
+// Host stress test of spsc_ring.h with a producer and a consumer thread, as
+// core 1 and core 0 use it. Every element carries a sequence number; the
+// consumer checks that each one arrives exactly once and in order (no loss,
+// no duplicates), and for the large elements that the whole slot matches
+// its sequence number (no torn reads of a slot still being written).
+//
+//   - push/pop of 4-byte elements through a 4-deep ring,
+//   - write_slot/commit and read_slot/release of frame-sized elements in
+//     place through an 8-deep ring, the consumer also peeking ahead,
+//   - both again with head and tail starting just below the 32-bit wrap.
+//
+// Build and run from testing/common:
+//   cc -O2 -pthread -I. tools/spsc_ring_stress.c -o spsc_ring_stress
+//   ./spsc_ring_stress [millions of items per run]
+//
+// Worth running on a multi-core host, and under -fsanitize=thread.
+
+#include "spsc_ring.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define SMALL_DEPTH 4
+#define FRAME_DEPTH 8
+#define FRAME_WORDS 42                  // 168 bytes, the size of a c_hid frame_t
+#define NEAR_WRAP   0xFFFFFF00u
+
+typedef struct {
+    uint32_t seq;
+    uint32_t words[FRAME_WORDS - 1];
+} frame_t;
+
+typedef struct {
+    spsc_ring_t ring;
+    uint32_t items;
+    bool in_place;
+    uint64_t producer_full;             // Times the producer found the ring full
+    uint64_t consumer_empty;
+    uint32_t received;
+    uint32_t out_of_order;              // Includes duplicates and gaps
+    uint32_t torn;
+    uint32_t bad_peeks;
+} run_t;
+
+static uint32_t pattern(uint32_t seq, uint32_t word) {
+    return seq * 2654435761u ^ word;
+}
+
+static void *producer(void *arg) {
+    run_t *run = arg;
+    for (uint32_t seq = 0; seq < run->items; seq++) {
+        if (run->in_place) {
+            frame_t *slot;
+            while ((slot = spsc_ring_write_slot(&run->ring)) == NULL) {
+                run->producer_full++;
+                sched_yield();
+            }
+            // Sequence number last, so a torn read shows as a mismatch
+            for (uint32_t w = 0; w < FRAME_WORDS - 1; w++) {
+                slot->words[w] = pattern(seq, w);
+            }
+            slot->seq = seq;
+            spsc_ring_commit(&run->ring);
+        } else {
+            while (!spsc_ring_push(&run->ring, &seq)) {
+                run->producer_full++;
+                sched_yield();
+            }
+        }
+    }
+    return NULL;
+}
+
+static void *consumer(void *arg) {
+    run_t *run = arg;
+    uint32_t expect = 0;
+    while (expect < run->items) {
+        uint32_t seq;
+        if (run->in_place) {
+            const frame_t *slot = spsc_ring_read_slot(&run->ring);
+            if (slot == NULL) {
+                run->consumer_empty++;
+                sched_yield();
+                continue;
+            }
+            seq = slot->seq;
+            for (uint32_t w = 0; w < FRAME_WORDS - 1; w++) {
+                if (slot->words[w] != pattern(seq, w)) {
+                    run->torn++;
+                    break;
+                }
+            }
+            // Whatever else is waiting must follow in order
+            for (uint32_t k = 1;; k++) {
+                const frame_t *ahead = spsc_ring_peek(&run->ring, k);
+                if (ahead == NULL) {
+                    break;
+                }
+                if (ahead->seq != seq + k) {
+                    run->bad_peeks++;
+                }
+            }
+            spsc_ring_release(&run->ring);
+        } else if (!spsc_ring_pop(&run->ring, &seq)) {
+            run->consumer_empty++;
+            sched_yield();
+            continue;
+        }
+        if (seq != expect) {
+            run->out_of_order++;
+            expect = seq;           // Resync to report each fault once
+        }
+        expect++;
+        run->received++;
+    }
+    return NULL;
+}
+
+static bool run_one(const char *name, uint32_t items, bool in_place, uint32_t start) {
+    static uint32_t small_storage[SMALL_DEPTH];
+    static frame_t frame_storage[FRAME_DEPTH];
+    run_t run = {.items = items, .in_place = in_place};
+
+    if (in_place) {
+        spsc_ring_init(&run.ring, frame_storage, sizeof(frame_t), FRAME_DEPTH);
+    } else {
+        spsc_ring_init(&run.ring, small_storage, sizeof(uint32_t), SMALL_DEPTH);
+    }
+    atomic_store(&run.ring.head, start);
+    atomic_store(&run.ring.tail, start);
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    pthread_t prod, cons;
+    pthread_create(&cons, NULL, consumer, &run);
+    pthread_create(&prod, NULL, producer, &run);
+    pthread_join(prod, NULL);
+    pthread_join(cons, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double seconds = (double)(t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    bool ok = run.received == items && run.out_of_order == 0 && run.torn == 0 && run.bad_peeks == 0 &&
+              spsc_ring_count(&run.ring) == 0;
+    printf("  %-28s %s  %u items, %.1f M/s, out of order %u, torn %u, bad peeks %u, full %llu, empty %llu\n",
+           name, ok ? "ok    " : "FAILED", run.received, items / seconds / 1e6, run.out_of_order, run.torn,
+           run.bad_peeks, (unsigned long long) run.producer_full, (unsigned long long) run.consumer_empty);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    uint32_t millions = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 0) : 10;
+    uint32_t items = millions * 1000000u;
+    bool ok = true;
+
+    printf("spsc_ring, one producer and one consumer thread:\n");
+    ok &= run_one("push/pop, depth 4", items, false, 0);
+    ok &= run_one("in place + peek, depth 8", items / 4, true, 0);
+    ok &= run_one("push/pop across the wrap", items, false, NEAR_WRAP);
+    ok &= run_one("in place across the wrap", items / 4, true, NEAR_WRAP);
+
+    printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
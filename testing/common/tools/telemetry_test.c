@@ -0,0 +1,348 @@
+// Host round-trip test of the binary telemetry framing (telemetry.c): the
+// device encoder (COBS + CRC-32 straight into the byte ring) against the
+// host decoder (telemetry_rx_feed).
+//   - 20,000 random records (random type, 0-512 byte payloads of random
+//     bytes, zeros, 0xFF runs across the 254-byte COBS blocks), each split
+//     at a random point between the two parts telemetry_send() gathers,
+//     drained with telemetry_tx_drain() into a sink that takes random
+//     amounts and fed to the decoder in random chunks: every record must
+//     come back once, in order and byte for byte, within
+//     TELEMETRY_MAX_PACKET,
+//   - damaged packets (one byte changed) are rejected as CRC or framing
+//     errors and every other packet still comes through,
+//   - a reader starting mid-packet or after text mode output resyncs at the
+//     next delimiter,
+//   - oversized payloads and a full ring drop whole records and count them.
+//
+// Build and run from testing/common:
+//   cc -O2 -I. tools/telemetry_test.c telemetry.c crc.c -o telemetry_test
+//   ./telemetry_test
+
+#include "telemetry.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RECORDS 20000
+#define RING_SIZE 2048
+#define STREAM_MAX (RECORDS * TELEMETRY_MAX_PACKET(TELEMETRY_MAX_PAYLOAD))
+
+static uint32_t failures;
+static uint32_t rng = 1;
+
+static uint32_t rnd(uint32_t n) {
+    rng = rng * 1664525u + 1013904223u;
+    return (rng >> 8) % n;
+}
+
+static void fail(const char *fmt, ...) {
+    if (failures++ < 20) {
+        va_list args;
+        va_start(args, fmt);
+        printf("    FAIL: ");
+        vprintf(fmt, args);
+        printf("\n");
+        va_end(args);
+    }
+}
+
+typedef struct {
+    uint8_t type;
+    uint16_t len;
+    uint8_t payload[TELEMETRY_MAX_PAYLOAD];
+} record_t;
+
+static record_t sent[RECORDS];
+static uint32_t packet_end[RECORDS];    // Stream offset just past each delimiter
+
+// The byte stream as the host would read it from CDC
+static uint8_t *stream;
+static uint32_t stream_len;
+static uint32_t sink_room;              // What the sink takes on this drain pass
+
+static uint32_t sink_write(const void *data, uint32_t len) {
+    uint32_t n = len < sink_room ? len : sink_room;
+    memcpy(stream + stream_len, data, n);
+    stream_len += n;
+    sink_room -= n;
+    return n;
+}
+
+static void drain(telemetry_tx_t *tx) {
+    sink_room = rnd(4) ? rnd(300) : RING_SIZE;
+    telemetry_tx_drain(tx, sink_write);
+}
+
+static void random_record(record_t *r, uint32_t seq) {
+    r->type = (uint8_t)(1 + rnd(255));
+    r->len = (uint16_t)(rnd(8) == 0 ? rnd(8) : rnd(TELEMETRY_MAX_PAYLOAD + 1));
+    uint32_t mode = rnd(4);
+    for (uint16_t i = 0; i < r->len; i++) {
+        switch (mode) {
+        case 0: r->payload[i] = (uint8_t) rnd(256); break;
+        case 1: r->payload[i] = 0; break;
+        case 2: r->payload[i] = 0xFF; break;
+        default: r->payload[i] = rnd(10) ? (uint8_t)(1 + rnd(255)) : 0; break;
+        }
+    }
+    // Sequence number up front so damaged-stream checks can tell records apart
+    if (r->len >= 4) {
+        memcpy(r->payload, &seq, 4);
+    }
+}
+
+// Encode records[0..count) into the stream through a small ring
+static void encode(telemetry_tx_t *tx, uint32_t count) {
+    stream_len = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const record_t *r = &sent[i];
+        while (RING_SIZE - telemetry_tx_used(tx) < (uint32_t) TELEMETRY_MAX_PACKET(r->len)) {
+            drain(tx);
+        }
+        uint16_t split = (uint16_t) rnd(r->len + 1u);
+        uint32_t before = tx->head;
+        if (!telemetry_send(tx, r->type, r->payload, split, r->payload + split, (uint16_t)(r->len - split))) {
+            fail("record %u (%u bytes) refused with room in the ring", i, r->len);
+        }
+        if (tx->head - before > (uint32_t) TELEMETRY_MAX_PACKET(r->len)) {
+            fail("record %u: %u bytes encoded, bound %u", i, tx->head - before, TELEMETRY_MAX_PACKET(r->len));
+        }
+        packet_end[i] = stream_len + telemetry_tx_used(tx);
+    }
+    while (telemetry_tx_used(tx) != 0) {
+        drain(tx);
+    }
+}
+
+typedef struct {
+    uint32_t next;                      // Index of the record expected next
+    uint32_t received;
+    uint32_t mismatched;
+} checker_t;
+
+static void on_record(void *ctx, uint8_t type, const uint8_t *payload, uint16_t len) {
+    checker_t *c = ctx;
+    c->received++;
+    if (c->next >= RECORDS) {
+        c->mismatched++;
+        return;
+    }
+    const record_t *r = &sent[c->next++];
+    if (type != r->type || len != r->len || memcmp(payload, r->payload, len) != 0) {
+        if (c->mismatched++ < 5) {
+            fail("record %u: type %u len %u, sent type %u len %u", c->next - 1, type, len, r->type, r->len);
+        }
+    }
+}
+
+// With damage, records may be skipped but never altered or reordered
+static void on_record_skipping(void *ctx, uint8_t type, const uint8_t *payload, uint16_t len) {
+    checker_t *c = ctx;
+    c->received++;
+    uint32_t seq;
+    if (len < 4) {
+        c->mismatched++;        // Short records are not used in these tests
+        return;
+    }
+    memcpy(&seq, payload, 4);
+    if (seq < c->next || seq >= RECORDS) {
+        c->mismatched++;
+        return;
+    }
+    const record_t *r = &sent[seq];
+    if (type != r->type || len != r->len || memcmp(payload, r->payload, len) != 0) {
+        c->mismatched++;
+    }
+    c->next = seq + 1;
+}
+
+static void feed_chunks(telemetry_rx_t *rx, uint32_t from, telemetry_record_cb_t cb, checker_t *c) {
+    for (uint32_t pos = from; pos < stream_len;) {
+        uint32_t n = 1 + (rnd(4) ? rnd(64) : rnd(2000));
+        n = n < stream_len - pos ? n : stream_len - pos;
+        telemetry_rx_feed(rx, stream + pos, n, cb, c);
+        pos += n;
+    }
+}
+
+static void test_round_trip(void) {
+    uint32_t before = failures;
+    static uint8_t ring_storage[RING_SIZE];
+    telemetry_tx_t tx;
+    telemetry_rx_t rx;
+    checker_t c = {0};
+
+    telemetry_tx_init(&tx, ring_storage, sizeof(ring_storage));
+    for (uint32_t i = 0; i < RECORDS; i++) {
+        random_record(&sent[i], i);
+    }
+    encode(&tx, RECORDS);
+
+    telemetry_rx_init(&rx);
+    feed_chunks(&rx, 0, on_record, &c);
+    if (c.received != RECORDS || c.mismatched || rx.packets != RECORDS || rx.crc_errors || rx.framing_errors ||
+        tx.records_sent != RECORDS || tx.records_dropped) {
+        fail("round trip: %u of %u received, %u mismatched, %u CRC / %u framing errors", c.received, RECORDS,
+             c.mismatched, rx.crc_errors, rx.framing_errors);
+    }
+    printf("  %-32s %s (%u records, %u bytes)\n", "random records, random chunks", failures == before ? "ok" : "FAILED",
+           c.received, stream_len);
+}
+
+static void test_damage(void) {
+    uint32_t before = failures;
+    static uint8_t ring_storage[RING_SIZE];
+    telemetry_tx_t tx;
+    telemetry_rx_t rx;
+    checker_t c = {0};
+    uint32_t count = RECORDS / 4, damaged = 0;
+
+    telemetry_tx_init(&tx, ring_storage, sizeof(ring_storage));
+    for (uint32_t i = 0; i < count; i++) {
+        random_record(&sent[i], i);
+        if (sent[i].len < 4) {
+            sent[i].len = 4;
+            memcpy(sent[i].payload, &i, 4);
+        }
+    }
+    encode(&tx, count);
+
+    // Change one byte (never a delimiter) in about one packet in ten
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t start = i ? packet_end[i - 1] : 0;
+        if (rnd(10) != 0) {
+            continue;
+        }
+        uint32_t at = start + rnd(packet_end[i] - 1 - start);
+        stream[at] ^= (uint8_t)(1 + rnd(255));
+        damaged++;
+    }
+
+    telemetry_rx_init(&rx);
+    feed_chunks(&rx, 0, on_record_skipping, &c);
+    if (c.mismatched || c.received != count - damaged || rx.crc_errors + rx.framing_errors < damaged) {
+        fail("damage: %u of %u undamaged received, %u altered, %u CRC / %u framing errors for %u damaged",
+             c.received, count - damaged, c.mismatched, rx.crc_errors, rx.framing_errors, damaged);
+    }
+    printf("  %-32s %s (%u damaged, %u CRC / %u framing errors)\n", "damaged packets",
+           failures == before ? "ok" : "FAILED", damaged, rx.crc_errors, rx.framing_errors);
+}
+
+static void test_resync(void) {
+    uint32_t before = failures;
+    static uint8_t ring_storage[RING_SIZE];
+    telemetry_tx_t tx;
+    telemetry_rx_t rx;
+    uint32_t count = 200;
+
+    telemetry_tx_init(&tx, ring_storage, sizeof(ring_storage));
+    for (uint32_t i = 0; i < count; i++) {
+        random_record(&sent[i], i);
+        if (sent[i].len < 4) {
+            sent[i].len = 4;
+            memcpy(sent[i].payload, &i, 4);
+        }
+    }
+    encode(&tx, count);
+
+    // Start inside every packet in turn: the rest all arrive
+    for (uint32_t i = 0; i + 1 < count; i += 7) {
+        uint32_t start = i ? packet_end[i - 1] : 0;
+        uint32_t from = start + 1 + rnd(packet_end[i] - start - 1);
+        checker_t c = {.next = i};
+        telemetry_rx_init(&rx);
+        feed_chunks(&rx, from, on_record_skipping, &c);
+        uint32_t expect = count - i - 1;
+        bool partial_seen = from < packet_end[i] - 1;
+        if (c.mismatched || c.received != expect || rx.crc_errors + rx.framing_errors != (partial_seen ? 1u : 0u)) {
+            fail("start in packet %u: %u of %u received, %u CRC / %u framing errors", i, c.received, expect,
+                 rx.crc_errors, rx.framing_errors);
+        }
+    }
+
+    // Text mode output, then the delimiter serial_set_binary() writes
+    telemetry_tx_init(&tx, ring_storage, sizeof(ring_storage));
+    const char text[] = "ADC: CH0=1234(1200)\r\nbinary mode\r\n";
+    const uint8_t delimiter = 0;
+    telemetry_tx_write_raw(&tx, text, sizeof(text) - 1);
+    telemetry_tx_write_raw(&tx, &delimiter, 1);
+    for (uint32_t i = 0; i < 5; i++) {
+        telemetry_send(&tx, sent[i].type, sent[i].payload, sent[i].len, NULL, 0);
+    }
+    stream_len = 0;
+    sink_room = RING_SIZE;
+    telemetry_tx_drain(&tx, sink_write);
+    checker_t c = {0};
+    telemetry_rx_init(&rx);
+    feed_chunks(&rx, 0, on_record, &c);
+    if (c.received != 5 || c.mismatched || rx.crc_errors + rx.framing_errors != 1) {
+        fail("after text: %u of 5 received, %u CRC / %u framing errors", c.received, rx.crc_errors,
+             rx.framing_errors);
+    }
+    printf("  %-32s %s\n", "mid-packet start, text first", failures == before ? "ok" : "FAILED");
+}
+
+static void test_drops(void) {
+    uint32_t before = failures;
+    static uint8_t small[1024];
+    static uint8_t payload[TELEMETRY_MAX_PAYLOAD + 1];
+    telemetry_tx_t tx;
+
+    if (telemetry_tx_init(&tx, small, 1000)) {
+        fail("ring of 1000 bytes accepted");
+    }
+    telemetry_tx_init(&tx, small, sizeof(small));
+    memset(payload, 0x55, sizeof(payload));
+    if (telemetry_send(&tx, 1, payload, TELEMETRY_MAX_PAYLOAD, payload, 1) || telemetry_tx_used(&tx) != 0) {
+        fail("oversized payload queued");
+    }
+    uint32_t queued = 0;
+    while (telemetry_send(&tx, 2, payload, 300, NULL, 0)) {
+        queued++;
+    }
+    uint32_t used = telemetry_tx_used(&tx);
+    if (queued != 3 || tx.records_sent != 3 || tx.records_dropped != 2 || used > sizeof(small)) {
+        fail("full ring: %u queued, %u sent, %u dropped, %u bytes used", queued, tx.records_sent,
+             tx.records_dropped, used);
+    }
+    // A dropped record leaves the ring as it was; the queued ones decode
+    stream_len = 0;
+    sink_room = sizeof(small);
+    if (!telemetry_tx_drain(&tx, sink_write) || telemetry_tx_used(&tx) != 0 || stream_len != used) {
+        fail("full ring: drain wrote %u of %u bytes", stream_len, used);
+    }
+    telemetry_rx_t rx;
+    telemetry_rx_init(&rx);
+    checker_t c = {0};
+    sent[0].type = 2;
+    sent[0].len = 300;
+    memset(sent[0].payload, 0x55, 300);
+    sent[1] = sent[0];
+    sent[2] = sent[0];
+    feed_chunks(&rx, 0, on_record, &c);
+    if (c.received != 3 || c.mismatched) {
+        fail("full ring: %u of 3 decoded", c.received);
+    }
+    sink_room = 0;
+    if (telemetry_tx_drain(&tx, sink_write)) {
+        fail("drain of an empty ring wrote");
+    }
+    printf("  %-32s %s\n", "oversized, ring full", failures == before ? "ok" : "FAILED");
+}
+
+int main(void) {
+    stream = malloc(STREAM_MAX);
+    if (stream == NULL) {
+        return 1;
+    }
+
+    printf("telemetry COBS/CRC-32 round trip:\n");
+    test_round_trip();
+    test_damage();
+    test_resync();
+    test_drops();
+
+    printf("\n%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
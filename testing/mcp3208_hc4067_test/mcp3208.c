@@ -0,0 +1,244 @@
+#include "mcp3208.h"
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/timer.h"
+#include "hardware/clocks.h"
+
+// PIO SPI master, 4 PIO cycles per bit, CS = side-set bit 0, SCK = bit 1.
+// Each TX word is a left-aligned 24-bit command; the 24 bits read back are
+// autopushed right-aligned, so the result is the low 12 bits. The [4] delay
+// keeps CS high for at least 500 ns (tCSH) between transactions at 2 MHz.
+//
+// .side_set 2
+// .wrap_target
+//     pull block       side 0b01 [4]   ; CS high, SCK low
+//     set x, 23        side 0b00       ; CS low
+// bitloop:
+//     out pins, 1      side 0b00 [1]   ; MOSI while SCK low (MCP3208 shifts DOUT on falling edge)
+//     in pins, 1       side 0b10       ; SCK high, sample MISO
+//     jmp x-- bitloop  side 0b10
+// .wrap
+static const uint16_t mcp3208_spi_program_instructions[] = {
+    //     .wrap_target
+    0x8ca0, //  0: pull   block           side 1 [4]
+    0xe037, //  1: set    x, 23           side 0
+    0x6101, //  2: out    pins, 1         side 0 [1]
+    0x5001, //  3: in     pins, 1         side 2
+    0x1042, //  4: jmp    x--, 2          side 2
+    //     .wrap
+};
+
+static const struct pio_program mcp3208_spi_program = {
+    .instructions = mcp3208_spi_program_instructions,
+    .length = 5,
+    .origin = -1,
+};
+
+#define MCP3208_PIO_CYCLES_PER_BIT 4
+#define MCP3208_BITS_PER_SAMPLE 24
+// pull + set between transactions
+#define MCP3208_PIO_CYCLES_GAP 6
+
+static PIO pio;
+static uint sm;
+static int tx_chan = -1;
+static int rx_chan = -1;
+static int settle_alarm = -1;
+static float pio_clkdiv;
+
+static uint32_t rx_buf[MCP3208_MAX_BATCH];
+
+// Frame scan state, owned by the DMA IRQ while scan_busy is set
+static uint32_t scan_cmds[SCAN_SCHEDULE_SELECTS][MCP3208_MAX_BATCH];
+static const scan_schedule_t *scan_sched;
+static mcp3208_select_fn scan_set_select;
+static uint16_t *scan_frame;
+static uint8_t scan_step;
+static volatile bool scan_busy = false;
+
+static volatile mcp3208_stats_t stats;
+
+// Start bit, single-ended, D2 D1 D0, left-aligned in the 32-bit TX word
+static inline uint32_t mcp3208_command(uint8_t ch) {
+    uint32_t cmd = ((0x06u | ((ch & 0x07u) >> 2)) << 16) | ((ch & 0x03u) << 14);
+    return cmd << 8;
+}
+
+static void start_batch(const uint32_t *cmds, uint8_t count) {
+    // RX first so no result can arrive before its channel is armed
+    dma_channel_transfer_to_buffer_now(rx_chan, rx_buf, count);
+    dma_channel_transfer_from_buffer_now(tx_chan, cmds, count);
+}
+
+static void scan_start_batch(void) {
+    start_batch(scan_cmds[scan_step], scan_sched->num_muxes);
+}
+
+static void scan_settle_alarm_cb(uint alarm_num) {
+    (void) alarm_num;
+    scan_start_batch();
+}
+
+// Drive the step's select value and start its batch once it has settled
+static void scan_begin_step(void) {
+    const scan_step_t *step = &scan_sched->steps[scan_step];
+    scan_set_select(step->select);
+    if (hardware_alarm_set_target(settle_alarm, make_timeout_time_us(step->wait_us))) {
+        // Target already passed
+        scan_start_batch();
+    }
+}
+
+static void mcp3208_dma_irq_handler(void) {
+    if (!dma_channel_get_irq1_status(rx_chan)) {
+        return;
+    }
+    dma_channel_acknowledge_irq1(rx_chan);
+    if (!scan_busy) {
+        return;
+    }
+
+    uint8_t n = scan_sched->num_muxes;
+    for (uint8_t slot = 0; slot < n; slot++) {
+        scan_frame[scan_schedule_slot_channel(scan_sched, scan_step, slot)] = (uint16_t)(rx_buf[slot] & 0x0FFF);
+    }
+    stats.batches++;
+    stats.samples += n;
+
+    if (++scan_step < SCAN_SCHEDULE_SELECTS) {
+        scan_begin_step();
+        return;
+    }
+    stats.frames++;
+    scan_busy = false;
+}
+
+bool mcp3208_init(void) {
+    pio = pio0;
+    int claimed = pio_claim_unused_sm(pio, false);
+    if (claimed < 0 || !pio_can_add_program(pio, &mcp3208_spi_program)) {
+        return false;
+    }
+    sm = (uint) claimed;
+    uint offset = pio_add_program(pio, &mcp3208_spi_program);
+
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset, offset + mcp3208_spi_program.length - 1);
+    sm_config_set_sideset(&c, 2, false, false);
+    sm_config_set_sideset_pins(&c, MCP3208_PIN_CS);
+    sm_config_set_out_pins(&c, MCP3208_PIN_MOSI, 1);
+    sm_config_set_in_pins(&c, MCP3208_PIN_MISO);
+    sm_config_set_out_shift(&c, false, false, 32);                    // Shift left, explicit pull
+    sm_config_set_in_shift(&c, false, true, MCP3208_BITS_PER_SAMPLE); // Shift left, autopush at 24 bits
+
+    pio_clkdiv = (float) clock_get_hz(clk_sys) / (MCP3208_PIO_CYCLES_PER_BIT * (float) MCP3208_SCK_HZ);
+    if (pio_clkdiv < 1.0f) pio_clkdiv = 1.0f;
+    sm_config_set_clkdiv(&c, pio_clkdiv);
+
+    // CS idles high, SCK low
+    uint32_t out_mask = (1u << MCP3208_PIN_CS) | (1u << MCP3208_PIN_SCK) | (1u << MCP3208_PIN_MOSI);
+    pio_sm_set_pins_with_mask(pio, sm, 1u << MCP3208_PIN_CS, out_mask);
+    pio_sm_set_pindirs_with_mask(pio, sm, out_mask, out_mask | (1u << MCP3208_PIN_MISO));
+    pio_gpio_init(pio, MCP3208_PIN_CS);
+    pio_gpio_init(pio, MCP3208_PIN_SCK);
+    pio_gpio_init(pio, MCP3208_PIN_MOSI);
+    pio_gpio_init(pio, MCP3208_PIN_MISO);
+
+    pio_sm_init(pio, sm, offset, &c);
+    pio_sm_set_enabled(pio, sm, true);
+
+    // TX: command table -> PIO TX FIFO, RX: PIO RX FIFO -> rx_buf
+    tx_chan = dma_claim_unused_channel(true);
+    dma_channel_config tx_cfg = dma_channel_get_default_config(tx_chan);
+    channel_config_set_transfer_data_size(&tx_cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&tx_cfg, true);
+    channel_config_set_write_increment(&tx_cfg, false);
+    channel_config_set_dreq(&tx_cfg, pio_get_dreq(pio, sm, true));
+    dma_channel_configure(tx_chan, &tx_cfg, &pio->txf[sm], NULL, 0, false);
+
+    rx_chan = dma_claim_unused_channel(true);
+    dma_channel_config rx_cfg = dma_channel_get_default_config(rx_chan);
+    channel_config_set_transfer_data_size(&rx_cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&rx_cfg, false);
+    channel_config_set_write_increment(&rx_cfg, true);
+    channel_config_set_dreq(&rx_cfg, pio_get_dreq(pio, sm, false));
+    dma_channel_configure(rx_chan, &rx_cfg, rx_buf, &pio->rxf[sm], 0, false);
+
+    dma_channel_set_irq1_enabled(rx_chan, true);
+    irq_add_shared_handler(DMA_IRQ_1, mcp3208_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    settle_alarm = hardware_alarm_claim_unused(true);
+    hardware_alarm_set_callback(settle_alarm, scan_settle_alarm_cb);
+
+    return true;
+}
+
+uint32_t mcp3208_sck_hz(void) {
+    return (uint32_t)((float) clock_get_hz(clk_sys) / (MCP3208_PIO_CYCLES_PER_BIT * pio_clkdiv));
+}
+
+uint16_t mcp3208_conversion_us(void) {
+    float cycles = MCP3208_PIO_CYCLES_PER_BIT * MCP3208_BITS_PER_SAMPLE + MCP3208_PIO_CYCLES_GAP;
+    return (uint16_t)(cycles * pio_clkdiv * 1e6f / (float) clock_get_hz(clk_sys));
+}
+
+bool mcp3208_read_batch(const uint8_t *channels, uint8_t count, uint16_t *out) {
+    static uint32_t cmds[MCP3208_MAX_BATCH];
+
+    if (scan_busy || rx_chan < 0 || count == 0 || count > MCP3208_MAX_BATCH) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        cmds[i] = mcp3208_command(channels[i]);
+    }
+    start_batch(cmds, count);
+    dma_channel_wait_for_finish_blocking(rx_chan);
+
+    for (uint8_t i = 0; i < count; i++) {
+        out[i] = (uint16_t)(rx_buf[i] & 0x0FFF);
+    }
+    stats.batches++;
+    stats.samples += count;
+    return true;
+}
+
+uint16_t mcp3208_read(uint8_t ch) {
+    uint16_t value = 0;
+    mcp3208_read_batch(&ch, 1, &value);
+    return value;
+}
+
+bool mcp3208_scan_start(const scan_schedule_t *sched, mcp3208_select_fn set_select, uint16_t *frame) {
+    if (scan_busy || rx_chan < 0 || sched->num_muxes > MCP3208_MAX_BATCH) {
+        return false;
+    }
+
+    // Commands for every step are fixed by the schedule, so build them up front
+    for (uint8_t step = 0; step < SCAN_SCHEDULE_SELECTS; step++) {
+        for (uint8_t slot = 0; slot < sched->num_muxes; slot++) {
+            scan_cmds[step][slot] = mcp3208_command(scan_schedule_slot_input(sched, step, slot));
+        }
+    }
+
+    scan_sched = sched;
+    scan_set_select = set_select;
+    scan_frame = frame;
+    scan_step = 0;
+    scan_busy = true;
+    scan_begin_step();
+    return true;
+}
+
+bool mcp3208_scan_done(void) {
+    return !scan_busy;
+}
+
+void mcp3208_get_stats(mcp3208_stats_t *out) {
+    out->batches = stats.batches;
+    out->samples = stats.samples;
+    out->frames = stats.frames;
+}
@@ -0,0 +1,103 @@
+#ifndef MCP3208_H
+#define MCP3208_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "scan_schedule.h"
+
+// MCP3208 driver: a PIO state machine runs SPI mode 0 with CS and SCK on
+// side-set, one 24-bit transaction per queued command, and two DMA
+// channels stream a whole batch of commands in and results out. CS
+// toggling and the next command's setup overlap the current conversion, so
+// a batch runs back-to-back at the SPI clock with no CPU involvement.
+//
+// The frame scan walks a scan_schedule_t: drive the select value, wait the
+// step's settle time on a hardware alarm, convert every mux input in one
+// DMA batch, repeat for all 16 steps. It runs from interrupts; the caller
+// polls mcp3208_scan_done().
+
+// SPI pins. CS and SCK must be consecutive (CS, CS + 1) for side-set.
+#ifndef MCP3208_PIN_MISO
+#define MCP3208_PIN_MISO 16
+#endif
+#ifndef MCP3208_PIN_CS
+#define MCP3208_PIN_CS   17
+#endif
+#define MCP3208_PIN_SCK  (MCP3208_PIN_CS + 1)
+#ifndef MCP3208_PIN_MOSI
+#define MCP3208_PIN_MOSI 19
+#endif
+
+// Rated SPI clock: 2 MHz at VDD = 5 V, 1 MHz at VDD = 2.7 V. At 3.3 V the
+// datasheet derating line gives ~1.25 MHz (~52 ksps with 24 clocks per
+// sample). Raise to 2000000 when the MCP3208 runs from 5 V.
+#ifndef MCP3208_SCK_HZ
+#define MCP3208_SCK_HZ 1250000
+#endif
+
+// Largest batch (one conversion per mux)
+#define MCP3208_MAX_BATCH SCAN_SCHEDULE_MAX_MUXES
+
+typedef void (*mcp3208_select_fn)(uint8_t select);
+
+typedef struct {
+    uint32_t batches;       // DMA batches completed
+    uint32_t samples;       // Conversions completed
+    uint32_t frames;        // Frame scans completed
+} mcp3208_stats_t;
+
+/**
+ * @brief Claim PIO/DMA/alarm resources and start the SPI state machine
+ *
+ * @return false if no PIO state machine or program space is free
+ */
+bool mcp3208_init(void);
+
+/**
+ * @brief Actual SCK frequency after PIO clock division
+ */
+uint32_t mcp3208_sck_hz(void);
+
+/**
+ * @brief Time per conversion in a batch, rounded down to whole microseconds
+ */
+uint16_t mcp3208_conversion_us(void);
+
+/**
+ * @brief Convert a batch of channels back-to-back (blocking)
+ *
+ * @param channels MCP3208 channels (0-7)
+ * @param count Number of channels (at most MCP3208_MAX_BATCH)
+ * @param out Receives the 12-bit results
+ * @return false if a frame scan is running or count is out of range
+ */
+bool mcp3208_read_batch(const uint8_t *channels, uint8_t count, uint16_t *out);
+
+/**
+ * @brief Convert one channel (blocking)
+ *
+ * @return 12-bit result, 0 if a frame scan is running
+ */
+uint16_t mcp3208_read(uint8_t ch);
+
+/**
+ * @brief Start an asynchronous scan of every schedule channel
+ *
+ * @param sched Schedule to walk; must stay valid until the scan is done
+ * @param set_select Drives the mux select lines, called from the DMA IRQ
+ * @param frame Receives 12-bit results indexed by schedule channel
+ * @return false if a scan is already running
+ */
+bool mcp3208_scan_start(const scan_schedule_t *sched, mcp3208_select_fn set_select, uint16_t *frame);
+
+/**
+ * @brief True once the last scan has filled its frame
+ */
+bool mcp3208_scan_done(void);
+
+/**
+ * @brief Get driver statistics
+ */
+void mcp3208_get_stats(mcp3208_stats_t *stats);
+
+#endif // MCP3208_H
@@ -1,16 +1,14 @@
 // mcp3208_demo.c
 #include <stdio.h>
 #include "pico/stdlib.h"
-#include "hardware/spi.h"
 #include "hardware/gpio.h"
 #include <stdbool.h>
 #include <string.h>
+#include "settle.h"
+#include "scan_schedule.h"
+#include "mcp3208.h"
 
-#define SPI_PORT spi0
-#define PIN_SCK  18   // GP18
-#define PIN_MOSI 19   // GP19
-#define PIN_MISO 16   // GP16
-#define PIN_CS   17   // GP17
+// MCP3208 SPI pins (MISO GP16, CS GP17, SCK GP18, MOSI GP19) live in mcp3208.h
 
 // HC4067 mux select pins (assumed mapping: GP10 = S0, GP11 = S1, GP12 = S2, GP13 = S3)
 #define PIN_MUX_S0 10
@@ -32,33 +30,24 @@ static const uint8_t mux_to_adc[MUX_COUNT] = { 0, 3, 4, 6, 7 };
 // Threshold below which readings are considered floating/unconnected and will NOT be printed
 #define MUX_PRINT_THRESHOLD 200u
 // Settle time after changing mux select (microseconds). Lower to speed up scans but
-// don't set to 0 if your wiring needs time to settle.
+// don't set to 0 if your wiring needs time to settle. Used for every select step
+// until characterization has measured the channels individually.
 #define MUX_SETTLE_US 200u
+// Characterize per-channel settle times at boot (also on 'c' over serial).
+// Each channel is switched to from the one scanned before it, read back-to-back
+// MUX_CHAR_TRACE_LEN times and given the time it takes to stay within
+// MUX_CHAR_TOLERANCE_LSB of its final value, worst of MUX_CHAR_PASSES runs.
+#define MUX_CHARACTERIZE 1
+#define MUX_CHAR_TOLERANCE_LSB 4u
+#define MUX_CHAR_TRACE_LEN 64u       // ~20 us per single read
+#define MUX_CHAR_PRESETTLE_US 2000u
+#define MUX_CHAR_PASSES 4
+// Throughput benchmark run at boot and on 'b' over serial
+#define BENCH_BATCHES 2000u
+#define BENCH_FRAMES 200u
 // Delay between full scans in milliseconds (lower = faster updates)
 #define SCAN_DELAY_MS 80u
 // ---------------------------------------------------------------------------------------
-static uint16_t mcp3208_read(uint8_t ch) {
-    // ch: 0..7
-    // Transaction: 3 bytes
-    //  - Byte0: 0b00000110 | (ch >> 2)   (Start=1, SGL/DIFF=1, D2)
-    //  - Byte1: (ch & 0x3) << 6          (D1 D0 then 6 zeros)
-    //  - Byte2: 0x00
-    // Response: 12-bit value across rx1[3:0] and rx2[7:0]
-    uint8_t tx[3];
-    uint8_t rx[3];
-
-    tx[0] = 0x06 | ((ch & 0x07) >> 2);
-    tx[1] = (uint8_t)((ch & 0x03) << 6);
-    tx[2] = 0x00;
-
-    gpio_put(PIN_CS, 0);
-    spi_write_read_blocking(SPI_PORT, tx, rx, 3);
-    gpio_put(PIN_CS, 1);
-
-    uint16_t value = ((rx[1] & 0x0F) << 8) | rx[2]; // 12 bits
-    return value;
-}
-
 // Set the 4-bit select value on the HC4067 (S0..S3)
 static inline void mux_set(uint8_t sel) {
     gpio_put(PIN_MUX_S0, sel & 0x1);
@@ -67,24 +56,97 @@ static inline void mux_set(uint8_t sel) {
     gpio_put(PIN_MUX_S3, (sel >> 3) & 0x1);
 }
 
+// The muxes share S0-S3, so each scan sets a select value once and reads
+// every mux at it (16 select changes per sweep instead of 80)
+static scan_schedule_t schedule;
+// Double-buffered: the driver scans into one frame while the other is printed
+static uint16_t raw_frames[2][MUX_COUNT * SCAN_SCHEDULE_SELECTS];
+
+// Per-channel settle times from the last characterization
+static uint16_t mux_settle_us[MUX_COUNT][SCAN_SCHEDULE_SELECTS];
+
+// Settle time of one channel when switched to from the previous select value
+static uint16_t characterize_channel(uint8_t mux_idx, uint8_t sel) {
+    uint16_t trace[MUX_CHAR_TRACE_LEN];
+    uint8_t adc_ch = mux_to_adc[mux_idx];
+    uint16_t worst = 0;
+
+    for (int pass = 0; pass < MUX_CHAR_PASSES; pass++) {
+        mux_set((uint8_t)((sel + 15) & 0x0F));
+        sleep_us(MUX_CHAR_PRESETTLE_US);
+
+        mux_set(sel);
+        uint32_t t0 = time_us_32();
+        for (uint16_t i = 0; i < MUX_CHAR_TRACE_LEN; i++) {
+            trace[i] = mcp3208_read(adc_ch);
+        }
+        // Reads are back-to-back, so the average spacing is the sample interval
+        uint16_t interval_us = (uint16_t)((time_us_32() - t0 + MUX_CHAR_TRACE_LEN - 1) / MUX_CHAR_TRACE_LEN);
+
+        uint16_t t = settle_time_from_trace(trace, MUX_CHAR_TRACE_LEN, interval_us, MUX_CHAR_TOLERANCE_LSB);
+        if (t > worst) worst = t;
+    }
+    return worst;
+}
+
+// Measure every channel, plan the schedule from it and print both
+static void characterize_settle(void) {
+    printf("Settle characterization (us, tolerance %u LSB):\n", (unsigned)MUX_CHAR_TOLERANCE_LSB);
+    for (uint8_t mux_idx = 0; mux_idx < MUX_COUNT; mux_idx++) {
+        printf("SETTLE MUX %u:", (unsigned)(mux_idx + 1));
+        for (uint8_t sel = 0; sel < 16; sel++) {
+            mux_settle_us[mux_idx][sel] = characterize_channel(mux_idx, sel);
+            printf(" %u", (unsigned)mux_settle_us[mux_idx][sel]);
+        }
+        printf("\n");
+    }
+
+    // The MCP3208 can read the muxes in any order: slowest-settling last.
+    // Within a DMA batch conversions are mcp3208_conversion_us() apart.
+    uint16_t conv_us = mcp3208_conversion_us();
+    scan_schedule_plan_order(&schedule, mux_settle_us, conv_us);
+    printf("SETTLE WAIT (conversion %u us):", (unsigned)conv_us);
+    for (uint8_t step = 0; step < SCAN_SCHEDULE_SELECTS; step++) {
+        printf(" %u", (unsigned)schedule.steps[step].wait_us);
+    }
+    printf("\n");
+}
+
+// Measure raw batch throughput and full frame scans including settle waits
+static void run_benchmark(void) {
+    static uint16_t bench_frame[MUX_COUNT * SCAN_SCHEDULE_SELECTS];
+    uint16_t values[MUX_COUNT];
+
+    uint32_t t0 = time_us_32();
+    for (uint32_t i = 0; i < BENCH_BATCHES; i++) {
+        mcp3208_read_batch(mux_to_adc, MUX_COUNT, values);
+    }
+    uint32_t batch_us = time_us_32() - t0;
+
+    t0 = time_us_32();
+    for (uint32_t i = 0; i < BENCH_FRAMES; i++) {
+        mcp3208_scan_start(&schedule, mux_set, bench_frame);
+        while (!mcp3208_scan_done()) tight_loop_contents();
+    }
+    uint32_t frame_us = time_us_32() - t0;
+
+    uint64_t batch_samples = (uint64_t)BENCH_BATCHES * MUX_COUNT;
+    uint64_t frame_samples = (uint64_t)BENCH_FRAMES * MUX_COUNT * SCAN_SCHEDULE_SELECTS;
+    printf("BENCH SCK %lu Hz\n", (unsigned long)mcp3208_sck_hz());
+    printf("BENCH batch: %lu samples/s\n", (unsigned long)(batch_samples * 1000000u / (batch_us ? batch_us : 1)));
+    printf("BENCH frame: %lu frames/s, %lu samples/s\n",
+           (unsigned long)((uint64_t)BENCH_FRAMES * 1000000u / (frame_us ? frame_us : 1)),
+           (unsigned long)(frame_samples * 1000000u / (frame_us ? frame_us : 1)));
+}
+
 // Print the current mux output states (reads back the gpio pins so you can verify actual outputs)
 // (removed debug print of select bits to keep output compact)
 
 int main() {
     stdio_init_all();
 
-    // SPI setup
-    spi_init(SPI_PORT, 1000 * 1000); // 1 MHz
-    spi_set_format(SPI_PORT, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
-
-    gpio_set_function(PIN_SCK,  GPIO_FUNC_SPI);
-    gpio_set_function(PIN_MOSI, GPIO_FUNC_SPI);
-    gpio_set_function(PIN_MISO, GPIO_FUNC_SPI);
-
-    // CS pin
-    gpio_init(PIN_CS);
-    gpio_set_dir(PIN_CS, GPIO_OUT);
-    gpio_put(PIN_CS, 1);
+    // SPI (PIO + DMA) setup
+    bool adc_ok = mcp3208_init();
 
     // Configure mux select pins as outputs
     gpio_init(PIN_MUX_S0);
@@ -106,7 +168,38 @@ int main() {
     // Give USB time to connect
     sleep_ms(1000);
 
+    if (!adc_ok) {
+        while (true) {
+            printf("MCP3208 init failed: no free PIO state machine\n");
+            sleep_ms(1000);
+        }
+    }
+
+    scan_schedule_init(&schedule, mux_to_adc, MUX_COUNT, MUX_SETTLE_US);
+#if MUX_CHARACTERIZE
+    characterize_settle();
+#endif
+    run_benchmark();
+
+    uint8_t back = 0;
+    mcp3208_scan_start(&schedule, mux_set, raw_frames[back]);
+
     while (true) {
+        // Wait for the frame in flight, then scan the next one while this one prints
+        while (!mcp3208_scan_done()) tight_loop_contents();
+        const uint16_t *raw_frame = raw_frames[back];
+
+        // 'c' over serial re-runs the settle characterization, 'b' the benchmark
+        int c = getchar_timeout_us(0);
+        if (c == 'c' || c == 'C') {
+            characterize_settle();
+        } else if (c == 'b' || c == 'B') {
+            run_benchmark();
+        }
+
+        back ^= 1;
+        mcp3208_scan_start(&schedule, mux_set, raw_frames[back]);
+
         // Build one output block in a buffer and print it in a single call to avoid line-by-line prints
         // This reduces interleaving and sends the whole scan as one packet to the serial monitor.
         char outbuf[2048];
@@ -114,8 +207,6 @@ int main() {
         size_t left = sizeof(outbuf);
 
         for (uint8_t mux_idx = 0; mux_idx < MUX_COUNT; mux_idx++) {
-            uint8_t adc_ch = mux_to_adc[mux_idx];
-
             // append header for this mux
             int n = snprintf(outbuf + off, left, "MUX %u", (unsigned)(mux_idx + 1));
             if (n < 0) n = 0;
@@ -124,10 +215,7 @@ int main() {
 
             bool any_printed = false;
             for (uint8_t sel = 0; sel < 16; sel++) {
-                mux_set(sel);
-                // small settle time after switching the mux select lines
-                sleep_us(MUX_SETTLE_US);
-                uint16_t raw = mcp3208_read(adc_ch);
+                uint16_t raw = raw_frame[mux_idx * SCAN_SCHEDULE_SELECTS + sel];
                 if (raw >= MUX_PRINT_THRESHOLD && left > 0) {
                     n = snprintf(outbuf + off, left, " | CH%u: %u", (unsigned)(sel + 1), (unsigned)raw);
                     if (n < 0) n = 0;
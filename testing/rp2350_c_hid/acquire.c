@@ -0,0 +1,293 @@
+#include "acquire.h"
+#include "scan.h"
+#include "spsc_ring.h"
+#include "flash_store.h"
+#include "sample_filter.h"
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "pico/flash.h"
+#include "hardware/sync.h"
+
+static frame_t frame_storage[ACQUIRE_FRAME_RING_DEPTH];
+static key_event_t event_storage[ACQUIRE_EVENT_RING_DEPTH];
+static spsc_ring_t frame_ring;
+static spsc_ring_t event_ring;
+
+// Written by core 1 only
+static volatile acquire_stats_t stats;
+
+// Settle characterization handshake: core 0 sets char_requested, core 1
+// fills settle_table and then bumps char_done
+static uint16_t settle_table[NUM_MUXES][CHANNELS_PER_MUX];
+static volatile bool char_requested = SCAN_CHARACTERIZE_AT_BOOT;
+static volatile uint32_t char_done = 0;
+static uint32_t char_taken = 0;
+
+// Key calibration handshake: core 0 loads calib_record before launching
+// core 1 (calib_loaded); afterwards core 1 fills it and sets calib_pending,
+// core 0 writes it to flash and clears calib_pending
+static uint8_t calib_record[KEYS_CALIB_RECORD_SIZE];
+static bool calib_loaded = false;
+static volatile bool calib_pending = false;
+static volatile int8_t calib_request = 0;   // +1 begin, -1 end
+
+// Scan power policy, run by core 1; the tier is published for core 0
+static const power_config_t power_config = {
+    .tier = {
+        [POWER_TIER_ACTIVE] = {.slices = 1},
+        [POWER_TIER_IDLE] = {.interval_us = POWER_IDLE_FRAME_US, .slices = 1,
+                             .oversample = POWER_LOW_OVERSAMPLE, .settle_us = POWER_LOW_SETTLE_US},
+        [POWER_TIER_SLEEP] = {.interval_us = POWER_SLEEP_FRAME_US, .slices = POWER_SLEEP_SLICES,
+                              .oversample = POWER_LOW_OVERSAMPLE, .settle_us = POWER_LOW_SETTLE_US},
+    },
+    .idle_after_ms = POWER_IDLE_AFTER_MS,
+    .sleep_after_ms = POWER_SLEEP_AFTER_MS,
+    .wake_travel = POWER_WAKE_TRAVEL,
+};
+static power_mode_t power;
+static volatile power_tier_t power_tier = POWER_TIER_ACTIVE;
+static volatile bool power_poke = false;
+
+// Filters every frame in place before key detection and publishing
+static sample_filter_t filter;
+
+static void filter_frame(frame_t *frame) {
+    uint32_t start = time_us_32();
+    sample_filter_process(&filter, frame->raw, frame->raw);
+    uint32_t elapsed = time_us_32() - start;
+    if (elapsed > stats.filter_us_max) {
+        stats.filter_us_max = elapsed;
+    }
+}
+
+static void publish_key_events(const frame_t *frame) {
+    uint8_t changed[KEY_BITMAP_BYTES];
+    uint32_t start = time_us_32();
+    uint8_t num_changed = keys_process(frame, changed);
+    uint32_t elapsed = time_us_32() - start;
+    if (elapsed > stats.keys_us_max) {
+        stats.keys_us_max = elapsed;
+    }
+    if (num_changed == 0) {
+        return;
+    }
+
+    for (int ch = 0; ch < TOTAL_CHANNELS; ch++) {
+        if (!(changed[ch >> 3] & (1u << (ch & 7)))) continue;
+
+        key_event_t event = {
+            .timestamp_us = frame->timestamp_us,
+            .frame_seq = frame->seq,
+            .channel = (uint8_t)ch,
+            .pressed = keys_is_pressed((uint8_t)ch),
+        };
+        if (!spsc_ring_push(&event_ring, &event)) {
+            stats.events_dropped++;
+        }
+    }
+}
+
+// Feed a frame to the power policy and switch the scan mode with the tier
+static void update_power(const frame_t *frame) {
+    if (power_poke || calib_request || keys_calibrating()) {
+        power_poke = false;
+        power_mode_poke(&power, frame->timestamp_us);
+    }
+
+    // A frame from before the last mode switch has no known slice
+    int slice = scan_frame_slice(frame->seq);
+    if (slice >= 0) {
+        uint8_t travel[TOTAL_CHANNELS];
+        keys_get_travel(travel);
+        power_mode_update(&power, frame->timestamp_us, (uint8_t) slice, travel, keys_pressed_count() != 0);
+    }
+
+    if (power_mode_take_change(&power)) {
+        const power_tier_config_t *cfg = power_mode_tier_config(&power);
+        scan_stop();
+        scan_set_mode(cfg->interval_us, cfg->slices, cfg->oversample, cfg->settle_us);
+        scan_start();
+        power_tier = power.tier;
+    }
+}
+
+static void characterize(void) {
+    scan_stop();
+    scan_characterize(settle_table);
+    scan_apply_settle(settle_table);
+    char_requested = false;
+    __dmb();
+    char_done++;
+}
+
+// Apply calibration requests and hand new tables to core 0
+static void service_calibration(void) {
+    static uint32_t last_export_ms = 0;
+
+    int8_t request = calib_request;
+    if (request) {
+        if (request > 0) {
+            keys_begin_calibration();
+        } else {
+            keys_end_calibration();
+            last_export_ms = 0;    // Publish right away
+        }
+        calib_request = 0;
+    }
+
+    if (calib_pending) {
+        return;
+    }
+    uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+    if (last_export_ms != 0 && now_ms - last_export_ms < ACQUIRE_CALIB_SAVE_INTERVAL_MS) {
+        return;
+    }
+    if (keys_export_calibration(calib_record)) {
+        last_export_ms = now_ms ? now_ms : 1;
+        __dmb();
+        calib_pending = true;
+    }
+}
+
+static void core1_entry(void) {
+    // Let core 0 pause this core while it writes flash
+    flash_safe_execute_core_init();
+
+    static const sample_filter_config_t filter_config = {
+        .weight = FILTER_WEIGHT,
+        .deadband = FILTER_DEADBAND,
+        .full_speed = FILTER_FULL_SPEED,
+    };
+    sample_filter_init(&filter, TOTAL_CHANNELS, FILTER_MEDIAN_LEN, &filter_config);
+
+    // Scan interrupts are enabled on this core
+    keys_init();
+    if (calib_loaded) {
+        keys_import_calibration(calib_record, sizeof(calib_record));
+    }
+    power_mode_init(&power, TOTAL_CHANNELS, CHANNELS_PER_MUX, &power_config, time_us_32());
+    scan_start();
+
+    frame_t overflow;
+    uint32_t last_seq = 0;
+
+    while (true) {
+        // Copy straight into the next ring slot when there is room
+        frame_t *slot = (frame_t *) spsc_ring_write_slot(&frame_ring);
+        frame_t *frame = slot ? slot : &overflow;
+
+        if (char_requested) {
+            characterize();
+            sample_filter_reset(&filter);
+            scan_start();
+        }
+
+        if (!scan_get_frame(frame, last_seq)) {
+            // Sleep until the next scan interrupt
+            __wfi();
+            continue;
+        }
+        last_seq = frame->seq;
+
+        filter_frame(frame);
+        publish_key_events(frame);
+        service_calibration();
+        update_power(frame);
+
+        if (slot) {
+            spsc_ring_commit(&frame_ring);
+            stats.frames_published++;
+        } else {
+            stats.frames_dropped++;
+        }
+
+        // Wake core 0 for the new frame and key events
+        __sev();
+    }
+}
+
+void acquire_launch_core1(void) {
+    calib_loaded = flash_store_load(KEYS_CALIB_MAGIC, calib_record, sizeof(calib_record));
+    spsc_ring_init(&frame_ring, frame_storage, sizeof(frame_t), ACQUIRE_FRAME_RING_DEPTH);
+    spsc_ring_init(&event_ring, event_storage, sizeof(key_event_t), ACQUIRE_EVENT_RING_DEPTH);
+    multicore_launch_core1(core1_entry);
+}
+
+bool acquire_latest_frame(frame_t *out) {
+    // Skip straight to the newest frame without copying the older ones
+    while (spsc_ring_count(&frame_ring) > 1) {
+        spsc_ring_release(&frame_ring);
+    }
+    return spsc_ring_pop(&frame_ring, out);
+}
+
+bool acquire_next_frame(frame_t *out) {
+    return spsc_ring_pop(&frame_ring, out);
+}
+
+uint32_t acquire_frames_pending(void) {
+    return spsc_ring_count(&frame_ring);
+}
+
+const frame_t *acquire_peek_frame(uint32_t index) {
+    return (const frame_t *) spsc_ring_peek(&frame_ring, index);
+}
+
+void acquire_release_frames(uint32_t count) {
+    while (count--) {
+        spsc_ring_release(&frame_ring);
+    }
+}
+
+bool acquire_pop_event(key_event_t *event) {
+    return spsc_ring_pop(&event_ring, event);
+}
+
+void acquire_request_characterization(void) {
+    // Core 1 wakes from __wfi on the next scan interrupt and picks it up
+    char_requested = true;
+}
+
+const uint16_t (*acquire_take_settle_table(void))[CHANNELS_PER_MUX] {
+    uint32_t done = char_done;
+    if (done == char_taken) {
+        return NULL;
+    }
+    __dmb();
+    char_taken = done;
+    return (const uint16_t (*)[CHANNELS_PER_MUX]) settle_table;
+}
+
+void acquire_request_calibration(bool start) {
+    calib_request = start ? 1 : -1;
+}
+
+bool acquire_save_calibration(void) {
+    if (!calib_pending) {
+        return false;
+    }
+    __dmb();
+    bool ok = flash_store_save(KEYS_CALIB_MAGIC, calib_record, sizeof(calib_record));
+    calib_pending = false;
+    return ok;
+}
+
+void acquire_power_poke(void) {
+    power_poke = true;
+}
+
+power_tier_t acquire_power_tier(void) {
+    return power_tier;
+}
+
+void acquire_get_power_stats(power_mode_stats_t *out) {
+    *out = power.stats;
+}
+
+void acquire_get_stats(acquire_stats_t *out) {
+    out->frames_published = stats.frames_published;
+    out->frames_dropped = stats.frames_dropped;
+    out->events_dropped = stats.events_dropped;
+    out->keys_us_max = stats.keys_us_max;
+    out->filter_us_max = stats.filter_us_max;
+}
@@ -0,0 +1,157 @@
+#ifndef ACQUIRE_H
+#define ACQUIRE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "frame.h"
+#include "keys.h"
+#include "power_mode.h"
+
+// Core 1 owns analog acquisition: it runs the scan engine interrupts and key
+// detection and publishes every completed frame and key event through
+// lock-free SPSC rings. Core 0 only consumes them, so USB, CDC and printf
+// never add jitter to the scan.
+//
+// Core 1 also runs the scan power policy (../common/power_mode.h, settings
+// in config.h): on a tier change it stops the scan, switches its mode with
+// scan_set_mode() and restarts it, so a wake goes straight back to
+// back-to-back frames.
+
+#ifndef ACQUIRE_FRAME_RING_DEPTH
+#define ACQUIRE_FRAME_RING_DEPTH 32     // Must be a power of two; covers bulk transfers in flight
+#endif
+
+#ifndef ACQUIRE_EVENT_RING_DEPTH
+#define ACQUIRE_EVENT_RING_DEPTH 64     // Must be a power of two
+#endif
+
+// Minimum time between saves of an auto-ranged calibration table
+#ifndef ACQUIRE_CALIB_SAVE_INTERVAL_MS
+#define ACQUIRE_CALIB_SAVE_INTERVAL_MS (5 * 60 * 1000)
+#endif
+
+typedef struct {
+    uint32_t frames_published;
+    uint32_t frames_dropped;    // Frame ring full (core 0 fell behind)
+    uint32_t events_dropped;    // Event ring full
+    uint32_t keys_us_max;       // Slowest key detection pass over a frame
+    uint32_t filter_us_max;     // Slowest sample filter pass over a frame
+} acquire_stats_t;
+
+/**
+ * @brief Initialize the rings and launch the acquisition loop on core 1
+ *
+ * scan_init() must have been called first (on core 0). A key calibration
+ * table saved in flash is restored before the first frame.
+ */
+void acquire_launch_core1(void);
+
+/**
+ * @brief Take the newest published frame, discarding older ones
+ *
+ * @param out Destination frame
+ * @return true if at least one new frame was available
+ */
+bool acquire_latest_frame(frame_t *out);
+
+/**
+ * @brief Take the oldest published frame (for consumers that need them all)
+ *
+ * @param out Destination frame
+ * @return true if a frame was available
+ */
+bool acquire_next_frame(frame_t *out);
+
+/**
+ * @brief Number of published frames not yet taken or released
+ */
+uint32_t acquire_frames_pending(void);
+
+/**
+ * @brief Look at a pending frame in its ring slot without taking it
+ *
+ * The frame stays valid and unchanged until released with
+ * acquire_release_frames().
+ *
+ * @param index 0 = oldest pending frame
+ * @return The frame, or NULL if fewer frames are pending
+ */
+const frame_t *acquire_peek_frame(uint32_t index);
+
+/**
+ * @brief Hand the oldest pending frames back to core 1
+ *
+ * @param count Number of frames to release
+ */
+void acquire_release_frames(uint32_t count);
+
+/**
+ * @brief Take the next key event
+ *
+ * @param event Destination event
+ * @return true if an event was available
+ */
+bool acquire_pop_event(key_event_t *event);
+
+/**
+ * @brief Ask core 1 to re-run settle characterization
+ *
+ * The scan pauses while the mux channels are measured, then resumes with
+ * per-step settle waits planned from the new table.
+ */
+void acquire_request_characterization(void);
+
+/**
+ * @brief Take a freshly completed settle characterization
+ *
+ * Returns each completed characterization once (including the one at boot
+ * when SCAN_CHARACTERIZE_AT_BOOT is set).
+ *
+ * @return Settle table in microseconds per mux and channel, or NULL
+ */
+const uint16_t (*acquire_take_settle_table(void))[CHANNELS_PER_MUX];
+
+/**
+ * @brief Start or finish explicit key calibration on core 1
+ *
+ * @param start true to begin (keys must be released), false to finish
+ */
+void acquire_request_calibration(bool start);
+
+/**
+ * @brief Save the key calibration table to flash if core 1 has a new one
+ *
+ * Call from the core 0 main loop. Core 1 publishes the table when explicit
+ * calibration finishes and, after auto-ranging changed it, at most every
+ * ACQUIRE_CALIB_SAVE_INTERVAL_MS. Core 1 is paused during the flash write.
+ *
+ * @return true if a table was saved
+ */
+bool acquire_save_calibration(void);
+
+/**
+ * @brief Get acquisition statistics
+ */
+void acquire_get_stats(acquire_stats_t *stats);
+
+/**
+ * @brief Report activity that did not come from the keys
+ *
+ * Returns the scan to full rate, e.g. on a host command or the button.
+ * Core 1 picks it up with the next frame.
+ */
+void acquire_power_poke(void);
+
+/**
+ * @brief Get the current scan power tier
+ */
+power_tier_t acquire_power_tier(void);
+
+/**
+ * @brief Get the power policy statistics
+ *
+ * Copied while core 1 keeps updating them, so counters can be one frame apart.
+ */
+void acquire_get_power_stats(power_mode_stats_t *stats);
+
+#endif // ACQUIRE_H
@@ -0,0 +1,154 @@
+#include "bulk_stream.h"
+#include "acquire.h"
+#include "tusb.h"
+#include "device/usbd_pvt.h"
+
+_Static_assert(sizeof(frame_t) == BULK_STREAM_FRAME_SIZE, "frame_t must match the wire format");
+
+static uint8_t stream_rhport;
+static uint8_t ep_in = 0;
+static uint16_t ep_packet_size = 64;
+static bool streaming = false;
+static uint32_t inflight = 0;       // Ring frames held by the transfer in progress
+static uint32_t dropped_base;       // acquire frames_dropped at START
+static bulk_stream_stats_t stats;
+static bulk_stream_stats_t stats_reply;     // Stays valid during the data stage
+
+static void bulk_init(void) {
+    streaming = false;
+    inflight = 0;
+    ep_in = 0;
+}
+
+static bool bulk_deinit(void) {
+    return true;
+}
+
+static void bulk_reset(uint8_t rhport) {
+    (void) rhport;
+    // Endpoints are closed: the frames of an aborted transfer simply stay
+    // pending in the ring for the other consumers
+    bulk_init();
+}
+
+static uint16_t bulk_open(uint8_t rhport, tusb_desc_interface_t const *itf_desc, uint16_t max_len) {
+    // Application drivers see every interface first; claim only ours
+    if (itf_desc->bInterfaceClass != TUSB_CLASS_VENDOR_SPECIFIC || itf_desc->bNumEndpoints != 1) {
+        return 0;
+    }
+    uint16_t len = sizeof(tusb_desc_interface_t) + sizeof(tusb_desc_endpoint_t);
+    if (max_len < len) {
+        return 0;
+    }
+
+    tusb_desc_endpoint_t const *ep_desc = (tusb_desc_endpoint_t const *) tu_desc_next(itf_desc);
+    if (tu_desc_type(ep_desc) != TUSB_DESC_ENDPOINT || !usbd_edpt_open(rhport, ep_desc)) {
+        return 0;
+    }
+    stream_rhport = rhport;
+    ep_in = ep_desc->bEndpointAddress;
+    ep_packet_size = tu_edpt_packet_size(ep_desc);
+    return len;
+}
+
+static bool bulk_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const *request) {
+    if (request->bmRequestType_bit.type != TUSB_REQ_TYPE_VENDOR) {
+        return false;
+    }
+    if (stage != CONTROL_STAGE_SETUP) {
+        return true;
+    }
+
+    acquire_stats_t acq;
+    switch (request->bRequest) {
+        case BULK_STREAM_REQ_START:
+            acquire_get_stats(&acq);
+            dropped_base = acq.frames_dropped;
+            stats.frames_sent = 0;
+            stats.transfers = 0;
+            streaming = true;
+            return tud_control_status(rhport, request);
+
+        case BULK_STREAM_REQ_STOP:
+            // A transfer in flight still completes and releases its frames
+            streaming = false;
+            return tud_control_status(rhport, request);
+
+        case BULK_STREAM_REQ_STATS:
+            acquire_get_stats(&acq);
+            stats_reply = stats;
+            stats_reply.frames_dropped = acq.frames_dropped - dropped_base;
+            return tud_control_xfer(rhport, request, &stats_reply, sizeof(stats_reply));
+
+        default:
+            return false;
+    }
+}
+
+static bool bulk_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
+    (void) rhport;
+    (void) xferred_bytes;
+    if (ep_addr != ep_in) {
+        return false;
+    }
+
+    // Sent (or failed): either way the slots go back to core 1
+    acquire_release_frames(inflight);
+    if (result == XFER_RESULT_SUCCESS) {
+        stats.frames_sent += inflight;
+    }
+    inflight = 0;
+    bulk_stream_task();
+    return true;
+}
+
+static const usbd_class_driver_t bulk_driver = {
+    .init = bulk_init,
+    .deinit = bulk_deinit,
+    .reset = bulk_reset,
+    .open = bulk_open,
+    .control_xfer_cb = bulk_control_xfer_cb,
+    .xfer_cb = bulk_xfer_cb,
+    .sof = NULL,
+};
+
+usbd_class_driver_t const *usbd_app_driver_get_cb(uint8_t *driver_count) {
+    *driver_count = 1;
+    return &bulk_driver;
+}
+
+bool bulk_stream_active(void) {
+    return streaming || inflight != 0;
+}
+
+void bulk_stream_task(void) {
+    if (!streaming || inflight != 0 || ep_in == 0 || !tud_ready() ||
+        usbd_edpt_busy(stream_rhport, ep_in)) {
+        return;
+    }
+
+    uint32_t pending = acquire_frames_pending();
+    if (pending == 0) {
+        return;
+    }
+
+    // One transfer covers the frames that sit in consecutive slots (up to
+    // the end of the ring storage)
+    const frame_t *first = acquire_peek_frame(0);
+    uint32_t count = 1;
+    while (count < pending && count < BULK_STREAM_BATCH_FRAMES && acquire_peek_frame(count) == first + count) {
+        count++;
+    }
+    // A transfer that fills its last packet would need a ZLP to end; send
+    // one frame fewer so the short packet ends the host's read instead
+    while (count > 1 && (count * sizeof(frame_t)) % ep_packet_size == 0) {
+        count--;
+    }
+
+    // The controller reads the slots in place; they are not written until
+    // released in bulk_xfer_cb()
+    if (usbd_edpt_xfer(stream_rhport, ep_in, (uint8_t *) first, (uint16_t)(count * sizeof(frame_t)))) {
+        inflight = count;
+        stats.transfers++;
+    }
+}
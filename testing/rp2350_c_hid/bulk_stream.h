@@ -0,0 +1,80 @@
+#ifndef BULK_STREAM_H
+#define BULK_STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "frame.h"
+
+// Raw frame capture over a vendor-specific bulk IN interface.
+//
+// Every scan frame is sent as it sits in the acquisition ring: frame_t
+// unchanged (seq uint32, timestamp_us uint32, raw uint16[TOTAL_CHANNELS],
+// all LE, BULK_STREAM_FRAME_SIZE bytes) with no header or padding. Runs of
+// consecutive ring slots are handed to the USB controller directly, so a
+// frame is never copied on the device; the slots go back to core 1 when
+// the transfer completes. A frame core 1 could not publish because the
+// ring was full shows up as a seq gap. A transfer is never a whole number
+// of packets, so each one ends with a short packet and completes the
+// host's read without a ZLP.
+//
+// The interface has one bulk IN endpoint and is described to Windows as
+// WinUSB through an MS OS 2.0 descriptor, so libusb opens it without a
+// driver install. It is a TinyUSB application class driver rather than the
+// vendor class, whose TX FIFO would copy every frame (CFG_TUD_VENDOR stays
+// 0). Vendor requests to the interface:
+//
+//   BULK_STREAM_REQ_START   OUT, no data: start streaming from the oldest
+//                           frame in the ring, clears the counters
+//   BULK_STREAM_REQ_STOP    OUT, no data
+//   BULK_STREAM_REQ_STATS   IN, bulk_stream_stats_t
+
+#ifndef BULK_STREAM_ENABLED
+#define BULK_STREAM_ENABLED 1
+#endif
+
+#define BULK_STREAM_FRAME_SIZE  (8 + 2 * TOTAL_CHANNELS)
+
+// Most frames handed to one transfer (one fewer when they would fill whole
+// packets: 8 x 168 B is 21 x 64 B at full speed)
+#ifndef BULK_STREAM_BATCH_FRAMES
+#define BULK_STREAM_BATCH_FRAMES 8
+#endif
+
+#define BULK_STREAM_REQ_START   0x01
+#define BULK_STREAM_REQ_STOP    0x02
+#define BULK_STREAM_REQ_STATS   0x03
+
+// Device-level vendor request code the host uses to fetch the MS OS 2.0
+// descriptor set (announced in the BOS descriptor)
+#define BULK_STREAM_MS_OS_VENDOR_CODE 0x20
+
+// Interface descriptor: one bulk IN endpoint
+#define BULK_STREAM_DESC_LEN    (9 + 7)
+#define BULK_STREAM_DESCRIPTOR(_itfnum, _stridx, _epin, _epsize) \
+    9, TUSB_DESC_INTERFACE, _itfnum, 0, 1, TUSB_CLASS_VENDOR_SPECIFIC, 0x00, 0x00, _stridx, \
+    7, TUSB_DESC_ENDPOINT, _epin, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0
+
+typedef struct __attribute__((packed)) {
+    uint32_t frames_sent;       // Since the last START
+    uint32_t transfers;
+    uint32_t frames_dropped;    // Ring full on core 1 since the last START
+} bulk_stream_stats_t;
+
+/**
+ * @brief Check whether the stream currently owns the frame ring
+ *
+ * True while the host has streaming started or a transfer is still in
+ * flight; other consumers must then look at frames in place
+ * (acquire_peek_frame()) instead of taking them.
+ */
+bool bulk_stream_active(void);
+
+/**
+ * @brief Submit the next run of frames if the endpoint is idle
+ *
+ * Call every main-loop pass after tud_task(); completions resubmit on
+ * their own.
+ */
+void bulk_stream_task(void);
+
+#endif // BULK_STREAM_H
@@ -0,0 +1,104 @@
+#include "cdc_telemetry.h"
+#include "pico/stdlib.h"
+#include "pico/stdio.h"
+#include "pico/stdio_usb.h"
+#include "hal.h"
+
+static uint8_t ring_storage[CDC_TELEMETRY_RING_SIZE];
+static telemetry_tx_t ring;
+static bool binary_mode = false;
+static bool stdio_rerouted = false;
+
+// stdio driver used in binary mode: printf() text becomes TEXT records
+static void telemetry_out_chars(const char *buf, int len) {
+    while (len > 0) {
+        uint16_t chunk = len > TELEMETRY_MAX_PAYLOAD ? TELEMETRY_MAX_PAYLOAD : (uint16_t) len;
+        telemetry_send(&ring, TELEMETRY_TEXT, buf, chunk, NULL, 0);
+        buf += chunk;
+        len -= chunk;
+    }
+}
+
+static stdio_driver_t telemetry_stdio = {
+    .out_chars = telemetry_out_chars,
+};
+
+void cdc_telemetry_init(void) {
+    telemetry_tx_init(&ring, ring_storage, sizeof(ring_storage));
+}
+
+void cdc_telemetry_set_binary(bool binary) {
+    if (binary == binary_mode) {
+        return;
+    }
+    binary_mode = binary;
+    if (binary) {
+        // Text printed so far is written straight to CDC, never via the ring
+        stdio_set_driver_enabled(&stdio_usb, false);
+        stdio_set_driver_enabled(&telemetry_stdio, true);
+        stdio_rerouted = true;
+        const uint8_t delimiter = 0;
+        telemetry_tx_write_raw(&ring, &delimiter, 1);
+    }
+    // Back to text: stdio returns to CDC in cdc_telemetry_task() once the
+    // queued records are out, so text never lands inside a packet
+}
+
+bool cdc_telemetry_binary(void) {
+    return binary_mode;
+}
+
+void cdc_telemetry_send_frame(const frame_t *frame) {
+    if (!binary_mode) {
+        return;
+    }
+    const telemetry_frame_header_t header = {
+        .seq = frame->seq,
+        .timestamp_us = frame->timestamp_us,
+        .count = TOTAL_CHANNELS,
+    };
+    telemetry_send(&ring, TELEMETRY_FRAME, &header, sizeof(header), frame->raw, sizeof(frame->raw));
+}
+
+void cdc_telemetry_send_key(const key_event_t *event) {
+    if (!binary_mode) {
+        return;
+    }
+    const telemetry_key_t key = {
+        .timestamp_us = event->timestamp_us,
+        .key = event->channel,
+        .pressed = event->pressed,
+    };
+    telemetry_send(&ring, TELEMETRY_KEY, &key, sizeof(key), NULL, 0);
+}
+
+void cdc_telemetry_send_stats(const acquire_stats_t *acq) {
+    if (!binary_mode) {
+        return;
+    }
+    const telemetry_stats_t stats = {
+        .uptime_ms = to_ms_since_boot(get_absolute_time()),
+        .records_sent = ring.records_sent + 1,  // Including this one
+        .records_dropped = ring.records_dropped,
+        .scans = acq->frames_published,
+        .scans_dropped = acq->frames_dropped,
+    };
+    telemetry_send(&ring, TELEMETRY_STATS, &stats, sizeof(stats), NULL, 0);
+}
+
+void cdc_telemetry_task(void) {
+    if (!hal_cdc_connected()) {
+        // Nobody is listening; don't replay stale records on connect
+        telemetry_tx_consume(&ring, telemetry_tx_used(&ring));
+    }
+
+    if (telemetry_tx_drain(&ring, hal_cdc_write)) {
+        hal_cdc_flush();
+    }
+
+    if (!binary_mode && stdio_rerouted && telemetry_tx_used(&ring) == 0) {
+        stdio_set_driver_enabled(&telemetry_stdio, false);
+        stdio_set_driver_enabled(&stdio_usb, true);
+        stdio_rerouted = false;
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef CDC_TELEMETRY_H
+#define CDC_TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "frame.h"
+#include "acquire.h"
+#include "telemetry.h"
+
+// Binary telemetry on the CDC port (format in ../common/telemetry.h).
+//
+// In binary mode every scan frame goes out as a TELEMETRY_FRAME record of
+// raw counts, key events as TELEMETRY_KEY and acquisition counters as
+// TELEMETRY_STATS. printf() output is rerouted into TELEMETRY_TEXT records
+// so it cannot corrupt the stream. Records are queued in a large ring and
+// written to the CDC FIFO as it frees up, with one flush per main-loop pass.
+// Text mode (the default) leaves stdio on CDC untouched.
+
+#ifndef CDC_TELEMETRY_RING_SIZE
+#define CDC_TELEMETRY_RING_SIZE 16384   // ~90 full frames, power of two
+#endif
+
+/**
+ * @brief Prepare the ring (text mode)
+ */
+void cdc_telemetry_init(void);
+
+/**
+ * @brief Switch between binary telemetry and text stdio
+ *
+ * Entering binary mode starts with a packet delimiter so the host resyncs;
+ * text output resumes once the queued records are written.
+ */
+void cdc_telemetry_set_binary(bool binary);
+
+/**
+ * @brief Check whether binary mode is active
+ */
+bool cdc_telemetry_binary(void);
+
+/**
+ * @brief Queue a scan frame (binary mode only)
+ */
+void cdc_telemetry_send_frame(const frame_t *frame);
+
+/**
+ * @brief Queue a key event (binary mode only)
+ */
+void cdc_telemetry_send_key(const key_event_t *event);
+
+/**
+ * @brief Queue the link and acquisition counters (binary mode only)
+ */
+void cdc_telemetry_send_stats(const acquire_stats_t *acq);
+
+/**
+ * @brief Write queued bytes to the CDC FIFO and flush once
+ *
+ * Call every main-loop pass after tud_task().
+ */
+void cdc_telemetry_task(void);
+
+#endif // CDC_TELEMETRY_H
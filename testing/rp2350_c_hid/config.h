@@ -1,10 +1,90 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
 #define MUX_S0 10
 #define MUX_S1 11
 #define MUX_S2 12
 #define MUX_S3 13
 
 #define MUX1_PIN 40  // ADC0 (GP40)
-#define MUX2_PIN 45  // ADC1 (GP41)
-#define MUX3_PIN 46  // ADC2 (GP42)
-#define MUX4_PIN 47  // ADC3 (GP43)
-#define MUX5_PIN 44  // ADC4 (GP44) - RP2350B only
\ No newline at end of file
+#define MUX2_PIN 45  // ADC5 (GP45)
+#define MUX3_PIN 46  // ADC6 (GP46)
+#define MUX4_PIN 47  // ADC7 (GP47)
+#define MUX5_PIN 44  // ADC4 (GP44) - RP2350B only
+
+#define NUM_MUXES 5
+#define CHANNELS_PER_MUX 16
+#define TOTAL_CHANNELS (NUM_MUXES * CHANNELS_PER_MUX)
+
+// Scan engine timing
+// Settle time after changing S0-S3 before the round-robin burst starts. All
+// five muxes switch together, so this is paid 16 times per frame. The hall
+// sensors drive the mux with a low impedance output, so a few tens of us is
+// enough; raise it if readings on the first channel of a burst look low.
+// Used until settle characterization has run.
+#ifndef SCAN_SETTLE_US
+#define SCAN_SETTLE_US 16
+#endif
+
+// ADC conversion time at the default 48 MHz ADC clock
+#define SCAN_CONVERSION_US 2
+
+// Settle characterization: for every mux/channel, switch from the channel
+// scanned before it (after a long pre-settle), sample the line back-to-back
+// and find when it stays within SCAN_CHAR_TOLERANCE_LSB of its final value.
+// The worst of SCAN_CHAR_PASSES runs plus SCAN_CHAR_MARGIN_US is kept.
+#ifndef SCAN_CHARACTERIZE_AT_BOOT
+#define SCAN_CHARACTERIZE_AT_BOOT 1
+#endif
+#ifndef SCAN_CHAR_TOLERANCE_LSB
+#define SCAN_CHAR_TOLERANCE_LSB 8
+#endif
+#define SCAN_CHAR_TRACE_LEN 128         // Samples per trace (256 us at 2 us each)
+#define SCAN_CHAR_PRESETTLE_US 1000     // Time spent on the previous channel first
+#define SCAN_CHAR_PASSES 4
+#define SCAN_CHAR_MARGIN_US 2
+
+// Round-robin passes per select step. Each pass converts every mux once
+// (2 us per conversion at the default 48 MHz ADC clock); passes are averaged.
+#ifndef SCAN_OVERSAMPLE
+#define SCAN_OVERSAMPLE 1
+#endif
+
+// Sample filter (../common/sample_filter.h) run on every frame on core 1
+// before key detection; the CDC and vendor HID outputs carry the filtered
+// values. A 3-frame median drops single-frame spikes (e.g. from the WS2812
+// line) for one frame of delay, then an adaptive EMA smooths resting keys
+// with weight FILTER_WEIGHT/256 and opens up to no smoothing as the
+// deviation grows from FILTER_DEADBAND to FILTER_DEADBAND + FILTER_FULL_SPEED
+// counts. tools/sample_filter_bench.c in ../common compares the presets.
+#ifndef FILTER_MEDIAN_LEN
+#define FILTER_MEDIAN_LEN 3             // 1 (off), 3 or 5
+#endif
+#ifndef FILTER_WEIGHT
+#define FILTER_WEIGHT 16                // 1-256, 256 = no smoothing
+#endif
+#define FILTER_DEADBAND 12
+#define FILTER_FULL_SPEED 64            // 0 = plain EMA
+
+// Low-power scanning (../common/power_mode.h), run on core 1. After
+// POWER_IDLE_AFTER_MS without activity frames start POWER_IDLE_FRAME_US
+// apart instead of back to back; after POWER_SLEEP_AFTER_MS each frame
+// covers only 1/POWER_SLEEP_SLICES of the select values, every
+// POWER_SLEEP_FRAME_US. Both use POWER_LOW_OVERSAMPLE passes and settle
+// waits capped at POWER_LOW_SETTLE_US: a resting key only has to move
+// POWER_WAKE_TRAVEL to be noticed, and the first such change returns to
+// the full-rate scan.
+#ifndef POWER_IDLE_AFTER_MS
+#define POWER_IDLE_AFTER_MS 5000
+#endif
+#ifndef POWER_SLEEP_AFTER_MS
+#define POWER_SLEEP_AFTER_MS 60000
+#endif
+#define POWER_IDLE_FRAME_US 5000
+#define POWER_SLEEP_FRAME_US 10000
+#define POWER_SLEEP_SLICES 4            // Every channel scanned every 40 ms
+#define POWER_LOW_OVERSAMPLE 1
+#define POWER_LOW_SETTLE_US 8
+#define POWER_WAKE_TRAVEL 8             // 0-255 travel units
+
+#endif // CONFIG_H
@@ -0,0 +1,15 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <stdint.h>
+#include "config.h"
+
+// One complete sweep of all mux channels.
+// raw[] is indexed mux-major: raw[mux * CHANNELS_PER_MUX + channel]
+typedef struct {
+    uint32_t seq;                   // Incremented once per completed sweep
+    uint32_t timestamp_us;          // Time the last channel of the sweep was sampled
+    uint16_t raw[TOTAL_CHANNELS];   // 12-bit ADC counts
+} frame_t;
+
+#endif // FRAME_H
@@ -0,0 +1,115 @@
+#include "frame_codec.h"
+#include <string.h>
+
+void frame_codec_init(frame_codec_t *codec, uint8_t encoding, uint16_t band, uint8_t keyframe_interval) {
+    memset(codec, 0, sizeof(*codec));
+    codec->encoding = encoding;
+    codec->band = band;
+    codec->keyframe_interval = keyframe_interval ? keyframe_interval : FRAME_CODEC_DEFAULT_KEYFRAME_INTERVAL;
+    codec->need_keyframe = true;
+}
+
+uint16_t frame_codec_pack12(const uint16_t *values, uint16_t count, uint8_t *out) {
+    uint16_t n = 0;
+    for (uint16_t i = 0; i < count; i += 2) {
+        uint16_t a = values[i] & 0x0FFF;
+        uint16_t b = (i + 1 < count) ? (values[i + 1] & 0x0FFF) : 0;
+        out[n++] = a & 0xFF;
+        out[n++] = (uint8_t)((a >> 8) | ((b & 0x0F) << 4));
+        if (i + 1 < count) {
+            out[n++] = (uint8_t)(b >> 4);
+        }
+    }
+    return n;
+}
+
+void frame_codec_unpack12(const uint8_t *in, uint16_t count, uint16_t *values) {
+    for (uint16_t i = 0; i < count; i += 2) {
+        const uint8_t *p = in + (i / 2) * 3;
+        values[i] = p[0] | ((p[1] & 0x0F) << 8);
+        if (i + 1 < count) {
+            values[i + 1] = (p[1] >> 4) | (p[2] << 4);
+        }
+    }
+}
+
+static uint16_t encode_keyframe(frame_codec_t *codec, const frame_t *frame, uint8_t *out, uint8_t *encoding) {
+    for (int ch = 0; ch < TOTAL_CHANNELS; ch++) {
+        codec->reference[ch] = frame->raw[ch] & 0x0FFF;
+    }
+    codec->need_keyframe = false;
+    codec->since_keyframe = 0;
+    *encoding = HID_STREAM_ENC_RAW12;
+    return frame_codec_pack12(codec->reference, TOTAL_CHANNELS, out);
+}
+
+uint16_t frame_codec_encode(frame_codec_t *codec, const frame_t *frame, uint8_t *out, uint8_t *encoding) {
+    if (codec->encoding != HID_STREAM_ENC_DELTA12 || codec->need_keyframe ||
+        ++codec->since_keyframe >= codec->keyframe_interval) {
+        return encode_keyframe(codec, frame, out, encoding);
+    }
+
+    // Collect channels that left the band around the host's value
+    uint16_t changed[TOTAL_CHANNELS];
+    uint16_t count = 0;
+    uint8_t *bitmap = out;
+    memset(bitmap, 0, FRAME_CODEC_BITMAP_BYTES);
+    for (int ch = 0; ch < TOTAL_CHANNELS; ch++) {
+        uint16_t raw = frame->raw[ch] & 0x0FFF;
+        uint16_t ref = codec->reference[ch];
+        uint16_t delta = raw > ref ? raw - ref : ref - raw;
+        if (delta > codec->band) {
+            bitmap[ch >> 3] |= 1u << (ch & 7);
+            changed[count++] = raw;
+        }
+    }
+
+    uint16_t len = FRAME_CODEC_BITMAP_BYTES + (count * 3 + 1) / 2;
+    if (len >= FRAME_CODEC_RAW12_BYTES) {
+        return encode_keyframe(codec, frame, out, encoding);
+    }
+
+    frame_codec_pack12(changed, count, out + FRAME_CODEC_BITMAP_BYTES);
+    count = 0;
+    for (int ch = 0; ch < TOTAL_CHANNELS; ch++) {
+        if (bitmap[ch >> 3] & (1u << (ch & 7))) {
+            codec->reference[ch] = changed[count++];
+        }
+    }
+    *encoding = HID_STREAM_ENC_DELTA12;
+    return len;
+}
+
+bool frame_codec_decode(uint8_t encoding, const uint8_t *in, uint16_t len, uint16_t *values) {
+    if (encoding == HID_STREAM_ENC_RAW12) {
+        if (len < FRAME_CODEC_RAW12_BYTES) {
+            return false;
+        }
+        frame_codec_unpack12(in, TOTAL_CHANNELS, values);
+        return true;
+    }
+
+    if (encoding != HID_STREAM_ENC_DELTA12 || len < FRAME_CODEC_BITMAP_BYTES) {
+        return false;
+    }
+
+    uint16_t count = 0;
+    for (int ch = 0; ch < TOTAL_CHANNELS; ch++) {
+        if (in[ch >> 3] & (1u << (ch & 7))) {
+            count++;
+        }
+    }
+    if (len < FRAME_CODEC_BITMAP_BYTES + (count * 3 + 1) / 2) {
+        return false;
+    }
+
+    uint16_t changed[TOTAL_CHANNELS];
+    frame_codec_unpack12(in + FRAME_CODEC_BITMAP_BYTES, count, changed);
+    count = 0;
+    for (int ch = 0; ch < TOTAL_CHANNELS; ch++) {
+        if (in[ch >> 3] & (1u << (ch & 7))) {
+            values[ch] = changed[count++];
+        }
+    }
+    return true;
+}
@@ -0,0 +1,98 @@
+#ifndef FRAME_CODEC_H
+#define FRAME_CODEC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "frame.h"
+#include "hid_stream.h"
+
+// Compact encodings of a frame for the vendor HID stream.
+//
+// RAW12:   raw counts packed two channels per three bytes,
+//          b0 = a[7:0], b1 = a[11:8] | b[3:0] << 4, b2 = b[11:4].
+//          80 channels = 120 bytes.
+// DELTA12: a bitmap of FRAME_CODEC_BITMAP_BYTES (bit n = channel n
+//          present) followed by the RAW12 packing of only the present
+//          channels, in channel order. A channel is present when it moved
+//          more than the band away from the value the host last received.
+//          An idle matrix costs 10 bytes; up to 30 moving channels still fit
+//          in a single report.
+//
+// In DELTA12 mode the encoder emits a RAW12 keyframe on the first frame,
+// every keyframe_interval frames, whenever a delta would not be smaller
+// than a keyframe, and after frame_codec_force_keyframe(). The host can only
+// apply a delta on top of an unbroken chain back to a keyframe.
+
+#define FRAME_CODEC_BITMAP_BYTES  ((TOTAL_CHANNELS + 7) / 8)
+#define FRAME_CODEC_RAW12_BYTES   ((TOTAL_CHANNELS * 3 + 1) / 2)
+#define FRAME_CODEC_MAX_BYTES     (FRAME_CODEC_BITMAP_BYTES + FRAME_CODEC_RAW12_BYTES)
+
+#ifndef FRAME_CODEC_DEFAULT_BAND
+#define FRAME_CODEC_DEFAULT_BAND 8
+#endif
+
+#ifndef FRAME_CODEC_DEFAULT_KEYFRAME_INTERVAL
+#define FRAME_CODEC_DEFAULT_KEYFRAME_INTERVAL 100
+#endif
+
+typedef struct {
+    uint8_t  encoding;                      // HID_STREAM_ENC_RAW12 or _DELTA12
+    uint16_t band;
+    uint8_t  keyframe_interval;
+    uint8_t  since_keyframe;
+    bool     need_keyframe;
+    uint16_t reference[TOTAL_CHANNELS];     // Values the host currently holds
+} frame_codec_t;
+
+/**
+ * @brief Initialize an encoder
+ *
+ * @param codec Encoder state
+ * @param encoding HID_STREAM_ENC_RAW12 or HID_STREAM_ENC_DELTA12
+ * @param band Delta band in raw counts
+ * @param keyframe_interval Frames between keyframes (0 = default)
+ */
+void frame_codec_init(frame_codec_t *codec, uint8_t encoding, uint16_t band, uint8_t keyframe_interval);
+
+/**
+ * @brief Encode a frame
+ *
+ * @param codec Encoder state
+ * @param frame Frame to encode
+ * @param out Output buffer of at least FRAME_CODEC_MAX_BYTES
+ * @param encoding Receives the encoding actually used for this frame
+ * @return Encoded length in bytes
+ */
+uint16_t frame_codec_encode(frame_codec_t *codec, const frame_t *frame, uint8_t *out, uint8_t *encoding);
+
+/**
+ * @brief Make the next encoded frame a keyframe (e.g. after a dropped frame)
+ */
+static inline void frame_codec_force_keyframe(frame_codec_t *codec) {
+    codec->need_keyframe = true;
+}
+
+/**
+ * @brief Pack 12-bit values two per three bytes
+ *
+ * @return Number of bytes written
+ */
+uint16_t frame_codec_pack12(const uint16_t *values, uint16_t count, uint8_t *out);
+
+/**
+ * @brief Unpack values written by frame_codec_pack12()
+ */
+void frame_codec_unpack12(const uint8_t *in, uint16_t count, uint16_t *values);
+
+/**
+ * @brief Decode a RAW12 or DELTA12 payload on top of the previous values
+ *
+ * @param encoding Encoding of the payload
+ * @param in Payload
+ * @param len Payload length
+ * @param values Channel values; updated in place
+ * @return false if the payload is malformed
+ */
+bool frame_codec_decode(uint8_t encoding, const uint8_t *in, uint16_t len, uint16_t *values);
+
+#endif // FRAME_CODEC_H
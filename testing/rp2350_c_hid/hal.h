@@ -0,0 +1,192 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Thin hardware layer under the scan engine (scan.c) and the keyboard
+// report path (keyboard.c): time, GPIO, the ADC round-robin bursts and the
+// USB HID/CDC endpoints. hal_pico.c maps it onto the Pico SDK and TinyUSB.
+// tools/sim/hal_sim.c is a Linux backend that models the HC4067 muxes, the
+// hall sensors and the USB host, so the same scan, key and report code runs
+// on the host (see tools/sim/scan_sim.c).
+//
+// The backend calls into the firmware from interrupt context:
+// scan_on_alarm() when a hal_alarm_set() target is reached and
+// scan_on_burst_done() when a hal_adc_burst_start() burst is complete
+// (scan.h); keyboard_report_complete() when the host has collected a
+// keyboard report (keyboard.h, from the TinyUSB callback on the Pico).
+
+// ---------------------------------------------------------------------------
+// Time and interrupts
+
+/**
+ * @brief Microseconds since boot (wraps every ~71 minutes)
+ */
+uint32_t hal_time_us(void);
+
+/**
+ * @brief Arm the scan alarm; scan_on_alarm() runs when time reaches target_us
+ *
+ * @param target_us Time to fire at
+ * @return false if the target has already passed (nothing armed)
+ */
+bool hal_alarm_set(uint32_t target_us);
+
+/**
+ * @brief Disarm the scan alarm if it has not fired
+ */
+void hal_alarm_cancel(void);
+
+/**
+ * @brief Route the scan alarm and burst interrupts to the calling core
+ *
+ * Idempotent; the first call claims the alarm and DMA interrupt.
+ */
+void hal_scan_attach(void);
+
+/**
+ * @brief Disable interrupts on the calling core
+ *
+ * @return State to pass to hal_irq_restore()
+ */
+uint32_t hal_irq_save(void);
+
+/**
+ * @brief Restore interrupts saved by hal_irq_save()
+ */
+void hal_irq_restore(uint32_t state);
+
+/**
+ * @brief Body of a busy-wait loop (lets the simulator advance time)
+ */
+void hal_spin(void);
+
+// ---------------------------------------------------------------------------
+// GPIO
+
+/**
+ * @brief Make the mux select lines outputs, all low
+ *
+ * @param pins GPIO of S0, S1, ... in bit order
+ * @param count Number of select lines
+ */
+void hal_mux_init(const uint8_t *pins, uint8_t count);
+
+/**
+ * @brief Drive all select lines at once, bit n on pins[n]
+ */
+void hal_mux_select(uint8_t select);
+
+// ---------------------------------------------------------------------------
+// ADC
+
+/**
+ * @brief Initialize the ADC and its analog pins
+ *
+ * @param pins Analog GPIO per mux
+ * @param count Number of pins
+ * @param inputs Receives the ADC input number of each pin
+ */
+void hal_adc_init(const uint8_t *pins, uint8_t count, uint8_t *inputs);
+
+/**
+ * @brief Set the inputs a burst walks through in round-robin order
+ *
+ * @param rr_mask Bit n = ADC input n, 0 for single-input conversions
+ */
+void hal_adc_set_round_robin(uint16_t rr_mask);
+
+/**
+ * @brief Start a burst of back-to-back conversions into buf
+ *
+ * Conversion k samples the k-th enabled input counting upwards from
+ * first_input, wrapping around, one conversion time after the one before;
+ * scan_on_burst_done() runs when len samples are in buf.
+ */
+void hal_adc_burst_start(uint8_t first_input, uint16_t *buf, uint16_t len);
+
+/**
+ * @brief Stop conversions and drop any result not yet collected
+ */
+void hal_adc_stop(void);
+
+/**
+ * @brief Record one input while the select lines switch (settle measurement)
+ *
+ * Holds from_select for presettle_us, then converts the input back to back
+ * and switches to to_select as the first conversion completes; trace[0]
+ * is the conversion after it. Blocking; the scan must be stopped.
+ *
+ * @param input ADC input to trace
+ * @param from_select Select value held first
+ * @param to_select Select value switched to
+ * @param presettle_us Time spent on from_select first
+ * @param trace Receives len samples, one conversion time apart
+ * @param len Number of samples
+ */
+void hal_adc_trace(uint8_t input, uint8_t from_select, uint8_t to_select, uint16_t presettle_us,
+                   uint16_t *trace, uint16_t len);
+
+// ---------------------------------------------------------------------------
+// USB
+
+/**
+ * @brief Check whether the host has configured the device
+ */
+bool hal_usb_mounted(void);
+
+/**
+ * @brief Check whether the bus is suspended
+ */
+bool hal_usb_suspended(void);
+
+/**
+ * @brief Signal remote wakeup to a suspended host
+ */
+void hal_usb_remote_wakeup(void);
+
+/**
+ * @brief Check whether a HID interface can take a report
+ */
+bool hal_hid_ready(uint8_t instance);
+
+/**
+ * @brief Check whether the host selected the boot protocol on a HID interface
+ */
+bool hal_hid_boot_protocol(uint8_t instance);
+
+/**
+ * @brief Queue a report on a HID interface's IN endpoint
+ *
+ * @param instance HID interface
+ * @param report_id Report ID, 0 for none
+ * @param report Report data (copied)
+ * @param len Report length
+ * @return false if the endpoint is busy
+ */
+bool hal_hid_report(uint8_t instance, uint8_t report_id, const void *report, uint16_t len);
+
+/**
+ * @brief Check whether a host has the CDC port open
+ */
+bool hal_cdc_connected(void);
+
+/**
+ * @brief Free space in the CDC TX FIFO
+ */
+uint32_t hal_cdc_write_available(void);
+
+/**
+ * @brief Copy bytes into the CDC TX FIFO
+ *
+ * @return Bytes taken
+ */
+uint32_t hal_cdc_write(const void *data, uint32_t len);
+
+/**
+ * @brief Start sending what is in the CDC TX FIFO
+ */
+void hal_cdc_flush(void);
+
+#endif // HAL_H
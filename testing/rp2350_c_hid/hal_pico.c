@@ -0,0 +1,198 @@
+#include "hal.h"
+#include "scan.h"
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/timer.h"
+#include "hardware/sync.h"
+#include "tusb.h"
+
+// hal.h on the RP2350: the ADC free-runs in round-robin mode into its FIFO
+// and a DMA channel drains each burst into the caller's buffer; the settle
+// wait is a hardware alarm. Both interrupts run on the core that called
+// hal_scan_attach().
+
+static uint8_t select_pins[8];
+static uint8_t num_select_pins = 0;
+static uint32_t select_mask = 0;
+static int dma_chan = -1;
+static int scan_alarm = -1;
+
+uint32_t hal_time_us(void) {
+    return time_us_32();
+}
+
+static void scan_alarm_cb(uint alarm_num) {
+    (void) alarm_num;
+    scan_on_alarm();
+}
+
+bool hal_alarm_set(uint32_t target_us) {
+    int32_t ahead = (int32_t)(target_us - time_us_32());
+    if (ahead <= 0) {
+        return false;
+    }
+    // Same instant on the 64-bit timer, so it survives the 32-bit wrap;
+    // true if the target passed while it was being set
+    absolute_time_t at = delayed_by_us(get_absolute_time(), (uint64_t) ahead);
+    return !hardware_alarm_set_target(scan_alarm, at);
+}
+
+void hal_alarm_cancel(void) {
+    hardware_alarm_cancel(scan_alarm);
+}
+
+static void scan_dma_irq_handler(void) {
+    if (!dma_channel_get_irq0_status(dma_chan)) {
+        return;
+    }
+    dma_channel_acknowledge_irq0(dma_chan);
+    adc_run(false);
+    scan_on_burst_done();
+}
+
+void hal_scan_attach(void) {
+    // IRQs are enabled on the calling core's NVIC
+    if (scan_alarm >= 0) {
+        return;
+    }
+    dma_channel_set_irq0_enabled(dma_chan, true);
+    irq_add_shared_handler(DMA_IRQ_0, scan_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+
+    scan_alarm = hardware_alarm_claim_unused(true);
+    hardware_alarm_set_callback(scan_alarm, scan_alarm_cb);
+}
+
+uint32_t hal_irq_save(void) {
+    return save_and_disable_interrupts();
+}
+
+void hal_irq_restore(uint32_t state) {
+    restore_interrupts(state);
+}
+
+void hal_spin(void) {
+    tight_loop_contents();
+}
+
+void hal_mux_init(const uint8_t *pins, uint8_t count) {
+    num_select_pins = count < sizeof(select_pins) ? count : sizeof(select_pins);
+    select_mask = 0;
+    for (uint8_t i = 0; i < num_select_pins; i++) {
+        select_pins[i] = pins[i];
+        gpio_init(pins[i]);
+        gpio_set_dir(pins[i], GPIO_OUT);
+        gpio_put(pins[i], 0);
+        select_mask |= 1u << pins[i];
+    }
+}
+
+// Drive the select lines in one write so the muxes never see an
+// intermediate address
+void hal_mux_select(uint8_t select) {
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < num_select_pins; i++) {
+        if ((select >> i) & 1) {
+            value |= 1u << select_pins[i];
+        }
+    }
+    gpio_put_masked(select_mask, value);
+}
+
+void hal_adc_init(const uint8_t *pins, uint8_t count, uint8_t *inputs) {
+    adc_init();
+    for (uint8_t i = 0; i < count; i++) {
+        adc_gpio_init(pins[i]);
+        inputs[i] = (uint8_t)(pins[i] - ADC_BASE_PIN);
+    }
+
+    // Every result into the FIFO with DREQ asserted as soon as one sample
+    // is available
+    adc_fifo_setup(true, true, 1, false, false);
+    adc_set_clkdiv(0); // Fastest conversion rate (500 ksps)
+
+    dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config cfg = dma_channel_get_default_config(dma_chan);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, true);
+    channel_config_set_dreq(&cfg, DREQ_ADC);
+    dma_channel_configure(dma_chan, &cfg, NULL, &adc_hw->fifo, 0, false);
+}
+
+void hal_adc_set_round_robin(uint16_t rr_mask) {
+    adc_set_round_robin(rr_mask);
+}
+
+void hal_adc_burst_start(uint8_t first_input, uint16_t *buf, uint16_t len) {
+    // Drop the conversion that was still in flight when the last burst stopped
+    adc_fifo_drain();
+    adc_select_input(first_input);
+    dma_channel_transfer_to_buffer_now(dma_chan, buf, len);
+    adc_run(true);
+}
+
+void hal_adc_stop(void) {
+    adc_run(false);
+    adc_fifo_drain();
+}
+
+void hal_adc_trace(uint8_t input, uint8_t from_select, uint8_t to_select, uint16_t presettle_us,
+                   uint16_t *trace, uint16_t len) {
+    adc_select_input(input);
+    hal_mux_select(from_select);
+    busy_wait_us(presettle_us);
+
+    adc_fifo_drain();
+    adc_run(true);
+    (void) adc_fifo_get_blocking();
+    hal_mux_select(to_select);
+    for (uint16_t i = 0; i < len; i++) {
+        trace[i] = adc_fifo_get_blocking() & 0x0FFF;
+    }
+    adc_run(false);
+    adc_fifo_drain();
+}
+
+bool hal_usb_mounted(void) {
+    return tud_mounted();
+}
+
+bool hal_usb_suspended(void) {
+    return tud_suspended();
+}
+
+void hal_usb_remote_wakeup(void) {
+    tud_remote_wakeup();
+}
+
+bool hal_hid_ready(uint8_t instance) {
+    return tud_hid_n_ready(instance);
+}
+
+bool hal_hid_boot_protocol(uint8_t instance) {
+    return tud_hid_n_get_protocol(instance) == HID_PROTOCOL_BOOT;
+}
+
+bool hal_hid_report(uint8_t instance, uint8_t report_id, const void *report, uint16_t len) {
+    return tud_hid_n_report(instance, report_id, report, len);
+}
+
+bool hal_cdc_connected(void) {
+    return tud_cdc_connected();
+}
+
+uint32_t hal_cdc_write_available(void) {
+    return tud_cdc_write_available();
+}
+
+uint32_t hal_cdc_write(const void *data, uint32_t len) {
+    return tud_cdc_write(data, len);
+}
+
+void hal_cdc_flush(void) {
+    tud_cdc_write_flush();
+}
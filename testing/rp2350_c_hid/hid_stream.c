@@ -0,0 +1,115 @@
+#include "hid_stream.h"
+#include "frame_codec.h"
+#include <string.h>
+
+_Static_assert((HID_STREAM_QUEUE_DEPTH & (HID_STREAM_QUEUE_DEPTH - 1)) == 0,
+               "HID_STREAM_QUEUE_DEPTH must be a power of two");
+
+#define QUEUE_MASK (HID_STREAM_QUEUE_DEPTH - 1)
+
+// Single producer (main loop) / single consumer (TinyUSB task context)
+static uint8_t queue[HID_STREAM_QUEUE_DEPTH][HID_STREAM_REPORT_SIZE];
+static volatile uint16_t head = 0;  // Next slot to fill
+static volatile uint16_t tail = 0;  // Next slot to send
+static uint16_t stream_seq = 0;
+static hid_stream_stats_t stats;
+
+static inline uint16_t queue_used(void) {
+    return (uint16_t)(head - tail);
+}
+
+void hid_stream_init(void) {
+    head = 0;
+    tail = 0;
+    stream_seq = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+bool hid_stream_queue_frame(uint8_t encoding, uint32_t timestamp_us, const uint8_t *payload, uint16_t len) {
+    uint16_t chunks = (len + HID_STREAM_CHUNK_DATA - 1) / HID_STREAM_CHUNK_DATA;
+    if (chunks == 0) {
+        chunks = 1;
+    }
+    uint16_t seq = stream_seq++;
+
+    if (chunks > HID_STREAM_MAX_CHUNKS || HID_STREAM_QUEUE_DEPTH - queue_used() < chunks) {
+        stats.frames_dropped++;
+        return false;
+    }
+
+    uint16_t offset = 0;
+    for (uint16_t chunk = 0; chunk < chunks; chunk++) {
+        uint8_t *report = queue[(head + chunk) & QUEUE_MASK];
+        uint16_t n = len - offset;
+        if (n > HID_STREAM_CHUNK_DATA) {
+            n = HID_STREAM_CHUNK_DATA;
+        }
+
+        report[0] = encoding;
+        report[1] = (uint8_t)((chunks << 4) | chunk);
+        report[2] = seq & 0xFF;
+        report[3] = (seq >> 8) & 0xFF;
+        report[4] = timestamp_us & 0xFF;
+        report[5] = (timestamp_us >> 8) & 0xFF;
+        report[6] = (timestamp_us >> 16) & 0xFF;
+        report[7] = (timestamp_us >> 24) & 0xFF;
+        memcpy(report + HID_STREAM_HEADER_SIZE, payload + offset, n);
+        memset(report + HID_STREAM_HEADER_SIZE + n, 0, HID_STREAM_CHUNK_DATA - n);
+        offset += n;
+    }
+
+    // Publish all chunks at once so the consumer never sees a partial frame
+    head = head + chunks;
+    stats.frames_queued++;
+    return true;
+}
+
+const uint8_t *hid_stream_peek(void) {
+    if (queue_used() == 0) {
+        return NULL;
+    }
+    return queue[tail & QUEUE_MASK];
+}
+
+void hid_stream_pop(void) {
+    if (queue_used() == 0) {
+        return;
+    }
+    tail = tail + 1;
+    stats.reports_sent++;
+}
+
+void hid_stream_get_stats(hid_stream_stats_t *out) {
+    *out = stats;
+}
+
+bool hid_stream_parse_config(const uint8_t *buffer, uint16_t len, hid_stream_config_t *config) {
+    if (len < 1 + HID_STREAM_CONFIG_SIZE || buffer[0] != HID_STREAM_CMD_CONFIGURE) {
+        return false;
+    }
+    if (buffer[1] > HID_STREAM_ENC_DELTA12) {
+        return false;
+    }
+
+    config->encoding = buffer[1];
+    config->band = buffer[2] | (buffer[3] << 8);
+    config->keyframe_interval = buffer[4];
+    if (config->keyframe_interval == 0) {
+        config->keyframe_interval = FRAME_CODEC_DEFAULT_KEYFRAME_INTERVAL;
+    }
+    config->period_ms = buffer[5] | (buffer[6] << 8);
+    if (config->period_ms == 0) {
+        config->period_ms = 1;
+    }
+    return true;
+}
+
+uint16_t hid_stream_write_config(const hid_stream_config_t *config, uint8_t *buffer) {
+    buffer[0] = config->encoding;
+    buffer[1] = config->band & 0xFF;
+    buffer[2] = (config->band >> 8) & 0xFF;
+    buffer[3] = config->keyframe_interval;
+    buffer[4] = config->period_ms & 0xFF;
+    buffer[5] = (config->period_ms >> 8) & 0xFF;
+    return HID_STREAM_CONFIG_SIZE;
+}
@@ -0,0 +1,121 @@
+#ifndef HID_STREAM_H
+#define HID_STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Framed streaming of ADC frames over the vendor HID interface (report ID 2).
+//
+// Every report is 64 bytes on the wire: the report ID plus 63 bytes made up
+// of a header followed by a slice of the frame payload:
+//
+//   [0]    encoding    Payload encoding (HID_STREAM_ENC_*)
+//   [1]    chunk       Low nibble: index of this report within the frame,
+//                      high nibble: number of reports that make up the frame
+//   [2-3]  seq         Stream sequence number (uint16 LE), +1 per frame
+//   [4-7]  timestamp   Frame timestamp in microseconds (uint32 LE)
+//   [8-]   data        Payload bytes, zero padded in the last report
+//
+// The host reassembles chunks with matching seq; a seq gap or a missing
+// chunk means frames were lost. Frames that do not fit in the TX queue are
+// dropped whole (their seq is still consumed so the host sees the gap).
+
+#define HID_STREAM_REPORT_ID     2
+#define HID_STREAM_REPORT_SIZE   63  // Report ID + 63 = one 64-byte packet
+#define HID_STREAM_HEADER_SIZE   8
+#define HID_STREAM_CHUNK_DATA    (HID_STREAM_REPORT_SIZE - HID_STREAM_HEADER_SIZE)
+#define HID_STREAM_MAX_CHUNKS    15
+
+// Reports buffered for transmission (3 reports per 160-byte frame).
+// Must be a power of two.
+#ifndef HID_STREAM_QUEUE_DEPTH
+#define HID_STREAM_QUEUE_DEPTH   16
+#endif
+
+// Payload encodings (see frame_codec.h for the compact formats)
+#define HID_STREAM_ENC_MV16      0   // uint16 LE millivolts per channel
+#define HID_STREAM_ENC_RAW12     1   // 12-bit raw counts, two channels per 3 bytes
+#define HID_STREAM_ENC_DELTA12   2   // Changed-channel bitmap + 12-bit raw counts
+
+// Host -> device configuration, sent as an OUT/SET_REPORT on report ID 2:
+//
+//   [0]    HID_STREAM_CMD_CONFIGURE
+//   [1]    encoding            HID_STREAM_ENC_*
+//   [2-3]  delta band          Counts a channel must move before it is resent (uint16 LE)
+//   [4]    keyframe interval   Frames between full RAW12 keyframes in delta mode
+//                              (0 = FRAME_CODEC_DEFAULT_KEYFRAME_INTERVAL)
+//   [5-6]  period              Milliseconds between streamed frames (uint16 LE)
+//
+// A GET_REPORT on report ID 2 returns bytes [1-6] of the active configuration.
+#define HID_STREAM_CMD_CONFIGURE 0x01
+
+#define HID_STREAM_CONFIG_SIZE   6
+
+typedef struct {
+    uint8_t  encoding;
+    uint16_t band;
+    uint8_t  keyframe_interval;
+    uint16_t period_ms;
+} hid_stream_config_t;
+
+typedef struct {
+    uint32_t frames_queued;
+    uint32_t frames_dropped;
+    uint32_t reports_sent;
+} hid_stream_stats_t;
+
+/**
+ * @brief Reset the TX queue, sequence number and statistics
+ */
+void hid_stream_init(void);
+
+/**
+ * @brief Split a frame payload into reports and queue them
+ *
+ * Never blocks; if the queue cannot hold every chunk the frame is dropped.
+ *
+ * @param encoding Payload encoding (HID_STREAM_ENC_*)
+ * @param timestamp_us Frame timestamp
+ * @param payload Encoded frame
+ * @param len Payload length in bytes
+ * @return true if the whole frame was queued
+ */
+bool hid_stream_queue_frame(uint8_t encoding, uint32_t timestamp_us, const uint8_t *payload, uint16_t len);
+
+/**
+ * @brief Next report to transmit (HID_STREAM_REPORT_SIZE bytes, no report ID)
+ *
+ * @return Pointer into the queue, or NULL if empty
+ */
+const uint8_t *hid_stream_peek(void);
+
+/**
+ * @brief Release the report returned by hid_stream_peek()
+ */
+void hid_stream_pop(void);
+
+/**
+ * @brief Parse a HID_STREAM_CMD_CONFIGURE report
+ *
+ * @param buffer Report data without report ID
+ * @param len Report length
+ * @param config Receives the requested configuration
+ * @return false if the report is not a valid configure command
+ */
+bool hid_stream_parse_config(const uint8_t *buffer, uint16_t len, hid_stream_config_t *config);
+
+/**
+ * @brief Serialize a configuration for GET_REPORT
+ *
+ * @param config Active configuration
+ * @param buffer Receives HID_STREAM_CONFIG_SIZE bytes
+ * @return Number of bytes written
+ */
+uint16_t hid_stream_write_config(const hid_stream_config_t *config, uint8_t *buffer);
+
+/**
+ * @brief Get streaming statistics
+ */
+void hid_stream_get_stats(hid_stream_stats_t *stats);
+
+#endif // HID_STREAM_H
@@ -0,0 +1,79 @@
+#include "keyboard.h"
+#include "nkro.h"
+#include "hal.h"
+
+// NKRO keyboard state sent on the keyboard interface
+static nkro_t keyboard;
+
+// Timestamp of the oldest key change not yet sent, and of the oldest change
+// carried by the report in flight. A sample is taken when the host has
+// collected that report.
+static uint32_t change_stamp_us;
+static uint32_t inflight_stamp_us;
+static bool inflight = false;
+static latency_hist_t report_latency;
+
+void keyboard_init(void) {
+    nkro_init(&keyboard);
+    inflight = false;
+    latency_hist_reset(&report_latency);
+}
+
+void keyboard_set(uint8_t usage, bool pressed, uint32_t change_us) {
+    bool was_pending = nkro_pending(&keyboard);
+    nkro_set(&keyboard, usage, pressed);
+    if (!was_pending && nkro_pending(&keyboard)) {
+        change_stamp_us = change_us;
+    }
+}
+
+void keyboard_task(void) {
+    if (!nkro_pending(&keyboard) || !hal_usb_mounted()) {
+        return;
+    }
+
+    if (hal_usb_suspended()) {
+        // Wake the host for a press; releases can wait for the resume
+        if (keyboard.num_keys || keyboard.modifiers) {
+            hal_usb_remote_wakeup();
+        }
+        return;
+    }
+
+    if (!hal_hid_ready(KEYBOARD_HID_INSTANCE)) {
+        return;
+    }
+
+    uint8_t report[NKRO_REPORT_SIZE];
+    uint8_t len = nkro_build_report(&keyboard, hal_hid_boot_protocol(KEYBOARD_HID_INSTANCE), report);
+    if (hal_hid_report(KEYBOARD_HID_INSTANCE, 0, report, len)) {
+        nkro_mark_sent(&keyboard);
+        inflight_stamp_us = change_stamp_us;
+        inflight = true;
+    }
+}
+
+void keyboard_report_complete(void) {
+    if (inflight) {
+        latency_hist_add(&report_latency, hal_time_us() - inflight_stamp_us);
+        inflight = false;
+    }
+    keyboard_task();
+}
+
+uint16_t keyboard_get_report(uint8_t *buffer, uint16_t len) {
+    bool boot = hal_hid_boot_protocol(KEYBOARD_HID_INSTANCE);
+    if (len < nkro_report_size(boot)) {
+        return 0;
+    }
+    return nkro_build_report(&keyboard, boot, buffer);
+}
+
+void keyboard_protocol_changed(void) {
+    nkro_invalidate(&keyboard);
+}
+
+void keyboard_take_report_latency(latency_hist_t *out) {
+    *out = report_latency;
+    latency_hist_reset(&report_latency);
+}
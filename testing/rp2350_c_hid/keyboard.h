@@ -0,0 +1,65 @@
+#ifndef KEYBOARD_H
+#define KEYBOARD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "latency_hist.h"
+
+// NKRO keyboard on HID interface KEYBOARD_HID_INSTANCE (../common/nkro.h):
+// key state changes are applied as they come and one report goes out per
+// change of the state, in whichever protocol the host selected. Runs on
+// core 0 on top of hal.h.
+//
+// Scan-to-report latency is measured from the oldest key change carried by
+// a report to the moment the host has collected it.
+
+#define KEYBOARD_HID_INSTANCE 0
+
+/**
+ * @brief Start with no keys down and an empty latency histogram
+ */
+void keyboard_init(void);
+
+/**
+ * @brief Press or release a key
+ *
+ * @param usage HID keyboard usage (0 is ignored)
+ * @param pressed true to press
+ * @param change_us Time the change was detected, for the latency histogram
+ */
+void keyboard_set(uint8_t usage, bool pressed, uint32_t change_us);
+
+/**
+ * @brief Send the report if the key state changed since the last one
+ *
+ * Wakes a suspended host for a press; releases wait for the resume.
+ */
+void keyboard_task(void);
+
+/**
+ * @brief The host has collected the last report: record its latency and
+ *        send any change that arrived meanwhile
+ */
+void keyboard_report_complete(void);
+
+/**
+ * @brief Build the current report for a GET_REPORT request
+ *
+ * @param buffer Destination
+ * @param len Buffer size
+ * @return Report length, 0 if the buffer is too small
+ */
+uint16_t keyboard_get_report(uint8_t *buffer, uint16_t len);
+
+/**
+ * @brief The host switched between boot and report protocol: resend the
+ *        state in the new format
+ */
+void keyboard_protocol_changed(void);
+
+/**
+ * @brief Copy and clear the scan-to-report latency histogram
+ */
+void keyboard_take_report_latency(latency_hist_t *out);
+
+#endif // KEYBOARD_H
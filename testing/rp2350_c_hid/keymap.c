@@ -0,0 +1,27 @@
+#include "keymap.h"
+#include "tusb.h"
+
+static const uint8_t keymap[TOTAL_CHANNELS] = {
+    // Row 0 (channels 0-13)
+    HID_KEY_ESCAPE, HID_KEY_1, HID_KEY_2, HID_KEY_3, HID_KEY_4, HID_KEY_5, HID_KEY_6,
+    HID_KEY_7, HID_KEY_8, HID_KEY_9, HID_KEY_0, HID_KEY_MINUS, HID_KEY_EQUAL, HID_KEY_BACKSPACE,
+    // Row 1 (channels 14-28)
+    HID_KEY_TAB, HID_KEY_Q, HID_KEY_W, HID_KEY_E, HID_KEY_R, HID_KEY_T, HID_KEY_Y, HID_KEY_U,
+    HID_KEY_I, HID_KEY_O, HID_KEY_P, HID_KEY_BRACKET_LEFT, HID_KEY_BRACKET_RIGHT,
+    HID_KEY_BACKSLASH, HID_KEY_DELETE,
+    // Row 2 (channels 29-42)
+    HID_KEY_CAPS_LOCK, HID_KEY_A, HID_KEY_S, HID_KEY_D, HID_KEY_F, HID_KEY_G, HID_KEY_H,
+    HID_KEY_J, HID_KEY_K, HID_KEY_L, HID_KEY_SEMICOLON, HID_KEY_APOSTROPHE, HID_KEY_ENTER,
+    HID_KEY_PAGE_UP,
+    // Row 3 (channels 43-56)
+    HID_KEY_SHIFT_LEFT, HID_KEY_Z, HID_KEY_X, HID_KEY_C, HID_KEY_V, HID_KEY_B, HID_KEY_N,
+    HID_KEY_M, HID_KEY_COMMA, HID_KEY_PERIOD, HID_KEY_SLASH, HID_KEY_SHIFT_RIGHT,
+    HID_KEY_ARROW_UP, HID_KEY_PAGE_DOWN,
+    // Row 4 (channels 57-65); Fn has no usage
+    HID_KEY_CONTROL_LEFT, HID_KEY_GUI_LEFT, HID_KEY_ALT_LEFT, HID_KEY_SPACE, HID_KEY_ALT_RIGHT,
+    HID_KEY_NONE, HID_KEY_ARROW_LEFT, HID_KEY_ARROW_DOWN, HID_KEY_ARROW_RIGHT,
+};
+
+uint8_t keymap_usage(uint8_t channel) {
+    return channel < TOTAL_CHANNELS ? keymap[channel] : HID_KEY_NONE;
+}
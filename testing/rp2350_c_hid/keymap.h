@@ -0,0 +1,18 @@
+#ifndef KEYMAP_H
+#define KEYMAP_H
+
+#include <stdint.h>
+#include "config.h"
+
+// Channel -> HID keyboard usage for the 65% layout (seung65_kle_layout.json).
+// Channels are assigned in layout order, row by row, left to right; channels
+// past the last key and the Fn key map to no usage.
+
+/**
+ * @brief HID usage sent for a channel, 0 if the channel sends nothing
+ *
+ * @param channel Channel index (mux * CHANNELS_PER_MUX + channel)
+ */
+uint8_t keymap_usage(uint8_t channel);
+
+#endif // KEYMAP_H
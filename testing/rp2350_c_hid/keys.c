@@ -0,0 +1,86 @@
+#include "keys.h"
+#include <string.h>
+
+static struct {
+    key_calib_t calib;
+    key_engine_t engine;
+    uint8_t travel[TOTAL_CHANNELS];     // Clamped travel of the last frame
+    uint8_t pressed;                    // Keys down after the last frame
+} key_state;
+
+void keys_init(void) {
+    static const key_engine_config_t defaults = {
+        .actuation = KEY_ACTUATION_TRAVEL,
+        .release = KEY_RELEASE_TRAVEL,
+        .rt_down = KEY_RT_TRAVEL,
+        .rt_up = KEY_RT_TRAVEL,
+    };
+
+    memset(&key_state, 0, sizeof(key_state));
+    key_calib_init(&key_state.calib, TOTAL_CHANNELS, KEY_FLOATING_THRESHOLD);
+    key_engine_init(&key_state.engine, TOTAL_CHANNELS, &defaults);
+}
+
+bool keys_import_calibration(const uint8_t *record, size_t len) {
+    return key_calib_import(&key_state.calib, record, len);
+}
+
+size_t keys_export_calibration(uint8_t *record) {
+    if (!key_state.calib.dirty || key_state.calib.capture) {
+        return 0;
+    }
+    return key_calib_export(&key_state.calib, record, KEYS_CALIB_RECORD_SIZE);
+}
+
+void keys_begin_calibration(void) {
+    key_calib_begin_capture(&key_state.calib);
+}
+
+void keys_end_calibration(void) {
+    key_calib_end_capture(&key_state.calib);
+}
+
+bool keys_calibrating(void) {
+    return key_state.calib.capture;
+}
+
+bool keys_set_config(uint8_t channel, const key_engine_config_t *config) {
+    return key_engine_set_config(&key_state.engine, channel, config);
+}
+
+uint8_t keys_process(const frame_t *frame, uint8_t *changed) {
+    uint16_t travel[TOTAL_CHANNELS];
+
+    if (changed) {
+        memset(changed, 0, KEY_BITMAP_BYTES);
+    }
+
+    // Floating/unpopulated channels read 0 travel
+    key_calib_process(&key_state.calib, frame->raw, travel);
+
+    // Keys stay released while they are being pressed for calibration
+    if (key_state.calib.capture) {
+        memset(travel, 0, sizeof(travel));
+    }
+    uint8_t num_changed = (uint8_t) key_engine_process(&key_state.engine, travel, changed);
+
+    uint8_t pressed = 0;
+    for (int ch = 0; ch < TOTAL_CHANNELS; ch++) {
+        key_state.travel[ch] = travel[ch] > 255 ? 255 : (uint8_t) travel[ch];
+        pressed += key_engine_is_pressed(&key_state.engine, (uint16_t) ch);
+    }
+    key_state.pressed = pressed;
+    return num_changed;
+}
+
+bool keys_is_pressed(uint8_t channel) {
+    return key_engine_is_pressed(&key_state.engine, channel);
+}
+
+void keys_get_travel(uint8_t *travel) {
+    memcpy(travel, key_state.travel, sizeof(key_state.travel));
+}
+
+uint8_t keys_pressed_count(void) {
+    return key_state.pressed;
+}
@@ -0,0 +1,125 @@
+#ifndef KEYS_H
+#define KEYS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "frame.h"
+#include "key_engine.h"
+#include "key_calib.h"
+
+// Key travel comes from the per-key calibration (key_calib.h): 0 at rest to
+// 255 at bottom-out, so the same thresholds mean the same depth on every
+// key. Until a key's bottom-out is known its range is KEY_CALIB_DEFAULT_RANGE
+// raw counts. The defaults below apply to every key; see key_engine.h for
+// the state machine.
+
+// Travel at which a key presses (96/255 = 300 counts on an uncalibrated key)
+#ifndef KEY_ACTUATION_TRAVEL
+#define KEY_ACTUATION_TRAVEL 96
+#endif
+
+// Travel below which a key always releases (hysteresis below actuation)
+#ifndef KEY_RELEASE_TRAVEL
+#define KEY_RELEASE_TRAVEL 80
+#endif
+
+// Rapid trigger: release after this much upward travel, press again after
+// this much downward travel, anywhere above the release point. 0 disables.
+#ifndef KEY_RT_TRAVEL
+#define KEY_RT_TRAVEL 16
+#endif
+
+// Record tag and size of the calibration table persisted in flash
+#define KEYS_CALIB_MAGIC 0x4B43414Cu   // "KCAL"
+#define KEYS_CALIB_RECORD_SIZE KEY_CALIB_RECORD_SIZE(TOTAL_CHANNELS)
+
+// Channels reading below this are treated as floating/unpopulated
+#ifndef KEY_FLOATING_THRESHOLD
+#define KEY_FLOATING_THRESHOLD 200
+#endif
+
+#define KEY_BITMAP_BYTES ((TOTAL_CHANNELS + 7) / 8)
+
+// One key state change, stamped with the frame it was detected in
+typedef struct {
+    uint32_t timestamp_us;
+    uint32_t frame_seq;
+    uint8_t channel;
+    bool pressed;
+} key_event_t;
+
+/**
+ * @brief Reset key state; the next frame is captured as the rest baseline
+ */
+void keys_init(void);
+
+/**
+ * @brief Restore a calibration table saved by keys_export_calibration()
+ *
+ * Replaces the first-frame rest capture, so keys can be held at boot.
+ *
+ * @return false if the record does not match this keyboard
+ */
+bool keys_import_calibration(const uint8_t *record, size_t len);
+
+/**
+ * @brief Serialize the calibration table if it changed since the last export
+ *
+ * @param record Buffer of KEYS_CALIB_RECORD_SIZE bytes
+ * @return Bytes written, 0 if nothing changed
+ */
+size_t keys_export_calibration(uint8_t *record);
+
+/**
+ * @brief Start explicit calibration: keys at rest now, then press each fully
+ */
+void keys_begin_calibration(void);
+
+/**
+ * @brief End explicit calibration; the table is exported on the next check
+ */
+void keys_end_calibration(void);
+
+/**
+ * @brief Check whether explicit calibration is in progress
+ */
+bool keys_calibrating(void);
+
+/**
+ * @brief Run key detection on a completed scan frame
+ *
+ * @param frame Frame to process
+ * @param changed Optional bitmap (KEY_BITMAP_BYTES) of keys that changed state
+ * @return Number of keys that changed state
+ */
+uint8_t keys_process(const frame_t *frame, uint8_t *changed);
+
+/**
+ * @brief Change one channel's actuation, release and rapid trigger settings
+ *
+ * @param channel Channel index
+ * @param config Travel thresholds (0-255 travel units)
+ * @return false if the channel or configuration is out of range
+ */
+bool keys_set_config(uint8_t channel, const key_engine_config_t *config);
+
+/**
+ * @brief Check whether a channel is currently pressed
+ *
+ * @param channel Channel index (mux * CHANNELS_PER_MUX + channel)
+ */
+bool keys_is_pressed(uint8_t channel);
+
+/**
+ * @brief Get every channel's travel from the last keys_process()
+ *
+ * @param travel TOTAL_CHANNELS values, 0 = rest to 255 = bottom-out
+ */
+void keys_get_travel(uint8_t *travel);
+
+/**
+ * @brief Number of keys pressed after the last keys_process()
+ */
+uint8_t keys_pressed_count(void);
+
+#endif // KEYS_H
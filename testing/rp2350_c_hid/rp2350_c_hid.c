@@ -3,10 +3,19 @@
 #include <string.h>
 #include "pico/stdlib.h"
 #include "hardware/gpio.h"
-#include "hardware/adc.h"
 #include "bsp/board.h"
 #include "tusb.h"
 #include "config.h"
+#include "scan.h"
+#include "keys.h"
+#include "acquire.h"
+#include "hid_stream.h"
+#include "frame_codec.h"
+#include "keymap.h"
+#include "nkro.h"
+#include "keyboard.h"
+#include "cdc_telemetry.h"
+#include "bulk_stream.h"
 
 // GPIO pin for button input
 #define BUTTON_PIN 30
@@ -14,81 +23,6 @@
 // ADC configuration
 #define ADC_VREF 3.3f
 #define ADC_RESOLUTION 4096
-#define NUM_MUXES 5
-#define CHANNELS_PER_MUX 16
-#define TOTAL_CHANNELS (NUM_MUXES * CHANNELS_PER_MUX)
-
-// Mux control pins
-const uint mux_select_pins[] = {MUX_S0, MUX_S1, MUX_S2, MUX_S3};
-const uint mux_analog_pins[] = {MUX1_PIN, MUX2_PIN, MUX3_PIN, MUX4_PIN, MUX5_PIN};
-// For RP2350B: GP26-29 = ADC0-3, GP40-47 = ADC4-11
-// GP40=ADC4, GP41=ADC5, GP42=ADC6, GP43=ADC7, GP44=ADC8
-const uint mux_adc_inputs[] = {4, 5, 6, 7, 8}; // ADC input numbers for GP40-44
-
-// Initialize mux control pins
-void init_mux_pins() {
-    printf("Initializing mux system...\n");
-    
-    // Initialize select pins as outputs
-    for (int i = 0; i < 4; i++) {
-        gpio_init(mux_select_pins[i]);
-        gpio_set_dir(mux_select_pins[i], GPIO_OUT);
-        gpio_put(mux_select_pins[i], 0);
-        printf("  S%d -> GP%d\n", i, mux_select_pins[i]);
-    }
-    
-    // Initialize ADC
-    printf("Initializing ADC...\n");
-    adc_init();
-    
-    // Initialize ADC inputs for all mux analog pins
-    printf("Initializing ADC GPIO pins:\n");
-    for (int i = 0; i < NUM_MUXES; i++) {
-        adc_gpio_init(mux_analog_pins[i]);
-        printf("  MUX%d -> GP%d (ADC%d)\n", i+1, mux_analog_pins[i], mux_adc_inputs[i]);
-    }
-    printf("Mux initialization complete!\n\n");
-}
-
-// Set mux channel (0-15)
-void set_mux_channel(uint8_t channel) {
-    for (int i = 0; i < 4; i++) {
-        gpio_put(mux_select_pins[i], (channel >> i) & 1);
-    }
-    // Small delay for mux settling. Increase to allow the analog line to charge
-    // through the source impedance of the sensor + mux. 10us is often too
-    // small for higher impedance sensors; use 200us here.
-    sleep_us(200);
-}
-
-// Read ADC value from specific mux and channel
-uint16_t read_mux_adc(uint8_t mux_index, uint8_t channel) {
-    if (mux_index >= NUM_MUXES || channel >= CHANNELS_PER_MUX) {
-        return 0;
-    }
-    
-    // Set the mux channel
-    set_mux_channel(channel);
-    
-    // Select the ADC input for this mux
-    adc_select_input(mux_adc_inputs[mux_index]);
-    
-    // Trick: discard first sample after switching (sample & hold needs to settle),
-    // then take a few samples and average. This helps when sensors are higher
-    // impedance or when the mux+traces need time to settle.
-    // Note: keep sample_count small to avoid slowing overall scan too much.
-    const int sample_count = 3;
-    // Short extra delay to let ADC sample capacitor settle to the new voltage
-    sleep_us(50);
-    // discard 1st read
-    (void)adc_read();
-    uint32_t sum = 0;
-    for (int i = 0; i < sample_count; i++) {
-        sum += adc_read();
-        sleep_us(20);
-    }
-    return (uint16_t)(sum / sample_count);
-}
 
 // Convert ADC reading to voltage
 float adc_to_voltage(uint16_t adc_value) {
@@ -96,70 +30,202 @@ float adc_to_voltage(uint16_t adc_value) {
 }
 
 // Forward declaration
-void send_vendor_hid_payload(const uint8_t *payload, uint16_t len);
+void send_vendor_hid_payload(const frame_t *frame, uint8_t encoding, const uint8_t *payload, uint16_t len);
 
-// Print all ADC values as a single CSV line: timestamp_ms, ch0_mV, ch1_mV, ...
 // Values below ADC_ACTIVE_THRESHOLD (raw) are reported as 0 to ignore floating channels.
 #ifndef ADC_ACTIVE_THRESHOLD
 #define ADC_ACTIVE_THRESHOLD 200
 #endif
 
-void print_all_adc_values() {
-    // Output clean ADC data with markers for easy parsing
-    printf("===ADC_START===\n");
-
-    for (int mux = 0; mux < NUM_MUXES; mux++) {
-        for (int channel = 0; channel < CHANNELS_PER_MUX; channel++) {
-            uint16_t adc_raw = read_mux_adc(mux, channel);
-            uint32_t mv = 0;
-            if (adc_raw >= ADC_ACTIVE_THRESHOLD) {
-                // convert to millivolts (rounded)
-                float v = adc_to_voltage(adc_raw);
-                mv = (uint32_t)(v * 1000.0f + 0.5f);
+// Frame-acquisition stage: the most recent frame published by core 1. Key
+// detection on core 1 and the CDC text / vendor HID consumers here all see
+// the same frame, so telemetry always matches what the keyboard acted on.
+static frame_t current_frame;
+
+// Fetch the newest frame published by core 1, if any. In binary telemetry
+// mode every frame is taken in order and queued as a record on the way.
+// While the bulk stream owns the ring, frames are only looked at in place
+// and the stream releases them once they are sent.
+static bool acquire_frame(void) {
+    if (bulk_stream_active()) {
+        uint32_t pending = acquire_frames_pending();
+        const frame_t *newest = NULL;
+        for (uint32_t i = 0; i < pending; i++) {
+            const frame_t *frame = acquire_peek_frame(i);
+            if ((int32_t)(frame->seq - current_frame.seq) <= 0) {
+                continue;   // Seen on an earlier pass
             }
-            int ch_num = mux * CHANNELS_PER_MUX + channel;
-            printf("CH %d:%lu\n", ch_num, (unsigned long)mv);
+            cdc_telemetry_send_frame(frame);
+            newest = frame;
+        }
+        if (newest) {
+            current_frame = *newest;
         }
+        return newest != NULL;
+    }
+    if (!cdc_telemetry_binary()) {
+        return acquire_latest_frame(&current_frame);
+    }
+    bool any = false;
+    while (acquire_next_frame(&current_frame)) {
+        cdc_telemetry_send_frame(&current_frame);
+        any = true;
+    }
+    return any;
+}
+
+// Convert raw counts to rounded millivolts, 0 for floating channels
+static uint16_t frame_channel_mv(const frame_t *frame, int ch_num) {
+    uint16_t adc_raw = frame->raw[ch_num];
+    if (adc_raw < ADC_ACTIVE_THRESHOLD) {
+        return 0;
+    }
+    float v = adc_to_voltage(adc_raw);
+    return (uint16_t)(v * 1000.0f + 0.5f);
+}
+
+// CDC text formatter: one channel per line between markers for easy parsing
+void print_frame_csv(const frame_t *frame) {
+    printf("===ADC_START===\n");
+    printf("FRAME %lu:%lu\n", (unsigned long)frame->seq, (unsigned long)frame->timestamp_us);
+
+    for (int ch_num = 0; ch_num < TOTAL_CHANNELS; ch_num++) {
+        printf("CH %d:%u\n", ch_num, (unsigned)frame_channel_mv(frame, ch_num));
     }
 
     printf("===ADC_END===\n");
+}
 
-    // Also send binary vendor HID payload (80 uint16 little-endian values = 160 bytes)
-    uint8_t payload[TOTAL_CHANNELS * 2];
+// Vendor HID packer: 80 uint16 little-endian millivolt values = 160 bytes
+void pack_frame_payload(const frame_t *frame, uint8_t *payload) {
     int idx = 0;
+    for (int ch_num = 0; ch_num < TOTAL_CHANNELS; ch_num++) {
+        uint16_t mv = frame_channel_mv(frame, ch_num);
+        payload[idx++] = mv & 0xFF;
+        payload[idx++] = (mv >> 8) & 0xFF;
+    }
+}
+
+// Apply key state changes detected on core 1 to the keyboard, send the
+// report, then log them (logging never delays the report)
+void handle_key_events(void) {
+    key_event_t events[16];
+    int count = 0;
+
+    while (count < (int)(sizeof(events) / sizeof(events[0])) && acquire_pop_event(&events[count])) {
+        const key_event_t *event = &events[count++];
+        keyboard_set(keymap_usage(event->channel), event->pressed, event->timestamp_us);
+    }
+    if (count == 0) {
+        return;
+    }
+
+    keyboard_task();
+
+    for (int i = 0; i < count; i++) {
+        cdc_telemetry_send_key(&events[i]);
+        printf("Key CH %d %s (frame %lu)\n", events[i].channel,
+               events[i].pressed ? "pressed" : "released", (unsigned long)events[i].frame_seq);
+    }
+}
+
+static void print_line(void *ctx, const char *line) {
+    (void)ctx;
+    printf("%s\n", line);
+}
+
+// Print and clear the scan-to-report latency histogram
+void print_report_latency(void) {
+    latency_hist_t h;
+    keyboard_take_report_latency(&h);
+    latency_hist_print(&h, print_line, NULL);
+}
+
+// Print the scan power tier, frames per tier and the wake latency
+void print_power_stats(void) {
+    static const char *const names[POWER_TIER_COUNT] = {"ACTIVE", "IDLE", "SLEEP"};
+    power_mode_stats_t ps;
+    acquire_get_power_stats(&ps);
+
+    printf("===POWER_START===\n");
+    printf("TIER %s, wakes %lu\n", names[acquire_power_tier()], (unsigned long)ps.wakes);
+    for (int t = 0; t < POWER_TIER_COUNT; t++) {
+        printf("%s: entered %lu, frames %lu\n", names[t], (unsigned long)ps.entered[t],
+               (unsigned long)ps.scans[t]);
+    }
+    const latency_hist_t *h = &ps.wake_latency;
+    if (h->count) {
+        printf("WAKE %lu: min %lu us, avg %lu us, max %lu us\n", (unsigned long)h->count,
+               (unsigned long)h->min_us, (unsigned long)(h->sum_us / h->count), (unsigned long)h->max_us);
+    }
+    printf("===POWER_END===\n");
+}
+
+// Print a settle characterization and the scan plan derived from it
+void print_settle_table(const uint16_t (*settle_us)[CHANNELS_PER_MUX]) {
+    printf("===SETTLE_START===\n");
     for (int mux = 0; mux < NUM_MUXES; mux++) {
-        for (int channel = 0; channel < CHANNELS_PER_MUX; channel++) {
-            uint16_t adc_raw = read_mux_adc(mux, channel);
-            uint16_t mv = 0;
-            if (adc_raw >= ADC_ACTIVE_THRESHOLD) {
-                float v = adc_to_voltage(adc_raw);
-                mv = (uint16_t)(v * 1000.0f + 0.5f);
-            }
-            payload[idx++] = mv & 0xFF;
-            payload[idx++] = (mv >> 8) & 0xFF;
+        printf("MUX%d:", mux + 1);
+        for (int ch = 0; ch < CHANNELS_PER_MUX; ch++) {
+            printf(" %u", (unsigned)settle_us[mux][ch]);
         }
+        printf("\n");
     }
+    for (uint8_t step = 0; step < CHANNELS_PER_MUX; step++) {
+        uint8_t sel, first_mux;
+        uint16_t wait_us = scan_step_plan(step, &sel, &first_mux);
+        printf("STEP %u: select %u, wait %u us, first MUX%u\n", (unsigned)step, (unsigned)sel,
+               (unsigned)wait_us, (unsigned)(first_mux + 1));
+    }
+    printf("===SETTLE_END===\n");
+}
 
-    // send vendor HID payload
-    static uint32_t hid_send_count = 0;
-    send_vendor_hid_payload(payload, sizeof(payload));
-    hid_send_count++;
-    if (hid_send_count == 1 || hid_send_count % 50 == 0) {
-        printf("🔵 Called send_vendor_hid_payload %lu times\n", hid_send_count);
-        fflush(stdout);
+// Vendor stream configuration, changed by the host with a SET_REPORT
+static hid_stream_config_t stream_config = {
+    .encoding = HID_STREAM_ENC_MV16,
+    .band = FRAME_CODEC_DEFAULT_BAND,
+    .keyframe_interval = FRAME_CODEC_DEFAULT_KEYFRAME_INTERVAL,
+    .period_ms = 100,
+};
+static frame_codec_t stream_codec;
+
+// Encode the frame with the negotiated encoding and queue it on vendor HID
+void stream_frame(const frame_t *frame) {
+    uint8_t payload[FRAME_CODEC_MAX_BYTES > TOTAL_CHANNELS * 2 ? FRAME_CODEC_MAX_BYTES : TOTAL_CHANNELS * 2];
+    uint8_t encoding = stream_config.encoding;
+    uint16_t len;
+
+    if (encoding == HID_STREAM_ENC_MV16) {
+        pack_frame_payload(frame, payload);
+        len = TOTAL_CHANNELS * 2;
+    } else {
+        len = frame_codec_encode(&stream_codec, frame, payload, &encoding);
     }
+
+    send_vendor_hid_payload(frame, encoding, payload, len);
 }
 
-// HID report descriptor for keyboard
-// HID report descriptor: keyboard
+// Send the current frame on CDC (text or a binary record) and as a vendor
+// HID payload
+void print_all_adc_values(const frame_t *frame) {
+    if (cdc_telemetry_binary()) {
+        cdc_telemetry_send_frame(frame);
+    } else {
+        print_frame_csv(frame);
+    }
+    stream_frame(frame);
+}
+
+// HID report descriptor: NKRO keyboard (boot protocol still supported)
 static const uint8_t desc_hid_report[] = {
-    TUD_HID_REPORT_DESC_KEYBOARD()
+    NKRO_REPORT_DESC()
 };
 
-// Vendor HID report descriptor (generic IN reports of 64 bytes)
+// Vendor HID report descriptor (generic IN/OUT reports of 63 bytes, so that
+// report ID + data fits one 64-byte full-speed packet)
 // Usage Page (Vendor 0xFF00), Usage 0x01, Collection Application,
-//   Report ID 2, Report Size 8, Report Count 64, Input (Data,Var,Abs)
-//   Report ID 2, Report Size 8, Report Count 64, Output (Data,Var,Abs)
+//   Report ID 2, Report Size 8, Report Count 63, Input (Data,Var,Abs)
+//   Report ID 2, Report Size 8, Report Count 63, Output (Data,Var,Abs)
 // End Collection
 static const uint8_t desc_hid_report_vendor[] = {
     0x06, 0x00, 0xFF,      // USAGE_PAGE (Vendor Defined 0xFF00)
@@ -167,12 +233,12 @@ static const uint8_t desc_hid_report_vendor[] = {
     0xA1, 0x01,            // COLLECTION (Application)
     0x85, 0x02,            //   REPORT_ID (2)
     0x75, 0x08,            //   REPORT_SIZE (8)
-    0x95, 0x40,            //   REPORT_COUNT (64)
+    0x95, 0x3F,            //   REPORT_COUNT (63)
     0x09, 0x00,            //   USAGE (Undefined)
     0x15, 0x00,            //   LOGICAL_MINIMUM (0)
     0x26, 0xFF, 0x00,      //   LOGICAL_MAXIMUM (255)
     0x81, 0x02,            //   INPUT (Data,Var,Abs)
-    0x95, 0x40,            //   REPORT_COUNT (64)
+    0x95, 0x3F,            //   REPORT_COUNT (63)
     0x09, 0x00,            //   USAGE (Undefined)
     0x91, 0x02,            //   OUTPUT (Data,Var,Abs)
     0xC0                   // END_COLLECTION
@@ -182,7 +248,11 @@ static const uint8_t desc_hid_report_vendor[] = {
 static const tusb_desc_device_t desc_device = {
     .bLength            = sizeof(tusb_desc_device_t),
     .bDescriptorType    = TUSB_DESC_DEVICE,
+#if BULK_STREAM_ENABLED
+    .bcdUSB             = 0x0210,   // BOS descriptor (MS OS 2.0) present
+#else
     .bcdUSB             = 0x0200,
+#endif
     .bDeviceClass       = 0x00,
     .bDeviceSubClass    = 0x00,
     .bDeviceProtocol    = 0x00,
@@ -202,10 +272,17 @@ enum {
     ITF_NUM_CDC_DATA,
     ITF_NUM_HID_KEYBOARD,
     ITF_NUM_HID_VENDOR,
+#if BULK_STREAM_ENABLED
+    ITF_NUM_BULK_STREAM,
+#endif
     ITF_NUM_TOTAL
 };
 
+#if BULK_STREAM_ENABLED
+#define CONFIG_TOTAL_LEN  (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + TUD_HID_DESC_LEN + TUD_HID_DESC_LEN + BULK_STREAM_DESC_LEN)
+#else
 #define CONFIG_TOTAL_LEN  (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + TUD_HID_DESC_LEN + TUD_HID_DESC_LEN)
+#endif
 
 static const uint8_t desc_configuration[] = {
     // Config number, interface count, string index, total length, attribute, power in mA
@@ -216,19 +293,84 @@ static const uint8_t desc_configuration[] = {
     TUD_CDC_DESCRIPTOR(ITF_NUM_CDC, 4, 0x82, 8, 0x01, 0x81, CFG_TUD_CDC_EP_BUFSIZE),
 
     // HID Keyboard Interface
-    TUD_HID_DESCRIPTOR(ITF_NUM_HID_KEYBOARD, 0, HID_ITF_PROTOCOL_KEYBOARD, sizeof(desc_hid_report), 0x83, CFG_TUD_HID_EP_BUFSIZE, 10),
+    // Polled every 1 ms so a key change reaches the host on the next frame
+    TUD_HID_DESCRIPTOR(ITF_NUM_HID_KEYBOARD, 0, HID_ITF_PROTOCOL_KEYBOARD, sizeof(desc_hid_report), 0x83, CFG_TUD_HID_EP_BUFSIZE, 1),
 
     // HID Vendor Interface (report descriptor defined above)
-    TUD_HID_DESCRIPTOR(ITF_NUM_HID_VENDOR, 0, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report_vendor), 0x84, CFG_TUD_HID_EP_BUFSIZE, 10)
+    TUD_HID_DESCRIPTOR(ITF_NUM_HID_VENDOR, 0, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report_vendor), 0x84, CFG_TUD_HID_EP_BUFSIZE, 1),
+
+#if BULK_STREAM_ENABLED
+    // Raw frame capture (see bulk_stream.h)
+    BULK_STREAM_DESCRIPTOR(ITF_NUM_BULK_STREAM, 5, 0x85, 64),
+#endif
 };
 
+#if BULK_STREAM_ENABLED
+// MS OS 2.0 descriptor set: binds WinUSB to the bulk stream interface so
+// libusb can open it on Windows without a driver install
+#define MS_OS_20_DESC_LEN  0xB2
+
+static const uint8_t desc_ms_os_20[] = {
+    // Set header: length, type, Windows version (8.1+), total length
+    U16_TO_U8S_LE(0x000A), U16_TO_U8S_LE(MS_OS_20_SET_HEADER_DESCRIPTOR), U32_TO_U8S_LE(0x06030000), U16_TO_U8S_LE(MS_OS_20_DESC_LEN),
+
+    // Configuration subset header: length, type, configuration index, reserved, subset length
+    U16_TO_U8S_LE(0x0008), U16_TO_U8S_LE(MS_OS_20_SUBSET_HEADER_CONFIGURATION), 0, 0, U16_TO_U8S_LE(MS_OS_20_DESC_LEN - 0x0A),
+
+    // Function subset header: length, type, first interface, reserved, subset length
+    U16_TO_U8S_LE(0x0008), U16_TO_U8S_LE(MS_OS_20_SUBSET_HEADER_FUNCTION), ITF_NUM_BULK_STREAM, 0, U16_TO_U8S_LE(MS_OS_20_DESC_LEN - 0x0A - 0x08),
+
+    // Compatible ID "WINUSB"
+    U16_TO_U8S_LE(0x0014), U16_TO_U8S_LE(MS_OS_20_FEATURE_COMPATBLE_ID), 'W', 'I', 'N', 'U', 'S', 'B', 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+
+    // Registry property DeviceInterfaceGUIDs (REG_MULTI_SZ)
+    U16_TO_U8S_LE(MS_OS_20_DESC_LEN - 0x0A - 0x08 - 0x08 - 0x14), U16_TO_U8S_LE(MS_OS_20_FEATURE_REG_PROPERTY),
+    U16_TO_U8S_LE(0x0007), U16_TO_U8S_LE(0x002A),
+    'D', 0x00, 'e', 0x00, 'v', 0x00, 'i', 0x00, 'c', 0x00, 'e', 0x00, 'I', 0x00, 'n', 0x00, 't', 0x00, 'e', 0x00,
+    'r', 0x00, 'f', 0x00, 'a', 0x00, 'c', 0x00, 'e', 0x00, 'G', 0x00, 'U', 0x00, 'I', 0x00, 'D', 0x00, 's', 0x00, 0x00, 0x00,
+    U16_TO_U8S_LE(0x0050),
+    '{', 0x00, '3', 0x00, 'C', 0x00, '8', 0x00, 'A', 0x00, '3', 0x00, 'B', 0x00, '0', 0x00, 'E', 0x00, '-', 0x00,
+    '5', 0x00, 'B', 0x00, '7', 0x00, 'D', 0x00, '-', 0x00, '4', 0x00, 'C', 0x00, '5', 0x00, '9', 0x00, '-', 0x00,
+    '9', 0x00, 'A', 0x00, '5', 0x00, '3', 0x00, '-', 0x00, '6', 0x00, 'F', 0x00, '1', 0x00, 'D', 0x00, '2', 0x00,
+    'E', 0x00, '7', 0x00, 'B', 0x00, '4', 0x00, 'A', 0x00, '2', 0x00, '1', 0x00, '}', 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+_Static_assert(sizeof(desc_ms_os_20) == MS_OS_20_DESC_LEN, "MS OS 2.0 descriptor length");
+
+#define BOS_TOTAL_LEN  (TUD_BOS_DESC_LEN + TUD_BOS_MICROSOFT_OS_DESC_LEN)
+
+static const uint8_t desc_bos[] = {
+    TUD_BOS_DESCRIPTOR(BOS_TOTAL_LEN, 1),
+    TUD_BOS_MS_OS_20_DESCRIPTOR(MS_OS_20_DESC_LEN, BULK_STREAM_MS_OS_VENDOR_CODE)
+};
+
+uint8_t const * tud_descriptor_bos_cb(void) {
+    return desc_bos;
+}
+
+// Device-level vendor requests: only the MS OS 2.0 descriptor fetch
+// (interface requests go to the bulk stream driver)
+bool tud_vendor_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const *request) {
+    if (stage != CONTROL_STAGE_SETUP) {
+        return true;
+    }
+    if (request->bmRequestType_bit.type == TUSB_REQ_TYPE_VENDOR &&
+        request->bRequest == BULK_STREAM_MS_OS_VENDOR_CODE && request->wIndex == 7) {
+        return tud_control_xfer(rhport, request, (void *)(uintptr_t) desc_ms_os_20, sizeof(desc_ms_os_20));
+    }
+    return false;
+}
+#endif
+
 // String Descriptors
 static const char* string_desc_arr[] = {
     (const char[]) { 0x09, 0x04 }, // 0: is supported language is English (0x0409)
     "RP2350",                      // 1: Manufacturer
     "RP2350 HID Keyboard",         // 2: Product
     "123456",                      // 3: Serials, should use chip ID
-    "CDC Serial"                   // 4: CDC interface string
+    "CDC Serial",                  // 4: CDC interface string
+    "Frame Stream"                 // 5: Bulk stream interface string
 };
 
 static uint16_t _desc_str[32];
@@ -279,86 +421,114 @@ uint8_t const * tud_hid_descriptor_report_cb(uint8_t instance) {
 }
 
 // HID callbacks
+// Use instance 1 for vendor HID (keyboard is instance 0)
+#define HID_INSTANCE_KEYBOARD KEYBOARD_HID_INSTANCE
+#define HID_INSTANCE_VENDOR 1
+
 uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t* buffer, uint16_t reqlen) {
-    (void) instance;
-    (void) report_id;
     (void) report_type;
-    (void) buffer;
-    (void) reqlen;
-    
+
+    // Current keyboard state in the active protocol
+    if (instance == HID_INSTANCE_KEYBOARD) {
+        return keyboard_get_report(buffer, reqlen);
+    }
+
+    // Vendor stream configuration readback
+    if (instance == HID_INSTANCE_VENDOR && report_id == HID_STREAM_REPORT_ID && reqlen >= HID_STREAM_CONFIG_SIZE) {
+        return hid_stream_write_config(&stream_config, buffer);
+    }
+
     return 0;
 }
 
 void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t const* buffer, uint16_t bufsize) {
-    (void) instance;
-    (void) report_id;
     (void) report_type;
-    (void) buffer;
-    (void) bufsize;
+
+    if (instance != HID_INSTANCE_VENDOR) {
+        return;
+    }
+
+    // OUT reports on the interrupt path arrive with report_id 0 and the ID
+    // still in the buffer
+    if (report_id == 0 && bufsize > 0 && buffer[0] == HID_STREAM_REPORT_ID) {
+        report_id = buffer[0];
+        buffer++;
+        bufsize--;
+    }
+    if (report_id != HID_STREAM_REPORT_ID) {
+        return;
+    }
+
+    hid_stream_config_t config;
+    if (hid_stream_parse_config(buffer, bufsize, &config)) {
+        stream_config = config;
+        frame_codec_init(&stream_codec, config.encoding, config.band, config.keyframe_interval);
+        printf("Vendor stream: encoding %u, band %u, keyframe every %u, period %u ms\n",
+               config.encoding, config.band, config.keyframe_interval, config.period_ms);
+    }
 }
 
-// Send keyboard report - returns true if sent successfully
-bool send_hid_report(uint8_t modifier, uint8_t keycode) {
-    if (tud_suspended() && (modifier || keycode)) {
-        tud_remote_wakeup();
-        return false; // Can't send while suspended
+// The host switched between boot and report protocol: resend the state in
+// the new format
+void tud_hid_set_protocol_cb(uint8_t instance, uint8_t protocol) {
+    if (instance == HID_INSTANCE_KEYBOARD) {
+        printf("Keyboard protocol: %s\n", protocol == HID_PROTOCOL_BOOT ? "boot" : "NKRO");
+        keyboard_protocol_changed();
     }
-    
-    if (tud_hid_ready()) {
-        uint8_t keycode_arr[6] = {0};
-        
-        if (keycode) {
-            keycode_arr[0] = keycode;
+}
+
+// Push queued vendor stream reports to TinyUSB until the endpoint is busy.
+// Called after queueing a frame and again from tud_hid_report_complete_cb,
+// so the queue drains at the USB polling rate without blocking the loop.
+static void vendor_stream_kick(void) {
+    const uint8_t *report;
+    while ((report = hid_stream_peek()) != NULL && tud_hid_n_ready(HID_INSTANCE_VENDOR)) {
+        if (!tud_hid_n_report(HID_INSTANCE_VENDOR, HID_STREAM_REPORT_ID, report, HID_STREAM_REPORT_SIZE)) {
+            break;
         }
-        
-        return tud_hid_keyboard_report(0, modifier, keycode_arr);
+        // TinyUSB copies the report into its endpoint buffer
+        hid_stream_pop();
     }
-    
-    return false; // HID not ready
 }
 
-// Send vendor HID payload (80 channels * 2 bytes = 160 bytes) as multiple 64-byte reports
-// Report ID used in descriptor: 2
-void send_vendor_hid_payload(const uint8_t *payload, uint16_t len) {
-    // Use instance 1 for vendor HID (keyboard is instance 0)
-    const uint8_t hid_instance = 1;
-    
-    static bool first_send = true;
-    static uint32_t send_count = 0;
-    static uint32_t fail_count = 0;
-    
-    // Don't check ready - just send and see what happens
-    if (first_send) {
-        printf("🚀 Attempting vendor HID send (instance=%d, mounted=%d)\n", hid_instance, tud_mounted());
-        fflush(stdout);
-        first_send = false;
+void tud_hid_report_complete_cb(uint8_t instance, uint8_t const* report, uint16_t len) {
+    (void) report;
+    (void) len;
+
+    if (instance == HID_INSTANCE_VENDOR) {
+        vendor_stream_kick();
+    } else if (instance == HID_INSTANCE_KEYBOARD) {
+        // The host has the report: record its latency and send any change
+        // that arrived meanwhile
+        keyboard_report_complete();
     }
+}
 
-    // For now, send just the FIRST chunk to test
-    // Chunk size: payload per HID report
-    const uint8_t chunk_size = 64;
-    uint8_t buf[65];  // report ID + 64 bytes data
-    
-    // First byte is report ID
-    buf[0] = 2;  // Report ID
-    memset(buf + 1, 0, chunk_size);
-    memcpy(buf + 1, payload, chunk_size < len ? chunk_size : len);
+// Send vendor HID payload (80 channels * 2 bytes = 160 bytes) as a framed
+// multi-report stream on report ID 2 (see hid_stream.h)
+void send_vendor_hid_payload(const frame_t *frame, uint8_t encoding, const uint8_t *payload, uint16_t len) {
+    if (!tud_mounted()) {
+        return;
+    }
 
-    // Send report using tud_hid_n_report for specific HID instance
-    bool success = tud_hid_n_report(hid_instance, buf[0], buf + 1, chunk_size);
-    
-    if (success) {
-        send_count++;
-        if (send_count % 50 == 1) {
-            printf("✅ Sent %lu HID reports successfully!\n", send_count);
-            fflush(stdout);
-        }
-    } else {
-        fail_count++;
-        if (fail_count % 100 == 1) {
-            printf("❌ HID send failed (count=%lu)\n", fail_count);
-            fflush(stdout);
-        }
+    if (!hid_stream_queue_frame(encoding, frame->timestamp_us, payload, len)) {
+        // The host missed a frame, so later deltas would not apply cleanly
+        frame_codec_force_keyframe(&stream_codec);
+    }
+    vendor_stream_kick();
+
+    static uint32_t last_report_frames = 0;
+    hid_stream_stats_t stats;
+    hid_stream_get_stats(&stats);
+    if (stats.frames_queued + stats.frames_dropped - last_report_frames >= 50) {
+        last_report_frames = stats.frames_queued + stats.frames_dropped;
+        printf("🔵 Vendor stream: %lu frames queued, %lu dropped, %lu reports sent\n",
+               stats.frames_queued, stats.frames_dropped, stats.reports_sent);
+        acquire_stats_t acq;
+        acquire_get_stats(&acq);
+        printf("🔵 Acquire: %lu frames, %lu dropped, filter max %lu us, key engine max %lu us\n",
+               acq.frames_published, acq.frames_dropped, acq.filter_us_max, acq.keys_us_max);
+        fflush(stdout);
     }
 }
 
@@ -370,6 +540,7 @@ int main() {
 
     // Initialize stdio to use USB CDC (enabled in CMake) so printf() goes over USB serial
     stdio_init_all();
+    cdc_telemetry_init();
 
     // Small delay to let USB enumerator/host settle
     sleep_ms(100);
@@ -396,8 +567,13 @@ int main() {
     gpio_set_dir(BUTTON_PIN, GPIO_IN);
     gpio_pull_up(BUTTON_PIN); // Enable pull-up resistor
     
-    // Initialize mux and ADC system
-    init_mux_pins();
+    // Initialize mux and ADC system, then hand scanning and key detection
+    // to core 1
+    scan_init();
+    keyboard_init();
+    acquire_launch_core1();
+    hid_stream_init();
+    frame_codec_init(&stream_codec, stream_config.encoding, stream_config.band, stream_config.keyframe_interval);
     
     printf("RP2350B USB HID Keyboard with ADC Mux Scanner\n");
     printf("Device will enumerate as a keyboard\n");
@@ -412,38 +588,103 @@ int main() {
     uint32_t blink_interval_ms = 1000;
     uint32_t start_ms = 0;
     uint32_t adc_scan_ms = 0;
-    const uint32_t adc_scan_interval = 100; // Scan ADCs every 100 ms
+    const uint32_t adc_scan_interval = 100; // Print the latest scan frame every 100 ms
+    uint32_t stream_ms = 0;
+    uint32_t telemetry_stats_ms = 0;
+    const uint32_t telemetry_stats_interval = 1000;
     bool led_state = false;
-    bool button_pressed = false; // Flag to track if we've already sent a key for this press
+    bool button_pressed = false;
     
     while (1) {
         tud_task(); // TinyUSB device task
         
-        // Blink LED to show activity
+        // Blink LED to show activity; dark while the scan sleeps
         uint32_t current_ms = board_millis();
-        if (current_ms - start_ms >= blink_interval_ms) {
+        if (acquire_power_tier() == POWER_TIER_SLEEP) {
+            if (led_state) {
+                board_led_write(false);
+                led_state = false;
+            }
+        } else if (current_ms - start_ms >= blink_interval_ms) {
             start_ms = current_ms;
-            board_led_write(led_state);
             led_state = !led_state;
+            board_led_write(led_state);
         }
         
         // (No heartbeat messages by request) -- only USB CDC/stdout output occurs when needed.
         
-        // Periodic ADC scanning
-        if (current_ms - adc_scan_ms >= adc_scan_interval) {
+        // Pick up the latest frame and key events published by core 1
+        bool new_frame = acquire_frame();
+        handle_key_events();
+        bool have_frame = current_frame.seq != 0;
+
+        // Periodic ADC reporting (scanning itself runs on core 1); binary
+        // telemetry already carries every frame
+        if (have_frame && !cdc_telemetry_binary() && current_ms - adc_scan_ms >= adc_scan_interval) {
             adc_scan_ms = current_ms;
-            print_all_adc_values();
+            print_frame_csv(&current_frame);
+        }
+
+        // Link and acquisition counters once a second in binary mode
+        if (cdc_telemetry_binary() && current_ms - telemetry_stats_ms >= telemetry_stats_interval) {
+            telemetry_stats_ms = current_ms;
+            acquire_stats_t acq;
+            acquire_get_stats(&acq);
+            cdc_telemetry_send_stats(&acq);
+        }
+
+        // Vendor HID stream at the host-negotiated rate
+        if (new_frame && current_ms - stream_ms >= stream_config.period_ms) {
+            stream_ms = current_ms;
+            stream_frame(&current_frame);
+        }
+
+        // Report settle characterization when core 1 finishes one
+        const uint16_t (*settle_us)[CHANNELS_PER_MUX] = acquire_take_settle_table();
+        if (settle_us) {
+            print_settle_table(settle_us);
+        }
+
+        // Persist a new key calibration table published by core 1
+        if (acquire_save_calibration()) {
+            printf("Key calibration saved to flash\n");
         }
 
-        // Check for incoming CDC commands from host (e.g., 's' to request a scan)
+        // Check for incoming CDC commands from host ('s' scan, 'c' characterize,
+        // 'k' calibrate keys, 'l' report latency, 'p' power stats, 'b' binary
+        // telemetry on/off)
         if (tud_cdc_connected() && tud_cdc_available()) {
             uint8_t buf[64];
             uint32_t count = tud_cdc_read(buf, sizeof(buf));
+            if (count) {
+                acquire_power_poke();
+            }
             for (uint32_t i = 0; i < count; i++) {
                 uint8_t b = buf[i];
-                if (b == 's' || b == 'S') {
-                    // immediate ADC scan on request
-                    print_all_adc_values();
+                if ((b == 's' || b == 'S') && have_frame) {
+                    // immediate ADC report on request
+                    print_all_adc_values(&current_frame);
+                } else if (b == 'b' || b == 'B') {
+                    // binary telemetry (tools/telemetry.py) <-> text
+                    bool binary = !cdc_telemetry_binary();
+                    printf("Binary telemetry %s\n", binary ? "on" : "off");
+                    cdc_telemetry_set_binary(binary);
+                } else if (b == 'c' || b == 'C') {
+                    // re-measure mux settle times; the scan pauses briefly
+                    acquire_request_characterization();
+                } else if (b == 'l' || b == 'L') {
+                    // scan-to-report latency since the last 'l'
+                    print_report_latency();
+                } else if (b == 'p' || b == 'P') {
+                    // scan power tier and wake latency
+                    print_power_stats();
+                } else if (b == 'k' || b == 'K') {
+                    // first 'k': release all keys, then press each one fully; second 'k' saves
+                    static bool calibrating = false;
+                    calibrating = !calibrating;
+                    acquire_request_calibration(calibrating);
+                    printf(calibrating ? "Key calibration: press every key to the bottom, then send 'k'\n"
+                                       : "Key calibration finished\n");
                 }
             }
         }
@@ -460,55 +701,35 @@ int main() {
                 }
             }
             
-            // Simple button handling - just check current state
+            // Simple button handling - the button holds 'E' in the keyboard state
             bool current_button = !gpio_get(BUTTON_PIN); // Invert because active low
-            
-            // Only send key if button is pressed AND we haven't sent one for this press
-            if (current_button && !button_pressed && tud_hid_ready()) {
-                printf("Button detected low - sending 'E' key\n");
-                
-                // Send key press
-                uint8_t keycode_arr[6] = {0};
-                keycode_arr[0] = HID_KEY_E;
-                
-                if (tud_hid_keyboard_report(0, 0, keycode_arr)) {
-                    printf("Key press sent\n");
-                    button_pressed = true; // Prevent repeat until button is released
-                    
-                    // Schedule key release for next loop iteration
-                    sleep_ms(50);
-                    // Also send an immediate ADC CSV block so host GUI can update
-                    print_all_adc_values();
-                } else {
-                    printf("Failed to send key press\n");
+            if (current_button != button_pressed) {
+                button_pressed = current_button;
+                acquire_power_poke();
+                keyboard_set(HID_KEY_E, current_button, time_us_32());
+                printf(current_button ? "Button detected low - pressing 'E' key\n"
+                                      : "Button released - releasing 'E' key\n");
+                // Also send an immediate ADC CSV block so host GUI can update
+                if (current_button && have_frame) {
+                    print_all_adc_values(&current_frame);
                 }
             }
-            
-            // Send key release if we've sent a press and HID is ready
-            static bool need_key_release = false;
-            if (button_pressed && !need_key_release && tud_hid_ready()) {
-                need_key_release = true;
-            }
-            
-            if (need_key_release && tud_hid_ready()) {
-                uint8_t empty_keys[6] = {0};
-                if (tud_hid_keyboard_report(0, 0, empty_keys)) {
-                    printf("Key released\n");
-                    need_key_release = false;
-                }
-            }
-            
-            // Reset flag when button is released
-            if (!current_button && button_pressed) {
-                printf("Button released - ready for next press\n");
-                button_pressed = false;
-                need_key_release = false;
-            }
         } else {
             blink_interval_ms = 1000;
         }
+
+        // One report per change of the key state, in the active protocol
+        keyboard_task();
+
+        // Move queued telemetry into the CDC FIFO, one flush per pass
+        cdc_telemetry_task();
+
+        // Hand the next run of frames to the bulk endpoint if it is idle
+        bulk_stream_task();
         
-        sleep_ms(10); // 10ms polling interval
+        // Sleep until core 1 publishes a frame or key event, or a USB
+        // interrupt arrives; the timeout keeps the LED and timers going
+        best_effort_wfe_or_timeout(make_timeout_time_ms(1));
     }
     
     return 0;
@@ -0,0 +1,262 @@
+#include "scan.h"
+#include "scan_seq.h"
+#include "settle.h"
+#include "hal.h"
+#include <stdio.h>
+#include <string.h>
+
+// Mux control pins
+static const uint8_t mux_select_pins[] = {MUX_S0, MUX_S1, MUX_S2, MUX_S3};
+static const uint8_t mux_analog_pins[] = {MUX1_PIN, MUX2_PIN, MUX3_PIN, MUX4_PIN, MUX5_PIN};
+
+static scan_seq_t seq;
+static uint8_t adc_inputs[NUM_MUXES];
+static bool ready = false;
+
+// Cleared by scan_stop(); burst_pending is set while an alarm or DMA burst
+// is outstanding so scan_stop() can wait for the engine to go idle, and
+// alarm_waiting while only the alarm is, so scan_stop() can cancel it
+static volatile bool running = false;
+static volatile bool burst_pending = false;
+static volatile bool alarm_waiting = false;
+
+// Low-power mode (scan_set_mode()): frames start frame_interval_us apart
+// instead of back to back. frame_due is the start of the next frame and
+// mode_seq the frame count at the last scan_start().
+static uint32_t frame_interval_us = 0;
+static uint32_t frame_due;
+static uint32_t mode_seq = 0;
+
+// DMA target for one select step (all muxes x SCAN_OVERSAMPLE passes)
+static uint16_t burst_buf[NUM_MUXES * SCAN_OVERSAMPLE];
+
+// Double-buffered frames: the IRQ assembles frames[write_idx] while readers
+// copy frames[write_idx ^ 1]. ready_seq is bumped after every swap so readers
+// can detect a swap that raced their copy.
+static frame_t frames[2];
+static volatile uint8_t write_idx = 0;
+static volatile uint32_t ready_seq = 0;
+
+static void start_burst(void) {
+    hal_adc_burst_start(scan_seq_first_input(&seq), burst_buf, scan_seq_burst_len(&seq));
+}
+
+void scan_on_alarm(void) {
+    alarm_waiting = false;
+    if (!running) {
+        burst_pending = false;
+        return;
+    }
+    start_burst();
+}
+
+// Start the next burst at `at`, and not before the select lines have settled
+static void schedule_burst_at(uint32_t at) {
+    uint32_t settled = hal_time_us() + scan_seq_settle_us(&seq);
+    if ((int32_t)(settled - at) > 0) {
+        at = settled;
+    }
+    alarm_waiting = true;
+    if (!hal_alarm_set(at)) {
+        // Target already passed
+        alarm_waiting = false;
+        start_burst();
+    }
+}
+
+static void schedule_burst(void) {
+    schedule_burst_at(hal_time_us());
+}
+
+void scan_on_burst_done(void) {
+    bool frame_done = scan_seq_complete_burst(&seq, burst_buf, &frames[write_idx], hal_time_us());
+    if (frame_done) {
+        uint8_t done = write_idx;
+        frames[done ^ 1].seq = 0;
+        if (seq.slices > 1) {
+            // The next frame only rescans its slice; the rest carries over
+            memcpy(frames[done ^ 1].raw, frames[done].raw, sizeof(frames[done].raw));
+        }
+        write_idx = done ^ 1;
+        ready_seq = frames[done].seq;
+    }
+
+    if (!running) {
+        burst_pending = false;
+        return;
+    }
+
+    // Switch to the next select value and let the analog lines settle; in
+    // low-power mode the next frame also waits for its start time
+    hal_mux_select(scan_seq_select(&seq));
+    if (frame_done && frame_interval_us) {
+        uint32_t now = hal_time_us();
+        frame_due += frame_interval_us;
+        if ((int32_t)(frame_due - now) < 0) {
+            frame_due = now;    // Fell behind: no catch-up frames
+        }
+        schedule_burst_at(frame_due);
+    } else {
+        schedule_burst();
+    }
+}
+
+void scan_init(void) {
+    printf("Initializing mux system...\n");
+
+    // Initialize select pins as outputs
+    hal_mux_init(mux_select_pins, 4);
+    for (int i = 0; i < 4; i++) {
+        printf("  S%d -> GP%d\n", i, mux_select_pins[i]);
+    }
+
+    // Initialize ADC and its inputs for all mux analog pins
+    printf("Initializing ADC...\n");
+    hal_adc_init(mux_analog_pins, NUM_MUXES, adc_inputs);
+    for (int i = 0; i < NUM_MUXES; i++) {
+        printf("  MUX%d -> GP%d (ADC%d)\n", i+1, mux_analog_pins[i], adc_inputs[i]);
+    }
+
+    if (!scan_seq_init(&seq, adc_inputs, NUM_MUXES, SCAN_OVERSAMPLE)) {
+        printf("Invalid mux ADC wiring, scan disabled!\n");
+        return;
+    }
+    scan_seq_set_uniform_settle(&seq, SCAN_SETTLE_US);
+
+    // Free-running round-robin over the mux inputs
+    hal_adc_set_round_robin(seq.rr_mask);
+    ready = true;
+
+    printf("Scan engine: %d samples per step, default settle %d us\n",
+           scan_seq_burst_len(&seq), SCAN_SETTLE_US);
+    printf("Mux initialization complete!\n\n");
+}
+
+void scan_start(void) {
+    if (!ready) {
+        return;
+    }
+
+    // The scan interrupts run on whichever core starts the scan
+    hal_scan_attach();
+
+    hal_adc_set_round_robin(seq.rr_mask);
+    scan_seq_restart(&seq);
+    frames[write_idx].seq = 0;
+    memcpy(frames[write_idx].raw, frames[write_idx ^ 1].raw, sizeof(frames[0].raw));
+    mode_seq = seq.seq;
+    frame_due = hal_time_us();
+
+    running = true;
+    burst_pending = true;
+    hal_mux_select(scan_seq_select(&seq));
+    schedule_burst();
+}
+
+void scan_stop(void) {
+    if (!running) {
+        return;
+    }
+    // A frame gap can hold the alarm for milliseconds: cancel it instead
+    // of waiting, so waking from low-power mode is prompt
+    uint32_t irq = hal_irq_save();
+    running = false;
+    if (alarm_waiting) {
+        hal_alarm_cancel();
+        alarm_waiting = false;
+        burst_pending = false;
+    }
+    hal_irq_restore(irq);
+    while (burst_pending) {
+        hal_spin();
+    }
+    hal_adc_stop();
+}
+
+// Settle time of one mux channel when switched to from the channel before it
+static uint16_t characterize_channel(uint8_t mux, uint8_t sel) {
+    static uint16_t trace[SCAN_CHAR_TRACE_LEN];
+    uint8_t prev = (uint8_t)((sel + CHANNELS_PER_MUX - 1) % CHANNELS_PER_MUX);
+    uint16_t worst = 0;
+
+    for (int pass = 0; pass < SCAN_CHAR_PASSES; pass++) {
+        // Free-running conversions every SCAN_CONVERSION_US; sample 0 is the
+        // first conversion to finish after the switch
+        hal_adc_trace(adc_inputs[mux], prev, sel, SCAN_CHAR_PRESETTLE_US, trace, SCAN_CHAR_TRACE_LEN);
+
+        uint16_t t = settle_time_from_trace(trace, SCAN_CHAR_TRACE_LEN, SCAN_CONVERSION_US,
+                                            SCAN_CHAR_TOLERANCE_LSB);
+        if (t > worst) {
+            worst = t;
+        }
+    }
+
+    return (uint16_t)(worst + SCAN_CHAR_MARGIN_US);
+}
+
+void scan_characterize(uint16_t settle_us[NUM_MUXES][CHANNELS_PER_MUX]) {
+    if (!ready || running) {
+        return;
+    }
+
+    // Single input, no round-robin, while tracing
+    hal_adc_set_round_robin(0);
+    for (uint8_t mux = 0; mux < NUM_MUXES; mux++) {
+        for (uint8_t sel = 0; sel < CHANNELS_PER_MUX; sel++) {
+            settle_us[mux][sel] = characterize_channel(mux, sel);
+        }
+    }
+    hal_adc_set_round_robin(seq.rr_mask);
+}
+
+void scan_apply_settle(const uint16_t settle_us[NUM_MUXES][CHANNELS_PER_MUX]) {
+    if (running) {
+        return;
+    }
+    scan_seq_set_settle(&seq, settle_us, SCAN_CONVERSION_US);
+}
+
+bool scan_set_mode(uint32_t interval_us, uint8_t slices, uint8_t oversample, uint16_t settle_cap_us) {
+    if (running || !scan_seq_set_mode(&seq, slices, oversample, settle_cap_us)) {
+        return false;
+    }
+    frame_interval_us = interval_us;
+    return true;
+}
+
+int scan_frame_slice(uint32_t frame_seq) {
+    if ((int32_t)(frame_seq - mode_seq) <= 0) {
+        return -1;
+    }
+    return (int)((frame_seq - mode_seq - 1) % seq.slices);
+}
+
+uint16_t scan_step_plan(uint8_t step, uint8_t *select, uint8_t *first_mux) {
+    const scan_step_t *s = &seq.sched.steps[step % SCAN_SCHEDULE_SELECTS];
+    *select = s->select;
+    *first_mux = s->slot_mux[0];
+    return s->wait_us;
+}
+
+bool scan_get_frame(frame_t *out, uint32_t last_seq) {
+    uint32_t seq_before;
+    do {
+        seq_before = ready_seq;
+        if (seq_before == 0 || seq_before == last_seq) {
+            return false;
+        }
+        memcpy(out, (const void *) &frames[write_idx ^ 1], sizeof(*out));
+    } while (ready_seq != seq_before || out->seq != seq_before);
+    return true;
+}
+
+uint16_t scan_read_channel(uint8_t mux, uint8_t channel) {
+    if (mux >= NUM_MUXES || channel >= CHANNELS_PER_MUX) {
+        return 0;
+    }
+    return frames[write_idx ^ 1].raw[mux * CHANNELS_PER_MUX + channel];
+}
+
+uint32_t scan_frame_count(void) {
+    return ready_seq;
+}
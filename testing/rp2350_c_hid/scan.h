@@ -0,0 +1,123 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "frame.h"
+
+/**
+ * @brief Initialize mux select pins and the ADC
+ *
+ * Configures the ADC for round-robin sampling of all mux inputs; each
+ * select step is one burst of conversions into a buffer (hal.h).
+ */
+void scan_init(void);
+
+/**
+ * @brief Start the free-running scan
+ *
+ * Frames are produced continuously from DMA/alarm interrupts; the CPU only
+ * touches the data once per select step to fold it into the frame. The
+ * interrupts are enabled on the calling core.
+ */
+void scan_start(void);
+
+/**
+ * @brief Stop the scan after the burst in flight
+ *
+ * Must be called on the core that called scan_start(). A partially
+ * assembled frame is discarded; scan_start() resumes at select 0.
+ */
+void scan_stop(void);
+
+/**
+ * @brief Measure the settle time of every mux channel
+ *
+ * Takes over the ADC for roughly NUM_MUXES * CHANNELS_PER_MUX *
+ * SCAN_CHAR_PASSES * 1.3 ms, so the scan must be stopped (or not yet
+ * started). Does not change the scan plan; see scan_apply_settle().
+ *
+ * @param settle_us Receives settle time in microseconds per mux and channel
+ */
+void scan_characterize(uint16_t settle_us[NUM_MUXES][CHANNELS_PER_MUX]);
+
+/**
+ * @brief Use a settle table for per-step waits and burst order
+ *
+ * Call while the scan is stopped.
+ *
+ * @param settle_us Settle time per mux and channel, e.g. from scan_characterize()
+ */
+void scan_apply_settle(const uint16_t settle_us[NUM_MUXES][CHANNELS_PER_MUX]);
+
+/**
+ * @brief Scan at a lower rate and cost, or (with the defaults) at full rate
+ *
+ * Call while the scan is stopped; takes effect from scan_start(). The
+ * defaults are interval 0, 1 slice, oversample 0 and no settle cap.
+ *
+ * @param interval_us Time from one frame start to the next, 0 = back to back
+ * @param slices Frames to cover every select value once; channels outside a
+ *               frame's slice keep their previous values
+ * @param oversample Round-robin passes per step (at most SCAN_OVERSAMPLE), 0 = SCAN_OVERSAMPLE
+ * @param settle_cap_us Longest settle wait per step, 0 = as planned
+ * @return false if the scan is running or an argument is out of range
+ */
+bool scan_set_mode(uint32_t interval_us, uint8_t slices, uint8_t oversample, uint16_t settle_cap_us);
+
+/**
+ * @brief Slice of the select values a frame covered
+ *
+ * Frame k after scan_start() covers the select values v with
+ * v % slices == k % slices.
+ *
+ * @param frame_seq Frame sequence number
+ * @return Slice (always 0 with full frames), -1 if the frame was completed
+ *         before the last scan_start()
+ */
+int scan_frame_slice(uint32_t frame_seq);
+
+/**
+ * @brief Get the planned select value, settle wait and first mux of a step
+ *
+ * @param step Schedule step (0-15)
+ * @param select Receives the select value driven in that step
+ * @param first_mux Receives the mux converted first in that step's burst
+ * @return Settle wait in microseconds
+ */
+uint16_t scan_step_plan(uint8_t step, uint8_t *select, uint8_t *first_mux);
+
+/**
+ * @brief Copy the most recently completed frame
+ *
+ * @param out Destination frame
+ * @param last_seq Sequence number of the frame the caller already has
+ * @return true if a frame newer than last_seq was copied
+ */
+bool scan_get_frame(frame_t *out, uint32_t last_seq);
+
+/**
+ * @brief Read one channel from the most recently completed frame
+ *
+ * @param mux Mux index (0-4)
+ * @param channel Mux channel (0-15)
+ * @return 12-bit ADC counts, 0 if out of range or no frame yet
+ */
+uint16_t scan_read_channel(uint8_t mux, uint8_t channel);
+
+/**
+ * @brief Number of frames completed since scan_start()
+ */
+uint32_t scan_frame_count(void);
+
+/**
+ * @brief Settle alarm handler, called by the HAL backend
+ */
+void scan_on_alarm(void);
+
+/**
+ * @brief Burst completion handler, called by the HAL backend
+ */
+void scan_on_burst_done(void);
+
+#endif // SCAN_H
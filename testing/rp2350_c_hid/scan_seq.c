@@ -0,0 +1,91 @@
+#include "scan_seq.h"
+#include <string.h>
+
+// Highest ADC input number (RP2350B: 8 GPIO inputs + temperature sensor)
+#define SCAN_SEQ_MAX_INPUT 15
+
+_Static_assert(NUM_MUXES <= SCAN_SCHEDULE_MAX_MUXES, "too many muxes for the scan schedule");
+_Static_assert(CHANNELS_PER_MUX == SCAN_SCHEDULE_SELECTS, "scan schedule assumes 16-channel muxes");
+
+bool scan_seq_init(scan_seq_t *seq, const uint8_t *adc_inputs, uint8_t num_muxes, uint8_t oversample) {
+    if (num_muxes == 0 || num_muxes > NUM_MUXES || oversample == 0) {
+        return false;
+    }
+
+    memset(seq, 0, sizeof(*seq));
+    seq->num_muxes = num_muxes;
+    seq->oversample = oversample;
+    seq->max_oversample = oversample;
+    seq->slices = 1;
+
+    for (uint8_t mux = 0; mux < num_muxes; mux++) {
+        if (adc_inputs[mux] > SCAN_SEQ_MAX_INPUT) {
+            return false;
+        }
+        seq->rr_mask |= (uint16_t)(1u << adc_inputs[mux]);
+    }
+
+    // The ADC starts a round-robin burst at AINSEL and then walks upwards
+    // through the enabled inputs, wrapping at the top: exactly the
+    // schedule's ascending input order.
+    return scan_schedule_init(&seq->sched, adc_inputs, num_muxes, 0);
+}
+
+void scan_seq_set_uniform_settle(scan_seq_t *seq, uint16_t wait_us) {
+    for (uint8_t step = 0; step < SCAN_SCHEDULE_SELECTS; step++) {
+        scan_step_t *s = &seq->sched.steps[step];
+        s->wait_us = wait_us;
+        memcpy(s->slot_mux, seq->sched.input_order, seq->num_muxes);
+    }
+}
+
+void scan_seq_set_settle(scan_seq_t *seq, const uint16_t settle_us[NUM_MUXES][CHANNELS_PER_MUX], uint16_t conv_us) {
+    scan_schedule_plan_rotation(&seq->sched, settle_us, conv_us);
+}
+
+bool scan_seq_set_mode(scan_seq_t *seq, uint8_t slices, uint8_t oversample, uint16_t settle_cap_us) {
+    if (slices == 0 || slices > SCAN_SCHEDULE_SELECTS || oversample > seq->max_oversample) {
+        return false;
+    }
+    seq->slices = slices;
+    seq->oversample = oversample ? oversample : seq->max_oversample;
+    seq->settle_cap_us = settle_cap_us;
+    return true;
+}
+
+// First step at or after `from` whose select value is in the current slice,
+// SCAN_SCHEDULE_SELECTS if none is left
+static uint8_t next_step(const scan_seq_t *seq, uint8_t from) {
+    while (from < SCAN_SCHEDULE_SELECTS && seq->sched.steps[from].select % seq->slices != seq->slice) {
+        from++;
+    }
+    return from;
+}
+
+void scan_seq_restart(scan_seq_t *seq) {
+    seq->slice = 0;
+    seq->step = next_step(seq, 0);
+}
+
+bool scan_seq_complete_burst(scan_seq_t *seq, const uint16_t *burst, frame_t *frame, uint32_t now_us) {
+    for (uint8_t slot = 0; slot < seq->num_muxes; slot++) {
+        uint32_t sum = 0;
+        for (uint8_t pass = 0; pass < seq->oversample; pass++) {
+            sum += burst[pass * seq->num_muxes + slot] & 0x0FFF;
+        }
+        uint8_t ch = scan_schedule_slot_channel(&seq->sched, seq->step, slot);
+        frame->raw[ch] = (uint16_t)(sum / seq->oversample);
+    }
+
+    seq->step = next_step(seq, (uint8_t)(seq->step + 1));
+    if (seq->step < SCAN_SCHEDULE_SELECTS) {
+        return false;
+    }
+
+    seq->slice = (uint8_t)((seq->slice + 1) % seq->slices);
+    seq->step = next_step(seq, 0);
+    seq->seq++;
+    frame->seq = seq->seq;
+    frame->timestamp_us = now_us;
+    return true;
+}
@@ -0,0 +1,131 @@
+#ifndef SCAN_SEQ_H
+#define SCAN_SEQ_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "frame.h"
+#include "scan_schedule.h"
+
+// Hardware-independent sequencing for the round-robin scan engine.
+//
+// The five HC4067s share S0-S3, so one select value exposes one channel on
+// every mux at once. The engine walks a scan_schedule_t (../common): for each
+// step it drives the select value once, waits the step's settle time, runs
+// the ADC in round-robin mode over the mux inputs and DMAs the results into
+// a burst buffer; this module knows which slot of that burst belongs to
+// which mux and folds completed bursts into a frame. It has no Pico SDK
+// dependencies so it can be built and exercised on the host.
+//
+// The round-robin hardware always walks inputs upwards, so a step's slot
+// order can only be a rotation of ascending input order, chosen by the
+// input selected before the burst. The five lines settle in parallel after
+// S0-S3 change, so starting on the fastest-settling mux lets the slower ones
+// keep settling while the earlier slots convert.
+//
+// For low-power scanning a frame can cover only a slice of the select
+// values: with N slices, frame k runs the steps whose select value v has
+// v % N == k % N, and the channels it skips keep the values of the frame
+// before. Fewer oversampling passes and a cap on the settle waits can be
+// set at the same time.
+
+typedef struct {
+    uint8_t  num_muxes;
+    uint8_t  oversample;                // Round-robin passes per select step
+    uint8_t  max_oversample;            // Passes the burst buffer holds
+    scan_schedule_t sched;              // Per-step select, wait and slot order
+    uint16_t rr_mask;                   // ADC round-robin enable mask
+    uint8_t  step;                      // Schedule step of the burst in flight
+    uint8_t  slices;                    // Frames to cover every select value
+    uint8_t  slice;                     // Slice of the frame in flight
+    uint16_t settle_cap_us;             // Longest settle wait, 0 = as planned
+    uint32_t seq;                       // Completed frame count
+} scan_seq_t;
+
+/**
+ * @brief Initialize the sequencer for a set of mux ADC inputs
+ *
+ * @param seq Sequencer state
+ * @param adc_inputs ADC input number wired to each mux
+ * @param num_muxes Number of entries in adc_inputs (at most NUM_MUXES)
+ * @param oversample Round-robin passes averaged per select step (>= 1)
+ * @return false if an input is out of range or used twice
+ */
+bool scan_seq_init(scan_seq_t *seq, const uint8_t *adc_inputs, uint8_t num_muxes, uint8_t oversample);
+
+/**
+ * @brief Use the same settle wait for every step, bursts starting on slot 0
+ */
+void scan_seq_set_uniform_settle(scan_seq_t *seq, uint16_t wait_us);
+
+/**
+ * @brief Plan per-step settle waits and burst order from a settle table
+ *
+ * For every select value picks the round-robin rotation that needs the
+ * shortest wait, given that slot k of the burst converts k * conv_us after
+ * the first one.
+ *
+ * @param seq Sequencer state
+ * @param settle_us Measured settle time per mux and channel
+ * @param conv_us ADC conversion time
+ */
+void scan_seq_set_settle(scan_seq_t *seq, const uint16_t settle_us[NUM_MUXES][CHANNELS_PER_MUX], uint16_t conv_us);
+
+/**
+ * @brief Cover the select values over several frames, with fewer passes and shorter waits
+ *
+ * Takes effect from the next scan_seq_restart().
+ *
+ * @param seq Sequencer state
+ * @param slices Frames to cover every select value once (1 = full frames)
+ * @param oversample Round-robin passes per step, 0 = as initialized
+ * @param settle_cap_us Longest settle wait, 0 = as planned
+ * @return false if slices or oversample is out of range
+ */
+bool scan_seq_set_mode(scan_seq_t *seq, uint8_t slices, uint8_t oversample, uint16_t settle_cap_us);
+
+/**
+ * @brief Restart the sweep at the first step of slice 0 (drops a partially assembled frame)
+ */
+void scan_seq_restart(scan_seq_t *seq);
+
+/**
+ * @brief Number of samples the DMA must collect for one select step
+ */
+static inline uint16_t scan_seq_burst_len(const scan_seq_t *seq) {
+    return (uint16_t)seq->num_muxes * seq->oversample;
+}
+
+/**
+ * @brief Select value (0-15) to drive onto S0-S3 for the next burst
+ */
+static inline uint8_t scan_seq_select(const scan_seq_t *seq) {
+    return seq->sched.steps[seq->step].select;
+}
+
+/**
+ * @brief ADC input to select before the next burst
+ */
+static inline uint8_t scan_seq_first_input(const scan_seq_t *seq) {
+    return scan_schedule_slot_input(&seq->sched, seq->step, 0);
+}
+
+/**
+ * @brief Settle wait after driving the next select value
+ */
+static inline uint16_t scan_seq_settle_us(const scan_seq_t *seq) {
+    uint16_t wait_us = seq->sched.steps[seq->step].wait_us;
+    return seq->settle_cap_us && wait_us > seq->settle_cap_us ? seq->settle_cap_us : wait_us;
+}
+
+/**
+ * @brief Fold a completed burst into the frame and advance to the next step
+ *
+ * @param seq Sequencer state
+ * @param burst scan_seq_burst_len() samples in ADC FIFO order
+ * @param frame Frame being assembled
+ * @param now_us Timestamp recorded in the frame when the sweep completes
+ * @return true if this burst completed the frame
+ */
+bool scan_seq_complete_burst(scan_seq_t *seq, const uint16_t *burst, frame_t *frame, uint32_t now_us);
+
+#endif // SCAN_SEQ_H
@@ -2,7 +2,8 @@
 HID-based ADC Viewer
 
 Reads binary ADC payloads from the vendor HID interface (VID=0xCAFE, PID=0x4001, report ID=2).
-Firmware sends 160 bytes = 80 uint16 little-endian millivolt values split into 64-byte HID reports.
+Firmware sends 160 bytes = 80 uint16 little-endian millivolt values split into framed
+63-byte HID reports; see hid_stream.py for the header layout and reassembly.
 
 Beautiful dark UI with gradient bars that update when you press any key.
 
@@ -13,11 +14,12 @@ Run: python tools/adc_hid_viewer.py
 import hid
 import threading
 import queue
-import struct
 import time
 import tkinter as tk
 from tkinter import ttk, messagebox
 
+from hid_stream import StreamDecoder, configure_report, ENC_DELTA12
+
 VID = 0xCAFE
 PID = 0x4001
 REPORT_ID = 2
@@ -26,6 +28,11 @@ ROWS = 5
 COLS = 16
 MAX_MV = 3300
 
+# Vendor stream settings requested from the firmware on connect
+STREAM_ENCODING = ENC_DELTA12
+STREAM_BAND = 8            # raw counts a channel must move before it is resent
+STREAM_PERIOD_MS = 20
+
 # Color scheme for beautiful UI
 BG_COLOR = '#1a1a1a'
 GRID_BG = '#0a0a0a'
@@ -66,6 +73,7 @@ class HIDReader(threading.Thread):
             self.dev.open_path(vendor_path)
             self.dev.set_nonblocking(False)  # Use blocking mode for Windows
             self.opened = True
+            self.dev.write(configure_report(STREAM_ENCODING, band=STREAM_BAND, period_ms=STREAM_PERIOD_MS))
             self.q.put(("info", f"Opened vendor HID {VID:04x}:{PID:04x}"))
             print(f"Successfully opened vendor HID interface")
         except Exception as e:
@@ -78,13 +86,13 @@ class HIDReader(threading.Thread):
         if not self.opened:
             return
 
-        buf_acc = bytearray()
+        decoder = StreamDecoder()
         read_count = 0
         print("HID reader thread started, waiting for data...")
         while not self.stop_event.is_set():
             try:
                 # Read with timeout (in milliseconds for blocking mode)
-                data = self.dev.read(65, timeout_ms=100)  # report id + 64
+                data = self.dev.read(64, timeout_ms=100)  # report id + 63
                 if not data:
                     continue
             except Exception as e:
@@ -100,10 +108,6 @@ class HIDReader(threading.Thread):
             if isinstance(data, list):
                 data = bytes(data)
             
-            # Debug: show we're receiving data
-            if read_count % 10 == 1:
-                self.q.put(("info", f"📦 Received {len(data)} bytes (total reads: {read_count})"))
-            
             # first byte is report id (if present)
             if len(data) == 0:
                 continue
@@ -114,17 +118,12 @@ class HIDReader(threading.Thread):
                     self.q.put(("info", f"⚠️ Ignoring report ID {report_id}, expecting {REPORT_ID}"))
                 continue
             
-            chunk = data[1:]
-            buf_acc.extend(chunk)
-            
-            # If we've accumulated at least 160 bytes, emit payload and reset
-            if len(buf_acc) >= NUM_CHANNELS * 2:
-                payload = bytes(buf_acc[:NUM_CHANNELS*2])
-                buf_acc = buf_acc[NUM_CHANNELS*2:]
-                # parse payload into 80 uint16 little-endian
-                vals = list(struct.unpack('<' + 'H'*NUM_CHANNELS, payload))
-                self.q.put(("payload", vals))
-                self.q.put(("info", f"✅ Parsed {NUM_CHANNELS} channels"))
+            for frame in decoder.feed(data):
+                self.q.put(("payload", frame.values))
+                stats = decoder.stats
+                if stats.frames_ok % 10 == 1:
+                    self.q.put(("info", f"✅ Frame {frame.seq}: {stats.frames_ok} ok, "
+                                        f"{stats.frames_lost} lost, {stats.frames_incomplete} incomplete"))
         try:
             if self.dev:
                 self.dev.close()
@@ -0,0 +1,206 @@
+"""
+Raw frame capture from the bulk stream interface
+
+Opens the vendor bulk interface (see bulk_stream.h in the firmware) through
+libusb, starts the stream and writes every frame to a file as it arrives.
+Each frame is the device's frame_t unchanged, FRAME_SIZE bytes:
+
+    [0-3]   seq           uint32 LE, +1 per scan sweep
+    [4-7]   timestamp_us  uint32 LE
+    [8-]    raw           80 x uint16 LE 12-bit counts, mux-major
+
+The output file is the plain concatenation of frames. Once a second the
+tool prints the sustained MB/s and frame rate, the frames lost (seq gaps)
+and the device's own counters.
+
+Every device transfer ends in a short packet, so a read returns whole
+frames. A read that times out mid-transfer still loses the bytes it had
+received, though; the tracker then finds the next frame boundary again
+from the data itself (12-bit counts, a seq that follows the last frame or
+is followed by the next one), counts the resync and the seq gap, and
+writes only whole frames.
+
+WinUSB is bound to the interface by the device's MS OS 2.0 descriptor, so
+no driver install is needed on Windows; on Linux a udev rule granting
+access to VID 0xCAFE is enough.
+
+Usage:
+    python bulk_capture.py OUTPUT [SECONDS]
+"""
+
+import struct
+import sys
+import time
+
+import usb.core
+import usb.util
+
+VID = 0xCAFE
+PID = 0x4001
+
+NUM_CHANNELS = 80
+FRAME_SIZE = 8 + 2 * NUM_CHANNELS
+
+REQ_START = 0x01
+REQ_STOP = 0x02
+REQ_STATS = 0x03
+
+# bmRequestType: vendor, interface recipient
+REQTYPE_OUT = 0x41
+REQTYPE_IN = 0xC1
+
+READ_SIZE = 64 * FRAME_SIZE     # Bytes requested per bulk read
+READ_TIMEOUT_MS = 100
+
+# A seq further ahead than this is not taken as following the last frame
+MAX_SEQ_GAP = 1 << 20
+
+
+def find_stream_interface(dev):
+    for itf in dev.get_active_configuration():
+        if itf.bInterfaceClass == 0xFF and itf.bNumEndpoints == 1:
+            ep = itf[0]
+            if usb.util.endpoint_direction(ep.bEndpointAddress) == usb.util.ENDPOINT_IN:
+                return itf.bInterfaceNumber, ep.bEndpointAddress
+    return None, None
+
+
+def device_stats(dev, itf):
+    data = dev.ctrl_transfer(REQTYPE_IN, REQ_STATS, 0, itf, 12)
+    return struct.unpack('<III', bytes(data))     # frames_sent, transfers, frames_dropped
+
+
+def counts_ok(data, off):
+    """True if every count of the frame at off fits in 12 bits."""
+    return max(data[off + 9:off + FRAME_SIZE:2]) < 0x10
+
+
+def seq_follows(prev, seq):
+    return (seq - prev - 1) & 0xFFFFFFFF < MAX_SEQ_GAP
+
+
+class SeqTracker:
+    """Splits the byte stream into frames, counts seq gaps and realigns on
+    frame boundaries after bytes were lost."""
+
+    def __init__(self):
+        self.pending = b''
+        self.last_seq = None
+        self.frames = 0
+        self.lost = 0
+        self.resyncs = 0
+        self.skipped = 0        # Bytes dropped while looking for a frame boundary
+        self._verify = False    # Boundary in doubt: a frame must be confirmed by the next
+        self._skipping = False
+
+    def _frame_at(self, data, off):
+        """True if a frame starts at off, None if the next frame is needed to tell."""
+        if not counts_ok(data, off):
+            return False
+        seq = struct.unpack_from('<I', data, off)[0]
+        if not self._verify and (self.last_seq is None or seq_follows(self.last_seq, seq)):
+            return True
+        # After lost bytes or a seq that does not follow (device restart),
+        # only a frame whose successor has the very next seq is accepted:
+        # a boundary four bytes off reads the timestamps as seq, and those
+        # never step by one
+        nxt = off + FRAME_SIZE
+        if len(data) - nxt < FRAME_SIZE:
+            return None
+        return counts_ok(data, nxt) and struct.unpack_from('<I', data, nxt)[0] == (seq + 1) & 0xFFFFFFFF
+
+    def feed(self, data):
+        """Feed bytes read from the endpoint; returns the whole frames found."""
+        data = self.pending + bytes(data)
+        frames = bytearray()
+        off = 0
+        while len(data) - off >= FRAME_SIZE:
+            found = self._frame_at(data, off)
+            if found is None:
+                break
+            if not found:
+                if not self._skipping:
+                    self._skipping = True
+                    self.resyncs += 1
+                self._verify = True
+                off += 1
+                self.skipped += 1
+                continue
+
+            self._verify = self._skipping = False
+            seq = struct.unpack_from('<I', data, off)[0]
+            if self.last_seq is not None and seq_follows(self.last_seq, seq):
+                self.lost += (seq - self.last_seq - 1) & 0xFFFFFFFF
+            self.last_seq = seq
+            self.frames += 1
+            frames += data[off:off + FRAME_SIZE]
+            off += FRAME_SIZE
+        self.pending = data[off:]
+        return bytes(frames)
+
+    def bytes_lost(self):
+        """A read failed: the next bytes may not start on a frame boundary."""
+        self.skipped += len(self.pending)
+        self.pending = b''
+        self._verify = True
+
+
+def capture(path, seconds=None):
+    dev = usb.core.find(idVendor=VID, idProduct=PID)
+    if dev is None:
+        print("Device not found!")
+        return 1
+    itf, ep_in = find_stream_interface(dev)
+    if itf is None:
+        print("Bulk stream interface not found (firmware built without BULK_STREAM_ENABLED?)")
+        return 1
+    usb.util.claim_interface(dev, itf)
+
+    tracker = SeqTracker()
+    total_bytes = 0
+    dev.ctrl_transfer(REQTYPE_OUT, REQ_START, 0, itf)
+    start = time.monotonic()
+    window_start, window_bytes, window_frames = start, 0, 0
+
+    try:
+        with open(path, 'wb') as out:
+            while seconds is None or time.monotonic() - start < seconds:
+                try:
+                    data = dev.read(ep_in, READ_SIZE, READ_TIMEOUT_MS)
+                except usb.core.USBTimeoutError:
+                    # pyusb drops whatever part of a transfer had arrived
+                    tracker.bytes_lost()
+                    data = b''
+                if data:
+                    total_bytes += len(data)
+                    window_bytes += len(data)
+                    frames_before = tracker.frames
+                    out.write(tracker.feed(data))
+                    window_frames += tracker.frames - frames_before
+
+                now = time.monotonic()
+                if now - window_start >= 1.0:
+                    elapsed = now - window_start
+                    sent, transfers, dropped = device_stats(dev, itf)
+                    print(f"{window_bytes / elapsed / 1e6:6.3f} MB/s  {window_frames / elapsed:7.1f} frames/s  "
+                          f"lost {tracker.lost}, {tracker.resyncs} resyncs "
+                          f"(device ring drops {dropped}, {sent} sent in {transfers} transfers)")
+                    window_start, window_bytes, window_frames = now, 0, 0
+    except KeyboardInterrupt:
+        pass
+    finally:
+        dev.ctrl_transfer(REQTYPE_OUT, REQ_STOP, 0, itf)
+        usb.util.release_interface(dev, itf)
+
+    elapsed = time.monotonic() - start
+    print(f"Captured {tracker.frames} frames ({total_bytes / 1e6:.2f} MB) in {elapsed:.1f} s: "
+          f"{total_bytes / elapsed / 1e6:.3f} MB/s sustained, {tracker.lost} frames lost, "
+          f"{tracker.resyncs} resyncs ({tracker.skipped} bytes skipped)")
+    return 0
+
+
+if __name__ == '__main__':
+    if len(sys.argv) < 2:
+        print(__doc__)
+        sys.exit(1)
+    sys.exit(capture(sys.argv[1], float(sys.argv[2]) if len(sys.argv) > 2 else None))
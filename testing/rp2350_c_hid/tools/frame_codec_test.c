@@ -0,0 +1,230 @@
+// Host round-trip test of the compact vendor stream encodings
+// (frame_codec.c): frames are encoded with the firmware encoder and decoded
+// with frame_codec_decode(), as a C host tool would.
+//   - pack12/unpack12 of every value at odd and even counts,
+//   - RAW12 keyframes decode to the frame exactly,
+//   - DELTA12 chains of synthetic hall-sensor frames (resting channels with
+//     noise inside the band, keys moving through it) keep the decoded values
+//     equal to the encoder's reference and within the band of every frame,
+//     with keyframes on the first frame, every keyframe_interval frames,
+//     when a delta would not be smaller, and after a forced keyframe,
+//   - truncated payloads and unknown encodings are rejected.
+// Exits nonzero on any failure.
+//
+// Build and run from testing/rp2350_c_hid:
+//   cc -O2 -I. -o frame_codec_test tools/frame_codec_test.c frame_codec.c
+//   ./frame_codec_test
+
+#include "frame_codec.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FRAMES 20000
+#define BAND 8
+#define KEYFRAME_INTERVAL 50
+
+static uint32_t failures;
+static uint32_t rng = 1;
+
+static uint32_t rnd(uint32_t n) {
+    rng = rng * 1664525u + 1013904223u;
+    return (rng >> 8) % n;
+}
+
+static void fail(const char *fmt, ...) {
+    if (failures++ < 20) {
+        va_list args;
+        va_start(args, fmt);
+        printf("    FAIL: ");
+        vprintf(fmt, args);
+        printf("\n");
+        va_end(args);
+    }
+}
+
+static void test_pack12(void) {
+    uint32_t before = failures;
+    uint16_t values[TOTAL_CHANNELS + 1], back[TOTAL_CHANNELS + 1];
+    uint8_t packed[FRAME_CODEC_RAW12_BYTES + 2];
+
+    for (uint32_t v = 0; v < 4096; v += TOTAL_CHANNELS + 1) {
+        for (uint16_t count = 1; count <= TOTAL_CHANNELS + 1; count++) {
+            for (uint16_t i = 0; i < count; i++) {
+                values[i] = (uint16_t)((v + i * 37u) & 0x0FFF);
+            }
+            uint16_t n = frame_codec_pack12(values, count, packed);
+            if (n != (count * 3 + 1) / 2) {
+                fail("pack12 of %u values: %u bytes", count, n);
+            }
+            frame_codec_unpack12(packed, count, back);
+            if (memcmp(values, back, count * sizeof(values[0])) != 0) {
+                fail("unpack12 of %u values differs", count);
+            }
+        }
+    }
+    // Bits above 12 are dropped, not spilled into the neighbour
+    values[0] = 0xFFFF;
+    values[1] = 0x0000;
+    frame_codec_pack12(values, 2, packed);
+    frame_codec_unpack12(packed, 2, back);
+    if (back[0] != 0x0FFF || back[1] != 0) {
+        fail("pack12 of 0xFFFF, 0: %03x %03x", back[0], back[1]);
+    }
+    printf("  %-30s %s\n", "pack12 / unpack12", failures == before ? "ok" : "FAILED");
+}
+
+static void test_raw12(void) {
+    uint32_t before = failures;
+    frame_codec_t codec;
+    frame_t frame;
+    uint8_t out[FRAME_CODEC_MAX_BYTES];
+    uint16_t decoded[TOTAL_CHANNELS];
+    uint8_t encoding;
+
+    frame_codec_init(&codec, HID_STREAM_ENC_RAW12, BAND, 0);
+    for (int i = 0; i < 1000; i++) {
+        for (int ch = 0; ch < TOTAL_CHANNELS; ch++) {
+            frame.raw[ch] = (uint16_t) rnd(4096);
+        }
+        uint16_t len = frame_codec_encode(&codec, &frame, out, &encoding);
+        if (encoding != HID_STREAM_ENC_RAW12 || len != FRAME_CODEC_RAW12_BYTES) {
+            fail("RAW12 mode sent encoding %u, %u bytes", encoding, len);
+        }
+        if (!frame_codec_decode(encoding, out, len, decoded) ||
+            memcmp(decoded, frame.raw, sizeof(decoded)) != 0) {
+            fail("RAW12 frame %d does not round-trip", i);
+        }
+    }
+    printf("  %-30s %s\n", "RAW12 keyframes", failures == before ? "ok" : "FAILED");
+}
+
+// Resting channels with noise, a few keys travelling at a time
+static void next_frame(frame_t *frame, int16_t *rest, int16_t *depth, int16_t *speed) {
+    for (int ch = 0; ch < TOTAL_CHANNELS; ch++) {
+        if (speed[ch] == 0 && rnd(400) == 0) {
+            speed[ch] = (int16_t)(20 + rnd(120));
+        }
+        depth[ch] = (int16_t)(depth[ch] + speed[ch]);
+        if (depth[ch] >= 1200) {
+            depth[ch] = 1200;
+            speed[ch] = (int16_t) -speed[ch];
+        } else if (depth[ch] <= 0) {
+            depth[ch] = 0;
+            speed[ch] = 0;
+        }
+        int v = rest[ch] + depth[ch] + (int) rnd(2 * BAND + 1) - BAND;
+        frame->raw[ch] = (uint16_t)(v < 0 ? 0 : v > 4095 ? 4095 : v);
+    }
+}
+
+static void test_delta12(void) {
+    uint32_t before = failures;
+    frame_codec_t codec;
+    frame_t frame;
+    uint8_t out[FRAME_CODEC_MAX_BYTES];
+    uint16_t host[TOTAL_CHANNELS] = {0};
+    int16_t rest[TOTAL_CHANNELS], depth[TOTAL_CHANNELS] = {0}, speed[TOTAL_CHANNELS] = {0};
+    uint32_t keyframes = 0, deltas = 0, bytes = 0, since_keyframe = 0;
+    uint8_t encoding;
+
+    for (int ch = 0; ch < TOTAL_CHANNELS; ch++) {
+        rest[ch] = (int16_t)(1800 + rnd(400));
+    }
+    frame_codec_init(&codec, HID_STREAM_ENC_DELTA12, BAND, KEYFRAME_INTERVAL);
+
+    for (int i = 0; i < FRAMES; i++) {
+        next_frame(&frame, rest, depth, speed);
+        if (i % 1000 == 999) {
+            // Every channel jumps: a delta would not be smaller than a keyframe
+            for (int ch = 0; ch < TOTAL_CHANNELS; ch++) {
+                frame.raw[ch] = (uint16_t)((frame.raw[ch] + 100) & 0x0FFF);
+            }
+        }
+        if (i % 777 == 500) {
+            frame_codec_force_keyframe(&codec);
+        }
+        bool forced = codec.need_keyframe;
+
+        uint16_t len = frame_codec_encode(&codec, &frame, out, &encoding);
+        bytes += len;
+        if (len > FRAME_CODEC_MAX_BYTES) {
+            fail("frame %d: %u bytes", i, len);
+            break;
+        }
+        if (encoding == HID_STREAM_ENC_RAW12) {
+            keyframes++;
+            since_keyframe = 0;
+            if (len != FRAME_CODEC_RAW12_BYTES) {
+                fail("frame %d: keyframe of %u bytes", i, len);
+            }
+        } else {
+            deltas++;
+            since_keyframe++;
+            if (i == 0 || forced || i % 1000 == 999) {
+                fail("frame %d: delta where a keyframe was due", i);
+            }
+            if (len >= FRAME_CODEC_RAW12_BYTES) {
+                fail("frame %d: delta of %u bytes, not smaller than a keyframe", i, len);
+            }
+            if (since_keyframe >= KEYFRAME_INTERVAL) {
+                fail("frame %d: %u deltas since the last keyframe", i, since_keyframe);
+            }
+        }
+
+        if (!frame_codec_decode(encoding, out, len, host)) {
+            fail("frame %d: encoding %u, %u bytes rejected", i, encoding, len);
+            continue;
+        }
+        if (memcmp(host, codec.reference, sizeof(host)) != 0) {
+            fail("frame %d: decoded values differ from the encoder's reference", i);
+        }
+        for (int ch = 0; ch < TOTAL_CHANNELS; ch++) {
+            if (abs((int) host[ch] - (int) frame.raw[ch]) > BAND) {
+                fail("frame %d ch%d: host %u, frame %u, band %d", i, ch, host[ch], frame.raw[ch], BAND);
+            }
+        }
+    }
+    printf("  %-30s %s (%lu keyframes, %lu deltas, %.1f bytes/frame vs %d raw)\n", "DELTA12 chain",
+           failures == before ? "ok" : "FAILED", (unsigned long) keyframes, (unsigned long) deltas,
+           (double) bytes / FRAMES, FRAME_CODEC_RAW12_BYTES);
+}
+
+static void test_malformed(void) {
+    uint32_t before = failures;
+    uint8_t payload[FRAME_CODEC_MAX_BYTES] = {0};
+    uint16_t values[TOTAL_CHANNELS];
+
+    if (frame_codec_decode(HID_STREAM_ENC_RAW12, payload, FRAME_CODEC_RAW12_BYTES - 1, values)) {
+        fail("short RAW12 accepted");
+    }
+    if (frame_codec_decode(HID_STREAM_ENC_DELTA12, payload, FRAME_CODEC_BITMAP_BYTES - 1, values)) {
+        fail("DELTA12 without a full bitmap accepted");
+    }
+    if (!frame_codec_decode(HID_STREAM_ENC_DELTA12, payload, FRAME_CODEC_BITMAP_BYTES, values)) {
+        fail("empty DELTA12 rejected");
+    }
+    // Three channels present need 5 bytes after the bitmap
+    payload[0] = 0x07;
+    if (frame_codec_decode(HID_STREAM_ENC_DELTA12, payload, FRAME_CODEC_BITMAP_BYTES + 4, values) ||
+        !frame_codec_decode(HID_STREAM_ENC_DELTA12, payload, FRAME_CODEC_BITMAP_BYTES + 5, values)) {
+        fail("DELTA12 length check off for three channels");
+    }
+    if (frame_codec_decode(HID_STREAM_ENC_MV16, payload, sizeof(payload), values) ||
+        frame_codec_decode(HID_STREAM_ENC_DELTA12 + 1, payload, sizeof(payload), values)) {
+        fail("MV16 or unknown encoding accepted");
+    }
+    printf("  %-30s %s\n", "malformed payloads", failures == before ? "ok" : "FAILED");
+}
+
+int main(void) {
+    printf("frame_codec round trip:\n");
+    test_pack12();
+    test_raw12();
+    test_delta12();
+    test_malformed();
+
+    printf("\n%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
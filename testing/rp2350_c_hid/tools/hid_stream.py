@@ -0,0 +1,202 @@
+"""
+Vendor HID stream decoder
+
+Reassembles ADC frames sent by the firmware over the vendor HID interface
+(report ID 2). Each 63-byte report carries an 8-byte header:
+
+    [0]    encoding    payload encoding (ENC_MV16, ENC_RAW12 or ENC_DELTA12)
+    [1]    chunk       low nibble = chunk index, high nibble = chunk count
+    [2-3]  seq         stream sequence number (uint16 LE), +1 per frame
+    [4-7]  timestamp   frame timestamp in microseconds (uint32 LE)
+    [8-]   data        payload slice
+
+A seq gap means whole frames were dropped (device queue full or reports lost
+on the host); a seq whose chunks never all arrive is counted as incomplete.
+
+Compact encodings (see frame_codec.h in the firmware):
+    ENC_RAW12    80 x 12-bit raw counts, two channels per 3 bytes (keyframe)
+    ENC_DELTA12  10-byte changed-channel bitmap + 12-bit counts of the set
+                 channels; only valid on top of an unbroken chain of frames
+                 back to the last RAW12 keyframe
+
+The encoding is selected by writing configure_report(...) to the device.
+
+Usage:
+    dec = StreamDecoder()
+    for frame in dec.feed(report_bytes):
+        print(frame.seq, frame.timestamp_us, frame.values)
+"""
+
+import struct
+from dataclasses import dataclass, field
+
+REPORT_ID = 2
+REPORT_SIZE = 63
+HEADER_SIZE = 8
+CHUNK_DATA = REPORT_SIZE - HEADER_SIZE
+NUM_CHANNELS = 80
+
+ENC_MV16 = 0
+ENC_RAW12 = 1
+ENC_DELTA12 = 2
+
+CMD_CONFIGURE = 0x01
+BITMAP_BYTES = (NUM_CHANNELS + 7) // 8
+RAW12_BYTES = (NUM_CHANNELS * 3 + 1) // 2
+
+ADC_VREF_MV = 3300
+ADC_RESOLUTION = 4096
+ADC_ACTIVE_THRESHOLD = 200  # raw counts, matches the firmware's MV16 output
+
+
+@dataclass
+class Frame:
+    seq: int
+    timestamp_us: int
+    encoding: int
+    payload: bytes
+    values: list = field(default_factory=list)  # millivolts, 0 for floating channels
+    raw: list = None                            # 12-bit counts (compact encodings only)
+
+
+@dataclass
+class StreamStats:
+    frames_ok: int = 0
+    frames_lost: int = 0        # seq numbers never seen at all
+    frames_incomplete: int = 0  # seq seen but some chunks missing
+    frames_unsynced: int = 0    # delta frames skipped while waiting for a keyframe
+    bad_reports: int = 0
+
+
+def configure_report(encoding, band=8, keyframe_interval=100, period_ms=100):
+    """Build the OUT report (with report ID) that selects the stream encoding."""
+    return bytes([REPORT_ID, CMD_CONFIGURE, encoding]) + struct.pack(
+        '<HBH', band, keyframe_interval, period_ms) + bytes(REPORT_SIZE - 7)
+
+
+def unpack12(data, count):
+    values = []
+    for i in range(0, count, 2):
+        p = data[(i // 2) * 3:(i // 2) * 3 + 3]
+        values.append(p[0] | ((p[1] & 0x0F) << 8))
+        if i + 1 < count:
+            values.append((p[1] >> 4) | (p[2] << 4))
+    return values
+
+
+def raw_to_mv(raw):
+    if raw < ADC_ACTIVE_THRESHOLD:
+        return 0
+    return (raw * ADC_VREF_MV + ADC_RESOLUTION // 2) // ADC_RESOLUTION
+
+
+class StreamDecoder:
+    def __init__(self):
+        self.stats = StreamStats()
+        self._seq = None          # seq currently being assembled
+        self._chunks = {}
+        self._count = 0
+        self._encoding = 0
+        self._timestamp = 0
+        self._last_seq = None     # last seq that was completed or abandoned
+        self._raw = [0] * NUM_CHANNELS
+        self._synced = False      # _raw matches the device's delta reference
+
+    def _abandon(self):
+        if self._seq is not None:
+            self.stats.frames_incomplete += 1
+            self._last_seq = self._seq
+            self._synced = False
+        self._seq = None
+        self._chunks = {}
+
+    def _account_gap(self, seq):
+        if self._last_seq is not None:
+            gap = (seq - self._last_seq - 1) & 0xFFFF
+            # Anything larger than half the seq space is a reordering/restart
+            if gap < 0x8000:
+                self.stats.frames_lost += gap
+            if gap:
+                self._synced = False
+
+    def _decode(self, frame):
+        """Fill frame.values (and frame.raw); returns False if it can't be shown."""
+        payload = frame.payload
+        if frame.encoding == ENC_MV16:
+            frame.values = list(struct.unpack_from('<' + 'H' * NUM_CHANNELS, payload))
+            return True
+        if frame.encoding == ENC_RAW12:
+            self._raw = unpack12(payload, NUM_CHANNELS)
+            self._synced = True
+        elif frame.encoding == ENC_DELTA12:
+            if not self._synced:
+                self.stats.frames_unsynced += 1
+                return False
+            present = [ch for ch in range(NUM_CHANNELS) if payload[ch >> 3] & (1 << (ch & 7))]
+            for ch, raw in zip(present, unpack12(payload[BITMAP_BYTES:], len(present))):
+                self._raw[ch] = raw
+        else:
+            raise ValueError(f"Unknown stream encoding {frame.encoding}")
+        frame.raw = list(self._raw)
+        frame.values = [raw_to_mv(raw) for raw in frame.raw]
+        return True
+
+    def feed(self, report):
+        """Feed one report (with or without leading report ID).
+
+        Returns a list of completed Frame objects (usually zero or one).
+        """
+        frames = []
+        for frame in self.reassemble(report):
+            try:
+                if not self._decode(frame):
+                    continue
+            except (ValueError, IndexError, struct.error):
+                self.stats.bad_reports += 1
+                self._synced = False
+                continue
+            self.stats.frames_ok += 1
+            frames.append(frame)
+        return frames
+
+    def reassemble(self, report):
+        """Feed one report; returns completed frames with the payload undecoded.
+
+        Keeps the loss counters (frames_lost, frames_incomplete, bad_reports)
+        but leaves frames_ok and the values to feed().
+        """
+        data = bytes(report)
+        if len(data) == REPORT_SIZE + 1:
+            if data[0] != REPORT_ID:
+                return []
+            data = data[1:]
+        if len(data) < HEADER_SIZE:
+            self.stats.bad_reports += 1
+            return []
+
+        encoding = data[0]
+        index = data[1] & 0x0F
+        count = data[1] >> 4
+        seq, timestamp = struct.unpack_from('<HI', data, 2)
+        if count == 0 or index >= count:
+            self.stats.bad_reports += 1
+            return []
+
+        if seq != self._seq:
+            self._abandon()
+            self._account_gap(seq)
+            self._seq = seq
+            self._count = count
+            self._encoding = encoding
+            self._timestamp = timestamp
+
+        self._chunks[index] = data[HEADER_SIZE:]
+        if len(self._chunks) < self._count:
+            return []
+
+        payload = b''.join(self._chunks[i] for i in range(self._count))
+        frame = Frame(seq, self._timestamp, self._encoding, payload)
+        self._last_seq = seq
+        self._seq = None
+        self._chunks = {}
+        return [frame]
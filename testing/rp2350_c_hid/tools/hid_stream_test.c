@@ -0,0 +1,357 @@
+// Host loopback test of the vendor HID stream framing (hid_stream.c)
+// against the host decoder that ships, tools/hid_stream.py.
+//
+// Frames are queued with the firmware's hid_stream_queue_frame() and
+// drained report by report with hid_stream_peek()/hid_stream_pop() as the
+// TinyUSB completion callback does. In between, the test drops, reorders
+// and holds back reports, and writes every report that reaches the "host"
+// to a vector file together with the frames that must come out of it
+// intact and the loss counters the host must report:
+//   - clean loopback of 1 to HID_STREAM_MAX_CHUNKS-chunk frames,
+//   - chunks of a frame arriving in any order,
+//   - whole frames dropped on the wire (lost) and single chunks dropped
+//     (incomplete),
+//   - chunks swapped across a frame boundary (both frames incomplete, none
+//     counted lost, nothing corrupt delivered),
+//   - a full device queue dropping frames whole, visible as seq gaps,
+//   - the 16-bit seq wrapping.
+// tools/hid_stream_test.py replays the file through
+// StreamDecoder.reassemble() and checks each frame byte for byte (including
+// the zero padding) and the counters. This program checks the device side:
+// its queue/drop/report counters and the configure/GET_REPORT round trip.
+//
+// Vector file, one line each:
+//   S <name>                           start of a scenario (fresh decoder)
+//   R <63 bytes hex>                   report as received by the host
+//   F <seq> <encoding> <timestamp> <len>   next frame that must complete;
+//                                      payload byte i is frame_byte(timestamp, i)
+//   E <ok> <lost> <incomplete>         expected counters at the end
+//
+// Build and run from testing/rp2350_c_hid:
+//   cc -O2 -I. -o hid_stream_test tools/hid_stream_test.c hid_stream.c
+//   ./hid_stream_test hid_stream_vectors.txt
+//   python3 tools/hid_stream_test.py hid_stream_vectors.txt
+
+#include "hid_stream.h"
+#include "frame_codec.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_PAYLOAD (HID_STREAM_MAX_CHUNKS * HID_STREAM_CHUNK_DATA)
+
+static uint32_t failures;
+static uint32_t rng = 1;
+static FILE *vectors;
+
+static uint32_t rnd(uint32_t n) {
+    rng = rng * 1664525u + 1013904223u;
+    return (rng >> 8) % n;
+}
+
+static void fail(const char *fmt, ...) {
+    if (failures++ < 20) {
+        va_list args;
+        va_start(args, fmt);
+        printf("    FAIL: ");
+        vprintf(fmt, args);
+        printf("\n");
+        va_end(args);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Frames as queued, indexed by the low byte of their seq
+
+// Payload contents, repeated in hid_stream_test.py: differs per frame and per
+// byte position, so misplaced chunks and mixed-up frames show
+static uint8_t frame_byte(uint32_t timestamp_us, uint32_t i) {
+    return (uint8_t)(timestamp_us + i * 167u + (i >> 8) * 13u);
+}
+
+static struct {
+    uint16_t seq;
+    uint8_t encoding;
+    uint32_t timestamp_us;
+    uint16_t len;
+} sent[256];
+
+static uint16_t device_seq;             // Mirrors the seq hid_stream assigns
+
+static bool queue_frame(uint16_t len) {
+    uint8_t slot = device_seq & 0xFF;
+    uint8_t payload[MAX_PAYLOAD];
+    sent[slot].seq = device_seq;
+    sent[slot].encoding = (uint8_t) rnd(3);
+    sent[slot].timestamp_us = rng;
+    sent[slot].len = len;
+    for (uint16_t i = 0; i < len; i++) {
+        payload[i] = frame_byte(sent[slot].timestamp_us, i);
+    }
+    device_seq++;
+    return hid_stream_queue_frame(sent[slot].encoding, sent[slot].timestamp_us, payload, len);
+}
+
+static uint16_t random_len(void) {
+    return (uint16_t)(1 + rnd(rnd(4) ? 3 * HID_STREAM_CHUNK_DATA : MAX_PAYLOAD));
+}
+
+// ---------------------------------------------------------------------------
+// Wire and vector file
+
+static uint8_t wire[HID_STREAM_QUEUE_DEPTH][HID_STREAM_REPORT_SIZE];
+
+// Take every queued report off the device; returns the count
+static int drain(void) {
+    int n = 0;
+    const uint8_t *report;
+    while ((report = hid_stream_peek()) != NULL) {
+        memcpy(wire[n++], report, HID_STREAM_REPORT_SIZE);
+        hid_stream_pop();
+    }
+    return n;
+}
+
+static void deliver(int from, int to) {
+    for (int i = from; i < to; i++) {
+        fputs("R ", vectors);
+        for (int b = 0; b < HID_STREAM_REPORT_SIZE; b++) {
+            fprintf(vectors, "%02x", wire[i][b]);
+        }
+        fputc('\n', vectors);
+    }
+}
+
+// The frame with this seq must come out of the host intact
+static void expect_frame(uint16_t seq) {
+    uint8_t slot = seq & 0xFF;
+    if (sent[slot].seq != seq) {
+        fail("seq %u no longer in the sent table", seq);
+        return;
+    }
+    fprintf(vectors, "F %u %u %lu %u\n", seq, sent[slot].encoding, (unsigned long) sent[slot].timestamp_us,
+            sent[slot].len);
+}
+
+static void start(const char *name) {
+    hid_stream_init();
+    device_seq = 0;
+    fprintf(vectors, "S %s\n", name);
+    printf("  %-36s", name);
+}
+
+static void expect_counts(uint32_t ok, uint32_t lost, uint32_t incomplete) {
+    fprintf(vectors, "E %lu %lu %lu\n", (unsigned long) ok, (unsigned long) lost, (unsigned long) incomplete);
+}
+
+static void finish(uint32_t before, uint32_t ok, uint32_t lost, uint32_t incomplete) {
+    expect_counts(ok, lost, incomplete);
+    printf(" %s (host must see ok %lu, lost %lu, incomplete %lu)\n", failures == before ? "ok" : "FAILED",
+           (unsigned long) ok, (unsigned long) lost, (unsigned long) incomplete);
+}
+
+// ---------------------------------------------------------------------------
+// Scenarios
+
+static void test_loopback(void) {
+    uint32_t before = failures;
+    start("loopback, 1-15 chunks");
+    uint32_t reports = 0;
+    for (int i = 0; i < 2000; i++) {
+        if (!queue_frame(random_len())) {
+            fail("frame %d not queued into an empty queue", i);
+        }
+        int n = drain();
+        reports += (uint32_t) n;
+        deliver(0, n);
+        expect_frame((uint16_t) i);
+    }
+    hid_stream_stats_t stats;
+    hid_stream_get_stats(&stats);
+    if (stats.frames_queued != 2000 || stats.frames_dropped || stats.reports_sent != reports) {
+        fail("device queued/dropped/sent %lu/%lu/%lu", (unsigned long) stats.frames_queued,
+             (unsigned long) stats.frames_dropped, (unsigned long) stats.reports_sent);
+    }
+    finish(before, 2000, 0, 0);
+}
+
+static void test_reordered_chunks(void) {
+    uint32_t before = failures;
+    start("chunks reordered within a frame");
+    for (int i = 0; i < 1000; i++) {
+        queue_frame(random_len());
+        int n = drain();
+        for (int k = n - 1; k > 0; k--) {
+            int j = (int) rnd((uint32_t) k + 1);
+            uint8_t tmp[HID_STREAM_REPORT_SIZE];
+            memcpy(tmp, wire[k], sizeof(tmp));
+            memcpy(wire[k], wire[j], sizeof(tmp));
+            memcpy(wire[j], tmp, sizeof(tmp));
+        }
+        deliver(0, n);
+        expect_frame((uint16_t) i);
+    }
+    finish(before, 1000, 0, 0);
+}
+
+static void test_dropped_reports(void) {
+    uint32_t before = failures;
+    start("frames and chunks dropped");
+    uint32_t ok = 0, lost = 0, incomplete = 0;
+    for (int i = 0; i < 2000; i++) {
+        queue_frame(random_len());
+        int n = drain();
+        // The first and last frames always arrive so every loss is accounted
+        uint32_t fate = i == 0 || i == 1999 ? 0 : rnd(10);
+        if (fate == 0 || fate > 2) {
+            deliver(0, n);
+            expect_frame((uint16_t) i);
+            ok++;
+        } else if (fate == 1) {
+            lost++;                         // Whole frame gone
+        } else if (n > 1) {
+            int skip = (int) rnd((uint32_t) n);
+            deliver(0, skip);
+            deliver(skip + 1, n);
+            incomplete++;
+        } else {
+            lost++;                         // Single-chunk frame: same as gone
+        }
+    }
+    finish(before, ok, lost, incomplete);
+}
+
+// Last chunk of frame A after the first chunk of frame B: A is abandoned
+// at B's first chunk, B at A's last, that lone A chunk at B's second, and
+// B (missing its first chunk) at the next frame. Four incomplete, none lost.
+static void test_reordered_frames(void) {
+    uint32_t before = failures;
+    start("chunks swapped across frames");
+    uint32_t swaps = 0;
+    for (int i = 0; i < 400; i++) {
+        // Two frames of two to HID_STREAM_QUEUE_DEPTH / 2 chunks each
+        for (int f = 0; f < 2; f++) {
+            queue_frame((uint16_t)(HID_STREAM_CHUNK_DATA + 1 +
+                                   rnd((HID_STREAM_QUEUE_DEPTH / 2 - 1) * HID_STREAM_CHUNK_DATA)));
+        }
+        int n = drain();
+        if (i % 4 == 1) {
+            int first_len = wire[0][1] >> 4;
+            uint8_t tmp[HID_STREAM_REPORT_SIZE];
+            memcpy(tmp, wire[first_len - 1], sizeof(tmp));
+            memcpy(wire[first_len - 1], wire[first_len], sizeof(tmp));
+            memcpy(wire[first_len], tmp, sizeof(tmp));
+            swaps++;
+        } else {
+            expect_frame((uint16_t)(2 * i));
+            expect_frame((uint16_t)(2 * i + 1));
+        }
+        deliver(0, n);
+    }
+    finish(before, 800 - 2 * swaps, 0, 4 * swaps);
+}
+
+static void test_queue_full(void) {
+    uint32_t before = failures;
+    start("device queue full");
+    uint32_t dropped = 0, queued = 0;
+    for (int i = 0; i < 1500; i++) {
+        // Producer outruns the host: the queue is drained only every few frames
+        if (queue_frame(random_len())) {
+            queued++;
+            expect_frame((uint16_t) i);
+        } else {
+            dropped++;
+        }
+        if (rnd(4) == 0) {
+            deliver(0, drain());
+        }
+    }
+    // One more frame that is sure to arrive, so trailing drops show as a gap
+    deliver(0, drain());
+    queue_frame(HID_STREAM_CHUNK_DATA);
+    expect_frame((uint16_t)(device_seq - 1));
+    queued++;
+    deliver(0, drain());
+
+    hid_stream_stats_t stats;
+    hid_stream_get_stats(&stats);
+    if (stats.frames_queued != queued || stats.frames_dropped != dropped || dropped == 0) {
+        fail("device queued/dropped %lu/%lu, expected %lu/%lu (nonzero drops)", (unsigned long) stats.frames_queued,
+             (unsigned long) stats.frames_dropped, (unsigned long) queued, (unsigned long) dropped);
+    }
+    finish(before, queued, dropped, 0);
+}
+
+// The host joins shortly before the wrap; seq 0xFFFE, 0xFFFF and 0 (the
+// second time round) are lost on the wire
+static void test_seq_wrap(void) {
+    uint32_t before = failures;
+    start("seq wrap, gap across the wrap");
+    uint32_t ok = 0;
+    for (uint32_t i = 0; i < 0x10000 + 16; i++) {
+        queue_frame((uint16_t)(1 + rnd(HID_STREAM_CHUNK_DATA * 2)));
+        int n = drain();
+        if (i < 0xFFF0 || (i >= 0xFFFE && i <= 0x10000)) {
+            continue;
+        }
+        deliver(0, n);
+        expect_frame((uint16_t) i);
+        ok++;
+    }
+    finish(before, ok, 3, 0);
+}
+
+static void test_config(void) {
+    uint32_t before = failures;
+    printf("  %-36s", "configure and GET_REPORT");
+    hid_stream_config_t config, back;
+    uint8_t report[HID_STREAM_REPORT_SIZE] = {HID_STREAM_CMD_CONFIGURE, HID_STREAM_ENC_DELTA12, 0x34, 0x12, 50, 0x10, 0x27};
+    if (!hid_stream_parse_config(report, sizeof(report), &config) || config.encoding != HID_STREAM_ENC_DELTA12 ||
+        config.band != 0x1234 || config.keyframe_interval != 50 || config.period_ms != 10000) {
+        fail("configure report not parsed");
+    }
+    uint8_t get[HID_STREAM_CONFIG_SIZE + 1] = {HID_STREAM_CMD_CONFIGURE};
+    if (hid_stream_write_config(&config, get + 1) != HID_STREAM_CONFIG_SIZE ||
+        !hid_stream_parse_config(get, sizeof(get), &back) || memcmp(&back, &config, sizeof(back)) != 0) {
+        fail("GET_REPORT does not round-trip");
+    }
+    report[4] = report[5] = report[6] = 0;
+    if (!hid_stream_parse_config(report, sizeof(report), &config) || config.period_ms != 1) {
+        fail("period 0 not raised to 1 ms");
+    }
+    // GET_REPORT must read back the interval frame_codec_init() will use
+    if (config.keyframe_interval != FRAME_CODEC_DEFAULT_KEYFRAME_INTERVAL) {
+        fail("keyframe interval 0 read back as %u", config.keyframe_interval);
+    }
+    report[1] = HID_STREAM_ENC_DELTA12 + 1;
+    if (hid_stream_parse_config(report, sizeof(report), &config)) {
+        fail("unknown encoding accepted");
+    }
+    report[1] = HID_STREAM_ENC_RAW12;
+    report[0] = 0;
+    if (hid_stream_parse_config(report, sizeof(report), &config) ||
+        hid_stream_parse_config(get, HID_STREAM_CONFIG_SIZE, &config)) {
+        fail("wrong command or short report accepted");
+    }
+    printf(" %s\n", failures == before ? "ok" : "FAILED");
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2 || (vectors = fopen(argv[1], "w")) == NULL) {
+        fprintf(stderr, "usage: %s VECTOR_FILE\n", argv[0]);
+        return 2;
+    }
+    printf("hid_stream loopback (device side; host side in tools/hid_stream_test.py):\n");
+    test_loopback();
+    test_reordered_chunks();
+    test_dropped_reports();
+    test_reordered_frames();
+    test_queue_full();
+    test_seq_wrap();
+    test_config();
+    fclose(vectors);
+
+    printf("\n%s, vectors in %s\n", failures ? "FAIL" : "PASS", argv[1]);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,99 @@
+"""
+Host side of the vendor HID stream loopback test
+
+Replays the vector file written by hid_stream_test.c (reports produced by
+the firmware's hid_stream.c, with drops and reordering applied) through
+StreamDecoder.reassemble() from hid_stream.py, the decoder the viewers use,
+and checks every completed frame byte for byte, including the zero padding,
+and the loss counters of each scenario.
+
+Usage (from testing/rp2350_c_hid):
+    cc -O2 -I. -o hid_stream_test tools/hid_stream_test.c hid_stream.c
+    ./hid_stream_test hid_stream_vectors.txt
+    python3 tools/hid_stream_test.py hid_stream_vectors.txt
+"""
+
+import sys
+
+from hid_stream import StreamDecoder, CHUNK_DATA
+
+
+def frame_byte(timestamp_us, i):
+    """Payload byte i of a test frame (frame_byte() in hid_stream_test.c)."""
+    return (timestamp_us + i * 167 + (i >> 8) * 13) & 0xFF
+
+
+def expected_payload(timestamp_us, length):
+    chunks = (length + CHUNK_DATA - 1) // CHUNK_DATA
+    data = bytes(frame_byte(timestamp_us, i) for i in range(length))
+    return data + bytes(chunks * CHUNK_DATA - length)
+
+
+class Scenario:
+    def __init__(self, name):
+        self.name = name
+        self.decoder = StreamDecoder()
+        self.frames = []
+        self.expected = []
+        self.failures = []
+
+    def fail(self, message):
+        if len(self.failures) < 5:
+            self.failures.append(message)
+
+    def finish(self, ok, lost, incomplete):
+        for i, (frame, want) in enumerate(zip(self.frames, self.expected)):
+            seq, encoding, timestamp_us, length = want
+            if (frame.seq, frame.encoding, frame.timestamp_us) != (seq, encoding, timestamp_us):
+                self.fail(f"frame {i}: seq/encoding/timestamp {frame.seq}/{frame.encoding}/"
+                          f"{frame.timestamp_us}, expected {seq}/{encoding}/{timestamp_us}")
+            elif frame.payload != expected_payload(timestamp_us, length):
+                self.fail(f"seq {seq}: payload differs")
+        if len(self.frames) != len(self.expected):
+            self.fail(f"{len(self.frames)} frames completed, expected {len(self.expected)}")
+
+        stats = self.decoder.stats
+        got = (len(self.frames), stats.frames_lost, stats.frames_incomplete, stats.bad_reports)
+        if got != (ok, lost, incomplete, 0):
+            self.fail(f"ok/lost/incomplete/bad {got[0]}/{got[1]}/{got[2]}/{got[3]}, "
+                      f"expected {ok}/{lost}/{incomplete}/0")
+        status = "FAILED" if self.failures else "ok"
+        print(f"  {self.name:<36} {status} (ok {got[0]}, lost {got[1]}, incomplete {got[2]})")
+        for message in self.failures:
+            print(f"    FAIL: {message}")
+        return not self.failures
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(f"usage: {sys.argv[0]} VECTOR_FILE", file=sys.stderr)
+        return 2
+
+    passed = True
+    scenarios = 0
+    scenario = None
+    print("hid_stream.py reassembly of the loopback vectors:")
+    with open(sys.argv[1]) as f:
+        for line in f:
+            kind, _, rest = line.rstrip('\n').partition(' ')
+            if kind == 'S':
+                scenario = Scenario(rest)
+            elif kind == 'R':
+                scenario.frames.extend(scenario.decoder.reassemble(bytes.fromhex(rest)))
+            elif kind == 'F':
+                scenario.expected.append(tuple(int(v) for v in rest.split()))
+            elif kind == 'E':
+                passed &= scenario.finish(*(int(v) for v in rest.split()))
+                scenarios += 1
+                scenario = None
+
+    if scenarios == 0 or scenario is not None:
+        print("  vector file empty or truncated")
+        passed = False
+    print()
+    print("PASS" if passed else "FAIL")
+    return 0 if passed else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,494 @@
+#include "hal_sim.h"
+#include "hal.h"
+#include "scan.h"
+#include "keyboard.h"
+#include "config.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SENSOR_CURVE 2.0f           // Steepness of the hall response towards bottom-out
+#define NOISE_LSB 1.5f              // ADC noise, standard deviation
+#define SAMPLE_OFFSET_NS 500        // Sample-and-hold point within a conversion
+#define CDC_PACKET 64
+#define MAX_INPUTS 8
+#define ADC_BASE_PIN 40             // RP2350B: ADC0-7 on GP40-47
+
+typedef struct {
+    uint64_t t0, t1;
+    float d0, d1;
+} move_t;
+
+typedef struct {
+    move_t *moves;
+    uint32_t count, cap;
+    uint32_t cur;                   // Move last looked at
+} key_script_t;
+
+typedef struct {
+    uint8_t channel;                // Channel on the line
+    uint64_t switched_ns;
+    float offset;                   // Line minus channel output at the switch
+} mux_line_t;
+
+static struct {
+    uint64_t now_ns;
+    uint32_t start_us;
+    uint32_t rng;
+
+    // Sensors and lines
+    float rest[TOTAL_CHANNELS];
+    float span[TOTAL_CHANNELS];
+    float tau_ns[NUM_MUXES][CHANNELS_PER_MUX];
+    key_script_t keys[HAL_SIM_KEYS];
+    uint8_t select;
+    mux_line_t lines[NUM_MUXES];
+
+    // ADC
+    int8_t input_mux[MAX_INPUTS];   // Mux on each ADC input, -1 = none
+    uint16_t rr_mask;
+    bool burst_active;
+    uint64_t burst_start_ns;
+    uint64_t burst_end_ns;
+    uint8_t burst_input;
+    uint16_t *burst_buf;
+    uint16_t burst_len;
+
+    // Alarm
+    bool alarm_armed;
+    uint64_t alarm_ns;
+
+    // USB
+    uint64_t usb_frame_ns;
+    uint8_t hid_report[64];
+    uint16_t hid_len;
+    bool hid_busy;
+    bool hid_complete;
+    uint8_t cdc_fifo[HAL_SIM_CDC_FIFO_SIZE];
+    uint32_t cdc_head, cdc_tail;
+    bool cdc_flushed;
+    uint64_t cdc_packet_ns;
+    hal_sim_report_cb_t report_cb;
+    hal_sim_cdc_cb_t cdc_cb;
+
+    hal_sim_stats_t stats;
+} sim;
+
+static uint32_t rnd(void) {
+    sim.rng ^= sim.rng << 13;
+    sim.rng ^= sim.rng >> 17;
+    sim.rng ^= sim.rng << 5;
+    return sim.rng;
+}
+
+static float rnd_uniform(void) {
+    return (rnd() >> 8) / 16777216.0f;
+}
+
+static float rnd_gauss(void) {
+    float u = rnd_uniform() + 1e-7f;
+    return sqrtf(-2.0f * logf(u)) * cosf(6.2831853f * rnd_uniform());
+}
+
+// ---------------------------------------------------------------------------
+// Model
+
+float hal_sim_sensor_fraction(float depth) {
+    if (depth <= 0) {
+        return 0;
+    }
+    if (depth >= 1) {
+        return 1;
+    }
+    return (expf(SENSOR_CURVE * depth) - 1) / (expf(SENSOR_CURVE) - 1);
+}
+
+float hal_sim_sensor_depth(float fraction) {
+    return logf(1 + fraction * (expf(SENSOR_CURVE) - 1)) / SENSOR_CURVE;
+}
+
+float hal_sim_key_depth(uint8_t key, uint64_t at_ns) {
+    key_script_t *k = &sim.keys[key];
+    if (k->count == 0 || at_ns < k->moves[0].t0) {
+        return 0;
+    }
+    uint32_t i = k->cur;
+    while (i > 0 && k->moves[i].t0 > at_ns) {
+        i--;
+    }
+    while (i + 1 < k->count && k->moves[i + 1].t0 <= at_ns) {
+        i++;
+    }
+    k->cur = i;
+    const move_t *m = &k->moves[i];
+    if (at_ns >= m->t1) {
+        return m->d1;
+    }
+    return m->d0 + (m->d1 - m->d0) * (float)(at_ns - m->t0) / (float)(m->t1 - m->t0);
+}
+
+void hal_sim_key_move(uint8_t key, uint64_t at_ns, float depth, uint32_t duration_us) {
+    if (key >= HAL_SIM_KEYS) {
+        return;
+    }
+    key_script_t *k = &sim.keys[key];
+    if (k->count == k->cap) {
+        k->cap = k->cap ? k->cap * 2 : 64;
+        k->moves = realloc(k->moves, k->cap * sizeof(move_t));
+    }
+    move_t m = {
+        .t0 = at_ns,
+        .t1 = at_ns + (uint64_t) duration_us * 1000 + 1,
+        .d0 = hal_sim_key_depth(key, at_ns),
+        .d1 = depth,
+    };
+    k->moves[k->count++] = m;
+}
+
+// Noise-free output of a channel
+static float channel_output(uint8_t channel, uint64_t at_ns) {
+    if (channel >= HAL_SIM_KEYS) {
+        return sim.rest[channel];
+    }
+    return sim.rest[channel] + sim.span[channel] * hal_sim_sensor_fraction(hal_sim_key_depth(channel, at_ns));
+}
+
+// Mux output line, settling towards its channel since the last switch
+static float line_output(uint8_t mux, uint64_t at_ns) {
+    const mux_line_t *line = &sim.lines[mux];
+    uint8_t ch = (uint8_t)(mux * CHANNELS_PER_MUX + line->channel);
+    float settle = expf(-(float)(at_ns - line->switched_ns) / sim.tau_ns[mux][line->channel]);
+    return channel_output(ch, at_ns) + line->offset * settle;
+}
+
+static uint16_t convert(uint8_t input, uint64_t at_ns) {
+    sim.stats.conversions++;
+    int8_t mux = input < MAX_INPUTS ? sim.input_mux[input] : -1;
+    float v = mux < 0 ? 0 : line_output((uint8_t) mux, at_ns);
+    long counts = lroundf(v + NOISE_LSB * rnd_gauss());
+    return (uint16_t)(counts < 0 ? 0 : counts > 4095 ? 4095 : counts);
+}
+
+static uint8_t next_input(uint8_t input) {
+    for (uint8_t i = 1; i <= MAX_INPUTS; i++) {
+        uint8_t next = (uint8_t)((input + i) % MAX_INPUTS);
+        if (sim.rr_mask & (1u << next)) {
+            return next;
+        }
+    }
+    return input;
+}
+
+float hal_sim_channel_output(uint8_t channel) {
+    return channel < TOTAL_CHANNELS ? channel_output(channel, sim.now_ns) : 0;
+}
+
+float hal_sim_settle_us(uint8_t mux, uint8_t channel, uint16_t tolerance_lsb) {
+    uint8_t prev = (uint8_t)((channel + CHANNELS_PER_MUX - 1) % CHANNELS_PER_MUX);
+    float step = fabsf(channel_output((uint8_t)(mux * CHANNELS_PER_MUX + channel), sim.now_ns) -
+                       channel_output((uint8_t)(mux * CHANNELS_PER_MUX + prev), sim.now_ns));
+    if (step <= tolerance_lsb) {
+        return 0;
+    }
+    return sim.tau_ns[mux][channel] * logf(step / tolerance_lsb) / 1000.0f;
+}
+
+void hal_sim_init(uint32_t seed, uint32_t start_us) {
+    for (int k = 0; k < HAL_SIM_KEYS; k++) {
+        free(sim.keys[k].moves);
+    }
+    memset(&sim, 0, sizeof(sim));
+    sim.rng = seed ? seed : 1;
+    sim.start_us = start_us;
+
+    for (int ch = 0; ch < TOTAL_CHANNELS; ch++) {
+        if (ch < HAL_SIM_KEYS) {
+            sim.rest[ch] = 2000 + 40 * rnd_gauss();
+            sim.span[ch] = 900 + 25 * rnd_gauss();
+        } else {
+            sim.rest[ch] = 40 + 60 * rnd_uniform();
+        }
+    }
+    // Slower lines further from the ADC pins, a little spread per channel
+    static const float line_tau_us[NUM_MUXES] = {1.6f, 2.0f, 2.4f, 2.8f, 2.2f};
+    for (int mux = 0; mux < NUM_MUXES; mux++) {
+        for (int ch = 0; ch < CHANNELS_PER_MUX; ch++) {
+            sim.tau_ns[mux][ch] = line_tau_us[mux] * 1000 * (0.9f + 0.2f * rnd_uniform());
+        }
+    }
+    memset(sim.input_mux, -1, sizeof(sim.input_mux));
+    sim.usb_frame_ns = HAL_SIM_USB_FRAME_NS;
+    sim.cdc_packet_ns = (uint64_t) CDC_PACKET * 1000000 / HAL_SIM_CDC_BYTES_PER_MS;
+}
+
+void hal_sim_set_host(hal_sim_report_cb_t report_cb, hal_sim_cdc_cb_t cdc_cb) {
+    sim.report_cb = report_cb;
+    sim.cdc_cb = cdc_cb;
+}
+
+uint64_t hal_sim_now_ns(void) {
+    return sim.now_ns;
+}
+
+void hal_sim_get_stats(hal_sim_stats_t *out) {
+    *out = sim.stats;
+}
+
+// ---------------------------------------------------------------------------
+// Events
+
+static void usb_frame(void) {
+    sim.usb_frame_ns += HAL_SIM_USB_FRAME_NS;
+    if (sim.hid_busy) {
+        sim.hid_busy = false;
+        sim.hid_complete = true;
+        sim.stats.hid_reports++;
+        if (sim.report_cb) {
+            sim.report_cb(sim.hid_report, sim.hid_len, sim.now_ns);
+        }
+    }
+}
+
+static void cdc_packet(void) {
+    sim.cdc_packet_ns += (uint64_t) CDC_PACKET * 1000000 / HAL_SIM_CDC_BYTES_PER_MS;
+    uint32_t used = sim.cdc_head - sim.cdc_tail;
+    if (used == 0 || (used < CDC_PACKET && !sim.cdc_flushed)) {
+        return;
+    }
+    uint8_t packet[CDC_PACKET];
+    uint16_t n = used < CDC_PACKET ? (uint16_t) used : CDC_PACKET;
+    for (uint16_t i = 0; i < n; i++) {
+        packet[i] = sim.cdc_fifo[sim.cdc_tail++ % HAL_SIM_CDC_FIFO_SIZE];
+    }
+    if (sim.cdc_head == sim.cdc_tail) {
+        sim.cdc_flushed = false;
+    }
+    sim.stats.cdc_bytes += n;
+    if (sim.cdc_cb) {
+        sim.cdc_cb(packet, n);
+    }
+}
+
+static void burst_done(void) {
+    sim.burst_active = false;
+    sim.stats.bursts++;
+    uint8_t input = sim.burst_input;
+    for (uint16_t k = 0; k < sim.burst_len; k++) {
+        uint64_t at = sim.burst_start_ns + (uint64_t) k * HAL_SIM_CONVERSION_NS + SAMPLE_OFFSET_NS;
+        sim.burst_buf[k] = convert(input, at);
+        input = next_input(input);
+    }
+    scan_on_burst_done();
+}
+
+bool hal_sim_run(uint64_t until_ns) {
+    // Earliest event; on a tie the scan interrupts go first
+    enum { ALARM, BURST, USB, CDC, NONE } next = NONE;
+    uint64_t due[NONE] = {
+        [ALARM] = sim.alarm_armed ? sim.alarm_ns : UINT64_MAX,
+        [BURST] = sim.burst_active ? sim.burst_end_ns : UINT64_MAX,
+        [USB] = sim.usb_frame_ns,
+        [CDC] = sim.cdc_packet_ns,
+    };
+    uint64_t at = until_ns;
+    for (int e = ALARM; e < NONE; e++) {
+        if (due[e] <= at && (next == NONE || due[e] < due[next])) {
+            next = e;
+            at = due[e];
+        }
+    }
+
+    if (at > sim.now_ns) {
+        sim.now_ns = at;
+    }
+    switch (next) {
+        case ALARM:
+            sim.alarm_armed = false;
+            sim.stats.alarms++;
+            scan_on_alarm();
+            break;
+        case BURST:
+            burst_done();
+            break;
+        case USB:
+            usb_frame();
+            break;
+        case CDC:
+            cdc_packet();
+            break;
+        case NONE:
+            return false;
+    }
+    return true;
+}
+
+static void advance_to(uint64_t ns) {
+    while (hal_sim_run(ns)) {
+    }
+}
+
+void hal_sim_usb_task(void) {
+    if (sim.hid_complete) {
+        sim.hid_complete = false;
+        keyboard_report_complete();
+    }
+}
+
+// ---------------------------------------------------------------------------
+// hal.h
+
+uint32_t hal_time_us(void) {
+    return sim.start_us + (uint32_t)(sim.now_ns / 1000);
+}
+
+bool hal_alarm_set(uint32_t target_us) {
+    int32_t ahead = (int32_t)(target_us - hal_time_us());
+    if (ahead <= 0) {
+        return false;
+    }
+    sim.alarm_ns = (sim.now_ns / 1000 + (uint64_t) ahead) * 1000;
+    sim.alarm_armed = true;
+    return true;
+}
+
+void hal_alarm_cancel(void) {
+    sim.alarm_armed = false;
+}
+
+void hal_scan_attach(void) {
+}
+
+uint32_t hal_irq_save(void) {
+    return 0;
+}
+
+void hal_irq_restore(uint32_t state) {
+    (void) state;
+}
+
+void hal_spin(void) {
+    // Nothing else runs while the firmware waits: skip to the next event
+    hal_sim_run(UINT64_MAX);
+}
+
+static void switch_lines(uint8_t select) {
+    for (uint8_t mux = 0; mux < NUM_MUXES; mux++) {
+        mux_line_t *line = &sim.lines[mux];
+        float v = line_output(mux, sim.now_ns);
+        line->channel = select;
+        line->switched_ns = sim.now_ns;
+        line->offset = v - channel_output((uint8_t)(mux * CHANNELS_PER_MUX + select), sim.now_ns);
+    }
+    sim.select = select;
+}
+
+void hal_mux_init(const uint8_t *pins, uint8_t count) {
+    (void) pins;
+    (void) count;
+    switch_lines(0);
+}
+
+void hal_mux_select(uint8_t select) {
+    select &= CHANNELS_PER_MUX - 1;
+    if (select != sim.select) {
+        switch_lines(select);
+    }
+}
+
+void hal_adc_init(const uint8_t *pins, uint8_t count, uint8_t *inputs) {
+    for (uint8_t i = 0; i < count; i++) {
+        inputs[i] = (uint8_t)(pins[i] - ADC_BASE_PIN);
+        if (inputs[i] < MAX_INPUTS) {
+            sim.input_mux[inputs[i]] = (int8_t) i;
+        }
+    }
+}
+
+void hal_adc_set_round_robin(uint16_t rr_mask) {
+    sim.rr_mask = rr_mask;
+}
+
+void hal_adc_burst_start(uint8_t first_input, uint16_t *buf, uint16_t len) {
+    sim.burst_active = true;
+    sim.burst_start_ns = sim.now_ns;
+    sim.burst_end_ns = sim.now_ns + (uint64_t) len * HAL_SIM_CONVERSION_NS;
+    sim.burst_input = first_input;
+    sim.burst_buf = buf;
+    sim.burst_len = len;
+}
+
+void hal_adc_stop(void) {
+    sim.burst_active = false;
+}
+
+void hal_adc_trace(uint8_t input, uint8_t from_select, uint8_t to_select, uint16_t presettle_us,
+                   uint16_t *trace, uint16_t len) {
+    hal_mux_select(from_select);
+    advance_to(sim.now_ns + (uint64_t) presettle_us * 1000);
+
+    // The switch follows the first conversion; sample 0 is the next one
+    advance_to(sim.now_ns + HAL_SIM_CONVERSION_NS);
+    hal_mux_select(to_select);
+    for (uint16_t i = 0; i < len; i++) {
+        trace[i] = convert(input, sim.now_ns + (uint64_t) i * HAL_SIM_CONVERSION_NS + SAMPLE_OFFSET_NS);
+    }
+    advance_to(sim.now_ns + (uint64_t) len * HAL_SIM_CONVERSION_NS);
+}
+
+bool hal_usb_mounted(void) {
+    return true;
+}
+
+bool hal_usb_suspended(void) {
+    return false;
+}
+
+void hal_usb_remote_wakeup(void) {
+}
+
+bool hal_hid_ready(uint8_t instance) {
+    return instance != KEYBOARD_HID_INSTANCE || !sim.hid_busy;
+}
+
+bool hal_hid_boot_protocol(uint8_t instance) {
+    (void) instance;
+    return false;
+}
+
+bool hal_hid_report(uint8_t instance, uint8_t report_id, const void *report, uint16_t len) {
+    (void) report_id;
+    if (instance != KEYBOARD_HID_INSTANCE) {
+        return true;    // Only the keyboard has a host model
+    }
+    if (sim.hid_busy || len > sizeof(sim.hid_report)) {
+        return false;
+    }
+    memcpy(sim.hid_report, report, len);
+    sim.hid_len = len;
+    sim.hid_busy = true;
+    return true;
+}
+
+bool hal_cdc_connected(void) {
+    return true;
+}
+
+uint32_t hal_cdc_write_available(void) {
+    return HAL_SIM_CDC_FIFO_SIZE - (sim.cdc_head - sim.cdc_tail);
+}
+
+uint32_t hal_cdc_write(const void *data, uint32_t len) {
+    uint32_t space = hal_cdc_write_available();
+    if (len > space) {
+        len = space;
+    }
+    const uint8_t *bytes = data;
+    for (uint32_t i = 0; i < len; i++) {
+        sim.cdc_fifo[sim.cdc_head++ % HAL_SIM_CDC_FIFO_SIZE] = bytes[i];
+    }
+    return len;
+}
+
+void hal_cdc_flush(void) {
+    sim.cdc_flushed = sim.cdc_head != sim.cdc_tail;
+}
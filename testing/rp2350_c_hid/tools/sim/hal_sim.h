@@ -0,0 +1,124 @@
+#ifndef HAL_SIM_H
+#define HAL_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Host backend for hal.h: a discrete-event model of the scan hardware and
+// the USB host, driven by a runner (scan_sim.c).
+//
+//   - Time only moves in hal_sim_run() (and in the blocking HAL calls), from
+//     one event to the next: the settle alarm, the end of an ADC burst, a
+//     USB frame, a CDC packet. Firmware code runs in zero simulated time.
+//   - Each HC4067 output follows its selected channel through an RC settle
+//     (per-line time constant) from wherever it was at the last select
+//     change. The ADC converts every HAL_SIM_CONVERSION_NS in round-robin
+//     order and adds Gaussian noise.
+//   - Keys 0..HAL_SIM_KEYS-1 are hall sensors: rest near 2000 counts, rising
+//     by a per-key span of ~900 counts at bottom-out along a curve that gets
+//     steeper towards the magnet. Depth (0 = rest, 1 = bottom-out) follows
+//     the linear ramps queued with hal_sim_key_move(). The remaining
+//     channels are unpopulated and float below KEY_FLOATING_THRESHOLD.
+//   - The USB host polls the HID interfaces every frame (1 ms, bInterval 1)
+//     and drains the CDC FIFO one 64-byte bulk packet at a time at
+//     HAL_SIM_CDC_BYTES_PER_MS. Completions reach the firmware from
+//     hal_sim_usb_task(), as TinyUSB defers them to tud_task().
+
+#define HAL_SIM_KEYS 66
+#define HAL_SIM_CONVERSION_NS 2000          // 500 ksps
+#define HAL_SIM_USB_FRAME_NS 1000000
+#define HAL_SIM_CDC_FIFO_SIZE 2048          // CFG_TUD_CDC_TX_BUFSIZE
+#define HAL_SIM_CDC_BYTES_PER_MS 1000       // Full-speed bulk with other traffic on the bus
+
+typedef struct {
+    uint64_t conversions;
+    uint64_t bursts;
+    uint64_t alarms;
+    uint32_t hid_reports;           // Keyboard reports collected by the host
+    uint64_t cdc_bytes;             // CDC bytes collected by the host
+} hal_sim_stats_t;
+
+// Called with every keyboard report the host collects
+typedef void (*hal_sim_report_cb_t)(const uint8_t *report, uint16_t len, uint64_t now_ns);
+
+// Called with every CDC packet the host collects
+typedef void (*hal_sim_cdc_cb_t)(const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Reset the model: keys at rest, no events pending
+ *
+ * @param seed Seeds sensor spread and ADC noise
+ * @param start_us hal_time_us() at simulated time 0 (use a value just
+ *                 below 2^32 to take the scan through the timer wrap)
+ */
+void hal_sim_init(uint32_t seed, uint32_t start_us);
+
+/**
+ * @brief Set the host-side consumers (either may be NULL)
+ */
+void hal_sim_set_host(hal_sim_report_cb_t report_cb, hal_sim_cdc_cb_t cdc_cb);
+
+/**
+ * @brief Simulated time since hal_sim_init()
+ */
+uint64_t hal_sim_now_ns(void);
+
+/**
+ * @brief Dispatch the next event, if it is due by until_ns
+ *
+ * @return false if no event was due; time is then advanced to until_ns
+ */
+bool hal_sim_run(uint64_t until_ns);
+
+/**
+ * @brief Deliver USB completions to the firmware (the tud_task() part)
+ */
+void hal_sim_usb_task(void);
+
+/**
+ * @brief Queue a linear move of a key to a new depth
+ *
+ * Moves of one key must be queued in time order and must not overlap.
+ *
+ * @param key Channel (below HAL_SIM_KEYS)
+ * @param at_ns Start of the move
+ * @param depth Depth at the end, 0 = rest to 1 = bottom-out
+ * @param duration_us Length of the move
+ */
+void hal_sim_key_move(uint8_t key, uint64_t at_ns, float depth, uint32_t duration_us);
+
+/**
+ * @brief Depth of a key at a time no earlier than its last-but-one move
+ */
+float hal_sim_key_depth(uint8_t key, uint64_t at_ns);
+
+/**
+ * @brief Noise-free sensor output at a depth, 0 = rest to 1 = bottom-out
+ *
+ * The key engine sees this fraction of 255 as travel once the key's range
+ * has been learned.
+ */
+float hal_sim_sensor_fraction(float depth);
+
+/**
+ * @brief Depth at which the noise-free sensor output reaches a fraction
+ */
+float hal_sim_sensor_depth(float fraction);
+
+/**
+ * @brief Noise-free output of a channel at the current simulated time, in counts
+ */
+float hal_sim_channel_output(uint8_t channel);
+
+/**
+ * @brief True settle time of a mux channel switched to from the one before
+ *        it, to within tolerance_lsb, at the current key positions
+ */
+float hal_sim_settle_us(uint8_t mux, uint8_t channel, uint16_t tolerance_lsb);
+
+/**
+ * @brief Counters since hal_sim_init()
+ */
+void hal_sim_get_stats(hal_sim_stats_t *out);
+
+#endif // HAL_SIM_H
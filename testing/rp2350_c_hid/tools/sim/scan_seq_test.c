@@ -0,0 +1,346 @@
+// Host test of scan_seq, the hardware-independent half of the scan engine.
+//
+// First against a scripted round-robin ADC that converts exactly as the
+// RP2350 does (from the selected input upwards through the enabled ones,
+// wrapping) and returns a sample that encodes its ADC input, the select
+// value and the pass. With the board wiring (ADC0, 5, 6, 7, 4, so slot order
+// is a rotation that differs from mux order) it checks for uniform and
+// planned settle, with and without oversampling, and in sliced low-power
+// mode:
+//   - every frame drives each select value of its slice exactly once,
+//   - each burst is num_muxes * oversample samples long,
+//   - every sample lands on the right channel and passes are averaged,
+//   - channels outside a frame's slice are left alone,
+//   - planned waits cover every slot's settle time, and respect the cap,
+//   - the frame completes on its last burst, with seq and timestamp set.
+//
+// Then the same sequencer drives the simulated hardware in hal_sim.c (RC
+// settle on every mux line, ADC noise, hall sensors held at a different
+// depth per mux) with waits planned from the model's settle times, and
+// every channel of every frame must read its noise-free output within
+// tolerance. Exits nonzero on any failure.
+//
+// Build and run from testing/rp2350_c_hid:
+//   cc -O2 -I. -I../common -Itools/sim -o scan_seq_test tools/sim/scan_seq_test.c tools/sim/hal_sim.c
+//      scan_seq.c ../common/scan_schedule.c ../common/settle.c -lm
+//   ./scan_seq_test
+
+#include "hal_sim.h"
+#include "hal.h"
+#include "scan.h"
+#include "keyboard.h"
+#include "scan_seq.h"
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#define UNTOUCHED 0xFFFF
+#define SIM_FRAMES 200
+#define SIM_TOLERANCE 20                // Settle tolerance plus ~6 sigma of ADC noise
+
+static const uint8_t adc_pins[NUM_MUXES] = {MUX1_PIN, MUX2_PIN, MUX3_PIN, MUX4_PIN, MUX5_PIN};
+static uint8_t adc_inputs[NUM_MUXES];
+static uint32_t failures;
+
+static void fail(const char *fmt, ...) {
+    if (failures++ < 20) {
+        va_list args;
+        va_start(args, fmt);
+        printf("    FAIL: ");
+        vprintf(fmt, args);
+        printf("\n");
+        va_end(args);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Scripted ADC
+
+// Sample the scripted ADC returns; passes differ so averaging is visible
+static uint16_t code(uint8_t input, uint8_t select, uint8_t pass) {
+    return (uint16_t)(400 * input + 20 * select + 2 * pass);
+}
+
+// Average scan_seq should store for a mux channel
+static uint16_t expected_raw(uint8_t mux, uint8_t select, uint8_t oversample) {
+    return (uint16_t)(code(adc_inputs[mux], select, 0) + oversample - 1);
+}
+
+// One burst as the round-robin hardware produces it
+static void scripted_burst(const scan_seq_t *seq, uint16_t *buf) {
+    uint8_t select = scan_seq_select(seq);
+    uint8_t input = scan_seq_first_input(seq);
+    uint16_t len = scan_seq_burst_len(seq);
+    for (uint16_t k = 0; k < len; k++) {
+        buf[k] = code(input, select, (uint8_t)(k / seq->num_muxes));
+        do {
+            input = (uint8_t)((input + 1) % 16);
+        } while (!(seq->rr_mask & (1u << input)));
+    }
+}
+
+// Run one frame; settle_us (optional) is the table the waits were planned from
+static void scripted_frame(scan_seq_t *seq, uint8_t slice, uint16_t cap_us,
+                           const uint16_t settle_us[NUM_MUXES][CHANNELS_PER_MUX]) {
+    static frame_t frame;
+    static uint16_t burst[NUM_MUXES * 8];
+    bool seen[CHANNELS_PER_MUX] = {false};
+    uint32_t seq_before = seq->seq;
+
+    memset(frame.raw, 0xFF, sizeof(frame.raw));
+    for (int b = 0; b < CHANNELS_PER_MUX + 1; b++) {
+        uint8_t select = scan_seq_select(seq);
+        uint16_t wait_us = scan_seq_settle_us(seq);
+        if (select % seq->slices != slice) {
+            fail("slice %u: select %u driven", slice, select);
+        }
+        if (seen[select]) {
+            fail("select %u driven twice in a frame", select);
+        }
+        seen[select] = true;
+        if (scan_seq_burst_len(seq) != seq->num_muxes * seq->oversample) {
+            fail("burst length %u, expected %u", scan_seq_burst_len(seq), seq->num_muxes * seq->oversample);
+        }
+        if (cap_us && wait_us > cap_us) {
+            fail("select %u: wait %u us above the %u us cap", select, wait_us, cap_us);
+        }
+        if (settle_us && !cap_us) {
+            for (uint8_t slot = 0; slot < seq->num_muxes; slot++) {
+                uint8_t mux = (uint8_t)(scan_schedule_slot_channel(&seq->sched, seq->step, slot) / CHANNELS_PER_MUX);
+                if (wait_us + slot * SCAN_CONVERSION_US < settle_us[mux][select]) {
+                    fail("select %u slot %u (MUX%u): sampled at %u us, settles at %u us", select, slot,
+                         mux + 1, wait_us + slot * SCAN_CONVERSION_US, settle_us[mux][select]);
+                }
+            }
+        }
+
+        scripted_burst(seq, burst);
+        if (scan_seq_complete_burst(seq, burst, &frame, 1000u + (uint32_t) b)) {
+            if (frame.seq != seq_before + 1 || seq->seq != frame.seq) {
+                fail("frame seq %lu after %lu", (unsigned long) frame.seq, (unsigned long) seq_before);
+            }
+            if (frame.timestamp_us != 1000u + (uint32_t) b) {
+                fail("frame timestamp from burst %lu, expected the last one", (unsigned long)(frame.timestamp_us - 1000));
+            }
+            break;
+        }
+        if (b == CHANNELS_PER_MUX) {
+            fail("no frame after %d bursts", b);
+            return;
+        }
+    }
+
+    for (uint8_t mux = 0; mux < NUM_MUXES; mux++) {
+        for (uint8_t sel = 0; sel < CHANNELS_PER_MUX; sel++) {
+            uint16_t raw = frame.raw[mux * CHANNELS_PER_MUX + sel];
+            bool in_slice = sel % seq->slices == slice;
+            uint16_t want = in_slice ? expected_raw(mux, sel, seq->oversample) : UNTOUCHED;
+            if (in_slice && !seen[sel]) {
+                fail("slice %u: select %u never driven", slice, sel);
+            }
+            if (raw != want) {
+                fail("MUX%u ch%u: %u, expected %u", mux + 1, sel, raw, want);
+            }
+        }
+    }
+}
+
+static void scripted_run(const char *name, uint8_t oversample, bool planned, uint8_t slices, uint8_t low_oversample,
+                         uint16_t cap_us) {
+    static uint16_t settle[NUM_MUXES][CHANNELS_PER_MUX];
+    uint32_t before = failures;
+    scan_seq_t seq;
+
+    if (!scan_seq_init(&seq, adc_inputs, NUM_MUXES, oversample)) {
+        fail("%s: init rejected the board wiring", name);
+        return;
+    }
+    if (planned) {
+        // Spread like a real characterization: mostly fast, a few slow channels
+        uint32_t r = 12345;
+        for (uint8_t mux = 0; mux < NUM_MUXES; mux++) {
+            for (uint8_t sel = 0; sel < CHANNELS_PER_MUX; sel++) {
+                r = r * 1664525u + 1013904223u;
+                settle[mux][sel] = (uint16_t)(4 + (r >> 24) % 8 + ((r >> 16) % 11 == 0 ? 20 : 0));
+            }
+        }
+        scan_seq_set_settle(&seq, settle, SCAN_CONVERSION_US);
+    } else {
+        scan_seq_set_uniform_settle(&seq, SCAN_SETTLE_US);
+        if (scan_seq_settle_us(&seq) != SCAN_SETTLE_US || scan_seq_first_input(&seq) != 0) {
+            fail("%s: uniform settle: wait %u, first input %u", name, scan_seq_settle_us(&seq),
+                 scan_seq_first_input(&seq));
+        }
+    }
+    if (slices > 1 || cap_us) {
+        if (!scan_seq_set_mode(&seq, slices, low_oversample, cap_us)) {
+            fail("%s: mode rejected", name);
+            return;
+        }
+    }
+    scan_seq_restart(&seq);
+
+    for (uint8_t frame = 0; frame < 3 * slices; frame++) {
+        scripted_frame(&seq, frame % slices, cap_us, planned ? settle : NULL);
+    }
+    printf("  %-34s %s\n", name, failures == before ? "ok" : "FAILED");
+}
+
+static void scripted_tests(void) {
+    scan_seq_t seq;
+    uint32_t before = failures;
+    static const uint8_t bad_range[NUM_MUXES] = {0, 5, 6, 16, 4};
+    static const uint8_t twice[NUM_MUXES] = {0, 5, 6, 5, 4};
+    if (scan_seq_init(&seq, adc_inputs, 0, 1) || scan_seq_init(&seq, adc_inputs, NUM_MUXES + 1, 1) ||
+        scan_seq_init(&seq, adc_inputs, NUM_MUXES, 0) || scan_seq_init(&seq, bad_range, NUM_MUXES, 1) ||
+        scan_seq_init(&seq, twice, NUM_MUXES, 1)) {
+        fail("init accepted a bad wiring or oversample");
+    }
+    scan_seq_init(&seq, adc_inputs, NUM_MUXES, 4);
+    if (scan_seq_set_mode(&seq, 0, 0, 0) || scan_seq_set_mode(&seq, 17, 0, 0) || scan_seq_set_mode(&seq, 1, 5, 0)) {
+        fail("set_mode accepted 0 or 17 slices or more passes than the buffer holds");
+    }
+    printf("  %-34s %s\n", "argument checks", failures == before ? "ok" : "FAILED");
+
+    scripted_run("uniform settle", 1, false, 1, 0, 0);
+    scripted_run("uniform settle, 4x oversample", 4, false, 1, 0, 0);
+    scripted_run("planned settle", 1, true, 1, 0, 0);
+    scripted_run("planned settle, 3x oversample", 3, true, 1, 0, 0);
+    scripted_run("4 slices, 1 pass of 4, cap 8 us", 4, true, 4, 1, 8);
+    scripted_run("3 slices (uneven), cap 5 us", 2, true, 3, 0, 5);
+
+    // A restart mid-frame drops the partial frame and starts again at slice 0
+    before = failures;
+    static frame_t frame;
+    static uint16_t burst[NUM_MUXES * 2];
+    scan_seq_init(&seq, adc_inputs, NUM_MUXES, 2);
+    scan_seq_set_uniform_settle(&seq, SCAN_SETTLE_US);
+    scan_seq_set_mode(&seq, 2, 0, 0);
+    scan_seq_restart(&seq);
+    for (int b = 0; b < 11; b++) {
+        scripted_burst(&seq, burst);
+        scan_seq_complete_burst(&seq, burst, &frame, 0);
+    }
+    scan_seq_restart(&seq);
+    if (seq.slice != 0 || scan_seq_select(&seq) != 0) {
+        fail("restart: slice %u, select %u", seq.slice, scan_seq_select(&seq));
+    }
+    scripted_frame(&seq, 0, 0, NULL);
+    printf("  %-34s %s\n", "restart mid-frame", failures == before ? "ok" : "FAILED");
+}
+
+// ---------------------------------------------------------------------------
+// Simulated hardware: a minimal engine in the shape of scan.c
+
+static scan_seq_t sim_seq;
+static frame_t sim_frame;
+static uint16_t sim_burst[NUM_MUXES * SCAN_OVERSAMPLE];
+static uint32_t sim_frames, sim_bursts;
+static uint64_t sim_frame_start_ns;
+static float worst_error;
+static uint32_t out_of_tolerance;
+
+void scan_on_alarm(void) {
+    hal_adc_burst_start(scan_seq_first_input(&sim_seq), sim_burst, scan_seq_burst_len(&sim_seq));
+}
+
+static void schedule_burst(void) {
+    if (!hal_alarm_set(hal_time_us() + scan_seq_settle_us(&sim_seq))) {
+        scan_on_alarm();
+    }
+}
+
+void scan_on_burst_done(void) {
+    sim_bursts++;
+    if (scan_seq_complete_burst(&sim_seq, sim_burst, &sim_frame, hal_time_us())) {
+        sim_frames++;
+        for (uint8_t ch = 0; ch < TOTAL_CHANNELS; ch++) {
+            float error = fabsf(sim_frame.raw[ch] - hal_sim_channel_output(ch));
+            if (error > worst_error) {
+                worst_error = error;
+            }
+            if (error > SIM_TOLERANCE && out_of_tolerance++ < 10) {
+                fail("frame %lu MUX%u ch%u: %u, model %.1f", (unsigned long) sim_frame.seq,
+                     ch / CHANNELS_PER_MUX + 1, ch % CHANNELS_PER_MUX, sim_frame.raw[ch],
+                     hal_sim_channel_output(ch));
+            }
+        }
+    }
+    hal_mux_select(scan_seq_select(&sim_seq));
+    schedule_burst();
+}
+
+void keyboard_report_complete(void) {
+}
+
+static void sim_test(void) {
+    uint32_t before = failures;
+    hal_sim_init(7, 0);
+    hal_mux_init((const uint8_t[]) {MUX_S0, MUX_S1, MUX_S2, MUX_S3}, 4);
+    hal_adc_init(adc_pins, NUM_MUXES, adc_inputs);
+    if (!scan_seq_init(&sim_seq, adc_inputs, NUM_MUXES, SCAN_OVERSAMPLE)) {
+        fail("sim: init rejected the board wiring");
+        return;
+    }
+
+    // Keys held still, one depth per mux so a sample on the wrong mux shows
+    for (uint8_t key = 0; key < HAL_SIM_KEYS; key++) {
+        hal_sim_key_move(key, 0, 0.25f * (key / CHANNELS_PER_MUX), 1);
+    }
+    hal_sim_run(1000);
+
+    // Waits planned from the model's settle times, rounded up
+    static uint16_t settle[NUM_MUXES][CHANNELS_PER_MUX];
+    uint32_t plan_us = 0;
+    for (uint8_t mux = 0; mux < NUM_MUXES; mux++) {
+        for (uint8_t sel = 0; sel < CHANNELS_PER_MUX; sel++) {
+            settle[mux][sel] = (uint16_t) ceilf(hal_sim_settle_us(mux, sel, SCAN_CHAR_TOLERANCE_LSB));
+        }
+    }
+    scan_seq_set_settle(&sim_seq, settle, SCAN_CONVERSION_US);
+    scan_seq_restart(&sim_seq);
+    for (uint8_t step = 0; step < CHANNELS_PER_MUX; step++) {
+        plan_us += sim_seq.sched.steps[step].wait_us + scan_seq_burst_len(&sim_seq) * HAL_SIM_CONVERSION_NS / 1000;
+    }
+
+    hal_adc_set_round_robin(sim_seq.rr_mask);
+    hal_mux_select(scan_seq_select(&sim_seq));
+    sim_frame_start_ns = hal_sim_now_ns();
+    schedule_burst();
+    while (sim_frames < SIM_FRAMES) {
+        hal_sim_run(UINT64_MAX);
+    }
+
+    hal_sim_stats_t stats;
+    hal_sim_get_stats(&stats);
+    double frame_us = (hal_sim_now_ns() - sim_frame_start_ns) / 1000.0 / sim_frames;
+    if (sim_bursts != sim_frames * CHANNELS_PER_MUX) {
+        fail("sim: %lu bursts for %lu frames", (unsigned long) sim_bursts, (unsigned long) sim_frames);
+    }
+    if (stats.conversions != (uint64_t) sim_bursts * scan_seq_burst_len(&sim_seq)) {
+        fail("sim: %llu conversions for %lu bursts", (unsigned long long) stats.conversions,
+             (unsigned long) sim_bursts);
+    }
+    // Alarms are whole microseconds: at most 1 us lost per step
+    if (frame_us < plan_us || frame_us > plan_us + CHANNELS_PER_MUX) {
+        fail("sim: %.1f us per frame, planned %lu us", frame_us, (unsigned long) plan_us);
+    }
+    printf("  %-34s %s (%lu frames, %.1f us each, planned %lu; worst error %.1f counts)\n",
+           "simulated mux and ADC", failures == before ? "ok" : "FAILED", (unsigned long) sim_frames,
+           frame_us, (unsigned long) plan_us, worst_error);
+}
+
+int main(void) {
+    // Board wiring, as scan_init() gets it
+    hal_sim_init(1, 0);
+    hal_adc_init(adc_pins, NUM_MUXES, adc_inputs);
+
+    printf("scan_seq against a scripted round-robin ADC:\n");
+    scripted_tests();
+    printf("\nscan_seq on the simulated hardware:\n");
+    sim_test();
+
+    printf("\n%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,521 @@
+// Host run of the rp2350_c_hid scan and keyboard path on the simulated
+// hardware in hal_sim.c. The firmware modules are the real ones: scan.c
+// (DMA/alarm round-robin engine, through hal.h), scan_seq, the settle
+// characterization, sample_filter, keys, keymap, keyboard and nkro. The
+// per-frame glue below stands in for acquire.c (core 1: filter, keys,
+// events) and the main loop (core 0: keyboard, CDC telemetry), which need
+// the Pico multicore and stdio.
+//
+// After boot (settle characterization, one full press of every key so the
+// ranges are learned) it plays three scripted scenarios: typing with
+// rollover, chords, and rapid taps plus rapid-trigger wiggles. A reference
+// model of the key engine rules (keys.h) works out, from the noise-free
+// sensor curve, when each press and release should register; the host side
+// decodes every keyboard report it collects and matches the changes against
+// those. Reported per scenario: missed and extra key changes and the
+// latency from the moment a key crossed its actuation (or release) point
+// to the host collecting the report. At the end: simulated frame rate,
+// frames simulated per second of host time and the telemetry stream
+// received over the simulated CDC port.
+//
+// Simulated time starts just below the 32-bit microsecond wrap, so every
+// run also takes the scan through hal_time_us() wrapping. Exits nonzero if
+// a key change was missed or extra, press latency exceeded
+// SIM_LATENCY_LIMIT_US, or telemetry frames were lost.
+//
+// Build and run from testing/rp2350_c_hid:
+//   cc -O2 -I. -I../common -Itools/sim -o scan_sim tools/sim/hal_sim.c tools/sim/scan_sim.c scan.c scan_seq.c keys.c keymap.c keyboard.c
+//      ../common/{scan_schedule,settle,key_engine,key_calib,sample_filter,nkro,latency_hist,telemetry,crc}.c -lm
+//   ./scan_sim [seed]
+
+#include "hal_sim.h"
+#include "hal.h"
+#include "scan.h"
+#include "keys.h"
+#include "keymap.h"
+#include "keyboard.h"
+#include "nkro.h"
+#include "sample_filter.h"
+#include "latency_hist.h"
+#include "telemetry.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SIM_START_US (0xFFFFFFFFu - 3000000u)   // hal_time_us() wraps 3 s in
+#define SIM_LATENCY_LIMIT_US 3500               // Press p99 above this fails the run
+#define MS 1000000ull                           // ns
+#define TELEMETRY_RING_SIZE 16384               // As CDC_TELEMETRY_RING_SIZE
+#define EXPECT_DEPTH 256                        // Key changes scripted ahead per usage
+
+static uint32_t rng;
+
+static uint32_t rnd(uint32_t n) {
+    rng = rng * 1664525u + 1013904223u;
+    return (rng >> 8) % n;
+}
+
+static float rnd_range(float lo, float hi) {
+    return lo + (hi - lo) * (float) rnd(10001) / 10000.0f;
+}
+
+// ---------------------------------------------------------------------------
+// Reference model: when should each key change register?
+
+typedef struct {
+    uint64_t at_ns;
+    bool pressed;
+    bool measure;                   // Counts towards the latency figures
+} expect_t;
+
+static struct {
+    expect_t q[EXPECT_DEPTH];
+    uint16_t head, tail;
+} expected[256];                    // Per HID usage
+
+static struct {
+    bool pressed;
+    bool rt;                        // Released inside the rapid trigger zone
+    float extreme;                  // Deepest travel while pressed, shallowest while rt
+} ref[HAL_SIM_KEYS];
+
+static bool measuring;
+static uint32_t expected_changes;
+static uint32_t queue_overflows;
+
+static float travel_at(float depth) {
+    return 255.0f * hal_sim_sensor_fraction(depth);
+}
+
+static void expect(uint8_t key, uint64_t at_ns, bool pressed) {
+    uint8_t usage = keymap_usage(key);
+    if (usage == 0) {
+        return;
+    }
+    if ((uint16_t)(expected[usage].head - expected[usage].tail) == EXPECT_DEPTH) {
+        queue_overflows++;
+        return;
+    }
+    expected[usage].q[expected[usage].head++ % EXPECT_DEPTH] = (expect_t) {at_ns, pressed, measuring};
+    expected_changes++;
+}
+
+// Time a ramp from d0 to d1 over [t0, t0 + dur] reaches travel u
+static uint64_t crossing(uint64_t t0, uint32_t dur_us, float d0, float d1, float u) {
+    float d = hal_sim_sensor_depth(u / 255.0f);
+    return t0 + (uint64_t)((double)(d - d0) / (d1 - d0) * dur_us * 1000);
+}
+
+// Queue a key move and the change it should cause (key_engine.h rules)
+static void move(uint8_t key, uint64_t at_ns, float depth, uint32_t dur_us) {
+    float d0 = hal_sim_key_depth(key, at_ns);
+    float u0 = travel_at(d0), u1 = travel_at(depth);
+    hal_sim_key_move(key, at_ns, depth, dur_us);
+
+    if (u1 > u0) {
+        if (ref[key].pressed) {
+            ref[key].extreme = u1;
+            return;
+        }
+        float trough = ref[key].extreme < u0 ? ref[key].extreme : u0;
+        float press_at = ref[key].rt ? trough + KEY_RT_TRAVEL : KEY_ACTUATION_TRAVEL;
+        if (u1 >= press_at) {
+            expect(key, crossing(at_ns, dur_us, d0, depth, press_at), true);
+            ref[key].pressed = true;
+            ref[key].extreme = u1;
+        } else if (ref[key].rt) {
+            ref[key].extreme = trough;
+        }
+        return;
+    }
+
+    if (ref[key].pressed) {
+        float rt_at = ref[key].extreme - KEY_RT_TRAVEL;
+        float release_at = rt_at > KEY_RELEASE_TRAVEL ? rt_at : KEY_RELEASE_TRAVEL;
+        if (u1 > release_at) {
+            return;
+        }
+        expect(key, crossing(at_ns, dur_us, d0, depth, release_at), false);
+        ref[key].pressed = false;
+        ref[key].rt = rt_at > KEY_RELEASE_TRAVEL;
+        ref[key].extreme = u1;
+    } else if (ref[key].rt && u1 < ref[key].extreme) {
+        ref[key].extreme = u1;
+    }
+    if (u1 < KEY_RELEASE_TRAVEL) {
+        ref[key].rt = false;
+    }
+}
+
+// Down, hold, up; returns when the key is back at rest
+static uint64_t tap(uint8_t key, uint64_t at_ns, float depth, uint32_t down_us, uint32_t hold_us, uint32_t up_us) {
+    move(key, at_ns, depth, down_us);
+    uint64_t up_at = at_ns + (uint64_t)(down_us + hold_us) * 1000;
+    move(key, up_at, 0, up_us);
+    return up_at + (uint64_t) up_us * 1000 + 1;
+}
+
+// ---------------------------------------------------------------------------
+// Host: decode collected reports and match them against the expectations
+
+static uint8_t host_keys[NKRO_REPORT_SIZE];
+static latency_hist_t press_latency, release_latency;
+static uint32_t matched, extra, early;
+
+static void match_change(uint8_t usage, bool pressed, uint64_t now_ns) {
+    if (expected[usage].head == expected[usage].tail) {
+        extra++;
+        return;
+    }
+    expect_t e = expected[usage].q[expected[usage].tail++ % EXPECT_DEPTH];
+    if (e.pressed != pressed) {
+        extra++;
+        return;
+    }
+    matched++;
+    if (!e.measure) {
+        return;
+    }
+    uint32_t latency_us = 0;
+    if (now_ns >= e.at_ns) {
+        latency_us = (uint32_t)((now_ns - e.at_ns) / 1000);
+    } else {
+        early++;
+    }
+    latency_hist_add(pressed ? &press_latency : &release_latency, latency_us);
+}
+
+static void host_report(const uint8_t *report, uint16_t len, uint64_t now_ns) {
+    if (len != NKRO_REPORT_SIZE) {
+        extra++;
+        return;
+    }
+    for (int i = 0; i < NKRO_REPORT_SIZE; i++) {
+        uint8_t diff = report[i] ^ host_keys[i];
+        for (int bit = 0; diff; bit++, diff >>= 1) {
+            if (diff & 1) {
+                uint8_t usage = i == 0 ? (uint8_t)(NKRO_MODIFIER_FIRST + bit) : (uint8_t)((i - 1) * 8 + bit);
+                match_change(usage, (report[i] >> bit) & 1, now_ns);
+            }
+        }
+    }
+    memcpy(host_keys, report, sizeof(host_keys));
+}
+
+static telemetry_rx_t cdc_rx;
+static uint32_t cdc_frames, cdc_gaps, cdc_last_seq;
+
+static void host_record(void *ctx, uint8_t type, const uint8_t *payload, uint16_t len) {
+    (void) ctx;
+    telemetry_frame_header_t header;
+    if (type != TELEMETRY_FRAME || len < sizeof(header)) {
+        return;
+    }
+    memcpy(&header, payload, sizeof(header));
+    if (cdc_frames && header.seq != cdc_last_seq + 1) {
+        cdc_gaps++;
+    }
+    cdc_last_seq = header.seq;
+    cdc_frames++;
+}
+
+static void host_cdc(const uint8_t *data, uint16_t len) {
+    telemetry_rx_feed(&cdc_rx, data, len, host_record, NULL);
+}
+
+// ---------------------------------------------------------------------------
+// Firmware glue
+
+static sample_filter_t filter;
+static frame_t frame;
+static uint32_t frames_processed, frames_skipped;
+static key_event_t events[64];
+static uint8_t event_head, event_tail;
+static uint8_t tx_storage[TELEMETRY_RING_SIZE];
+static telemetry_tx_t tx;
+
+// Core 1 (acquire.c): filter, key detection, events
+static void core1_poll(void) {
+    uint32_t last_seq = frame.seq;
+    if (!scan_get_frame(&frame, last_seq)) {
+        return;
+    }
+    if (frames_processed && frame.seq != last_seq + 1) {
+        frames_skipped += frame.seq - last_seq - 1;
+    }
+    frames_processed++;
+
+    sample_filter_process(&filter, frame.raw, frame.raw);
+    uint8_t changed[KEY_BITMAP_BYTES];
+    if (keys_process(&frame, changed)) {
+        for (int ch = 0; ch < TOTAL_CHANNELS; ch++) {
+            if (changed[ch >> 3] & (1u << (ch & 7))) {
+                events[event_head++ % 64] = (key_event_t) {
+                    .timestamp_us = frame.timestamp_us,
+                    .frame_seq = frame.seq,
+                    .channel = (uint8_t) ch,
+                    .pressed = keys_is_pressed((uint8_t) ch),
+                };
+            }
+        }
+    }
+
+    // Binary telemetry: every frame as a record
+    const telemetry_frame_header_t header = {
+        .seq = frame.seq,
+        .timestamp_us = frame.timestamp_us,
+        .count = TOTAL_CHANNELS,
+    };
+    telemetry_send(&tx, TELEMETRY_FRAME, &header, sizeof(header), frame.raw, sizeof(frame.raw));
+}
+
+// Core 0 (main loop): keyboard report, then the CDC FIFO as in cdc_telemetry_task()
+static void core0_poll(void) {
+    hal_sim_usb_task();
+
+    bool any = false;
+    while (event_tail != event_head) {
+        const key_event_t *event = &events[event_tail++ % 64];
+        keyboard_set(keymap_usage(event->channel), event->pressed, event->timestamp_us);
+        any = true;
+    }
+    if (any) {
+        keyboard_task();
+    }
+
+    if (telemetry_tx_drain(&tx, hal_cdc_write)) {
+        hal_cdc_flush();
+    }
+}
+
+static void run_until(uint64_t end_ns) {
+    while (hal_sim_now_ns() < end_ns) {
+        hal_sim_run(end_ns);
+        core1_poll();
+        core0_poll();
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Scenarios
+
+static uint8_t typing_keys[HAL_SIM_KEYS];
+static int num_typing_keys;
+
+static uint8_t random_key(void) {
+    return typing_keys[rnd((uint32_t) num_typing_keys)];
+}
+
+// Key presses overlapping at ~15 keys/s, varied depth and speed
+static uint64_t script_typing(uint64_t t) {
+    static uint64_t busy_until[HAL_SIM_KEYS];
+    for (int i = 0; i < 1500; i++) {
+        uint8_t key;
+        do {
+            key = random_key();
+        } while (busy_until[key] > t);
+        busy_until[key] = tap(key, t, rnd_range(0.75f, 1.0f), 5000 + rnd(10000), 15000 + rnd(70000),
+                              5000 + rnd(10000)) + 5 * MS;
+        t += (25 + rnd(65)) * MS;
+    }
+    return t + 150 * MS;
+}
+
+// Three to six keys landing within 3 ms of each other
+static uint64_t script_chords(uint64_t t) {
+    for (int i = 0; i < 200; i++) {
+        uint8_t chord[6];
+        int n = 3 + (int) rnd(4);
+        for (int k = 0; k < n; k++) {
+            bool dup;
+            do {
+                chord[k] = random_key();
+                dup = false;
+                for (int j = 0; j < k; j++) {
+                    dup |= chord[j] == chord[k];
+                }
+            } while (dup);
+        }
+        uint32_t hold = 40000 + rnd(60000);
+        for (int k = 0; k < n; k++) {
+            uint64_t at = t + rnd(3000) * 1000ull;
+            tap(chord[k], at, 1.0f, 8000, hold, 6000 + rnd(6000));
+        }
+        t += 160 * MS;
+    }
+    return t + 50 * MS;
+}
+
+// Fast full taps, then a half-pressed key wiggled across the rapid trigger
+// distance (released and pressed again each time without reaching rest)
+static uint64_t script_rapid(uint64_t t) {
+    for (int i = 0; i < 40; i++) {
+        uint8_t key = random_key();
+        for (int n = 0; n < 5; n++) {
+            t = tap(key, t, 1.0f, 4000, 3000, 4000) + 8 * MS;
+        }
+        move(key, t, 0.9f, 6000);
+        t += 6 * MS + 5 * MS;
+        for (int n = 0; n < 6; n++) {
+            move(key, t, 0.62f, 4000);
+            t += 4 * MS + 3 * MS;
+            move(key, t, 0.9f, 4000);
+            t += 4 * MS + 3 * MS;
+        }
+        move(key, t, 0, 6000);
+        t += 6 * MS + 30 * MS;
+    }
+    return t + 50 * MS;
+}
+
+static void print_latency(const char *what, const latency_hist_t *h) {
+    if (h->count == 0) {
+        return;
+    }
+    printf("    %-8s %5lu  min %4lu  avg %4lu  p50 %4lu  p99 %4lu  max %4lu us\n", what,
+           (unsigned long) h->count, (unsigned long) h->min_us, (unsigned long)(h->sum_us / h->count),
+           (unsigned long) latency_hist_percentile(h, 500), (unsigned long) latency_hist_percentile(h, 990),
+           (unsigned long) h->max_us);
+}
+
+static uint32_t pending_changes(void) {
+    uint32_t n = 0;
+    for (int u = 0; u < 256; u++) {
+        n += (uint16_t)(expected[u].head - expected[u].tail);
+    }
+    return n;
+}
+
+static bool failed;
+
+static void run_scenario(const char *name, uint64_t (*script)(uint64_t)) {
+    latency_hist_reset(&press_latency);
+    latency_hist_reset(&release_latency);
+    latency_hist_t device;
+    keyboard_take_report_latency(&device);
+    uint32_t expected_before = expected_changes, matched_before = matched, extra_before = extra;
+
+    measuring = true;
+    uint64_t end = script(hal_sim_now_ns() + 10 * MS);
+    run_until(end);
+
+    uint32_t missed = pending_changes();
+    printf("  %s: %lu key changes, %lu missed, %lu extra\n", name,
+           (unsigned long)(expected_changes - expected_before), (unsigned long) missed,
+           (unsigned long)(extra - extra_before));
+    print_latency("press", &press_latency);
+    print_latency("release", &release_latency);
+    keyboard_take_report_latency(&device);
+    print_latency("device", &device);
+
+    if (missed || extra != extra_before || matched - matched_before != expected_changes - expected_before ||
+        latency_hist_percentile(&press_latency, 990) > SIM_LATENCY_LIMIT_US) {
+        failed = true;
+    }
+    // Start the next scenario with nothing outstanding
+    for (int u = 0; u < 256; u++) {
+        expected[u].tail = expected[u].head;
+    }
+}
+
+int main(int argc, char **argv) {
+    uint32_t seed = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 0) : 1;
+    rng = seed;
+    hal_sim_init(seed, SIM_START_US);
+    hal_sim_set_host(host_report, host_cdc);
+    telemetry_rx_init(&cdc_rx);
+    telemetry_tx_init(&tx, tx_storage, sizeof(tx_storage));
+    for (int ch = 0; ch < HAL_SIM_KEYS; ch++) {
+        if (keymap_usage((uint8_t) ch)) {
+            typing_keys[num_typing_keys++] = (uint8_t) ch;
+        }
+    }
+
+    // Boot as core 1 does: start, characterize the settle times, restart
+    static const sample_filter_config_t filter_config = {
+        .weight = FILTER_WEIGHT,
+        .deadband = FILTER_DEADBAND,
+        .full_speed = FILTER_FULL_SPEED,
+    };
+    scan_init();
+    keyboard_init();
+    sample_filter_init(&filter, TOTAL_CHANNELS, FILTER_MEDIAN_LEN, &filter_config);
+    keys_init();
+    scan_start();
+    scan_stop();
+
+    static uint16_t settle[NUM_MUXES][CHANNELS_PER_MUX];
+    scan_characterize(settle);
+    scan_apply_settle(settle);
+    printf("\nSettle characterization (measured / model, us, worst channel per mux):\n");
+    uint32_t plan_us = 0;
+    for (uint8_t mux = 0; mux < NUM_MUXES; mux++) {
+        uint16_t worst = 0;
+        float model = 0;
+        for (uint8_t ch = 0; ch < CHANNELS_PER_MUX; ch++) {
+            float m = hal_sim_settle_us(mux, ch, SCAN_CHAR_TOLERANCE_LSB);
+            worst = settle[mux][ch] > worst ? settle[mux][ch] : worst;
+            model = m > model ? m : model;
+        }
+        printf("  MUX%u %3u / %4.1f\n", (unsigned)(mux + 1), (unsigned) worst, model);
+    }
+    for (uint8_t step = 0; step < CHANNELS_PER_MUX; step++) {
+        uint8_t sel, first_mux;
+        plan_us += scan_step_plan(step, &sel, &first_mux);
+    }
+    printf("  Planned settle per frame: %lu us\n", (unsigned long) plan_us);
+    scan_start();
+
+    // Learn every key's range: one full press each, not timed
+    uint64_t t = hal_sim_now_ns() + 20 * MS;
+    uint64_t warm_end = t;
+    measuring = false;
+    for (int i = 0; i < num_typing_keys; i++) {
+        warm_end = tap(typing_keys[i], t, 1.0f, 10000, 20000, 10000);
+        t += 15 * MS;
+    }
+    run_until(warm_end + 50 * MS);
+    uint32_t warm_missed = pending_changes();
+    printf("\nWarm-up: %d keys pressed once, %lu missed, %lu extra\n", num_typing_keys,
+           (unsigned long) warm_missed, (unsigned long) extra);
+    if (warm_missed || extra) {
+        failed = true;
+    }
+
+    struct timespec wall0, wall1;
+    clock_gettime(CLOCK_MONOTONIC, &wall0);
+    uint64_t sim0 = hal_sim_now_ns();
+    uint32_t frames0 = frames_processed;
+
+    printf("\nScenarios (latency: key crossing its point -> host has the report; device = frame -> report):\n");
+    run_scenario("typing", script_typing);
+    run_scenario("chords", script_chords);
+    run_scenario("rapid", script_rapid);
+
+    clock_gettime(CLOCK_MONOTONIC, &wall1);
+    double wall_s = (double)(wall1.tv_sec - wall0.tv_sec) + (wall1.tv_nsec - wall0.tv_nsec) / 1e9;
+    double sim_s = (hal_sim_now_ns() - sim0) / 1e9;
+    uint32_t frames = frames_processed - frames0;
+    hal_sim_stats_t hs;
+    hal_sim_get_stats(&hs);
+
+    printf("\nThroughput:\n");
+    printf("  %lu frames in %.1f s simulated: %.0f frames/s, %.1f us per frame, %lu skipped\n",
+           (unsigned long) frames, sim_s, frames / sim_s, sim_s * 1e6 / frames, (unsigned long) frames_skipped);
+    printf("  Host: %.2f s, %.0f simulated frames/s (%.0fx real time)\n", wall_s, frames / wall_s, sim_s / wall_s);
+    printf("  ADC %.0f conversions/s; %lu keyboard reports\n", hs.conversions / (hal_sim_now_ns() / 1e9),
+           (unsigned long) hs.hid_reports);
+    printf("  CDC telemetry: %lu frames received, %lu gaps, %lu dropped in the ring, %lu CRC errors, %.0f KB/s\n",
+           (unsigned long) cdc_frames, (unsigned long) cdc_gaps, (unsigned long) tx.records_dropped,
+           (unsigned long) cdc_rx.crc_errors, hs.cdc_bytes / (hal_sim_now_ns() / 1e6));
+    if (cdc_gaps || tx.records_dropped || cdc_rx.crc_errors || frames_skipped || queue_overflows) {
+        failed = true;
+    }
+    if (early) {
+        printf("  %lu changes reported before the reference crossing\n", (unsigned long) early);
+    }
+
+    printf("\n%s\n", failed ? "FAIL" : "PASS");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,216 @@
+"""
+Binary CDC telemetry decoder and monitor
+
+Parses the record stream the firmware sends on the CDC port after a 'b'
+command (format in ../../common/telemetry.h). Each record is
+
+    [type][payload][CRC-32 of type + payload, uint32 LE]
+
+COBS-encoded and terminated by a 0x00 byte, so the decoder resyncs at the
+next delimiter after lost or damaged bytes. Record types:
+
+    TEXT   0x01  log text (printf output while binary mode is on)
+    FRAME  0x02  seq u32, timestamp_us u32, count u16, count x u16 raw counts
+    KEY    0x03  timestamp_us u32, key u16, pressed u8, reserved u8
+    STATS  0x04  uptime_ms, records_sent, records_dropped, scans, scans_dropped (u32)
+
+Usage:
+    dec = TelemetryDecoder()
+    for rec in dec.feed(serial_bytes):
+        ...
+
+    python telemetry.py [PORT]     switch the device to binary mode and print
+                                   frame rate, throughput and drop counters
+"""
+
+import struct
+import sys
+import time
+import zlib
+from dataclasses import dataclass, field
+
+TEXT = 0x01
+FRAME = 0x02
+KEY = 0x03
+STATS = 0x04
+
+MAX_PAYLOAD = 512
+MAX_PACKET = (1 + MAX_PAYLOAD + 4) + (1 + MAX_PAYLOAD + 4) // 254 + 1
+
+FRAME_HEADER = struct.Struct('<IIH')
+KEY_RECORD = struct.Struct('<IHBB')
+STATS_RECORD = struct.Struct('<IIIII')
+
+
+@dataclass
+class Frame:
+    seq: int
+    timestamp_us: int
+    raw: list
+
+
+@dataclass
+class Key:
+    timestamp_us: int
+    key: int
+    pressed: bool
+
+
+@dataclass
+class Stats:
+    uptime_ms: int
+    records_sent: int
+    records_dropped: int
+    scans: int
+    scans_dropped: int
+
+
+@dataclass
+class Text:
+    text: str
+
+
+@dataclass
+class DecoderStats:
+    records: int = 0
+    crc_errors: int = 0
+    framing_errors: int = 0
+    frames_lost: int = 0        # Gaps in the frame seq
+
+
+def cobs_decode(packet):
+    """Decode one COBS packet (without the delimiter); None if malformed."""
+    out = bytearray()
+    i = 0
+    while i < len(packet):
+        code = packet[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(packet):
+            return None
+        out += packet[i:i + code - 1]
+        i += code - 1
+        if code < 0xFF and i < len(packet):
+            out.append(0)
+    return bytes(out)
+
+
+@dataclass
+class TelemetryDecoder:
+    stats: DecoderStats = field(default_factory=DecoderStats)
+    _buf: bytearray = field(default_factory=bytearray)
+    _overflow: bool = False
+    _last_seq: int = None
+
+    def _parse(self, rtype, payload):
+        if rtype == TEXT:
+            return Text(payload.decode('utf-8', errors='replace'))
+        if rtype == FRAME:
+            seq, timestamp, count = FRAME_HEADER.unpack_from(payload)
+            raw = list(struct.unpack_from('<%dH' % count, payload, FRAME_HEADER.size))
+            if self._last_seq is not None:
+                gap = (seq - self._last_seq - 1) & 0xFFFFFFFF
+                if gap < 0x80000000:
+                    self.stats.frames_lost += gap
+            self._last_seq = seq
+            return Frame(seq, timestamp, raw)
+        if rtype == KEY:
+            timestamp, key, pressed, _ = KEY_RECORD.unpack_from(payload)
+            return Key(timestamp, key, bool(pressed))
+        if rtype == STATS:
+            return Stats(*STATS_RECORD.unpack_from(payload))
+        return None     # Unknown type: skipped, the format may grow
+
+    def _finish(self):
+        if self._overflow:
+            self.stats.framing_errors += 1
+            return None
+        if not self._buf:
+            return None
+        data = cobs_decode(self._buf)
+        if data is None or len(data) < 5:
+            self.stats.framing_errors += 1
+            return None
+        body, crc = data[:-4], struct.unpack_from('<I', data, len(data) - 4)[0]
+        if zlib.crc32(body) != crc:
+            self.stats.crc_errors += 1
+            return None
+        try:
+            rec = self._parse(body[0], body[1:])
+        except struct.error:
+            self.stats.framing_errors += 1
+            return None
+        self.stats.records += 1
+        return rec
+
+    def feed(self, data):
+        """Feed received bytes in any chunking; returns the decoded records."""
+        records = []
+        for byte in bytes(data):
+            if byte == 0:
+                rec = self._finish()
+                if rec is not None:
+                    records.append(rec)
+                self._buf.clear()
+                self._overflow = False
+            elif len(self._buf) < MAX_PACKET:
+                self._buf.append(byte)
+            else:
+                self._overflow = True
+        return records
+
+
+def find_port():
+    import serial.tools.list_ports
+    for port in serial.tools.list_ports.comports():
+        if "CAFE" in port.hwid.upper() or "4001" in port.hwid:
+            return port.device
+    return None
+
+
+def monitor(port):
+    import serial
+    ser = serial.Serial(port, 115200, timeout=0.1)
+    ser.write(b'b')
+    dec = TelemetryDecoder()
+    # Text printed before the switch arrives first; the first delimiter
+    # ends it as one bad packet, so don't count that one
+    started = time.monotonic()
+    window_start, window_frames, window_bytes = started, 0, 0
+    device = None
+    try:
+        while True:
+            data = ser.read(max(1, ser.in_waiting))
+            window_bytes += len(data)
+            for rec in dec.feed(data):
+                if isinstance(rec, Frame):
+                    window_frames += 1
+                elif isinstance(rec, Key):
+                    print(f"KEY {rec.key} {'pressed' if rec.pressed else 'released'} @ {rec.timestamp_us} us")
+                elif isinstance(rec, Stats):
+                    device = rec
+                elif isinstance(rec, Text):
+                    print(rec.text, end='')
+            now = time.monotonic()
+            if now - window_start >= 1.0:
+                elapsed = now - window_start
+                line = (f"{window_frames / elapsed:7.1f} frames/s  {window_bytes / elapsed / 1024:7.1f} KiB/s  "
+                        f"lost {dec.stats.frames_lost}  crc {dec.stats.crc_errors}  "
+                        f"framing {max(0, dec.stats.framing_errors - 1)}")
+                if device:
+                    line += (f"  | device: {device.records_dropped} records dropped, "
+                             f"{device.scans_dropped}/{device.scans} scans dropped")
+                print(line)
+                window_start, window_frames, window_bytes = now, 0, 0
+    except KeyboardInterrupt:
+        pass
+    finally:
+        ser.write(b'b')
+        ser.close()
+
+
+if __name__ == '__main__':
+    port = sys.argv[1] if len(sys.argv) > 1 else find_port()
+    if port is None:
+        print("CDC port not found!")
+        sys.exit(1)
+    monitor(port)
@@ -72,19 +72,21 @@ extern "C" {
 #define CFG_TUD_CDC               1
 #define CFG_TUD_MSC               0
 #define CFG_TUD_MIDI              0
-#define CFG_TUD_VENDOR            0
+#define CFG_TUD_VENDOR            0     // The bulk frame stream is an app driver (bulk_stream.c)
 
 // CDC buffer sizes
 #ifndef CFG_TUD_CDC_EP_BUFSIZE
 #define CFG_TUD_CDC_EP_BUFSIZE    64
 #endif
 
+// TX FIFO holds several full-speed packets so binary telemetry keeps the
+// bulk endpoint busy between main-loop passes
 #ifndef CFG_TUD_CDC_TX_BUFSIZE
-#define CFG_TUD_CDC_TX_BUFSIZE    64
+#define CFG_TUD_CDC_TX_BUFSIZE    2048
 #endif
 
 #ifndef CFG_TUD_CDC_RX_BUFSIZE
-#define CFG_TUD_CDC_RX_BUFSIZE    64
+#define CFG_TUD_CDC_RX_BUFSIZE    256
 #endif
 
 // HID buffer size Should be sufficient to hold ID (if any) + Data
@@ -0,0 +1,257 @@
+#include "acquire.h"
+#include "config.h"
+#include "spsc_ring.h"
+#include "flash_store.h"
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "pico/flash.h"
+#include "hardware/sync.h"
+
+static adc_frame_t frame_storage[ACQUIRE_FRAME_RING_DEPTH];
+static key_event_t event_storage[ACQUIRE_EVENT_RING_DEPTH];
+static spsc_ring_t frame_ring;
+static spsc_ring_t event_ring;
+
+// Written by core 1 only
+static volatile acquire_stats_t stats;
+static volatile bool scan_max_reset = false;
+
+// Scan power policy, run by core 1; the tier is published for core 0
+static const power_config_t power_config = {
+    .tier = {
+        [POWER_TIER_ACTIVE] = {.interval_us = ADC_SCAN_INTERVAL_US, .slices = 1, .led_brightness = 255},
+        [POWER_TIER_IDLE] = {.interval_us = POWER_IDLE_SCAN_US, .slices = 1, .led_brightness = POWER_IDLE_LED_SCALE},
+        [POWER_TIER_SLEEP] = {.interval_us = POWER_SLEEP_SCAN_US, .slices = POWER_SLEEP_SLICES,
+                              .led_brightness = POWER_SLEEP_LED_SCALE},
+    },
+    .idle_after_ms = POWER_IDLE_AFTER_MS,
+    .sleep_after_ms = POWER_SLEEP_AFTER_MS,
+    .wake_travel = POWER_WAKE_TRAVEL,
+};
+static power_mode_t power;
+static volatile power_tier_t power_tier = POWER_TIER_ACTIVE;
+static volatile bool power_poke = false;
+
+// Frame slot core 0 holds (not yet released to core 1)
+static bool frame_held = false;
+
+// Key calibration handshake: core 0 loads calib_record before launching
+// core 1 (calib_loaded); afterwards core 1 fills it and sets calib_pending,
+// core 0 writes it to flash and clears calib_pending
+static uint8_t calib_record[ADC_CALIB_RECORD_SIZE];
+static bool calib_loaded = false;
+static volatile bool calib_pending = false;
+static volatile int8_t calib_request = 0;   // +1 begin, -1 end
+
+// Apply calibration requests and hand new tables to core 0
+static void service_calibration(void) {
+    static uint32_t last_export_ms = 0;
+
+    int8_t request = calib_request;
+    if (request) {
+        if (request > 0) {
+            adc_begin_calibration();
+        } else {
+            adc_end_calibration();
+            last_export_ms = 0;    // Publish right away
+        }
+        calib_request = 0;
+    }
+
+    if (calib_pending) {
+        return;
+    }
+    uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+    if (last_export_ms != 0 && now_ms - last_export_ms < CALIB_SAVE_INTERVAL_MS) {
+        return;
+    }
+    if (adc_export_calibration(calib_record)) {
+        last_export_ms = now_ms ? now_ms : 1;
+        __dmb();
+        calib_pending = true;
+    }
+}
+
+static void core1_entry(void) {
+    // Let core 0 pause this core while it writes flash
+    flash_safe_execute_core_init();
+
+    if (calib_loaded) {
+        adc_import_calibration(calib_record, sizeof(calib_record));
+    }
+
+    uint8_t last_key_mask = 0;
+    uint32_t seq = 0;
+    absolute_time_t next_scan = get_absolute_time();
+    power_mode_init(&power, NUM_ADC_CHANNELS, NUM_ADC_CHANNELS, &power_config, time_us_32());
+
+    while (true) {
+        // Fixed-rate scan; core 1 has nothing else to do, so at full rate
+        // busy-wait for the deadline instead of depending on core 0's alarm
+        // interrupts. The low-power tiers sleep: jitter does not matter there
+        absolute_time_t scan_at = next_scan;
+        if (power.tier == POWER_TIER_ACTIVE) {
+            busy_wait_until(scan_at);
+        } else {
+            sleep_until(scan_at);
+        }
+        uint32_t scan_start = time_us_32();
+
+        // Each ADC input is its own group: a slice reads a subset of them
+        uint8_t slice = power.slice;
+        uint8_t channel_mask = 0;
+        for (int ch = 0; ch < NUM_ADC_CHANNELS; ch++) {
+            if (power_mode_scan_group(&power, (uint16_t)ch)) {
+                channel_mask |= (uint8_t)(1 << ch);
+            }
+        }
+        uint8_t key_mask = adc_process_channels(channel_mask);
+        uint32_t now = time_us_32();
+
+        uint8_t changed = key_mask ^ last_key_mask;
+        for (int i = 0; changed && i < NUM_ADC_CHANNELS; i++) {
+            if (!(changed & (1 << i))) continue;
+
+            key_event_t event = {
+                .timestamp_us = now,
+                .key = (uint8_t)i,
+                .pressed = (key_mask & (1 << i)) != 0,
+            };
+            if (!spsc_ring_push(&event_ring, &event)) {
+                stats.events_dropped++;
+            }
+        }
+        last_key_mask = key_mask;
+        service_calibration();
+
+        // Choose the next scan's tier; calibration keeps the scan at full rate
+        uint8_t travel[NUM_ADC_CHANNELS];
+        adc_get_travel(travel);
+        if (power_poke || adc_calibrating() || calib_request) {
+            power_poke = false;
+            power_mode_poke(&power, now);
+        }
+        power_mode_update(&power, now, slice, travel, key_mask != 0);
+        if (power_mode_take_change(&power)) {
+            power_tier = power.tier;
+        }
+        if (power.tier == POWER_TIER_ACTIVE && power.wake_pending) {
+            next_scan = get_absolute_time();    // Woken: rescan right away
+        } else {
+            next_scan = delayed_by_us(scan_at, power_mode_tier_config(&power)->interval_us);
+        }
+
+        adc_frame_t *frame = (adc_frame_t *) spsc_ring_write_slot(&frame_ring);
+        if (frame == NULL) {
+            stats.frames_dropped++;
+        } else {
+            frame->seq = ++seq;
+            frame->timestamp_us = now;
+            frame->key_mask = key_mask;
+            adc_get_values(frame->values);
+            adc_get_travel(frame->travel);
+            spsc_ring_commit(&frame_ring);
+            stats.frames_published++;
+        }
+
+        // Wake core 0 for the new frame and key events
+        __sev();
+
+        // Busy time of this pass against ADC_SCAN_INTERVAL_US
+        uint32_t scan_us = time_us_32() - scan_start;
+        if (scan_max_reset) {
+            stats.scan_us_max = 0;
+            scan_max_reset = false;
+        }
+        if (scan_us > stats.scan_us_max) {
+            stats.scan_us_max = scan_us;
+        }
+        stats.scan_us_sum += scan_us;
+        stats.scans++;
+    }
+}
+
+void acquire_launch_core1(void) {
+    calib_loaded = flash_store_load(ADC_CALIB_MAGIC, calib_record, sizeof(calib_record));
+    spsc_ring_init(&frame_ring, frame_storage, sizeof(adc_frame_t), ACQUIRE_FRAME_RING_DEPTH);
+    spsc_ring_init(&event_ring, event_storage, sizeof(key_event_t), ACQUIRE_EVENT_RING_DEPTH);
+    multicore_launch_core1(core1_entry);
+}
+
+const adc_frame_t *acquire_hold_latest_frame(bool *fresh) {
+    uint32_t count = spsc_ring_count(&frame_ring);
+    *fresh = count > (frame_held ? 1u : 0u);
+    if (count == 0) {
+        return NULL;
+    }
+
+    // Skip straight to the newest frame, releasing the held one and any
+    // older ones; the newest stays in its slot
+    while (spsc_ring_count(&frame_ring) > 1) {
+        spsc_ring_release(&frame_ring);
+    }
+    frame_held = true;
+    return (const adc_frame_t *) spsc_ring_read_slot(&frame_ring);
+}
+
+const adc_frame_t *acquire_hold_next_frame(void) {
+    if (spsc_ring_count(&frame_ring) <= (frame_held ? 1u : 0u)) {
+        return NULL;
+    }
+    if (frame_held) {
+        spsc_ring_release(&frame_ring);
+    }
+    frame_held = true;
+    return (const adc_frame_t *) spsc_ring_read_slot(&frame_ring);
+}
+
+bool acquire_pop_event(key_event_t *event) {
+    return spsc_ring_pop(&event_ring, event);
+}
+
+void acquire_request_calibration(bool start) {
+    calib_request = start ? 1 : -1;
+}
+
+bool acquire_calibrating(void) {
+    return calib_request > 0 || adc_calibrating();
+}
+
+bool acquire_save_calibration(void) {
+    if (!calib_pending) {
+        return false;
+    }
+    __dmb();
+    bool ok = flash_store_save(ADC_CALIB_MAGIC, calib_record, sizeof(calib_record));
+    calib_pending = false;
+    return ok;
+}
+
+void acquire_get_stats(acquire_stats_t *out) {
+    out->frames_published = stats.frames_published;
+    out->frames_dropped = stats.frames_dropped;
+    out->events_dropped = stats.events_dropped;
+    out->scans = stats.scans;
+    out->scan_us_sum = stats.scan_us_sum;
+    out->scan_us_max = stats.scan_us_max;
+}
+
+void acquire_reset_scan_max(void) {
+    scan_max_reset = true;
+}
+
+void acquire_power_poke(void) {
+    power_poke = true;
+}
+
+power_tier_t acquire_power_tier(void) {
+    return power_tier;
+}
+
+uint8_t acquire_power_led_scale(void) {
+    return power_config.tier[power_tier].led_brightness;
+}
+
+void acquire_get_power_stats(power_mode_stats_t *out) {
+    *out = power.stats;
+}
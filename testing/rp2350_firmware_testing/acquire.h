@@ -0,0 +1,150 @@
+#ifndef ACQUIRE_H
+#define ACQUIRE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "adc.h"
+#include "power_mode.h"
+
+// Core 1 owns analog acquisition: it scans the ADC at a fixed rate, runs key
+// detection and publishes frames and key events through lock-free SPSC
+// rings. Core 0 services TinyUSB, CDC, LEDs and the encoder, so none of that
+// adds jitter to the scan.
+//
+// Core 1 also runs the scan power policy (../common/power_mode.h): after
+// POWER_IDLE_AFTER_MS without activity it scans every POWER_IDLE_SCAN_US,
+// after POWER_SLEEP_AFTER_MS a slice of the channels every
+// POWER_SLEEP_SCAN_US, sleeping between scans instead of busy-waiting. The
+// first travel change returns it to full rate with no wait.
+
+#ifndef ACQUIRE_FRAME_RING_DEPTH
+#define ACQUIRE_FRAME_RING_DEPTH 8      // Must be a power of two
+#endif
+
+#ifndef ACQUIRE_EVENT_RING_DEPTH
+#define ACQUIRE_EVENT_RING_DEPTH 32     // Must be a power of two
+#endif
+
+// One scan of all ADC channels
+typedef struct {
+    uint32_t seq;
+    uint32_t timestamp_us;
+    uint16_t values[NUM_ADC_CHANNELS];
+    uint8_t travel[NUM_ADC_CHANNELS];   // 0 = rest, 255 = bottom-out
+    uint8_t key_mask;                   // Bit n = key n pressed
+} adc_frame_t;
+
+// One key state change
+typedef struct {
+    uint32_t timestamp_us;
+    uint8_t key;
+    bool pressed;
+} key_event_t;
+
+typedef struct {
+    uint32_t frames_published;
+    uint32_t frames_dropped;    // Frame ring full (core 0 fell behind)
+    uint32_t events_dropped;    // Event ring full
+    uint32_t scans;             // Scan loop passes
+    uint32_t scan_us_sum;       // Core 1 busy time (scan to publish), wraps
+    uint32_t scan_us_max;       // Longest pass since acquire_reset_scan_max()
+} acquire_stats_t;
+
+/**
+ * @brief Initialize the rings and launch the scan loop on core 1
+ *
+ * The ADC must already be initialized. A key calibration table saved in
+ * flash is restored before the first scan.
+ */
+void acquire_launch_core1(void);
+
+/**
+ * @brief Hold the newest published frame in place, discarding older ones
+ *
+ * The frame is not copied: its ring slot stays reserved for core 0 until a
+ * newer frame replaces it on a later call, so the pointer (including the
+ * travel array) stays valid and unchanged until then.
+ *
+ * @param fresh Set to true if the returned frame was not returned before
+ * @return The held frame, or NULL if none was published yet
+ */
+const adc_frame_t *acquire_hold_latest_frame(bool *fresh);
+
+/**
+ * @brief Hold the oldest frame newer than the held one, releasing the held one
+ *
+ * Steps through every published frame in order, for consumers that must
+ * not skip any (binary telemetry). Mixes with acquire_hold_latest_frame():
+ * the frame returned last stays held as it does there.
+ *
+ * @return The held frame, or NULL (nothing held changes) if no newer frame
+ *         was published
+ */
+const adc_frame_t *acquire_hold_next_frame(void);
+
+/**
+ * @brief Take the next key event
+ *
+ * @param event Destination event
+ * @return true if an event was available
+ */
+bool acquire_pop_event(key_event_t *event);
+
+/**
+ * @brief Start or finish explicit key calibration on core 1
+ *
+ * @param start true to begin (keys must be released), false to finish
+ */
+void acquire_request_calibration(bool start);
+
+/**
+ * @brief Check whether explicit calibration is requested or running
+ */
+bool acquire_calibrating(void);
+
+/**
+ * @brief Save the key calibration table to flash if core 1 has a new one
+ *
+ * Call from the core 0 main loop. Core 1 publishes the table when explicit
+ * calibration finishes and, after auto-ranging changed it, at most every
+ * CALIB_SAVE_INTERVAL_MS. Core 1 is paused during the flash write.
+ *
+ * @return true if a table was saved
+ */
+bool acquire_save_calibration(void);
+
+/**
+ * @brief Get acquisition statistics
+ */
+void acquire_get_stats(acquire_stats_t *stats);
+
+/**
+ * @brief Restart the longest-pass measurement (applied by core 1)
+ */
+void acquire_reset_scan_max(void);
+
+/**
+ * @brief Report activity that did not come from the keys (applied by core 1)
+ *
+ * Returns the scan to full rate, e.g. on an encoder turn or a serial command.
+ */
+void acquire_power_poke(void);
+
+/**
+ * @brief Get the current scan power tier
+ */
+power_tier_t acquire_power_tier(void);
+
+/**
+ * @brief Get the LED brightness scale of the current tier, 255 = full
+ */
+uint8_t acquire_power_led_scale(void);
+
+/**
+ * @brief Get the power policy statistics
+ *
+ * Copied while core 1 keeps updating them, so counters can be one scan apart.
+ */
+void acquire_get_power_stats(power_mode_stats_t *stats);
+
+#endif // ACQUIRE_H
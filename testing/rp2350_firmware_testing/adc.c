@@ -1,4 +1,5 @@
 #include "adc.h"
+#include "config.h"
 #include "hardware/adc.h"
 #include "hardware/gpio.h"
 #include "pico/stdlib.h"
@@ -14,6 +15,18 @@ static adc_state_t adc_state;
 static const uint8_t adc_gpio_map[8] = {26, 27, 28, 29, 40, 41, 42, 43};
 
 void adc_init_module(void) {
+    static const key_engine_config_t key_config = {
+        .actuation = ADC_ACTUATION_TRAVEL,
+        .release = ADC_RELEASE_TRAVEL,
+        .rt_down = ADC_RAPID_TRIGGER_TRAVEL,
+        .rt_up = ADC_RAPID_TRIGGER_TRAVEL,
+    };
+    static const sample_filter_config_t filter_config = {
+        .weight = ADC_FILTER_WEIGHT,
+        .deadband = ADC_FILTER_DEADBAND,
+        .full_speed = ADC_FILTER_FULL_SPEED,
+    };
+
     // Initialize ADC hardware
     adc_init();
     
@@ -22,81 +35,84 @@ void adc_init_module(void) {
         adc_gpio_init(adc_gpio_map[i]);
     }
     
-    // Clear state
+    // Clear state; rest comes from flash or the first scan
     memset(&adc_state, 0, sizeof(adc_state_t));
+    key_calib_init(&adc_state.calib, NUM_ADC_CHANNELS, 0);
+    sample_filter_init(&adc_state.filter, NUM_ADC_CHANNELS, ADC_FILTER_MEDIAN_LEN, &filter_config);
+    key_engine_init(&adc_state.keys, NUM_ADC_CHANNELS, &key_config);
+}
+
+bool adc_import_calibration(const uint8_t *record, size_t len) {
+    return key_calib_import(&adc_state.calib, record, len);
+}
+
+size_t adc_export_calibration(uint8_t *record) {
+    if (!adc_state.calib.dirty || adc_state.calib.capture) {
+        return 0;
+    }
+    return key_calib_export(&adc_state.calib, record, ADC_CALIB_RECORD_SIZE);
+}
+
+void adc_begin_calibration(void) {
+    key_calib_begin_capture(&adc_state.calib);
+}
+
+void adc_end_calibration(void) {
+    key_calib_end_capture(&adc_state.calib);
 }
 
-void adc_calibrate(void) {
-    const int samples = 100;
-    uint32_t accumulator[NUM_ADC_CHANNELS] = {0};
+bool adc_calibrating(void) {
+    return adc_state.calib.capture;
+}
+
+uint8_t adc_process(void) {
+    return adc_process_channels(0xFF);
+}
+
+uint8_t adc_process_channels(uint8_t channel_mask) {
+    uint16_t travel[NUM_ADC_CHANNELS];
     
-    // Take multiple samples and average for all 8 channels
-    for (int sample = 0; sample < samples; sample++) {
-        for (int ch = 0; ch < NUM_ADC_CHANNELS; ch++) {
+    // Read the channels back to back; the sample filter takes care of noise
+    // instead of settle delays and repeated reads
+    for (int ch = 0; ch < NUM_ADC_CHANNELS; ch++) {
+        if (channel_mask & (1 << ch)) {
             adc_select_input(ch);
-            sleep_us(10); // Allow ADC to settle
-            accumulator[ch] += adc_read();
+            adc_state.raw[ch] = adc_read();
         }
-        sleep_ms(1);
     }
-    
-    // Calculate baseline and thresholds for all 8 channels
+    sample_filter_process(&adc_state.filter, adc_state.raw, adc_state.current);
+
+    key_calib_process(&adc_state.calib, adc_state.current, travel);
+    if (adc_state.calib.capture) {
+        // Keys stay released while they are being pressed for calibration
+        memset(travel, 0, sizeof(travel));
+    }
+    key_engine_process(&adc_state.keys, travel, NULL);
     for (int ch = 0; ch < NUM_ADC_CHANNELS; ch++) {
-        adc_state.baseline[ch] = accumulator[ch] / samples;
-        
-        // Calculate threshold values (10% deviation)
-        float baseline_float = (float)adc_state.baseline[ch];
-        float deviation = baseline_float * ADC_DEVIATION_THRESHOLD;
-        
-        adc_state.threshold_low[ch] = baseline_float - deviation;
-        adc_state.threshold_high[ch] = baseline_float + deviation;
-        
-        adc_state.key_pressed[ch] = false;
+        adc_state.travel[ch] = travel[ch] > 255 ? 255 : (uint8_t)travel[ch];
     }
-}
 
-uint8_t adc_process(void) {
     uint8_t key_mask = 0;
-    uint16_t current_value;
-    
-    // Process all 8 ADC channels on RP2350B
     for (int ch = 0; ch < NUM_ADC_CHANNELS; ch++) {
-        adc_select_input(ch);
-        sleep_us(10); // Allow ADC to settle
-        current_value = adc_read();
-        
-        // Check if value has deviated by more than threshold
-        bool is_deviated = (current_value < adc_state.threshold_low[ch]) || 
-                          (current_value > adc_state.threshold_high[ch]);
-        
-        // Update key state with basic debouncing
-        if (is_deviated && !adc_state.key_pressed[ch]) {
-            adc_state.key_pressed[ch] = true;
-            key_mask |= (1 << ch);
-        } else if (!is_deviated && adc_state.key_pressed[ch]) {
-            adc_state.key_pressed[ch] = false;
-        }
-        
-        // Add current state to mask (for key hold)
-        if (adc_state.key_pressed[ch]) {
+        if (key_engine_is_pressed(&adc_state.keys, (uint16_t)ch)) {
             key_mask |= (1 << ch);
         }
     }
-    
     return key_mask;
 }
 
 void adc_get_values(uint16_t *values) {
-    // Read all 8 ADC channels on RP2350B
     for (int ch = 0; ch < NUM_ADC_CHANNELS; ch++) {
-        adc_select_input(ch);
-        sleep_us(10);
-        values[ch] = adc_read();
+        values[ch] = adc_state.current[ch];
     }
 }
 
+void adc_get_travel(uint8_t *travel) {
+    memcpy(travel, adc_state.travel, sizeof(adc_state.travel));
+}
+
 void adc_get_baseline(uint16_t *values) {
     for (int ch = 0; ch < NUM_ADC_CHANNELS; ch++) {
-        values[ch] = adc_state.baseline[ch];
+        values[ch] = adc_state.calib.rest[ch];
     }
 }
@@ -3,6 +3,10 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include "key_engine.h"
+#include "key_calib.h"
+#include "sample_filter.h"
 
 // ADC channel definitions for RP2350B
 // The RP2350B has 8 ADC channels:
@@ -13,13 +17,17 @@
 #define NUM_ADC_CHANNELS 8
 #endif
 
-#define ADC_DEVIATION_THRESHOLD 0.10f  // 10% deviation threshold
+// Record tag and size of the calibration table persisted in flash
+#define ADC_CALIB_MAGIC 0x4143414Cu   // "ACAL"
+#define ADC_CALIB_RECORD_SIZE KEY_CALIB_RECORD_SIZE(NUM_ADC_CHANNELS)
 
 typedef struct {
-    uint16_t baseline[NUM_ADC_CHANNELS];  // Calibrated baseline values
-    bool key_pressed[NUM_ADC_CHANNELS];   // Current key state
-    float threshold_low[NUM_ADC_CHANNELS]; // Lower threshold
-    float threshold_high[NUM_ADC_CHANNELS]; // Upper threshold
+    uint16_t raw[NUM_ADC_CHANNELS];       // Last reading of each channel
+    uint16_t current[NUM_ADC_CHANNELS];   // Filtered values from the last adc_process()
+    uint8_t travel[NUM_ADC_CHANNELS];     // Travel 0-255 from the last adc_process()
+    sample_filter_t filter;               // Median + adaptive EMA per channel
+    key_calib_t calib;                    // Rest / bottom-out per key -> 0-255 travel
+    key_engine_t keys;                    // Actuation/release/rapid trigger per key
 } adc_state_t;
 
 /**
@@ -30,32 +38,80 @@ typedef struct {
 void adc_init_module(void);
 
 /**
- * @brief Calibrate ADC baseline values
+ * @brief Restore a calibration table saved by adc_export_calibration()
  * 
- * Reads all ADC channels multiple times and establishes baseline values
- * Should be called at startup when no keys are pressed
+ * Without one, the first adc_process() takes the current readings as rest,
+ * so no keys should be held at power-up.
+ * 
+ * @return false if the record does not match this keyboard
  */
-void adc_calibrate(void);
+bool adc_import_calibration(const uint8_t *record, size_t len);
+
+/**
+ * @brief Serialize the calibration table if it changed since the last export
+ * 
+ * @param record Buffer of ADC_CALIB_RECORD_SIZE bytes
+ * @return Bytes written, 0 if nothing changed
+ */
+size_t adc_export_calibration(uint8_t *record);
+
+/**
+ * @brief Start explicit calibration (keys at rest now, then press each fully)
+ * 
+ * Keys report released until adc_end_calibration().
+ */
+void adc_begin_calibration(void);
+
+/**
+ * @brief End explicit calibration; the new table is ready to export
+ */
+void adc_end_calibration(void);
+
+/**
+ * @brief Check whether explicit calibration is running
+ */
+bool adc_calibrating(void);
 
 /**
  * @brief Process ADC readings and detect key presses
  * 
- * Reads all ADC channels, compares against baseline with threshold,
- * and returns a bitmask of pressed keys
+ * Reads all ADC channels, maps them to 0-255 travel with the per-key
+ * calibration and runs the key engine on it (actuation, release and rapid
+ * trigger points in config.h), returning a bitmask of pressed keys
  * 
  * @return uint8_t Bitmask of pressed keys (bit 0 = key 0, bit 7 = key 7)
  */
 uint8_t adc_process(void);
 
 /**
- * @brief Get current ADC values for all channels
+ * @brief Process ADC readings, reading only some of the channels
+ * 
+ * Like adc_process(), but channels outside the mask are not converted and
+ * keep their last reading, for the sparse low-power scans.
+ * 
+ * @param channel_mask Channels to read (bit n = ADC n)
+ * @return uint8_t Bitmask of pressed keys
+ */
+uint8_t adc_process_channels(uint8_t channel_mask);
+
+/**
+ * @brief Get the ADC values read by the last adc_process()
+ * 
+ * Does not touch the ADC, so it never disturbs an ongoing scan.
  * 
  * @param values Array of 8 uint16_t to store current ADC readings
  */
 void adc_get_values(uint16_t *values);
 
 /**
- * @brief Get baseline values for all channels
+ * @brief Get the key travel computed by the last adc_process()
+ * 
+ * @param travel Array of 8 uint8_t, 0 = rest, 255 = bottom-out
+ */
+void adc_get_travel(uint8_t *travel);
+
+/**
+ * @brief Get baseline (calibrated rest) values for all channels
  * 
  * @param values Array of 8 uint16_t to store baseline readings
  */
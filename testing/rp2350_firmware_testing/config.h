@@ -7,8 +7,18 @@
 
 // ADC Configuration (RP2350B has 8 ADC channels!)
 #define ADC_NUM_CHANNELS        8
-#define ADC_CALIBRATION_SAMPLES 100
-#define ADC_DEVIATION_PERCENT   10      // 10% deviation triggers key press
+// Key thresholds in calibrated travel, 0 = rest to 255 = bottom-out. Until a
+// key has been pressed deep enough to learn its range, 255 = 800 counts
+// (64 ~ the old 10% of a mid-scale baseline).
+#define ADC_ACTUATION_TRAVEL    64      // Key presses at this travel
+#define ADC_RELEASE_TRAVEL      52      // Key releases below this travel
+#define ADC_RAPID_TRIGGER_TRAVEL 13     // Rapid trigger distance (0 = off)
+// Sample filter (../common/sample_filter.h): median of 3 scans, then an
+// EMA of weight 16/256 that opens up for deviations beyond 12 counts
+#define ADC_FILTER_MEDIAN_LEN   3       // 1 (off), 3 or 5
+#define ADC_FILTER_WEIGHT       16      // 1-256, 256 = no smoothing
+#define ADC_FILTER_DEADBAND     12
+#define ADC_FILTER_FULL_SPEED   64      // 0 = plain EMA
 
 // ADC GPIO Pins (RP2350B has ADC0-7)
 #define ADC_GPIO_0              26      // ADC0
@@ -63,10 +73,28 @@
 // TIMING CONFIGURATION
 // ============================================================================
 
-#define MAIN_LOOP_DELAY_MS      1       // Main loop iteration delay
-#define CALIBRATION_DELAY_MS    500     // Delay before calibration starts
+#define MAIN_LOOP_DELAY_MS      1       // Longest core 0 sleep between loop passes
+#define ADC_SCAN_INTERVAL_US    1000    // Key scan period on core 1
+#define CALIB_SAVE_INTERVAL_MS  (5 * 60 * 1000) // Min time between auto-range saves
 #define ENCODER_DEBOUNCE_MS     5       // Encoder button debounce time
 
+// ============================================================================
+// POWER CONFIGURATION
+// ============================================================================
+
+// Scan power tiers (../common/power_mode.h). The 8 ADC inputs are read back
+// to back with no settle delay or oversampling to cut, so the low-power
+// tiers scan less often and, asleep, read 2 of the 8 channels per scan.
+// The first travel change wakes the scan back to full rate.
+#define POWER_IDLE_AFTER_MS     5000    // No activity: dim LEDs, scan slower
+#define POWER_SLEEP_AFTER_MS    60000   // No activity: LEDs off, sparse scan
+#define POWER_IDLE_SCAN_US      5000    // Scan period when idle
+#define POWER_SLEEP_SCAN_US     10000   // Scan period when asleep
+#define POWER_SLEEP_SLICES      4       // Scans to cover every channel asleep
+#define POWER_IDLE_LED_SCALE    64      // LED brightness scale, 255 = full
+#define POWER_SLEEP_LED_SCALE   0
+#define POWER_WAKE_TRAVEL       8       // Travel change (0-255) that wakes
+
 // ============================================================================
 // FEATURE ENABLES
 // ============================================================================
@@ -1,11 +1,19 @@
 #include "encoder.h"
+#include "quadrature.h"
 #include "hardware/gpio.h"
+#include "hardware/irq.h"
 #include "pico/stdlib.h"
 
-// Encoder state
+// Rotation is decoded in the GPIO interrupt; the main loop only reads
+// detent_count, a 32-bit word written by the interrupt alone, so the read is
+// atomic and no edge depends on the loop's timing
+static quad_decoder_t decoder;
+static volatile int32_t detent_count;
+static int32_t detents_taken;
+static quad_accel_t accel;
+
+// Button state
 static struct {
-    uint8_t last_clk;
-    uint8_t last_dt;
     bool button_pressed;
     bool button_last_state;
     uint32_t last_button_time;
@@ -14,6 +22,24 @@ static struct {
 // Debounce time in milliseconds
 #define DEBOUNCE_MS 5
 
+// Line state for the decoder: DT is A, CLK is B, so a clockwise turn
+// (CLK falling while DT is high) counts up
+static inline uint8_t read_lines(void) {
+    uint32_t pins = gpio_get_all();
+    return (uint8_t)((((pins >> ENCODER_DT_PIN) & 1u) << 1) | ((pins >> ENCODER_CLK_PIN) & 1u));
+}
+
+static void encoder_irq_handler(void) {
+    // Both lines are read after acknowledging, so an edge that lands
+    // during the handler raises the interrupt again instead of being lost
+    gpio_acknowledge_irq(ENCODER_CLK_PIN, gpio_get_irq_event_mask(ENCODER_CLK_PIN));
+    gpio_acknowledge_irq(ENCODER_DT_PIN, gpio_get_irq_event_mask(ENCODER_DT_PIN));
+
+    if (quad_decoder_update(&decoder, read_lines())) {
+        detent_count = decoder.detents;
+    }
+}
+
 void encoder_init(void) {
     // Initialize CLK pin
     gpio_init(ENCODER_CLK_PIN);
@@ -30,38 +56,36 @@ void encoder_init(void) {
     gpio_set_dir(ENCODER_SW_PIN, GPIO_IN);
     gpio_pull_up(ENCODER_SW_PIN);
     
-    // Read initial states
-    encoder_state.last_clk = gpio_get(ENCODER_CLK_PIN);
-    encoder_state.last_dt = gpio_get(ENCODER_DT_PIN);
+    // Decode rotation on every edge of either line
+    quad_decoder_init(&decoder, read_lines());
+    detent_count = 0;
+    detents_taken = 0;
+    quad_accel_init(&accel);
+    gpio_add_raw_irq_handler_masked((1u << ENCODER_CLK_PIN) | (1u << ENCODER_DT_PIN), encoder_irq_handler);
+    gpio_set_irq_enabled(ENCODER_CLK_PIN, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true);
+    gpio_set_irq_enabled(ENCODER_DT_PIN, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true);
+    irq_set_enabled(IO_IRQ_BANK0, true);
+
+    // Read initial button state
     encoder_state.button_pressed = false;
     encoder_state.button_last_state = gpio_get(ENCODER_SW_PIN);
     encoder_state.last_button_time = 0;
 }
 
+int32_t encoder_take_steps(void) {
+    int32_t count = detent_count;
+    int32_t detents = count - detents_taken;
+    detents_taken = count;
+    return quad_accel_steps(&accel, detents, time_us_32());
+}
+
+uint32_t encoder_errors(void) {
+    return decoder.errors;
+}
+
 encoder_event_t encoder_process(void) {
     encoder_event_t event = ENCODER_EVENT_NONE;
     
-    // Read current states
-    uint8_t clk = gpio_get(ENCODER_CLK_PIN);
-    uint8_t dt = gpio_get(ENCODER_DT_PIN);
-    
-    // Detect rotation
-    // Standard rotary encoder logic: CLK changes while DT stable indicates direction
-    if (clk != encoder_state.last_clk) {
-        if (clk == 0) { // CLK went low (falling edge)
-            if (dt == 1) {
-                // DT is high when CLK falls = clockwise
-                event = ENCODER_EVENT_CW;
-            } else {
-                // DT is low when CLK falls = counter-clockwise
-                event = ENCODER_EVENT_CCW;
-            }
-        }
-    }
-    
-    encoder_state.last_clk = clk;
-    encoder_state.last_dt = dt;
-    
     // Check button state with debouncing
     uint8_t button_state = !gpio_get(ENCODER_SW_PIN); // Active low, so invert
     uint32_t now = to_ms_since_boot(get_absolute_time());
@@ -74,15 +98,11 @@ encoder_event_t encoder_process(void) {
             if (button_state && !encoder_state.button_pressed) {
                 // Button pressed
                 encoder_state.button_pressed = true;
-                if (event == ENCODER_EVENT_NONE) {
-                    event = ENCODER_EVENT_PRESS;
-                }
+                event = ENCODER_EVENT_PRESS;
             } else if (!button_state && encoder_state.button_pressed) {
                 // Button released
                 encoder_state.button_pressed = false;
-                if (event == ENCODER_EVENT_NONE) {
-                    event = ENCODER_EVENT_RELEASE;
-                }
+                event = ENCODER_EVENT_RELEASE;
             }
         }
     }
@@ -9,11 +9,9 @@
 #define ENCODER_DT_PIN  21
 #define ENCODER_SW_PIN  20
 
-// Encoder events
+// Button events (rotation is counted separately, see encoder_take_steps())
 typedef enum {
     ENCODER_EVENT_NONE = 0,
-    ENCODER_EVENT_CW,        // Clockwise rotation (volume up)
-    ENCODER_EVENT_CCW,       // Counter-clockwise rotation (volume down)
     ENCODER_EVENT_PRESS,     // Button press (mute)
     ENCODER_EVENT_RELEASE    // Button release
 } encoder_event_t;
@@ -21,16 +19,32 @@ typedef enum {
 /**
  * @brief Initialize the rotary encoder
  * 
- * Sets up GPIO pins and interrupts for the encoder
+ * Sets up GPIO pins and the edge interrupt that decodes rotation
+ * (../common/quadrature.c), so no step is lost while the main loop is busy
  */
 void encoder_init(void);
 
 /**
- * @brief Process encoder state and return events
+ * @brief Take the rotation since the last call as volume steps
+ * 
+ * Detents are counted in the GPIO interrupt; this reads the count and
+ * multiplies fast turns (QUAD_ACCEL_* in quadrature.h).
+ * 
+ * @return Signed steps, positive = clockwise (volume up)
+ */
+int32_t encoder_take_steps(void);
+
+/**
+ * @brief Number of edges where both lines changed at once (missed edges)
+ */
+uint32_t encoder_errors(void);
+
+/**
+ * @brief Debounce the button and return press/release events
  * 
  * Should be called regularly from main loop
  * 
- * @return encoder_event_t The detected encoder event
+ * @return encoder_event_t The detected button event
  */
 encoder_event_t encoder_process(void);
 
@@ -1,5 +1,7 @@
 #include "led.h"
 #include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
 #include "hardware/clocks.h"
 #include "pico/stdlib.h"
 #include <string.h>
@@ -7,13 +9,26 @@
 // WS2812 timing (in nanoseconds at 800kHz)
 // T0H: 350ns, T0L: 800ns
 // T1H: 700ns, T1L: 600ns
-// Reset: >50us low
+// Reset: >50us low (>280us on WS2812B V5), see LED_RESET_US
 
 static rgb_t led_buffer[LED_COUNT];
 static PIO pio;
 static uint sm;
 static uint offset;
 
+// Frame being sent: one word per pixel, GRB in the top 24 bits. Only
+// written while no frame is in flight.
+static uint32_t frame_words[LED_COUNT];
+static int dma_chan;
+static bool dirty;                      // led_buffer differs from the strip
+static volatile bool busy;              // DMA or reset time in progress
+static uint32_t last_frame_us;
+static uint8_t power_scale = 255;       // Applied when a frame is packed
+static led_stats_t stats;
+
+static rgb_matrix_t matrix;
+static uint8_t effect;
+
 // PIO program for WS2812
 // Based on the standard WS2812 PIO example from Raspberry Pi Pico examples
 static const uint16_t ws2812_program_instructions[] = {
@@ -31,14 +46,35 @@ static const struct pio_program ws2812_program = {
     .origin = -1,
 };
 
-static inline void put_pixel(uint32_t pixel_grb) {
-    pio_sm_put_blocking(pio, sm, pixel_grb << 8u);
-}
-
 static inline uint32_t urgb_u32(uint8_t r, uint8_t g, uint8_t b) {
     return ((uint32_t)(g) << 16) | ((uint32_t)(r) << 8) | (uint32_t)(b);
 }
 
+static inline uint8_t scale8(uint8_t value, uint8_t scale) {
+    return (uint8_t)(((uint16_t)value * (scale + 1)) >> 8);
+}
+
+// Reset time over: the strip has latched the frame
+static int64_t reset_done_callback(alarm_id_t id, void *user_data) {
+    (void)id;
+    (void)user_data;
+    busy = false;
+    return 0;
+}
+
+static void led_dma_irq_handler(void) {
+    if (!dma_channel_get_irq0_status(dma_chan)) {
+        return;
+    }
+    dma_channel_acknowledge_irq0(dma_chan);
+
+    // The last pixels are still in the PIO FIFO; hold the line low for the
+    // drain plus the latch time before the next frame may start
+    if (add_alarm_in_us(LED_RESET_US, reset_done_callback, NULL, true) < 0) {
+        busy = false;   // No alarm slot: the next frame is LED_FRAME_INTERVAL_US away anyway
+    }
+}
+
 void led_init(void) {
     // Use PIO0
     pio = pio0;
@@ -75,28 +111,85 @@ void led_init(void) {
     // Enable state machine
     pio_sm_set_enabled(pio, sm, true);
     
-    // Clear LED buffer
+    // DMA feeds the state machine one pixel word per TX request
+    dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config dc = dma_channel_get_default_config(dma_chan);
+    channel_config_set_transfer_data_size(&dc, DMA_SIZE_32);
+    channel_config_set_read_increment(&dc, true);
+    channel_config_set_write_increment(&dc, false);
+    channel_config_set_dreq(&dc, pio_get_dreq(pio, sm, true));
+    dma_channel_configure(dma_chan, &dc, &pio->txf[sm], frame_words, LED_COUNT, false);
+    dma_channel_set_irq0_enabled(dma_chan, true);
+    irq_add_shared_handler(DMA_IRQ_0, led_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+    
+    rgb_matrix_init(&matrix, LED_COUNT);
+    rgb_matrix_set_color(&matrix, 85, 255);     // Green
+    rgb_matrix_set_brightness(&matrix, LED_EFFECT_BRIGHTNESS);
+    led_set_effect(LED_EFFECT_DEFAULT);
+    
+    // Clear LED buffer; the first frame is always sent
     memset(led_buffer, 0, sizeof(led_buffer));
+    memset(&stats, 0, sizeof(stats));
+    busy = false;
+    dirty = true;
+    last_frame_us = time_us_32() - LED_FRAME_INTERVAL_US;
     led_update();
 }
 
+static inline bool rgb_equal(rgb_t a, rgb_t b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
 void led_set_color(uint8_t index, rgb_t color) {
-    if (index < LED_COUNT) {
+    if (index < LED_COUNT && !rgb_equal(led_buffer[index], color)) {
         led_buffer[index] = color;
+        dirty = true;
     }
 }
 
 void led_set_all(rgb_t color) {
     for (int i = 0; i < LED_COUNT; i++) {
-        led_buffer[i] = color;
+        led_set_color(i, color);
     }
 }
 
 void led_update(void) {
+    if (!dirty || busy) {
+        return;
+    }
+    uint32_t start_us = time_us_32();
+    if (start_us - last_frame_us < LED_FRAME_INTERVAL_US) {
+        return;
+    }
+    
     for (int i = 0; i < LED_COUNT; i++) {
-        put_pixel(urgb_u32(led_buffer[i].r, led_buffer[i].g, led_buffer[i].b));
+        frame_words[i] = urgb_u32(scale8(led_buffer[i].r, power_scale), scale8(led_buffer[i].g, power_scale),
+                                  scale8(led_buffer[i].b, power_scale)) << 8u;
+    }
+    dirty = false;
+    busy = true;
+    last_frame_us = start_us;
+    dma_channel_transfer_from_buffer_now(dma_chan, frame_words, LED_COUNT);
+    
+    uint32_t cpu_us = time_us_32() - start_us;
+    stats.frames++;
+    stats.cpu_us_sum += cpu_us;
+    if (cpu_us > stats.cpu_us_max) {
+        stats.cpu_us_max = cpu_us;
+    }
+}
+
+void led_set_power_scale(uint8_t scale) {
+    if (scale != power_scale) {
+        power_scale = scale;
+        dirty = true;
     }
-    sleep_us(100); // Reset time
+}
+
+void led_take_stats(led_stats_t *out) {
+    *out = stats;
+    memset(&stats, 0, sizeof(stats));
 }
 
 void led_clear(void) {
@@ -105,22 +198,48 @@ void led_clear(void) {
     led_update();
 }
 
-void led_update_keys(uint8_t key_mask) {
-    // Light up LEDs corresponding to pressed keys
-    for (int i = 0; i < LED_COUNT; i++) {
-        if (key_mask & (1 << i)) {
-            // Key pressed - set to color (e.g., green)
-            led_buffer[i].r = 0;
-            led_buffer[i].g = 50;
-            led_buffer[i].b = 0;
-        } else {
-            // Key released - dim or off
-            led_buffer[i].r = 5;
-            led_buffer[i].g = 0;
-            led_buffer[i].b = 5;
+void led_set_travel(const uint8_t *travel) {
+    rgb_matrix_set_travel(&matrix, travel);
+}
+
+void led_set_effect(uint8_t new_effect) {
+    if (new_effect != LED_EFFECT_MANUAL && new_effect >= RGB_EFFECT_COUNT) {
+        return;
+    }
+    effect = new_effect;
+    if (effect != LED_EFFECT_MANUAL) {
+        rgb_matrix_set_effect(&matrix, effect);
+    }
+}
+
+uint8_t led_get_effect(void) {
+    return effect;
+}
+
+void led_effect_task(void) {
+    if (effect == LED_EFFECT_MANUAL || power_scale == 0) {
+        return;
+    }
+    uint32_t start_us = time_us_32();
+    
+    // Start a frame only when the strip has taken the last one and is due
+    // for the next
+    if (matrix.next_led == 0 &&
+        (dirty || start_us - last_frame_us < LED_FRAME_INTERVAL_US)) {
+        return;
+    }
+    
+    if (rgb_matrix_task(&matrix, start_us / 1000)) {
+        for (int i = 0; i < LED_COUNT; i++) {
+            rgb_t color = {matrix.rgb[i].r, matrix.rgb[i].g, matrix.rgb[i].b};
+            led_set_color(i, color);
         }
     }
-    led_update();
+    
+    uint32_t render_us = time_us_32() - start_us;
+    if (render_us > stats.render_us_max) {
+        stats.render_us_max = render_us;
+    }
 }
 
 void led_process_via_command(uint8_t* data, uint16_t length) {
@@ -144,6 +263,7 @@ void led_process_via_command(uint8_t* data, uint16_t length) {
                 case 0x00: // Set all LEDs
                     if (length >= 5) {
                         rgb_t color = {data[2], data[3], data[4]};
+                        led_set_effect(LED_EFFECT_MANUAL);
                         led_set_all(color);
                         led_update();
                     }
@@ -152,10 +272,31 @@ void led_process_via_command(uint8_t* data, uint16_t length) {
                     if (length >= 6) {
                         uint8_t index = data[2];
                         rgb_t color = {data[3], data[4], data[5]};
+                        led_set_effect(LED_EFFECT_MANUAL);
                         led_set_color(index, color);
                         led_update();
                     }
                     break;
+                case 0x02: // Select effect
+                    if (length >= 3) {
+                        led_set_effect(data[2]);
+                    }
+                    break;
+                case 0x03: // Effect brightness
+                    if (length >= 3) {
+                        rgb_matrix_set_brightness(&matrix, data[2]);
+                    }
+                    break;
+                case 0x04: // Effect hue / saturation
+                    if (length >= 4) {
+                        rgb_matrix_set_color(&matrix, data[2], data[3]);
+                    }
+                    break;
+                case 0x05: // Effect speed
+                    if (length >= 3) {
+                        rgb_matrix_set_speed(&matrix, data[2]);
+                    }
+                    break;
                 default:
                     break;
             }
@@ -168,5 +309,4 @@ void led_process_via_command(uint8_t* data, uint16_t length) {
     // 1. Raw HID endpoint in USB descriptors
     // 2. Proper protocol parsing
     // 3. EEPROM storage for settings
-    // 4. RGB matrix effects library
 }
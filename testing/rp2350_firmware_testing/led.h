@@ -3,10 +3,32 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "rgb_matrix.h"
 
 #define LED_PIN 28
 #define LED_COUNT 8
 
+// Frames are sent by DMA at most this often; changes in between are merged
+#ifndef LED_FRAME_INTERVAL_US
+#define LED_FRAME_INTERVAL_US 10000     // 100 fps
+#endif
+
+// Line held low after the DMA finishes: drains the PIO FIFO (4 pixels +
+// the one being shifted, ~150 us) plus the >= 280 us WS2812B latch time
+#ifndef LED_RESET_US
+#define LED_RESET_US 450
+#endif
+
+// Effects (../common/rgb_matrix.c); the 8 LEDs take the positions of the
+// first 8 keys of the Seung65 layout
+#ifndef LED_EFFECT_DEFAULT
+#define LED_EFFECT_DEFAULT RGB_EFFECT_TRAVEL
+#endif
+#ifndef LED_EFFECT_BRIGHTNESS
+#define LED_EFFECT_BRIGHTNESS 128
+#endif
+#define LED_EFFECT_MANUAL 0xFF          // Colors set directly, no effect
+
 // RGB color structure
 typedef struct {
     uint8_t r;
@@ -14,10 +36,19 @@ typedef struct {
     uint8_t b;
 } rgb_t;
 
+// Per-frame CPU cost of the LED output (time spent in led_update() sending
+// a frame; the transfer itself runs on DMA)
+typedef struct {
+    uint32_t frames;                // Frames sent
+    uint32_t cpu_us_sum;
+    uint32_t cpu_us_max;
+    uint32_t render_us_max;         // Longest led_effect_task() call
+} led_stats_t;
+
 /**
  * @brief Initialize WS2812 LED control
  * 
- * Sets up PIO for WS2812 control
+ * Sets up PIO for WS2812 control and a DMA channel to feed it
  */
 void led_init(void);
 
@@ -37,9 +68,11 @@ void led_set_color(uint8_t index, rgb_t color);
 void led_set_all(rgb_t color);
 
 /**
- * @brief Update LED strip (send data to LEDs)
+ * @brief Send the colors to the strip if they changed (never blocks)
  * 
- * Must be called after setting colors to actually update the LEDs
+ * Starts a DMA frame when colors changed since the last frame, the previous
+ * frame and its reset time are over, and LED_FRAME_INTERVAL_US has passed.
+ * Otherwise the change stays pending, so call this every main-loop pass.
  */
 void led_update(void);
 
@@ -49,11 +82,50 @@ void led_update(void);
 void led_clear(void);
 
 /**
- * @brief Set LED based on key state
+ * @brief Point the reactive effects at the keys' travel
+ * 
+ * The array (one 0-255 value per LED) is read in place while effect frames
+ * render, typically the travel of the frame held from the acquisition ring,
+ * so it must stay valid until replaced.
+ * 
+ * @param travel Travel per key, or NULL for none
+ */
+void led_set_travel(const uint8_t *travel);
+
+/**
+ * @brief Select an effect (RGB_EFFECT_*) or LED_EFFECT_MANUAL
+ */
+void led_set_effect(uint8_t effect);
+
+/**
+ * @brief Get the selected effect
+ */
+uint8_t led_get_effect(void);
+
+/**
+ * @brief Render the next slice of the effect frame
+ * 
+ * A new frame is started only when the strip can take it, so effects run
+ * at the LED frame rate however often this is called. Each call renders at
+ * most RGB_MATRIX_LEDS_PER_TICK LEDs; a finished frame goes to the LED
+ * buffer for led_update().
+ */
+void led_effect_task(void);
+
+/**
+ * @brief Scale the brightness of everything sent to the strip
+ * 
+ * Used by the scan power tiers to dim the LEDs. At 0 the strip is sent
+ * dark once and effects stop rendering until the scale goes back up.
  * 
- * @param key_mask Bitmask of pressed keys
+ * @param scale 0 = off, 255 = as set
+ */
+void led_set_power_scale(uint8_t scale);
+
+/**
+ * @brief Copy and clear the per-frame CPU-time statistics
  */
-void led_update_keys(uint8_t key_mask);
+void led_take_stats(led_stats_t *stats);
 
 /**
  * @brief Process VIA/SignalRGB commands (placeholder for future implementation)
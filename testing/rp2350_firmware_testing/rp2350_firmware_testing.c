@@ -6,6 +6,65 @@
 #include "usb.h"
 #include "led.h"
 #include "serial.h"
+#include "acquire.h"
+
+static void serial_line(void *ctx, const char *line) {
+    (void)ctx;
+    serial_printf("%s\r\n", line);
+}
+
+// Print and clear the scan-to-report latency histogram
+static void print_report_latency(void) {
+    latency_hist_t h;
+    usb_take_report_latency(&h);
+    latency_hist_print(&h, serial_line, NULL);
+}
+
+// Print (and restart) the core 1 scan budget and the core 0 LED cost
+static void print_cpu_budget(void) {
+    static acquire_stats_t last;
+    acquire_stats_t acq;
+    acquire_get_stats(&acq);
+    acquire_reset_scan_max();
+
+    uint32_t scans = acq.scans - last.scans;
+    uint32_t busy_us = acq.scan_us_sum - last.scan_us_sum;
+    last = acq;
+    if (scans) {
+        // Busy share of the scan period in 0.1 %
+        uint32_t permille = (uint32_t)(((uint64_t)busy_us * 1000) / ((uint64_t)scans * ADC_SCAN_INTERVAL_US));
+        serial_printf("SCAN %lu passes, avg %lu us, max %lu us of %d us (%lu.%lu%% busy)\r\n",
+                      (unsigned long)scans, (unsigned long)(busy_us / scans),
+                      (unsigned long)acq.scan_us_max, ADC_SCAN_INTERVAL_US,
+                      (unsigned long)(permille / 10), (unsigned long)(permille % 10));
+    }
+
+    led_stats_t led_stats;
+    led_take_stats(&led_stats);
+    serial_printf("LED frames %lu, cpu avg %lu us, max %lu us, effect render max %lu us\r\n",
+                  (unsigned long)led_stats.frames,
+                  (unsigned long)(led_stats.frames ? led_stats.cpu_us_sum / led_stats.frames : 0),
+                  (unsigned long)led_stats.cpu_us_max, (unsigned long)led_stats.render_us_max);
+}
+
+// Print the scan power tier, scans per tier and the wake latency
+static void print_power_stats(void) {
+    static const char *const names[POWER_TIER_COUNT] = {"ACTIVE", "IDLE", "SLEEP"};
+    power_mode_stats_t ps;
+    acquire_get_power_stats(&ps);
+
+    serial_printf("POWER %s, wakes %lu\r\n", names[acquire_power_tier()], (unsigned long)ps.wakes);
+    for (int t = 0; t < POWER_TIER_COUNT; t++) {
+        serial_printf("TIER %s: entered %lu, scans %lu\r\n", names[t],
+                      (unsigned long)ps.entered[t], (unsigned long)ps.scans[t]);
+    }
+    const latency_hist_t *h = &ps.wake_latency;
+    if (h->count) {
+        serial_printf("WAKE %lu: min %lu us, avg %lu us, max %lu us\r\n", (unsigned long)h->count,
+                      (unsigned long)h->min_us, (unsigned long)(h->sum_us / h->count),
+                      (unsigned long)h->max_us);
+    }
+}
 
 // HID keycodes for keys 0-7 (configured in config.h)
 static const uint8_t number_keycodes[8] = {
@@ -34,72 +93,125 @@ int main() {
     encoder_init();
     led_init();
     
-    serial_printf("Calibrating ADC...\r\n");
+    // Core 1 takes over the ADC from here on. It restores the key
+    // calibration from flash, or takes the first scan as rest (so no keys
+    // should be held at power-up) and learns each key's travel as it is
+    // pressed; send 'c' to calibrate explicitly.
+    acquire_launch_core1();
     
-    // Calibrate ADC (do this when no keys are pressed)
-    // Visual feedback during calibration
-    rgb_t calibration_color = {50, 50, 0}; // Yellow
-    led_set_all(calibration_color);
-    led_update();
-    
-    sleep_ms(500); // Give user time to release any keys
-    adc_calibrate();
+    serial_printf("System ready.\r\n\r\n");
     
-    led_clear();
+    // Latest frame published by core 1, read in place in the frame ring
+    const adc_frame_t *frame = NULL;
+    uint16_t adc_baseline[8];
     
-    serial_printf("Calibration complete!\r\n");
-    serial_printf("System ready.\r\n\r\n");
+    // Visual feedback during explicit calibration
+    const rgb_t calibration_color = {
+        LED_COLOR_CALIBRATING_R, LED_COLOR_CALIBRATING_G, LED_COLOR_CALIBRATING_B
+    };
     
-    // Track previous key states
-    static uint8_t last_key_mask = 0;
+    // Periodic ADC value printing
+    uint32_t last_print_ms = 0;
+    const uint32_t print_interval_ms = 100;
     
-    // Counter for periodic ADC value printing
-    uint32_t print_counter = 0;
-    const uint32_t print_interval = 100; // Print every 100 loops (~100ms)
+    // Stats records in binary telemetry mode
+    uint32_t last_stats_ms = 0;
+    const uint32_t stats_interval_ms = 1000;
     
     while (true) {
         // Process USB tasks
         usb_hid_task();
-        serial_task();
         
-        // Process ADC and get key states
-        uint8_t key_mask = adc_process();
+        int command = serial_task();
+        if (command >= 0) {
+            acquire_power_poke();
+        }
+        if (command == 'c') {
+            bool start = !acquire_calibrating();
+            acquire_request_calibration(start);
+            serial_printf(start ? "Calibrating: release all keys, then press each key fully. Send 'c' when done.\r\n"
+                                : "Calibration complete!\r\n");
+        } else if (command == 'l') {
+            print_report_latency();
+        } else if (command == 'r') {
+            print_cpu_budget();
+        } else if (command == 'p') {
+            print_power_stats();
+        } else if (command == 'e') {
+            // Cycle the effects, then manual (colors stay as last set)
+            uint8_t next = led_get_effect() == LED_EFFECT_MANUAL ? 0 : led_get_effect() + 1;
+            led_set_effect(next < RGB_EFFECT_COUNT ? next : LED_EFFECT_MANUAL);
+            serial_printf("LED effect %d\r\n", (int)led_get_effect());
+        } else if (command == 'b') {
+            // Binary telemetry (rp2350_c_hid/tools/telemetry.py) <-> text
+            serial_set_binary(!serial_binary());
+            serial_printf("Binary telemetry %s\r\n", serial_binary() ? "on" : "off");
+        }
+        if (acquire_save_calibration()) {
+            serial_printf("Key calibration saved to flash\r\n");
+        }
+        
+        // Handle key press/release events detected on core 1: apply them
+        // all, send the report, then log them
+        key_event_t events[NUM_ADC_CHANNELS];
+        int num_events = 0;
+        while (num_events < NUM_ADC_CHANNELS && acquire_pop_event(&events[num_events])) {
+            const key_event_t *event = &events[num_events++];
+            usb_keyboard_set(number_keycodes[event->key], event->pressed, event->timestamp_us);
+        }
+        usb_keyboard_flush();
+        for (int i = 0; i < num_events; i++) {
+            serial_send_key(&events[i]);
+            serial_printf("Key %d %s\r\n", events[i].key, events[i].pressed ? "pressed" : "released");
+        }
         
-        // Handle key press/release events
-        for (int i = 0; i < 8; i++) {
-            bool current = (key_mask & (1 << i)) != 0;
-            bool previous = (last_key_mask & (1 << i)) != 0;
-            
-            if (current && !previous) {
-                // Key pressed
-                usb_keyboard_press(number_keycodes[i]);
-                serial_printf("Key %d pressed\r\n", i);
-            } else if (!current && previous) {
-                // Key released
-                usb_keyboard_release(number_keycodes[i]);
-                serial_printf("Key %d released\r\n", i);
+        // Update LEDs from the key travel in the newest scan frame. The
+        // frame stays in its ring slot, so the effects read its travel
+        // without a copy; they render a slice per pass at the LED frame
+        // rate, and the frame goes out by DMA only when a color changed.
+        // Binary telemetry steps through every pending frame in order
+        // first, which leaves the newest one held
+        bool fresh_frame = false;
+        if (serial_binary()) {
+            const adc_frame_t *next;
+            while ((next = acquire_hold_next_frame()) != NULL) {
+                serial_send_frame(next);
+                frame = next;
+                fresh_frame = true;
             }
+        } else {
+            frame = acquire_hold_latest_frame(&fresh_frame);
         }
+        if (fresh_frame) {
+            led_set_travel(frame->travel);
+        }
+        if (acquire_calibrating()) {
+            led_set_all(calibration_color);
+        } else {
+            led_effect_task();
+        }
+        led_set_power_scale(acquire_power_led_scale());
+        led_update();
         
-        last_key_mask = key_mask;
-        
-        // Update LEDs based on key states
-        led_update_keys(key_mask);
+        // Process encoder: rotation counted by its interrupt, accelerated
+        int32_t volume_steps = encoder_take_steps();
+        for (int32_t i = 0; i < volume_steps; i++) {
+            usb_consumer_volume_up();
+        }
+        for (int32_t i = 0; i > volume_steps; i--) {
+            usb_consumer_volume_down();
+        }
+        if (volume_steps) {
+            serial_printf("Volume %s x%ld\r\n", volume_steps > 0 ? "Up" : "Down",
+                          (long)(volume_steps > 0 ? volume_steps : -volume_steps));
+        }
         
-        // Process encoder
         encoder_event_t encoder_event = encoder_process();
+        if (volume_steps || encoder_event != ENCODER_EVENT_NONE) {
+            acquire_power_poke();
+        }
         
         switch (encoder_event) {
-            case ENCODER_EVENT_CW:
-                usb_consumer_volume_up();
-                serial_printf("Volume Up\r\n");
-                break;
-                
-            case ENCODER_EVENT_CCW:
-                usb_consumer_volume_down();
-                serial_printf("Volume Down\r\n");
-                break;
-                
             case ENCODER_EVENT_PRESS:
                 usb_consumer_mute();
                 serial_printf("Mute Toggle\r\n");
@@ -109,20 +221,26 @@ int main() {
                 break;
         }
         
-        // Periodically print ADC values
-        if (++print_counter >= print_interval) {
-            print_counter = 0;
-            
-            uint16_t adc_values[8];
-            uint16_t adc_baseline[8];
-            adc_get_values(adc_values);
+        // Periodically print ADC values (binary telemetry sends every frame)
+        uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+        if (frame && !serial_binary() && now_ms - last_print_ms >= print_interval_ms) {
+            last_print_ms = now_ms;
             adc_get_baseline(adc_baseline);
-            
-            serial_print_adc_values(adc_values, adc_baseline);
+            serial_print_adc_values(frame->values, adc_baseline);
         }
+        if (serial_binary() && now_ms - last_stats_ms >= stats_interval_ms) {
+            last_stats_ms = now_ms;
+            acquire_stats_t acq;
+            acquire_get_stats(&acq);
+            serial_send_stats(&acq);
+        }
+        
+        // Everything queued this pass goes out with one CDC flush
+        serial_flush();
         
-        // Small delay to prevent overwhelming the system
-        sleep_ms(1);
+        // Sleep until core 1 publishes a scan or key events, or a USB
+        // interrupt arrives; the timeout keeps the encoder polled
+        best_effort_wfe_or_timeout(make_timeout_time_ms(MAIN_LOOP_DELAY_MS));
     }
     
     return 0;
@@ -1,4 +1,6 @@
 #include "serial.h"
+#include "telemetry.h"
+#include "pico/stdlib.h"
 #include "tusb.h"
 #include <stdio.h>
 #include <stdarg.h>
@@ -6,6 +8,10 @@
 
 static char print_buffer[256];
 
+static uint8_t ring_storage[SERIAL_RING_SIZE];
+static telemetry_tx_t ring;
+static bool binary_mode = false;
+
 // TinyUSB CDC callbacks
 void tud_cdc_line_state_cb(uint8_t itf, bool dtr, bool rts) {
     (void) itf;
@@ -19,14 +25,26 @@ void tud_cdc_rx_cb(uint8_t itf) {
 
 void serial_init(void) {
     // CDC is initialized as part of TinyUSB init
-    // Nothing specific needed here
+    telemetry_tx_init(&ring, ring_storage, sizeof(ring_storage));
 }
 
 bool serial_connected(void) {
     return tud_cdc_connected();
 }
 
-void serial_print_adc_values(uint16_t *values, uint16_t *baseline) {
+// Queue text: raw in text mode, as a TEXT record in binary mode
+static void serial_write_text(const char *text, int len) {
+    if (len <= 0) {
+        return;
+    }
+    if (binary_mode) {
+        telemetry_send(&ring, TELEMETRY_TEXT, text, (uint16_t) len, NULL, 0);
+    } else {
+        telemetry_tx_write_raw(&ring, text, (uint32_t) len);
+    }
+}
+
+void serial_print_adc_values(const uint16_t *values, const uint16_t *baseline) {
     if (!tud_cdc_connected()) return;
     
     // Format: "ADC: CH0=1234(1200) CH1=2345(2300) ..."
@@ -41,8 +59,7 @@ void serial_print_adc_values(uint16_t *values, uint16_t *baseline) {
     
     pos += snprintf(print_buffer + pos, sizeof(print_buffer) - pos, "\r\n");
     
-    tud_cdc_write(print_buffer, pos);
-    tud_cdc_write_flush();
+    serial_write_text(print_buffer, pos);
 }
 
 void serial_printf(const char *format, ...) {
@@ -53,22 +70,94 @@ void serial_printf(const char *format, ...) {
     int len = vsnprintf(print_buffer, sizeof(print_buffer), format, args);
     va_end(args);
     
-    if (len > 0) {
-        tud_cdc_write(print_buffer, len);
-        tud_cdc_write_flush();
+    if (len >= (int) sizeof(print_buffer)) {
+        len = sizeof(print_buffer) - 1;
     }
+    serial_write_text(print_buffer, len);
 }
 
-void serial_task(void) {
+int serial_task(void) {
+    int command = -1;
+
     // Handle any incoming serial data if needed
     if (tud_cdc_available()) {
         uint8_t buf[64];
         uint32_t count = tud_cdc_read(buf, sizeof(buf));
         
-        // Echo back for testing
+        // Echo back for testing (text mode only: it would break packets)
         if (count > 0) {
-            tud_cdc_write(buf, count);
-            tud_cdc_write_flush();
+            if (!binary_mode) {
+                telemetry_tx_write_raw(&ring, buf, count);
+            }
+            command = buf[0];
         }
     }
+
+    return command;
+}
+
+static uint32_t cdc_write(const void *data, uint32_t len) {
+    return tud_cdc_write(data, len);
+}
+
+void serial_flush(void) {
+    if (!tud_cdc_connected()) {
+        telemetry_tx_consume(&ring, telemetry_tx_used(&ring));
+        return;
+    }
+
+    if (telemetry_tx_drain(&ring, cdc_write)) {
+        tud_cdc_write_flush();
+    }
+}
+
+void serial_set_binary(bool binary) {
+    if (binary && !binary_mode) {
+        // Delimiter ends any partial text so the host starts on a packet
+        const uint8_t delimiter = 0;
+        telemetry_tx_write_raw(&ring, &delimiter, 1);
+    }
+    binary_mode = binary;
+}
+
+bool serial_binary(void) {
+    return binary_mode;
+}
+
+void serial_send_frame(const adc_frame_t *frame) {
+    if (!binary_mode) {
+        return;
+    }
+    const telemetry_frame_header_t header = {
+        .seq = frame->seq,
+        .timestamp_us = frame->timestamp_us,
+        .count = NUM_ADC_CHANNELS,
+    };
+    telemetry_send(&ring, TELEMETRY_FRAME, &header, sizeof(header), frame->values, sizeof(frame->values));
+}
+
+void serial_send_key(const key_event_t *event) {
+    if (!binary_mode) {
+        return;
+    }
+    const telemetry_key_t key = {
+        .timestamp_us = event->timestamp_us,
+        .key = event->key,
+        .pressed = event->pressed,
+    };
+    telemetry_send(&ring, TELEMETRY_KEY, &key, sizeof(key), NULL, 0);
+}
+
+void serial_send_stats(const acquire_stats_t *acq) {
+    if (!binary_mode) {
+        return;
+    }
+    const telemetry_stats_t stats = {
+        .uptime_ms = to_ms_since_boot(get_absolute_time()),
+        .records_sent = ring.records_sent + 1,  // Including this one
+        .records_dropped = ring.records_dropped,
+        .scans = acq->frames_published,
+        .scans_dropped = acq->frames_dropped,
+    };
+    telemetry_send(&ring, TELEMETRY_STATS, &stats, sizeof(stats), NULL, 0);
 }
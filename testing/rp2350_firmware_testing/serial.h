@@ -3,6 +3,20 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "adc.h"
+#include "acquire.h"
+
+// Output to the CDC port goes through a byte ring drained by serial_flush(),
+// once per main-loop pass, instead of a write and flush per call.
+//
+// Text mode (default): serial_printf() and serial_print_adc_values() write
+// text. Binary mode: the telemetry format in ../common/telemetry.h, with
+// scan frames, key events and stats as records and text wrapped in
+// TELEMETRY_TEXT records (parse with rp2350_c_hid/tools/telemetry.py).
+
+#ifndef SERIAL_RING_SIZE
+#define SERIAL_RING_SIZE 8192   // Power of two
+#endif
 
 /**
  * @brief Initialize serial interface (USB CDC)
@@ -22,7 +36,7 @@ bool serial_connected(void);
  * @param values Array of ADC values
  * @param baseline Array of baseline values
  */
-void serial_print_adc_values(uint16_t *values, uint16_t *baseline);
+void serial_print_adc_values(const uint16_t *values, const uint16_t *baseline);
 
 /**
  * @brief Print a formatted string to serial
@@ -33,7 +47,42 @@ void serial_printf(const char *format, ...);
 
 /**
  * @brief Process serial tasks (must be called regularly)
+ * 
+ * @return First byte received in this call, or -1 if nothing arrived
+ */
+int serial_task(void);
+
+/**
+ * @brief Write queued output to the CDC FIFO, flushing once
+ *
+ * Call at the end of every main-loop pass. Output queued while no host is
+ * connected is discarded.
+ */
+void serial_flush(void);
+
+/**
+ * @brief Switch between binary telemetry and text output
+ */
+void serial_set_binary(bool binary);
+
+/**
+ * @brief Check whether binary telemetry is active
+ */
+bool serial_binary(void);
+
+/**
+ * @brief Queue a scan frame record (binary mode only)
+ */
+void serial_send_frame(const adc_frame_t *frame);
+
+/**
+ * @brief Queue a key event record (binary mode only)
+ */
+void serial_send_key(const key_event_t *event);
+
+/**
+ * @brief Queue a stats record (binary mode only)
  */
-void serial_task(void);
+void serial_send_stats(const acquire_stats_t *acq);
 
 #endif // SERIAL_H
@@ -62,8 +62,8 @@ extern "C" {
 #define CFG_TUD_NCM             0
 #define CFG_TUD_BTH             0
 
-// HID buffer size
-#define CFG_TUD_HID_EP_BUFSIZE 16
+// HID buffer size: report ID + 29-byte NKRO keyboard report
+#define CFG_TUD_HID_EP_BUFSIZE 32
 
 // CDC FIFO size
 #define CFG_TUD_CDC_RX_BUFSIZE 256
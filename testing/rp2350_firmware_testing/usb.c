@@ -1,55 +1,31 @@
 #include "usb.h"
 #include "tusb.h"
+#include "nkro.h"
+#include "latency_hist.h"
+#include "consumer_queue.h"
 #include "pico/stdlib.h"
 #include <string.h>
 
-// HID Report IDs
-#define REPORT_ID_KEYBOARD      1
-#define REPORT_ID_CONSUMER      2
+// NKRO keyboard state; a report goes out only when it changes
+static nkro_t keyboard;
 
-// Keyboard report structure
-static struct {
-    uint8_t modifiers;
-    uint8_t reserved;
-    uint8_t keys[6];
-} keyboard_report = {0};
+// Scan-to-report latency: timestamp of the oldest key change not yet sent,
+// and of the oldest change carried by the report in flight. A sample is
+// taken when the host has collected that report.
+static uint32_t change_stamp_us;
+static uint32_t inflight_stamp_us;
+static bool inflight = false;
+static latency_hist_t report_latency;
 
-// Consumer control report
-static uint16_t consumer_report = 0;
+// Consumer control taps (press + release each), sent one report at a time
+// as the endpoint frees up
+static consumer_queue_t consumer;
 
 // HID report descriptor combining keyboard and consumer control
 static const uint8_t hid_report_descriptor[] = {
-    // Keyboard Report
-    0x05, 0x01,        // Usage Page (Generic Desktop)
-    0x09, 0x06,        // Usage (Keyboard)
-    0xA1, 0x01,        // Collection (Application)
-    0x85, REPORT_ID_KEYBOARD,  // Report ID (1)
-    
-    // Modifier keys
-    0x05, 0x07,        //   Usage Page (Key Codes)
-    0x19, 0xE0,        //   Usage Minimum (224)
-    0x29, 0xE7,        //   Usage Maximum (231)
-    0x15, 0x00,        //   Logical Minimum (0)
-    0x25, 0x01,        //   Logical Maximum (1)
-    0x75, 0x01,        //   Report Size (1)
-    0x95, 0x08,        //   Report Count (8)
-    0x81, 0x02,        //   Input (Data, Variable, Absolute)
-    
-    // Reserved byte
-    0x95, 0x01,        //   Report Count (1)
-    0x75, 0x08,        //   Report Size (8)
-    0x81, 0x01,        //   Input (Constant)
-    
-    // Key array (6 keys)
-    0x95, 0x06,        //   Report Count (6)
-    0x75, 0x08,        //   Report Size (8)
-    0x15, 0x00,        //   Logical Minimum (0)
-    0x25, 0x65,        //   Logical Maximum (101)
-    0x05, 0x07,        //   Usage Page (Key Codes)
-    0x19, 0x00,        //   Usage Minimum (0)
-    0x29, 0x65,        //   Usage Maximum (101)
-    0x81, 0x00,        //   Input (Data, Array)
-    0xC0,              // End Collection
+    // NKRO Keyboard Report (boot protocol sends the 8-byte boot report
+    // without a report ID instead)
+    NKRO_REPORT_DESC(NKRO_REPORT_ID(REPORT_ID_KEYBOARD)),
     
     // Consumer Control Report
     0x05, 0x0C,        // Usage Page (Consumer)
@@ -66,13 +42,27 @@ static const uint8_t hid_report_descriptor[] = {
     0xC0,              // End Collection
 };
 
+_Static_assert(sizeof(hid_report_descriptor) == HID_REPORT_DESC_LEN,
+               "update HID_REPORT_DESC_LEN in usb.h");
+
+static bool boot_protocol(void) {
+    return tud_hid_get_protocol() == HID_PROTOCOL_BOOT;
+}
+
+static void consumer_flush(void);
+
 // TinyUSB device callbacks
 void tud_mount_cb(void) {
     // Called when device is mounted (configured)
 }
 
+// Bus reset or unplug: TinyUSB completes nothing that was in flight, so
+// drop the in-flight state here or the endpoint would look busy forever.
+// The key state is resent once the host configures the device again.
 void tud_umount_cb(void) {
-    // Called when device is unmounted
+    inflight = false;
+    nkro_invalidate(&keyboard);
+    consumer_queue_clear(&consumer);
 }
 
 void tud_suspend_cb(bool remote_wakeup_en) {
@@ -85,21 +75,37 @@ void tud_resume_cb(void) {
 // USB HID callbacks
 void tud_hid_report_complete_cb(uint8_t instance, uint8_t const* report, uint16_t len) {
     (void) instance;
-    (void) report;
-    (void) len;
+
+    // Boot protocol reports carry no ID and are always the keyboard
+    bool keyboard_report = boot_protocol() || (len > 0 && report[0] == REPORT_ID_KEYBOARD);
+    if (keyboard_report) {
+        // The host has the report: record its latency
+        if (inflight) {
+            latency_hist_add(&report_latency, time_us_32() - inflight_stamp_us);
+            inflight = false;
+        }
+    } else if (len > 0 && report[0] == REPORT_ID_CONSUMER) {
+        consumer_queue_complete(&consumer);
+    }
+
+    // The endpoint is free again: key changes first, then media key taps
+    usb_keyboard_flush();
+    consumer_flush();
 }
 
 uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t* buffer, uint16_t reqlen) {
     (void) instance;
     (void) report_type;
-    (void) reqlen;
-
-    if (report_id == REPORT_ID_KEYBOARD) {
-        memcpy(buffer, &keyboard_report, sizeof(keyboard_report));
-        return sizeof(keyboard_report);
-    } else if (report_id == REPORT_ID_CONSUMER) {
-        memcpy(buffer, &consumer_report, sizeof(consumer_report));
-        return sizeof(consumer_report);
+
+    // Boot protocol has no report IDs: every request is for the keyboard
+    bool boot = boot_protocol();
+    if ((boot || report_id == REPORT_ID_KEYBOARD) && reqlen >= nkro_report_size(boot)) {
+        return nkro_build_report(&keyboard, boot, buffer);
+    } else if (report_id == REPORT_ID_CONSUMER && reqlen >= 2) {
+        // Nothing is held between taps except a press awaiting its release
+        uint16_t usage = consumer.pressed ? consumer.usage[consumer.head] : 0;
+        memcpy(buffer, &usage, sizeof(usage));
+        return sizeof(usage);
     }
     
     return 0;
@@ -113,6 +119,17 @@ void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_
     (void) bufsize;
 }
 
+// The host switched between boot and report protocol: resend the key state
+// in the new format
+void tud_hid_set_protocol_cb(uint8_t instance, uint8_t protocol) {
+    (void) instance;
+    nkro_invalidate(&keyboard);
+    // The boot protocol has no consumer report
+    if (protocol == HID_PROTOCOL_BOOT) {
+        consumer_queue_clear(&consumer);
+    }
+}
+
 // HID report descriptor length (needed for descriptor)
 uint16_t tud_hid_descriptor_report_len(void) {
     return sizeof(hid_report_descriptor);
@@ -125,6 +142,9 @@ uint8_t const* tud_hid_descriptor_report_cb(uint8_t instance) {
 }
 
 void usb_hid_init(void) {
+    nkro_init(&keyboard);
+    consumer_queue_init(&consumer);
+    latency_hist_reset(&report_latency);
     tusb_init();
 }
 
@@ -132,79 +152,81 @@ bool usb_hid_ready(void) {
     return tud_hid_ready();
 }
 
-void usb_keyboard_press(uint8_t key) {
-    // Add key to report if not already present
-    for (int i = 0; i < 6; i++) {
-        if (keyboard_report.keys[i] == key) {
-            return; // Already pressed
-        }
-        if (keyboard_report.keys[i] == 0) {
-            keyboard_report.keys[i] = key;
-            break;
-        }
+void usb_keyboard_set(uint8_t key, bool pressed, uint32_t timestamp_us) {
+    bool was_pending = nkro_pending(&keyboard);
+    nkro_set(&keyboard, key, pressed);
+    if (!was_pending && nkro_pending(&keyboard)) {
+        change_stamp_us = timestamp_us;
     }
 }
 
+void usb_keyboard_press(uint8_t key) {
+    usb_keyboard_set(key, true, time_us_32());
+}
+
 void usb_keyboard_release(uint8_t key) {
-    // Remove key from report
-    for (int i = 0; i < 6; i++) {
-        if (keyboard_report.keys[i] == key) {
-            keyboard_report.keys[i] = 0;
-            // Shift remaining keys down
-            for (int j = i; j < 5; j++) {
-                keyboard_report.keys[j] = keyboard_report.keys[j + 1];
-            }
-            keyboard_report.keys[5] = 0;
-            break;
-        }
+    usb_keyboard_set(key, false, time_us_32());
+}
+
+void usb_keyboard_flush(void) {
+    if (!nkro_pending(&keyboard) || !tud_hid_ready()) {
+        return;
+    }
+
+    uint8_t report[NKRO_REPORT_SIZE];
+    bool boot = boot_protocol();
+    uint8_t len = nkro_build_report(&keyboard, boot, report);
+    if (tud_hid_report(boot ? 0 : REPORT_ID_KEYBOARD, report, len)) {
+        nkro_mark_sent(&keyboard);
+        inflight_stamp_us = change_stamp_us;
+        inflight = true;
     }
 }
 
+void usb_take_report_latency(latency_hist_t *out) {
+    *out = report_latency;
+    latency_hist_reset(&report_latency);
+}
+
 void usb_keyboard_release_all(void) {
-    memset(&keyboard_report, 0, sizeof(keyboard_report));
+    nkro_clear(&keyboard);
 }
 
-void usb_consumer_volume_up(void) {
-    consumer_report = 0x00E9; // Volume Up
-    if (tud_hid_ready()) {
-        tud_hid_report(REPORT_ID_CONSUMER, &consumer_report, sizeof(consumer_report));
+// Send the next consumer press/release if one is due and the endpoint is free
+static void consumer_flush(void) {
+    uint16_t report;
+    if (boot_protocol() || !tud_hid_ready() || !consumer_queue_next(&consumer, &report)) {
+        return;
     }
-    sleep_ms(10);
-    consumer_report = 0;
-    if (tud_hid_ready()) {
-        tud_hid_report(REPORT_ID_CONSUMER, &consumer_report, sizeof(consumer_report));
+    consumer_queue_sent(&consumer, tud_hid_report(REPORT_ID_CONSUMER, &report, sizeof(report)));
+}
+
+bool usb_consumer_tap(uint16_t usage) {
+    if (boot_protocol()) {
+        return false;
     }
+    bool queued = consumer_queue_tap(&consumer, usage);
+    consumer_flush();
+    return queued;
+}
+
+void usb_consumer_volume_up(void) {
+    usb_consumer_tap(0x00E9); // Volume Up
 }
 
 void usb_consumer_volume_down(void) {
-    consumer_report = 0x00EA; // Volume Down
-    if (tud_hid_ready()) {
-        tud_hid_report(REPORT_ID_CONSUMER, &consumer_report, sizeof(consumer_report));
-    }
-    sleep_ms(10);
-    consumer_report = 0;
-    if (tud_hid_ready()) {
-        tud_hid_report(REPORT_ID_CONSUMER, &consumer_report, sizeof(consumer_report));
-    }
+    usb_consumer_tap(0x00EA); // Volume Down
 }
 
 void usb_consumer_mute(void) {
-    consumer_report = 0x00E2; // Mute
-    if (tud_hid_ready()) {
-        tud_hid_report(REPORT_ID_CONSUMER, &consumer_report, sizeof(consumer_report));
-    }
-    sleep_ms(10);
-    consumer_report = 0;
-    if (tud_hid_ready()) {
-        tud_hid_report(REPORT_ID_CONSUMER, &consumer_report, sizeof(consumer_report));
-    }
+    usb_consumer_tap(0x00E2); // Mute
 }
 
 void usb_hid_task(void) {
     tud_task();
     
-    // Send keyboard report if ready
-    if (tud_hid_ready()) {
-        tud_hid_report(REPORT_ID_KEYBOARD, &keyboard_report, sizeof(keyboard_report));
-    }
+    // Send the keyboard report only when the key state changed, then any
+    // media key tap that is due
+    usb_keyboard_flush();
+    consumer_flush();
 }
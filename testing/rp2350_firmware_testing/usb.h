@@ -3,17 +3,42 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "latency_hist.h"
+
+// HID report IDs on the keyboard interface (report protocol only; the boot
+// protocol carries the keyboard alone, without an ID)
+#define REPORT_ID_KEYBOARD      1
+#define REPORT_ID_CONSUMER      2
+
+// Size of the HID report descriptor in usb.c (NKRO keyboard + consumer)
+#define HID_REPORT_DESC_LEN     74
 
 // USB initialization and management
 void usb_hid_init(void);
 bool usb_hid_ready(void);
 
-// Keyboard functions
+// Keyboard functions: N-key rollover, any number of keys can be held.
+// usb_keyboard_flush() (also called by usb_hid_task() and when the previous
+// report completes) sends a report whenever the key state changed.
 void usb_keyboard_press(uint8_t key);
 void usb_keyboard_release(uint8_t key);
 void usb_keyboard_release_all(void);
 
-// Consumer control (volume/mute) functions
+// Press or release with the time the change was detected (time_us_32()),
+// used for the scan-to-report latency histogram
+void usb_keyboard_set(uint8_t key, bool pressed, uint32_t timestamp_us);
+
+// Send the keyboard report now if the state changed and the endpoint is free
+void usb_keyboard_flush(void);
+
+// Copy and clear the scan-to-report latency histogram (time from the scan
+// that detected a change until the host collected the report carrying it)
+void usb_take_report_latency(latency_hist_t *out);
+
+// Consumer control (volume/mute) functions. Each call queues one tap (press
+// then release) and returns at once; repeated taps of the same usage
+// coalesce, and the reports go out as the endpoint frees up.
+bool usb_consumer_tap(uint16_t usage);
 void usb_consumer_volume_up(void);
 void usb_consumer_volume_down(void);
 void usb_consumer_mute(void);
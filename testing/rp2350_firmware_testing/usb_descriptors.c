@@ -1,4 +1,5 @@
 #include "tusb.h"
+#include "usb.h"
 #include "pico/unique_id.h"
 #include <string.h>
 #include <stdio.h>
@@ -35,10 +36,6 @@ enum {
     ITF_NUM_TOTAL
 };
 
-// Calculate the actual HID report descriptor length
-// Keyboard report: 53 bytes + Consumer report: 18 bytes = 71 bytes total
-#define HID_REPORT_DESC_LEN 71
-
 #define CONFIG_TOTAL_LEN    (TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN + TUD_CDC_DESC_LEN)
 
 #define EPNUM_HID           0x81
@@ -51,7 +48,8 @@ uint8_t const desc_configuration[] = {
     TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0x00, 500),
 
     // Interface number, string index, protocol, report descriptor len, EP In address, size & polling interval
-    TUD_HID_DESCRIPTOR(ITF_NUM_HID, 0, HID_ITF_PROTOCOL_NONE, HID_REPORT_DESC_LEN, EPNUM_HID, CFG_TUD_HID_EP_BUFSIZE, 1),
+    // Boot keyboard subclass so BIOS/boot loaders can switch to the boot protocol
+    TUD_HID_DESCRIPTOR(ITF_NUM_HID, 0, HID_ITF_PROTOCOL_KEYBOARD, HID_REPORT_DESC_LEN, EPNUM_HID, CFG_TUD_HID_EP_BUFSIZE, 1),
 
     // Interface number, string index, EP notification address and size, EP data address (out, in) and size.
     TUD_CDC_DESCRIPTOR(ITF_NUM_CDC_0, 4, EPNUM_CDC_NOTIF, 8, EPNUM_CDC_OUT, EPNUM_CDC_IN, 64),